@@ -3,6 +3,7 @@
 #include "ai_agent.h"
 #include "ai_open_router.h"
 #include "mcp/mcp_manager.h"
+#include "../util/redraw.h"
 #include <chrono>
 #include <curl/curl.h>
 #include <iostream>
@@ -106,6 +107,24 @@ void AgentRequest::sendMessage(const std::string &payload,
 	extern std::atomic<bool> g_should_cancel;
 	g_should_cancel = false;
 
+	// Both callbacks run on the streaming thread; wake the UI so the new text
+	// and the final state get drawn
+	if (onStreamingToken)
+	{
+		onStreamingToken = [callback = std::move(onStreamingToken)](const std::string &token) {
+			callback(token);
+			gRedraw.request();
+		};
+	}
+	if (onComplete)
+	{
+		onComplete = [callback = std::move(onComplete)](const std::string &response,
+														 bool hasToolCall) {
+			callback(response, hasToolCall);
+			gRedraw.request();
+		};
+	}
+
 	// Track the full response using shared pointer
 	auto fullResponse = std::make_shared<std::string>();
 	auto toolCallMarkers = std::make_shared<std::vector<std::string>>();
@@ -2,6 +2,7 @@
 #include "../files/files.h" // for gFileExplorer
 #include "../lib/json.hpp"
 #include "editor/editor.h" // for editor_state
+#include "util/redraw.h"
 #include "util/settings.h"
 #include <cctype>
 #include <cstring>
@@ -260,6 +261,7 @@ void AIAgentTextInput::renderButtons(float textBoxWidth)
 	if (isProcessingCallback && isProcessingCallback())
 	{
 		ImGui::SameLine();
+		gRedraw.requestIn(Redraw::ANIMATION_INTERVAL);
 
 		// Get the position after the History button
 		ImVec2 spinnerPos = ImGui::GetCursorScreenPos();
@@ -290,7 +292,7 @@ void AIAgentTextInput::renderButtons(float textBoxWidth)
 		if (isHovered)
 		{
 			// Show close icon when hovering
-			ImTextureID closeIcon = gFileExplorer.getIcon("close-mac-hover");
+			IconRef closeIcon = gFileExplorer.getIcon("close-mac-hover");
 			ImVec2 iconSize = ImVec2(
 				fontSize * 0.8f,
 				fontSize * 0.8f); // Make close button slightly smaller than font size
@@ -298,10 +300,12 @@ void AIAgentTextInput::renderButtons(float textBoxWidth)
 									spinnerPos.y - iconSize.y * 0.5f);
 
 			// Draw the close icon
-			ImGui::GetWindowDrawList()->AddImage(closeIcon,
+			ImGui::GetWindowDrawList()->AddImage(closeIcon.texture,
 												 iconPos,
 												 ImVec2(iconPos.x + iconSize.x,
-														iconPos.y + iconSize.y));
+														iconPos.y + iconSize.y),
+												 closeIcon.uv0,
+												 closeIcon.uv1);
 
 			// Handle click to stop the request
 			if (ImGui::IsMouseClicked(ImGuiMouseButton_Left))
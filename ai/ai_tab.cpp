@@ -1,6 +1,8 @@
 #include "ai_tab.h"
 #include "../editor/editor.h"
 #include "../files/files.h"
+#include "../lsp/lsp_client.h"
+#include "../util/redraw.h"
 #include "ai_open_router.h"
 #include <algorithm>
 #include <atomic>
@@ -138,6 +140,7 @@ void AITab::tab_complete()
 						request_done = true;
 					}
 				}
+				gRedraw.request();
 				request_active = false;
 				decrement_thread_count();
 			});
@@ -282,6 +285,7 @@ void AITab::insert(const std::string &code)
 
 	// Insert the code into the file content
 	editor_state.fileContent.insert(editor_state.cursor_index, code);
+	gLSPClient.dropAnchor(); // Lines past the ghost text moved unseen
 
 	ImVec4 ghost_color = ImVec4(0.5f, 0.5f, 0.5f, 0.5f);
 
@@ -307,6 +311,16 @@ void AITab::accept_completion()
 	if (!has_ghost_text)
 		return;
 
+	// The ghost text went in unrecorded; accepting it is what undo reverts
+	if (ghost_text_end <= editor_state.fileContent.size())
+	{
+		std::string_view content(editor_state.fileContent);
+		gFileExplorer.recordEdit(
+			ghost_text_start,
+			{},
+			content.substr(ghost_text_start, ghost_text_end - ghost_text_start));
+	}
+
 	for (int i = ghost_text_start; i < ghost_text_end; i++)
 	{
 		if (i < editor_state.fileColors.size())
@@ -346,6 +360,7 @@ void AITab::dismiss_completion()
 	}
 
 	editor_state.fileContent.erase(ghost_text_start, ghost_text_end - ghost_text_start);
+	gLSPClient.dropAnchor();
 	editor_state.fileColors.erase(editor_state.fileColors.begin() + ghost_text_start,
 								  editor_state.fileColors.begin() + ghost_text_end);
 
@@ -18,11 +18,14 @@
 #include "editor_bookmarks.h"
 #include "editor_copy_paste.h"
 #include "editor_cursor.h"
+#include "editor_display_map.h"
+#include "editor_folding.h"
 #include "editor_header.h"
 #include "editor_highlight.h"
 #include "editor_keyboard.h"
 #include "editor_line_jump.h"
 #include "editor_line_numbers.h"
+#include "editor_minimap.h"
 #include "editor_mouse.h"
 #include "editor_render.h"
 #include "editor_selection.h"
@@ -31,6 +34,9 @@
 #include "../ai/ai_tab.h"
 #include "../files/file_finder.h"
 #include "../files/files.h"
+#include "../files/symbol_search.h"
+#include "../files/workspace_search.h"
+#include "../lsp/lsp_client.h"
 #include "../lsp/lsp_symbol_info.h"
 
 #include "../util/settings.h"
@@ -51,6 +57,9 @@ void Editor::textEditor()
 
 	processEditorInput();
 
+	// Edits of this frame go to the language server once typing pauses
+	gLSPClient.update();
+
 	gEditorRender.renderEditorFrame();
 }
 
@@ -65,13 +74,20 @@ void Editor::setupEditorDisplay()
 	editor_state.line_numbers_pos = gEditorLineNumbers.createLineNumbersPanel();
 
 	updateLineStarts();
-	editor_state.total_height =
-		editor_state.line_height * editor_state.editor_content_lines.size();
+	gEditorFolding.update();
+
+	float remaining_width =
+		editor_state.size.x - editor_state.line_number_width - gEditorMinimap.width();
+	gEditorDisplayMap.sync(remaining_width - editor_state.text_left_margin -
+						   ImGui::GetStyle().ScrollbarSize - ImGui::GetFontSize());
+
+	editor_state.total_height = editor_state.line_height * gEditorDisplayMap.rowCount();
 
-	float remaining_width = editor_state.size.x - editor_state.line_number_width;
-	float content_width = calculateTextWidth() + ImGui::GetFontSize() * 10.0f;
-	float content_height =
-		editor_state.editor_content_lines.size() * editor_state.line_height;
+	// Wrapped text never scrolls horizontally
+	float content_width = gEditorDisplayMap.isWrapping()
+							  ? remaining_width
+							  : calculateTextWidth() + ImGui::GetFontSize() * 10.0f;
+	float content_height = editor_state.total_height;
 
 	gEditorRender.beginTextEditorChild(
 		"##editor", remaining_width, content_width, content_height);
@@ -100,9 +116,31 @@ void Editor::updateLineStarts()
 		return;
 	}
 
+	// Byte range that differs from the last layout, so the display map only
+	// re-wraps the lines an edit actually touched
+	const std::string &old_text = editor_state.cached_text;
+	const std::string &new_text = editor_state.fileContent;
+	const size_t common = std::min(old_text.size(), new_text.size());
+	size_t prefix = 0;
+	while (prefix < common && old_text[prefix] == new_text[prefix])
+	{
+		++prefix;
+	}
+	size_t suffix = 0;
+	while (suffix < common - prefix && old_text[old_text.size() - 1 - suffix] ==
+											new_text[new_text.size() - 1 - suffix])
+	{
+		++suffix;
+	}
+	const int old_line_count = static_cast<int>(editor_state.editor_content_lines.size());
+	const size_t old_end = old_text.size() - suffix;
+
 	editor_state.cached_text = editor_state.fileContent;
+	editor_state.text_version++;
+	gFileContentSearch.onTextChanged(prefix, old_end, new_text.size() - suffix);
 	editor_state.editor_content_lines.clear();
 	editor_state.line_widths.clear();
+	editor_state.line_indents.clear();
 
 	editor_state.editor_content_lines.reserve(
 		editor_state.fileContent.size() /
@@ -128,6 +166,76 @@ void Editor::updateLineStarts()
 						  .x;
 		editor_state.line_widths.push_back(width);
 	}
+
+	updateLineIndents();
+
+	// Lines past the change are wholly inside the common suffix, so they map
+	// one-to-one onto the old lines shifted by the line count delta
+	const int line_delta =
+		static_cast<int>(editor_state.editor_content_lines.size()) - old_line_count;
+	int first_line = getLineFromPos(static_cast<int>(prefix));
+	int last_line = std::max(
+		getLineFromPos(static_cast<int>(new_text.size() - suffix)), first_line);
+	gEditorDisplayMap.onLinesChanged(
+		first_line, last_line + 1 - line_delta, last_line + 1);
+	gEditorFolding.onLinesChanged(first_line, last_line + 1 - line_delta, last_line + 1);
+	gEditorMinimap.onLinesChanged(first_line, last_line + 1 - line_delta, last_line + 1);
+}
+
+void Editor::updateLineIndents()
+{
+	const std::string &content = editor_state.fileContent;
+	const std::vector<int> &line_starts = editor_state.editor_content_lines;
+	std::vector<int> &indents = editor_state.line_indents;
+	const int BLANK = -1;
+
+	indents.resize(line_starts.size());
+	for (size_t i = 0; i < line_starts.size(); ++i)
+	{
+		size_t end = (i + 1 < line_starts.size()) ? line_starts[i + 1] : content.size();
+		int columns = 0;
+		int indent = BLANK;
+		for (size_t pos = line_starts[i]; pos < end; ++pos)
+		{
+			char c = content[pos];
+			if (c == ' ')
+			{
+				columns++;
+			} else if (c == '\t')
+			{
+				columns += 4;
+			} else
+			{
+				if (c != '\n' && c != '\r')
+				{
+					indent = columns;
+				}
+				break;
+			}
+		}
+		indents[i] = indent;
+	}
+
+	// Blank lines take the smaller of the nearest non-blank indents around them
+	int previous = 0;
+	size_t i = 0;
+	while (i < indents.size())
+	{
+		if (indents[i] != BLANK)
+		{
+			previous = indents[i++];
+			continue;
+		}
+		size_t next = i;
+		while (next < indents.size() && indents[next] == BLANK)
+		{
+			++next;
+		}
+		int following = next < indents.size() ? indents[next] : 0;
+		int fill = std::min(previous, following);
+		std::fill(indents.begin() + i, indents.begin() + next, fill);
+		i = next;
+	}
 }
 
 int Editor::getLineFromPos(int pos)
@@ -138,6 +246,47 @@ int Editor::getLineFromPos(int pos)
 	return std::distance(editor_state.editor_content_lines.begin(), it) - 1;
 }
 
+void Editor::insertText(int index, std::string_view text)
+{
+	gFileExplorer.recordEdit(index, {}, text);
+	editor_state.fileContent.insert(index, text);
+}
+
+void Editor::eraseText(int index, int length)
+{
+	std::string &content = editor_state.fileContent;
+	gFileExplorer.recordEdit(index, std::string_view(content).substr(index, length), {});
+	content.erase(index, length);
+}
+
+void Editor::replaceText(int index, int length, std::string_view text)
+{
+	std::string &content = editor_state.fileContent;
+	gFileExplorer.recordEdit(
+		index, std::string_view(content).substr(index, length), text);
+	content.replace(index, length, text);
+}
+
+void Editor::replaceContent(std::string content)
+{
+	const std::string &old = editor_state.fileContent;
+	size_t prefix = 0;
+	size_t limit = std::min(old.size(), content.size());
+	while (prefix < limit && old[prefix] == content[prefix])
+		prefix++;
+	size_t suffix = 0;
+	while (suffix < limit - prefix &&
+		   old[old.size() - 1 - suffix] == content[content.size() - 1 - suffix])
+		suffix++;
+
+	std::string_view oldView(old);
+	std::string_view newView(content);
+	gFileExplorer.recordEdit(prefix,
+							 oldView.substr(prefix, old.size() - prefix - suffix),
+							 newView.substr(prefix, content.size() - prefix - suffix));
+	editor_state.fileContent = std::move(content);
+}
+
 float Editor::calculateTextWidth()
 {
 	float max_width = 0.0f;
@@ -185,6 +334,8 @@ void Editor::renderEditor(ImFont *font, float editorWidth)
 	ImVec2 editorPanePos = ImGui::GetWindowPos();
 	ImVec2 editorPaneSize = ImGui::GetWindowSize();
 	gFileFinder.setEditorPaneBounds(editorPanePos, editorPaneSize);
+	gWorkspaceSearch.setEditorPaneBounds(editorPanePos, editorPaneSize);
+	gSymbolSearch.setEditorPaneBounds(editorPanePos, editorPaneSize);
 
 	// Calculate if git changes should be shown based on window width
 	float windowWidth = ImGui::GetWindowWidth();
@@ -18,6 +18,7 @@
 #include "editor_types.h"
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 // Forward declarations
@@ -35,9 +36,18 @@ class Editor
 	void processEditorInput();
 
 	void updateLineStarts();
+	void updateLineIndents();
 
 	int getLineFromPos(int pos);
 
+	// Edits of fileContent that go through the undo journal. Callers keep
+	// fileColors in step themselves.
+	void insertText(int index, std::string_view text);
+	void eraseText(int index, int length);
+	void replaceText(int index, int length, std::string_view text);
+	// Replaces the whole buffer, journaling only the range that differs
+	void replaceContent(std::string content);
+
 	float calculateTextWidth();
 
 	void renderEditor(ImFont *font, float editorWidth);
@@ -68,17 +68,13 @@ void EditorCopyPaste::cutSelectedText()
 {
 	if (editor_state.selection_start != editor_state.selection_end)
 	{
-		// Save the state before making any changes
-		std::string beforeContent = editor_state.fileContent;
-		int beforeCursor = editor_state.cursor_index;
-		int cutStart = getSelectionStart();
-		int cutEnd = getSelectionEnd();
+		gFileExplorer.forceCommitUndoState(); // A cut is a step of its own
 
 		int start = getSelectionStart();
 		int end = getSelectionEnd();
 		std::string selected_text = editor_state.fileContent.substr(start, end - start);
 		ImGui::SetClipboardText(selected_text.c_str());
-		editor_state.fileContent.erase(start, end - start);
+		gEditor.eraseText(start, end - start);
 		editor_state.fileColors.erase(editor_state.fileColors.begin() + start,
 									  editor_state.fileColors.begin() + end);
 		editor_state.cursor_index = start;
@@ -94,10 +90,7 @@ void EditorCopyPaste::cutWholeLine()
 {
 	gAITab.cancel_request();
 	gAITab.dismiss_completion();
-	gFileExplorer.addUndoState();
-	// Save the state before making any changes
-	std::string beforeContent = editor_state.fileContent;
-	int beforeCursor = editor_state.cursor_index;
+	gFileExplorer.forceCommitUndoState(); // A cut is a step of its own
 
 	int line = EditorUtils::GetLineFromPosition(editor_state.editor_content_lines,
 												editor_state.cursor_index);
@@ -110,7 +103,7 @@ void EditorCopyPaste::cutWholeLine()
 		editor_state.fileContent.substr(line_start, line_end - line_start);
 	ImGui::SetClipboardText(line_text.c_str());
 
-	editor_state.fileContent.erase(line_start, line_end - line_start);
+	gEditor.eraseText(line_start, line_end - line_start);
 	editor_state.fileColors.erase(editor_state.fileColors.begin() + line_start,
 								  editor_state.fileColors.begin() + line_end);
 
@@ -125,9 +118,7 @@ void EditorCopyPaste::pasteText()
 	gAITab.cancel_request();
 	gAITab.dismiss_completion();
 
-	// Save the state before making any changes
-	std::string beforeContent = editor_state.fileContent;
-	int beforeCursor = editor_state.cursor_index;
+	gFileExplorer.forceCommitUndoState(); // A paste is a step of its own
 
 	const char *clipboard_text = ImGui::GetClipboardText();
 	if (clipboard_text != nullptr)
@@ -157,7 +148,7 @@ void EditorCopyPaste::pasteText()
 			{
 				int start = getSelectionStart();
 				int end = getSelectionEnd();
-				editor_state.fileContent.replace(start, end - start, paste_content);
+				gEditor.replaceText(start, end - start, paste_content);
 				editor_state.fileColors.erase(editor_state.fileColors.begin() + start,
 											  editor_state.fileColors.begin() + end);
 				editor_state.fileColors.insert(editor_state.fileColors.begin() + start,
@@ -167,7 +158,7 @@ void EditorCopyPaste::pasteText()
 				paste_end = start + paste_content.size();
 			} else
 			{
-				editor_state.fileContent.insert(editor_state.cursor_index, paste_content);
+				gEditor.insertText(editor_state.cursor_index, paste_content);
 				editor_state.fileColors.insert(editor_state.fileColors.begin() +
 												   editor_state.cursor_index,
 											   paste_content.size(),
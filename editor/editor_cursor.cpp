@@ -1,8 +1,10 @@
 #include "editor_cursor.h"
 #include "../files/files.h"
 #include "../lib/utfcpp/source/utf8.h"
+#include "../util/redraw.h"
 #include "../util/settings.h"
 #include "editor.h"
+#include "editor_display_map.h"
 #include "editor/utf8_utils.h"
 #include "editor_utils.h"
 #include <algorithm>
@@ -104,19 +106,19 @@ void EditorCursor::renderCursor()
 	// (ImGui::IsWindowFocused(ImGuiFocusedFlags_RootAndChildWindows))
 	{
 		// Main cursor calculations
-		int main_cursor_line = gEditor.getLineFromPos(editor_state.cursor_index);
-		float main_cursor_x = getCursorXPosition(editor_state.text_pos,
-												 editor_state.fileContent,
-												 editor_state.cursor_index);
-
-		ImVec2 main_cursor_start = editor_state.text_pos;
-		main_cursor_start.x = main_cursor_x;
-		main_cursor_start.y += main_cursor_line * editor_state.line_height;
+		ImVec2 main_cursor_start = cursorScreenPosition(editor_state.cursor_index);
 		ImVec2 main_cursor_end(main_cursor_start.x,
 							   main_cursor_start.y + editor_state.line_height - 1);
 
-		// Color calculations
-		float blink_alpha = (sinf(editor_state.cursor_blink_time * 4.0f) + 1.0f) * 0.5f;
+		// Color calculations. Blinking and rainbow cycling keep frames coming, so
+		// after a while without input the cursor settles on a solid color and the
+		// editor goes idle.
+		float blink_alpha = 1.0f;
+		if (gRedraw.secondsSinceInput() < Redraw::IDLE_ANIMATION_SECONDS)
+		{
+			blink_alpha = (sinf(editor_state.cursor_blink_time * 4.0f) + 1.0f) * 0.5f;
+			gRedraw.requestIn(Redraw::ANIMATION_INTERVAL);
+		}
 
 		// Main cursor color (red if multiple, else normal)
 		ImU32 main_color =
@@ -139,14 +141,7 @@ void EditorCursor::renderCursor()
 		// Render multi-cursors
 		for (int cursor_idx : editor_state.multi_cursor_indices)
 		{
-			int cursor_line = gEditor.getLineFromPos(cursor_idx);
-			float cursor_x = getCursorXPosition(editor_state.text_pos,
-												editor_state.fileContent,
-												cursor_idx);
-
-			ImVec2 cursor_start = editor_state.text_pos;
-			cursor_start.x = cursor_x;
-			cursor_start.y += cursor_line * editor_state.line_height;
+			ImVec2 cursor_start = cursorScreenPosition(cursor_idx);
 			ImVec2 cursor_end(cursor_start.x,
 							  cursor_start.y + editor_state.line_height - 1);
 
@@ -155,6 +150,22 @@ void EditorCursor::renderCursor()
 	}
 }
 
+ImVec2 EditorCursor::cursorScreenPosition(int cursor_pos)
+{
+	ImVec2 pos = editor_state.text_pos;
+	if (gEditorDisplayMap.isWrapping())
+	{
+		pos.x += gEditorDisplayMap.xOfIndex(cursor_pos);
+		pos.y += gEditorDisplayMap.rowOfIndex(cursor_pos) * editor_state.line_height;
+		return pos;
+	}
+
+	pos.x =
+		getCursorXPosition(editor_state.text_pos, editor_state.fileContent, cursor_pos);
+	pos.y += gEditorDisplayMap.rowOfIndex(cursor_pos) * editor_state.line_height;
+	return pos;
+}
+
 // Cursor time management
 void EditorCursor::updateBlinkTime()
 {
@@ -281,6 +292,12 @@ void EditorCursor::cursorRight()
 
 void EditorCursor::cursorUp()
 {
+	if (gEditorDisplayMap.isActive())
+	{
+		moveCursorsByRow(-1);
+		return;
+	}
+
 	// --- Main Cursor ---
 	int main_current_line_num =
 		EditorUtils::GetLineFromPosition(editor_state.editor_content_lines,
@@ -362,17 +379,16 @@ void EditorCursor::cursorUp()
 		editor_state.multi_cursor_indices[i] =
 			snapToUtf8CharBoundary(editor_state.fileContent,
 								   editor_state.multi_cursor_indices[i]);
-
-	// Update undo manager's pendingFinalCursor for first edit logic
-	if (gFileExplorer.currentUndoManager)
-	{
-		gFileExplorer.currentUndoManager->updatePendingFinalCursor(
-			editor_state.cursor_index);
-	}
 }
 
 void EditorCursor::cursorDown()
 {
+	if (gEditorDisplayMap.isActive())
+	{
+		moveCursorsByRow(1);
+		return;
+	}
+
 	// --- Main Cursor ---
 	int main_current_line_num =
 		EditorUtils::GetLineFromPosition(editor_state.editor_content_lines,
@@ -446,12 +462,36 @@ void EditorCursor::cursorDown()
 		editor_state.multi_cursor_indices[i] =
 			snapToUtf8CharBoundary(editor_state.fileContent,
 								   editor_state.multi_cursor_indices[i]);
+}
 
-	// Update undo manager's pendingFinalCursor for first edit logic
-	if (gFileExplorer.currentUndoManager)
+// Soft wrap and folds move between visual rows, keeping the horizontal offset
+void EditorCursor::moveCursorsByRow(int row_delta)
+{
+	const int row_count = gEditorDisplayMap.rowCount();
+	auto moveByRow = [&](int cursor_pos) {
+		int target_row = gEditorDisplayMap.rowOfIndex(cursor_pos) + row_delta;
+		if (target_row < 0 || target_row >= row_count)
+		{
+			return cursor_pos;
+		}
+		float x = gEditorDisplayMap.xOfIndex(cursor_pos);
+		return gEditorDisplayMap.indexAt(target_row, x);
+	};
+
+	int new_index = moveByRow(editor_state.cursor_index);
+	if (new_index != editor_state.cursor_index)
 	{
-		gFileExplorer.currentUndoManager->updatePendingFinalCursor(
-			editor_state.cursor_index);
+		editor_state.cursor_index = new_index;
+		ImVec2 currentPos = gEditorScroll.getScrollPosition();
+		gEditorScroll.setScrollPosition(ImVec2(
+			currentPos.x,
+			std::max(0.0f, currentPos.y + row_delta * editor_state.line_height)));
+	}
+
+	for (size_t i = 0; i < editor_state.multi_cursor_indices.size(); ++i)
+	{
+		editor_state.multi_cursor_indices[i] =
+			moveByRow(editor_state.multi_cursor_indices[i]);
 	}
 }
 
@@ -703,9 +743,7 @@ void EditorCursor::moveWordBackward(const std::string &text)
 
 float EditorCursor::getCursorYPosition(float line_height)
 {
-	int cursor_line = EditorUtils::GetLineFromPosition(editor_state.editor_content_lines,
-													   editor_state.cursor_index);
-	return cursor_line * line_height;
+	return gEditorDisplayMap.rowOfIndex(editor_state.cursor_index) * line_height;
 }
 
 float EditorCursor::getCursorXPosition(const ImVec2 &text_pos,
@@ -728,7 +766,7 @@ float EditorCursor::getCursorXPosition(const ImVec2 &text_pos,
 				continue;
 			}
 
-			// Handle UTF-8 characters properly (same logic as renderCharacterAndSelection)
+			// Handle UTF-8 characters properly (same logic as EditorRender::characterAdvance)
 			const char *char_start = &text[i];
 			const char *char_end = (i + 1 < text.size()) ? &text[i + 1] : nullptr;
 
@@ -869,7 +907,7 @@ void EditorCursor::swapLines(int direction)
 								: editor_state.fileContent.size();
 
 		// Delete original line
-		editor_state.fileContent.erase(line_start, line_end - line_start);
+		gEditor.eraseText(line_start, line_end - line_start);
 		editor_state.fileColors.erase(editor_state.fileColors.begin() + line_start,
 									  editor_state.fileColors.begin() + line_end);
 
@@ -878,7 +916,7 @@ void EditorCursor::swapLines(int direction)
 			insert_pos -= (line_end - line_start);
 
 		// Insert below next line
-		editor_state.fileContent.insert(insert_pos, line_content);
+		gEditor.insertText(insert_pos, line_content);
 		editor_state.fileColors.insert(editor_state.fileColors.begin() + insert_pos,
 									   line_content.size(),
 									   ImVec4(1.0f, 1.0f, 1.0f, 1.0f));
@@ -920,13 +958,13 @@ void EditorCursor::swapLines(int direction)
 		const size_t cursor_offset = editor_state.cursor_index - line_start;
 
 		// Delete original line
-		editor_state.fileContent.erase(line_start, line_end - line_start);
+		gEditor.eraseText(line_start, line_end - line_start);
 		editor_state.fileColors.erase(editor_state.fileColors.begin() + line_start,
 									  editor_state.fileColors.begin() + line_end);
 
 		// Insert above target line
 		const size_t insert_pos = editor_state.editor_content_lines[target_line];
-		editor_state.fileContent.insert(insert_pos, line_content);
+		gEditor.insertText(insert_pos, line_content);
 		editor_state.fileColors.insert(editor_state.fileColors.begin() + insert_pos,
 									   line_content.size(),
 									   ImVec4(1.0f, 1.0f, 1.0f, 1.0f));
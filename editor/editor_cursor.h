@@ -55,6 +55,9 @@ class EditorCursor
 	float
 	getCursorXPosition(const ImVec2 &text_pos, const std::string &text, int cursor_pos);
 
+	// Top-left of the cursor at cursor_pos in screen space, on its visual row
+	ImVec2 cursorScreenPosition(int cursor_pos);
+
 	void updateBlinkTime();
 
 	void renderCursor();
@@ -68,6 +71,7 @@ class EditorCursor
 
   private:
 	void findPositionFromVisualColumn(int line_start, int line_end);
+	void moveCursorsByRow(int row_delta);
 
 	static bool isWordChar(char c)
 	{
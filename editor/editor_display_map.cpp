@@ -0,0 +1,491 @@
+/*
+	File: editor_display_map.cpp
+	Description: Maps logical lines to visual rows for soft wrap and folding.
+*/
+
+#include "editor_display_map.h"
+#include "editor.h"
+#include "editor_render.h"
+
+#include "../util/redraw.h"
+#include "../util/settings.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Global instance
+EditorDisplayMap gEditorDisplayMap;
+
+void EditorDisplayMap::sync(float width)
+{
+	const bool wrap = gSettings.getSnapshot()->softWrap;
+	if (!wrap && hidden_ranges.empty())
+	{
+		if (active)
+		{
+			active = false;
+			wrapping = false;
+			lines.clear();
+			fenwick.clear();
+			total_rows = 0;
+		}
+		return;
+	}
+
+	// Never wrap narrower than a few characters, even in a collapsed pane
+	width = std::max(width, ImGui::GetFontSize() * 4.0f);
+	ImFont *font = ImGui::GetFont();
+	float font_size = ImGui::GetFontSize();
+	bool layout_changed = wrap && (font != wrap_font || font_size != wrap_font_size ||
+								   std::fabs(width - wrap_width) >= 1.0f);
+	if (!active || wrap != wrapping || layout_changed ||
+		lines.size() != editor_state.editor_content_lines.size())
+	{
+		active = true;
+		wrapping = wrap;
+		wrap_font = font;
+		wrap_font_size = font_size;
+		wrap_width = width;
+		reset();
+	}
+
+	if (unmeasured_count == 0)
+	{
+		return;
+	}
+
+	// Lines on screen are measured on demand by rowAt; the rest are re-wrapped
+	// here a slice per frame so a resize never stalls on a large file.
+	const double slice_start = Redraw::now();
+	int measured_in_slice = 0;
+	while (unmeasured_count > 0)
+	{
+		if (next_unmeasured >= lines.size())
+		{
+			next_unmeasured = 0;
+		}
+		ensureMeasured(static_cast<int>(next_unmeasured++));
+
+		if (++measured_in_slice % 64 == 0 &&
+			Redraw::now() - slice_start >= REWRAP_SLICE_SECONDS)
+		{
+			break;
+		}
+	}
+
+	if (unmeasured_count > 0)
+	{
+		gRedraw.request(1);
+	}
+}
+
+void EditorDisplayMap::onLinesChanged(int first_line, int old_end_line, int new_end_line)
+{
+	if (!active)
+	{
+		return;
+	}
+
+	int removed = old_end_line - first_line;
+	int added = new_end_line - first_line;
+	if (first_line < 0 || removed < 0 || added < 0 ||
+		lines.size() - removed + added != editor_state.editor_content_lines.size())
+	{
+		// Out of step with the buffer; start over from estimates
+		reset();
+		return;
+	}
+
+	for (int i = first_line; i < old_end_line; ++i)
+	{
+		if (!lines[i].measured)
+		{
+			unmeasured_count--;
+		}
+	}
+
+	// Without wrapping a line is always one row, so nothing is left to measure
+	if (wrapping)
+	{
+		unmeasured_count += added;
+		next_unmeasured = std::min(next_unmeasured, static_cast<size_t>(first_line));
+	}
+
+	// Edits that keep the line count only touch their own tree nodes. Folding
+	// re-applies hidden lines after edits, so the flags are kept only here.
+	if (removed == added)
+	{
+		for (int i = first_line; i < new_end_line; ++i)
+		{
+			LineWrap wrap;
+			wrap.hidden = lines[i].hidden;
+			wrap.measured = !wrapping;
+			wrap.rows = visibleRows(wrap.hidden, wrapping ? estimateRows(i) : 1);
+			addRows(i, wrap.rows - lines[i].rows);
+			lines[i] = std::move(wrap);
+		}
+		return;
+	}
+
+	lines.erase(lines.begin() + first_line, lines.begin() + old_end_line);
+	lines.insert(lines.begin() + first_line, added, LineWrap{});
+	for (int i = first_line; i < new_end_line; ++i)
+	{
+		lines[i].measured = !wrapping;
+		lines[i].rows = wrapping ? estimateRows(i) : 1;
+	}
+	rebuildFenwick();
+}
+
+void EditorDisplayMap::setHiddenLines(const std::vector<std::pair<int, int>> &ranges)
+{
+	if (ranges == hidden_ranges)
+	{
+		return;
+	}
+	hidden_ranges = ranges;
+
+	// An inactive map picks the ranges up when sync() activates it
+	if (active)
+	{
+		applyHiddenLines();
+	}
+}
+
+void EditorDisplayMap::applyHiddenLines()
+{
+	auto range = hidden_ranges.begin();
+	for (int i = 0; i < static_cast<int>(lines.size()); ++i)
+	{
+		while (range != hidden_ranges.end() && range->second < i)
+		{
+			++range;
+		}
+		bool hidden = range != hidden_ranges.end() && range->first <= i;
+
+		LineWrap &wrap = lines[i];
+		if (wrap.hidden == hidden)
+		{
+			continue;
+		}
+		wrap.hidden = hidden;
+		int wrapped_rows = 1;
+		if (wrapping)
+		{
+			wrapped_rows = wrap.measured ? static_cast<int>(wrap.breaks.size()) + 1
+										 : estimateRows(i);
+		}
+		int rows = visibleRows(hidden, wrapped_rows);
+		addRows(i, rows - wrap.rows);
+		wrap.rows = rows;
+	}
+}
+
+int EditorDisplayMap::rowCount() const
+{
+	return active ? total_rows
+					: static_cast<int>(editor_state.editor_content_lines.size());
+}
+
+int EditorDisplayMap::rowOfLine(int line) const
+{
+	if (!active)
+	{
+		return line;
+	}
+
+	line = std::clamp(line, 0, static_cast<int>(lines.size()));
+	int row = 0;
+	for (int i = line; i > 0; i -= i & -i)
+	{
+		row += fenwick[i];
+	}
+	return row;
+}
+
+int EditorDisplayMap::lineAtRow(int row) const
+{
+	const int line_count = static_cast<int>(editor_state.editor_content_lines.size());
+	if (!active)
+	{
+		return std::clamp(row, 0, std::max(line_count - 1, 0));
+	}
+	if (lines.empty())
+	{
+		return 0;
+	}
+
+	// Walk down the tree for the last line whose preceding rows are <= row
+	const int n = static_cast<int>(lines.size());
+	int step = 1;
+	while (step * 2 <= n)
+	{
+		step *= 2;
+	}
+
+	int line = 0;
+	int remaining = std::max(row, 0);
+	for (; step > 0; step /= 2)
+	{
+		if (line + step <= n && fenwick[line + step] <= remaining)
+		{
+			line += step;
+			remaining -= fenwick[line];
+		}
+	}
+	return std::min(line, n - 1);
+}
+
+int EditorDisplayMap::rowsInLine(int line)
+{
+	if (!active || line < 0 || line >= static_cast<int>(lines.size()))
+	{
+		return 1;
+	}
+	ensureMeasured(line);
+	return lines[line].rows;
+}
+
+EditorDisplayMap::Row EditorDisplayMap::rowAt(int row)
+{
+	int line = lineAtRow(row);
+	if (active)
+	{
+		// Measuring a line can change how many rows precede `row`, so settle
+		// the lookup before reading the break offsets.
+		while (!lines[line].measured)
+		{
+			ensureMeasured(line);
+			line = lineAtRow(row);
+		}
+	}
+
+	int line_start = 0;
+	int line_end = 0;
+	lineBounds(line, line_start, line_end);
+	if (!active)
+	{
+		return Row{line, line_start, line_end};
+	}
+
+	const std::vector<int> &breaks = lines[line].breaks;
+	int sub_row = std::clamp(row - rowOfLine(line), 0, static_cast<int>(breaks.size()));
+	int start = line_start + (sub_row == 0 ? 0 : breaks[sub_row - 1]);
+	int end = sub_row < static_cast<int>(breaks.size()) ? line_start + breaks[sub_row]
+														: line_end;
+	return Row{line, start, end};
+}
+
+int EditorDisplayMap::rowOfIndex(int char_index)
+{
+	int line = std::max(gEditor.getLineFromPos(char_index), 0);
+	if (!active)
+	{
+		return line;
+	}
+
+	ensureMeasured(line);
+	const std::vector<int> &breaks = lines[line].breaks;
+	int offset = char_index - editor_state.editor_content_lines[line];
+	auto next_break = std::upper_bound(breaks.begin(), breaks.end(), offset);
+	int sub_row = static_cast<int>(next_break - breaks.begin());
+	return rowOfLine(line) + sub_row;
+}
+
+float EditorDisplayMap::xOfIndex(int char_index)
+{
+	Row row = rowAt(rowOfIndex(char_index));
+	const std::string &content = editor_state.fileContent;
+	const int limit = std::min(char_index, row.end);
+
+	float x = 0.0f;
+	for (int i = row.start; i < limit;)
+	{
+		if ((content[i] & 0xC0) == 0x80)
+		{
+			i++;
+			continue;
+		}
+		const char *char_end = nullptr;
+		x += gEditorRender.characterAdvance(i, x, char_end);
+		i = static_cast<int>(char_end - content.data());
+	}
+	return x;
+}
+
+int EditorDisplayMap::indexAt(int row, float x)
+{
+	Row visual_row = rowAt(row);
+	const std::string &content = editor_state.fileContent;
+
+	float column_x = 0.0f;
+	int i = visual_row.start;
+	while (i < visual_row.end && content[i] != '\n')
+	{
+		if ((content[i] & 0xC0) == 0x80)
+		{
+			i++;
+			continue;
+		}
+		const char *char_end = nullptr;
+		float advance = gEditorRender.characterAdvance(i, column_x, char_end);
+		if (x < column_x + advance * 0.5f)
+		{
+			return i;
+		}
+		column_x += advance;
+		i = static_cast<int>(char_end - content.data());
+	}
+
+	// Past the end of a wrapped row: stay before the break, since the break
+	// offset itself is drawn at the start of the next row.
+	if (i > visual_row.start && i >= visual_row.end &&
+		visual_row.end < static_cast<int>(content.size()) &&
+		content[visual_row.end - 1] != '\n')
+	{
+		i = visual_row.end - 1;
+		while (i > visual_row.start && (content[i] & 0xC0) == 0x80)
+		{
+			i--;
+		}
+	}
+	return i;
+}
+
+void EditorDisplayMap::reset()
+{
+	const size_t line_count = editor_state.editor_content_lines.size();
+	lines.assign(line_count, LineWrap{});
+	for (size_t i = 0; i < line_count; ++i)
+	{
+		lines[i].measured = !wrapping;
+		lines[i].rows = wrapping ? estimateRows(static_cast<int>(i)) : 1;
+	}
+	unmeasured_count = wrapping ? static_cast<int>(line_count) : 0;
+	next_unmeasured = 0;
+	rebuildFenwick();
+	applyHiddenLines();
+}
+
+void EditorDisplayMap::rebuildFenwick()
+{
+	const int n = static_cast<int>(lines.size());
+	fenwick.assign(n + 1, 0);
+	total_rows = 0;
+	for (int i = 1; i <= n; ++i)
+	{
+		fenwick[i] += lines[i - 1].rows;
+		total_rows += lines[i - 1].rows;
+		int parent = i + (i & -i);
+		if (parent <= n)
+		{
+			fenwick[parent] += fenwick[i];
+		}
+	}
+}
+
+void EditorDisplayMap::addRows(int line, int delta)
+{
+	if (delta == 0)
+	{
+		return;
+	}
+	const int n = static_cast<int>(lines.size());
+	for (int i = line + 1; i <= n; i += i & -i)
+	{
+		fenwick[i] += delta;
+	}
+	total_rows += delta;
+}
+
+int EditorDisplayMap::estimateRows(int line) const
+{
+	// line_widths is already measured by updateLineStarts; it ignores tab stops
+	// and word boundaries, so it is only good enough until the line is measured.
+	if (line >= static_cast<int>(editor_state.line_widths.size()) || wrap_width <= 0.0f)
+	{
+		return 1;
+	}
+	float width = editor_state.line_widths[line];
+	return std::max(1, static_cast<int>(std::ceil(width / wrap_width)));
+}
+
+void EditorDisplayMap::ensureMeasured(int line)
+{
+	LineWrap &wrap = lines[line];
+	if (wrap.measured)
+	{
+		return;
+	}
+
+	wrap.breaks.clear();
+	// Lines that fit are one row without measuring a single glyph
+	if (wrapping && (line >= static_cast<int>(editor_state.line_widths.size()) ||
+					 editor_state.line_widths[line] > wrap_width))
+	{
+		measureLine(line, wrap.breaks);
+	}
+
+	int rows = visibleRows(wrap.hidden, static_cast<int>(wrap.breaks.size()) + 1);
+	addRows(line, rows - wrap.rows);
+	wrap.rows = rows;
+	wrap.measured = true;
+	unmeasured_count--;
+}
+
+void EditorDisplayMap::measureLine(int line, std::vector<int> &breaks) const
+{
+	const std::string &content = editor_state.fileContent;
+	int line_start = 0;
+	int line_end = 0;
+	lineBounds(line, line_start, line_end);
+
+	int row_start = line_start;
+	int last_space_end = -1; // Where a row may break after whitespace
+	float x = 0.0f;
+	for (int i = line_start; i < line_end && content[i] != '\n';)
+	{
+		if ((content[i] & 0xC0) == 0x80)
+		{
+			i++;
+			continue;
+		}
+
+		const char *char_end = nullptr;
+		float advance = gEditorRender.characterAdvance(i, x, char_end);
+		if (x + advance > wrap_width && i > row_start)
+		{
+			// Prefer breaking after the last whitespace; a single word wider
+			// than the row is split wherever it overflows.
+			int break_at = last_space_end > row_start ? last_space_end : i;
+			breaks.push_back(break_at - line_start);
+			row_start = break_at;
+			last_space_end = -1;
+			x = 0.0f;
+			i = break_at;
+			continue;
+		}
+
+		x += advance;
+		int next = static_cast<int>(char_end - content.data());
+		if (content[i] == ' ' || content[i] == '\t')
+		{
+			last_space_end = next;
+		}
+		i = next;
+	}
+}
+
+void EditorDisplayMap::lineBounds(int line, int &start, int &end) const
+{
+	const std::vector<int> &line_starts = editor_state.editor_content_lines;
+	if (line_starts.empty())
+	{
+		start = end = 0;
+		return;
+	}
+	start = line_starts[line];
+	end = line + 1 < static_cast<int>(line_starts.size())
+			  ? line_starts[line + 1]
+			  : static_cast<int>(editor_state.fileContent.size());
+}
@@ -0,0 +1,100 @@
+/*
+	File: editor_display_map.h
+	Description: Maps logical lines to visual rows. With soft wrap enabled a
+   line can span several rows and lines inside a collapsed fold take none; the
+   per-line row counts live in a Fenwick tree so converting between rows and
+   lines is O(log n) and re-wrapping one line is a single point update.
+
+   Without soft wrap or folds every line is exactly one row and all queries
+   are the identity, so callers can go through the map unconditionally.
+*/
+
+#pragma once
+#include "imgui.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Forward declarations
+class EditorDisplayMap;
+extern EditorDisplayMap gEditorDisplayMap;
+
+class EditorDisplayMap
+{
+  public:
+	// A visual row: the byte range [start, end) of `line` drawn on it
+	struct Row
+	{
+		int line;
+		int start;
+		int end;
+	};
+
+	// Called once per frame with the width available to text. Picks up the
+	// soft wrap setting, invalidates everything on a font or width change and
+	// re-wraps a time-boxed slice of the lines still pending.
+	void sync(float wrap_width);
+
+	// Old lines [first_line, old_end_line) were replaced by new lines
+	// [first_line, new_end_line). Only those lines get re-wrapped.
+	void onLinesChanged(int first_line, int old_end_line, int new_end_line);
+
+	// Lines in the inclusive ranges take no rows. Ranges are sorted and
+	// disjoint; folding recomputes them whenever a fold opens or closes.
+	void setHiddenLines(const std::vector<std::pair<int, int>> &ranges);
+
+	bool isWrapping() const { return wrapping; }
+	// False while every line is one row
+	bool isActive() const { return active; }
+
+	int rowCount() const;
+	int rowOfLine(int line) const;
+	int lineAtRow(int row) const;
+	int rowsInLine(int line);
+
+	Row rowAt(int row);
+	int rowOfIndex(int char_index);
+	// Horizontal offset of a character from the start of its visual row
+	float xOfIndex(int char_index);
+	// Character index closest to `x` on visual row `row`
+	int indexAt(int row, float x);
+
+  private:
+	struct LineWrap
+	{
+		std::vector<int> breaks; // Offsets from the line start where rows 2.. begin
+		int rows = 1;
+		bool measured = false; // False while `rows` is only an estimate
+		bool hidden = false;   // Inside a collapsed fold
+	};
+
+	bool active = false;
+	bool wrapping = false;
+	float wrap_width = 0.0f;
+	ImFont *wrap_font = nullptr;
+	float wrap_font_size = 0.0f;
+
+	std::vector<LineWrap> lines;
+	std::vector<std::pair<int, int>> hidden_ranges;
+	std::vector<int> fenwick; // 1-based tree over the per-line row counts
+	int total_rows = 0;
+	size_t next_unmeasured = 0;
+	int unmeasured_count = 0;
+
+	// Time slice spent per frame re-wrapping lines nobody is looking at
+	static constexpr double REWRAP_SLICE_SECONDS = 0.002;
+
+	void reset();
+	void applyHiddenLines();
+	static int visibleRows(bool hidden, int wrapped_rows)
+	{
+		return hidden ? 0 : wrapped_rows;
+	}
+	void rebuildFenwick();
+	void addRows(int line, int delta);
+	int estimateRows(int line) const;
+	void ensureMeasured(int line);
+	void measureLine(int line, std::vector<int> &breaks) const;
+	void lineBounds(int line, int &start, int &end) const;
+};
@@ -0,0 +1,276 @@
+/*
+	File: editor_folding.cpp
+	Description: Code folding on top of the display map.
+*/
+
+#include "editor_folding.h"
+#include "editor.h"
+#include "editor_display_map.h"
+
+#include "../files/files.h"
+#include "../util/redraw.h"
+
+#include <algorithm>
+
+// Global instance
+EditorFolding gEditorFolding;
+
+void EditorFolding::publishRanges(std::vector<FoldRange> new_ranges,
+								  size_t line_count,
+								  size_t content_size)
+{
+	{
+		std::lock_guard<std::mutex> lock(published_mutex);
+		published_ranges = std::move(new_ranges);
+		published_line_count = line_count;
+		published_content_size = content_size;
+		has_published = true;
+	}
+	gRedraw.request();
+}
+
+void EditorFolding::update()
+{
+	// Folds belong to the file they were made in
+	static std::string last_file;
+	if (last_file != gFileExplorer.currentFile)
+	{
+		last_file = gFileExplorer.currentFile;
+		ranges.clear();
+		collapsed.clear();
+		hidden_dirty = true;
+	}
+
+	bool adopted = false;
+	{
+		std::lock_guard<std::mutex> lock(published_mutex);
+		// Ranges parsed from an older buffer would hide the wrong lines; a newer
+		// parse is already on its way in that case.
+		if (has_published &&
+			published_line_count == editor_state.editor_content_lines.size() &&
+			published_content_size == editor_state.fileContent.size())
+		{
+			ranges.swap(published_ranges);
+			has_published = false;
+			adopted = true;
+		}
+	}
+
+	if (adopted)
+	{
+		// A fold whose region was edited away opens again
+		std::erase_if(collapsed, [this](int line) { return findRange(line) == nullptr; });
+		hidden_dirty = true;
+	}
+
+	// The cursor never rests inside a collapsed fold: search, line jumps and
+	// LSP navigation open the folds around their target
+	revealLine(gEditor.getLineFromPos(editor_state.cursor_index));
+
+	if (hidden_dirty)
+	{
+		pushHiddenLines();
+	}
+}
+
+void EditorFolding::onLinesChanged(int first_line, int old_end_line, int new_end_line)
+{
+	const int delta = new_end_line - old_end_line;
+	if (delta == 0)
+	{
+		return;
+	}
+
+	for (FoldRange &range : ranges)
+	{
+		if (range.start_line >= old_end_line)
+		{
+			range.start_line += delta;
+			range.end_line += delta;
+		} else if (range.end_line >= old_end_line)
+		{
+			range.end_line += delta;
+		}
+	}
+	// Headers inside a shrinking edit can land past the shifted ones
+	std::sort(ranges.begin(), ranges.end(), [](const FoldRange &a, const FoldRange &b) {
+		return a.start_line < b.start_line;
+	});
+
+	for (int &line : collapsed)
+	{
+		if (line >= old_end_line)
+		{
+			line += delta;
+		}
+	}
+	std::sort(collapsed.begin(), collapsed.end());
+	collapsed.erase(std::unique(collapsed.begin(), collapsed.end()), collapsed.end());
+	hidden_dirty = hidden_dirty || !collapsed.empty();
+}
+
+void EditorFolding::toggleFoldAtLine(int line)
+{
+	auto it = std::lower_bound(collapsed.begin(), collapsed.end(), line);
+	if (it != collapsed.end() && *it == line)
+	{
+		collapsed.erase(it);
+	} else
+	{
+		const FoldRange *range = findRange(line);
+		if (!range)
+		{
+			range = innermostRangeContaining(line);
+		}
+		if (!range)
+		{
+			return;
+		}
+
+		it = std::lower_bound(collapsed.begin(), collapsed.end(), range->start_line);
+		if (it == collapsed.end() || *it != range->start_line)
+		{
+			collapsed.insert(it, range->start_line);
+		}
+
+		// Park the cursor on the header so update() does not reopen the fold
+		int cursor_line = gEditor.getLineFromPos(editor_state.cursor_index);
+		if (cursor_line > range->start_line && cursor_line <= range->end_line)
+		{
+			editor_state.cursor_index =
+				editor_state.editor_content_lines[range->start_line + 1] - 1;
+			editor_state.selection_active = false;
+		}
+	}
+
+	hidden_dirty = true;
+	gRedraw.request();
+}
+
+void EditorFolding::unfoldAll()
+{
+	if (collapsed.empty())
+	{
+		return;
+	}
+	collapsed.clear();
+	hidden_dirty = true;
+	gRedraw.request();
+}
+
+bool EditorFolding::isCollapsed(int line) const
+{
+	return std::binary_search(collapsed.begin(), collapsed.end(), line);
+}
+
+void EditorFolding::renderFoldMarker(int line, const ImVec2 &pos)
+{
+	if (markers_frame != ImGui::GetFrameCount())
+	{
+		markers.clear();
+		markers_frame = ImGui::GetFrameCount();
+	}
+
+	const char *label = "...";
+	ImVec2 text_size = ImGui::CalcTextSize(label);
+	ImVec2 min(pos.x + ImGui::GetFontSize() * 0.5f, pos.y + 1.0f);
+	ImVec2 max(min.x + text_size.x + 8.0f, pos.y + editor_state.line_height - 1.0f);
+
+	ImDrawList *draw_list = ImGui::GetWindowDrawList();
+	draw_list->AddRectFilled(min, max, ImGui::GetColorU32(ImGuiCol_FrameBg), 3.0f);
+	draw_list->AddText(ImVec2(min.x + 4.0f, pos.y),
+					   ImGui::GetColorU32(ImGuiCol_TextDisabled),
+					   label);
+
+	markers.push_back(FoldMarker{line, min, max});
+}
+
+bool EditorFolding::handleMarkerClick(const ImVec2 &mouse_pos)
+{
+	// Input runs before rendering, so the markers to hit are last frame's
+	if (markers_frame < ImGui::GetFrameCount() - 1)
+	{
+		return false;
+	}
+
+	for (const FoldMarker &marker : markers)
+	{
+		if (mouse_pos.x >= marker.min.x && mouse_pos.x <= marker.max.x &&
+			mouse_pos.y >= marker.min.y && mouse_pos.y <= marker.max.y)
+		{
+			toggleFoldAtLine(marker.line);
+			return true;
+		}
+	}
+	return false;
+}
+
+const FoldRange *EditorFolding::findRange(int start_line) const
+{
+	auto it = std::lower_bound(
+		ranges.begin(), ranges.end(), start_line, [](const FoldRange &range, int line) {
+			return range.start_line < line;
+		});
+	return it != ranges.end() && it->start_line == start_line ? &*it : nullptr;
+}
+
+const FoldRange *EditorFolding::innermostRangeContaining(int line) const
+{
+	// Nested folds start later than the folds around them, so the first hit
+	// walking back from `line` is the innermost one
+	auto it = std::upper_bound(
+		ranges.begin(), ranges.end(), line, [](int line, const FoldRange &range) {
+			return line < range.start_line;
+		});
+	while (it != ranges.begin())
+	{
+		--it;
+		if (it->end_line >= line)
+		{
+			return &*it;
+		}
+	}
+	return nullptr;
+}
+
+void EditorFolding::revealLine(int line)
+{
+	bool revealed = false;
+	for (auto it = collapsed.begin(); it != collapsed.end();)
+	{
+		const FoldRange *range = findRange(*it);
+		if (range && line > range->start_line && line <= range->end_line)
+		{
+			it = collapsed.erase(it);
+			revealed = true;
+		} else
+		{
+			++it;
+		}
+	}
+	hidden_dirty = hidden_dirty || revealed;
+}
+
+void EditorFolding::pushHiddenLines()
+{
+	// Nested collapsed folds merge into their parent's range
+	std::vector<std::pair<int, int>> hidden;
+	for (int line : collapsed)
+	{
+		const FoldRange *range = findRange(line);
+		if (!range)
+		{
+			continue;
+		}
+		if (!hidden.empty() && range->start_line <= hidden.back().second)
+		{
+			hidden.back().second = std::max(hidden.back().second, range->end_line);
+		} else
+		{
+			hidden.emplace_back(range->start_line + 1, range->end_line);
+		}
+	}
+
+	gEditorDisplayMap.setHiddenLines(hidden);
+	hidden_dirty = false;
+}
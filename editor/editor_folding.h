@@ -0,0 +1,80 @@
+/*
+	File: editor_folding.h
+	Description: Code folding. Fold ranges come from the per-language fold
+   queries in editor/queries/folds, evaluated by TreeSitter on the highlight
+   thread. The editor keeps which folds are collapsed and hands the hidden
+   lines to the display map, so rendering, scrolling, the gutter and hit-testing
+   skip them without knowing about folds.
+*/
+
+#pragma once
+#include "imgui.h"
+
+#include <mutex>
+#include <vector>
+
+// A foldable region: start_line stays visible as the fold header, lines
+// (start_line, end_line] are hidden while it is collapsed.
+struct FoldRange
+{
+	int start_line;
+	int end_line;
+
+	bool operator==(const FoldRange &other) const
+	{
+		return start_line == other.start_line && end_line == other.end_line;
+	}
+};
+
+// Forward declarations
+class EditorFolding;
+extern EditorFolding gEditorFolding;
+
+class EditorFolding
+{
+  public:
+	// Highlight thread: fold ranges for a buffer of `line_count` lines and
+	// `content_size` bytes. Picked up by update() if they still match the buffer.
+	void publishRanges(std::vector<FoldRange> ranges,
+					   size_t line_count,
+					   size_t content_size);
+
+	// Main thread, once per frame before the display map syncs
+	void update();
+
+	// Keeps collapsed folds attached to their header lines across edits
+	void onLinesChanged(int first_line, int old_end_line, int new_end_line);
+
+	void toggleFoldAtLine(int line);
+	void unfoldAll();
+	bool isCollapsed(int line) const;
+
+	// Placeholder drawn after a collapsed header; clicking it opens the fold
+	void renderFoldMarker(int line, const ImVec2 &pos);
+	bool handleMarkerClick(const ImVec2 &mouse_pos);
+
+  private:
+	std::mutex published_mutex;
+	std::vector<FoldRange> published_ranges;
+	size_t published_line_count = 0;
+	size_t published_content_size = 0;
+	bool has_published = false;
+
+	std::vector<FoldRange> ranges; // Sorted by start_line
+	std::vector<int> collapsed;	   // Sorted header lines of collapsed folds
+	bool hidden_dirty = false;
+
+	struct FoldMarker
+	{
+		int line;
+		ImVec2 min;
+		ImVec2 max;
+	};
+	std::vector<FoldMarker> markers; // Drawn this frame
+	int markers_frame = -1;
+
+	const FoldRange *findRange(int start_line) const;
+	const FoldRange *innermostRangeContaining(int line) const;
+	void revealLine(int line);
+	void pushHiddenLines();
+};
@@ -1,5 +1,6 @@
 #include "editor_git.h"
 #include "../files/files.h"
+#include "../util/redraw.h"
 #include <array>
 #include <atomic>
 #include <chrono>
@@ -66,11 +67,13 @@ void EditorGit::gitEditedLines()
 	if (!fileChanges.empty())
 	{
 		editedLines = fileChanges;
+		editedLinesVersion++;
 	}
 	// If fileChanges is empty but we have no existing data, then clear it
 	else if (editedLines.empty())
 	{
 		editedLines = fileChanges; // This will be empty, but that's correct for first run
+		editedLinesVersion++;
 	}
 	// If fileChanges is empty but we have existing data, keep the existing data
 	// This prevents the flicker when saving files
@@ -109,18 +112,27 @@ void EditorGit::backgroundTask()
 				// Get current file changes and stats in single operation (FAST)
 				auto currentFileData = gitWrapper.getCurrentFileData(relativePath);
 
-				// Always update the actual data (clears old data when file becomes clean)
-				editedLines[relativePath] = currentFileData.editedLines;
-
+				std::string newGitChanges;
 				if (currentFileData.stats.additions > 0 ||
 					currentFileData.stats.deletions > 0)
 				{
-					currentGitChanges =
+					newGitChanges =
 						"+" + std::to_string(currentFileData.stats.additions) + "-" +
 						std::to_string(currentFileData.stats.deletions);
-				} else
+				}
+
+				// Only a real change in the gutter/header needs a frame
+				bool changed = editedLines[relativePath] != currentFileData.editedLines ||
+							   currentGitChanges != newGitChanges;
+
+				// Always update the actual data (clears old data when file becomes clean)
+				editedLines[relativePath] = currentFileData.editedLines;
+				currentGitChanges = newGitChanges;
+
+				if (changed)
 				{
-					currentGitChanges = "";
+					editedLinesVersion++;
+					gRedraw.request();
 				}
 			}
 
@@ -154,6 +166,7 @@ void EditorGit::init()
 		std::cout << "[GIT TIMING] Initial scan on startup" << std::endl;
 		auto initialData = gitWrapper.getAllGitData();
 		editedLines = initialData.editedLines;
+		editedLinesVersion++;
 
 		backgroundThread = std::thread(&EditorGit::backgroundTask, this);
 	}
@@ -178,6 +191,47 @@ bool EditorGit::isLineEdited(const std::string &filePath, int lineNumber) const
 	return false;
 }
 
+const std::vector<uint8_t> &EditorGit::getEditedLineMask(const std::string &filePath)
+{
+	uint64_t version = editedLinesVersion.load();
+	if (version == editedLineMaskVersion && filePath == editedLineMaskPath)
+	{
+		return editedLineMask;
+	}
+	editedLineMaskVersion = version;
+	editedLineMaskPath = filePath;
+	editedLineMask.clear();
+
+	std::string relativePath = filePath;
+	if (filePath.find(gFileExplorer.selectedFolder) == 0)
+	{
+		size_t folderLength = gFileExplorer.selectedFolder.length();
+		if (folderLength < filePath.length())
+		{
+			relativePath = filePath.substr(folderLength + 1);
+		}
+	}
+	auto it = editedLines.find(relativePath);
+	if (it == editedLines.end())
+	{
+		return editedLineMask;
+	}
+
+	for (int lineNumber : it->second)
+	{
+		if (lineNumber < 1)
+		{
+			continue;
+		}
+		if (static_cast<size_t>(lineNumber) > editedLineMask.size())
+		{
+			editedLineMask.resize(lineNumber, 0);
+		}
+		editedLineMask[lineNumber - 1] = 1;
+	}
+	return editedLineMask;
+}
+
 std::string EditorGit::gitPlusMinus(const std::string &filePath)
 {
 	if (!git_enabled || gFileExplorer.selectedFolder.empty())
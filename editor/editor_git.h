@@ -2,6 +2,7 @@
 #include "git_libgit2.h"
 #include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <map>
 #include <mutex>
 #include <set>
@@ -28,6 +29,10 @@ class EditorGit
 	float getLineAnimationAlpha(const std::string &filePath,
 								int lineNumber) const; // Get animation alpha for line
 
+	// Per-line edited flags for the gutter (index = 0-based line). Rebuilt only
+	// when the git data or the requested file changes. Main thread only.
+	const std::vector<uint8_t> &getEditedLineMask(const std::string &filePath);
+
 	// Simple function for file tree to get modified file paths
 	std::set<std::string> getModifiedFilePaths();
 
@@ -45,6 +50,12 @@ class EditorGit
 	void cleanupCompletedAnimations();
 
 	std::atomic<bool> git_enabled{false};
+	std::atomic<uint64_t> editedLinesVersion{0}; // Bumped whenever editedLines changes
+
+	// Cached result of getEditedLineMask
+	std::vector<uint8_t> editedLineMask;
+	std::string editedLineMaskPath;
+	uint64_t editedLineMaskVersion = 0;
 	std::atomic<bool> immediateUpdateRequested{false};
 	std::thread backgroundThread;
 	std::chrono::steady_clock::time_point lastUpdate;
@@ -185,8 +185,8 @@ void EditorHeader::renderSettingsIcon(float iconSize)
 	}
 	bool isHovered = ImGui::IsItemHovered();
 	ImGui::SetCursorPos(cursor_pos);
-	ImTextureID icon = isHovered ? getStatusIcon("gear-hover") : getStatusIcon("gear");
-	ImGui::Image(icon, ImVec2(iconSize, iconSize));
+	IconRef icon = isHovered ? getStatusIcon("gear-hover") : getStatusIcon("gear");
+	ImGui::Image(icon.texture, ImVec2(iconSize, iconSize), icon.uv0, icon.uv1);
 
 	ImGui::PopStyleColor(3);
 	ImGui::PopStyleVar();
@@ -211,20 +211,20 @@ void EditorHeader::renderTerminalIcon(float iconSize)
 	}
 	bool isHovered = ImGui::IsItemHovered();
 	ImGui::SetCursorPos(cursor_pos);
-	ImTextureID icon =
+	IconRef icon =
 		isHovered ? getStatusIcon("terminal-hover") : getStatusIcon("terminal");
-	ImGui::Image(icon, ImVec2(iconSize, iconSize));
+	ImGui::Image(icon.texture, ImVec2(iconSize, iconSize), icon.uv0, icon.uv1);
 
 	ImGui::PopStyleColor(3);
 	ImGui::PopStyleVar();
 }
 
-ImTextureID EditorHeader::getFileIcon(const std::string &filename)
+IconRef EditorHeader::getFileIcon(const std::string &filename)
 {
 	return gFileExplorer.getIconForFile(filename);
 }
 
-ImTextureID EditorHeader::getStatusIcon(const std::string &iconName)
+IconRef EditorHeader::getStatusIcon(const std::string &iconName)
 {
 	return gFileExplorer.getIcon(iconName);
 }
@@ -268,7 +268,7 @@ void EditorHeader::render(ImFont *font,
 	} else
 	{
 		// Special case: show shell icon for Terminal
-		ImTextureID fileIcon;
+		IconRef fileIcon;
 		if (currentFile == "Terminal")
 		{
 			fileIcon = getStatusIcon("sh");
@@ -282,7 +282,8 @@ void EditorHeader::render(ImFont *font,
 			float textHeight = ImGui::GetTextLineHeight();
 			float iconTopY = ImGui::GetCursorPosY() + (textHeight - iconSize) * 0.5f;
 			ImGui::SetCursorPosY(iconTopY);
-			ImGui::Image(fileIcon, ImVec2(iconSize, iconSize));
+			ImGui::Image(
+				fileIcon.texture, ImVec2(iconSize, iconSize), fileIcon.uv0, fileIcon.uv1);
 			ImGui::SameLine();
 		}
 
@@ -341,7 +342,8 @@ void EditorHeader::render(ImFont *font,
 		// Brain icon (only visible when active)
 		if (gAITab.request_active)
 		{
-			ImGui::Image(getStatusIcon("green-dot"), ImVec2(iconSize, iconSize));
+			IconRef dot = getStatusIcon("green-dot");
+			ImGui::Image(dot.texture, ImVec2(iconSize, iconSize), dot.uv0, dot.uv1);
 		} else
 		{
 			// Invisible placeholder to maintain layout
@@ -5,6 +5,7 @@ Description: Editor header rendering class for NED text editor.
 
 #pragma once
 
+#include "../files/icon_atlas.h"
 #include "imgui.h"
 #include <filesystem>
 #include <string>
@@ -33,8 +34,8 @@ class EditorHeader
 	void renderTerminalIcon(float iconSize);
 
 	// Helper function to get file icon
-	ImTextureID getFileIcon(const std::string &filename);
+	IconRef getFileIcon(const std::string &filename);
 
 	// Helper function to get status icons
-	ImTextureID getStatusIcon(const std::string &iconName);
+	IconRef getStatusIcon(const std::string &iconName);
 };
\ No newline at end of file
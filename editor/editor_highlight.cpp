@@ -1,5 +1,7 @@
 #include "../files/files.h"
+#include "../util/redraw.h"
 #include "editor.h"
+#include "editor_minimap.h"
 #include "editor_tree_sitter.h"
 #include <algorithm>
 #include <filesystem>
@@ -40,6 +42,45 @@ void EditorHighlight::forceColorUpdate()
 	}
 }
 
+void EditorHighlight::invalidateMinimap(const std::string &content,
+										const std::vector<ImVec4> &before,
+										const std::vector<ImVec4> &after)
+{
+	auto same = [](const ImVec4 &a, const ImVec4 &b) {
+		return a.x == b.x && a.y == b.y && a.z == b.z && a.w == b.w;
+	};
+
+	// Byte range whose color changed; the lexers redo the whole file, but an
+	// edit rarely recolors more than the lines around it
+	size_t first = 0;
+	size_t end = after.size();
+	if (before.size() == after.size())
+	{
+		while (first < end && same(before[first], after[first]))
+		{
+			++first;
+		}
+		while (end > first && same(before[end - 1], after[end - 1]))
+		{
+			--end;
+		}
+	}
+	if (first == end)
+	{
+		return;
+	}
+
+	end = std::min(end, content.size());
+	first = std::min(first, end);
+	auto lines = [&](size_t from, size_t to) {
+		return static_cast<int>(
+			std::count(content.begin() + from, content.begin() + to, '\n'));
+	};
+	int first_line = lines(0, first);
+	int end_line = first_line + lines(first, end) + 1;
+	gEditorMinimap.invalidateLines(first_line, end_line, content.size());
+}
+
 bool EditorHighlight::validateHighlightContentParams()
 {
 	if (editor_state.fileContent.empty())
@@ -162,6 +203,7 @@ void EditorHighlight::highlightContent(bool fullRehighlight, bool sync)
 		// Synchronous highlighting - perform immediately
 		std::lock_guard<std::mutex> state_lock(editor_state.colorsMutex);
 		performHighlighting(editor_state.fileColors);
+		invalidateMinimap(content_copy, colors_param_copy, editor_state.fileColors);
 	} else
 	{
 		// Asynchronous highlighting - use existing async logic
@@ -190,7 +232,10 @@ void EditorHighlight::highlightContent(bool fullRehighlight, bool sync)
 					currentFile_copy == gFileExplorer.currentFile &&
 					content_copy == editor_state.fileContent)
 				{
+					invalidateMinimap(
+						content_copy, editor_state.fileColors, current_colors);
 					editor_state.fileColors = current_colors;
+					gRedraw.request();
 				}
 				highlightingInProgress = false;
 			});
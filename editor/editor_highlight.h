@@ -37,6 +37,12 @@ class EditorHighlight
 	void setTheme(const std::string &themeName);
 
   private:
+	// Tells the minimap which lines of `content` changed color from `before`
+	// to `after`
+	static void invalidateMinimap(const std::string &content,
+								  const std::vector<ImVec4> &before,
+								  const std::vector<ImVec4> &after);
+
 	// Lexer instances
 	PythonLexer::Lexer pythonLexer;
 	CppLexer::Lexer cppLexer;
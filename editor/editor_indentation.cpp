@@ -105,7 +105,7 @@ void EditorIndentation::handleMultiLineIndentation()
 	newText.append(editor_state.fileContent.substr(lastLineEnd));
 
 	// Update text
-	editor_state.fileContent = std::move(newText);
+	gEditor.replaceContent(std::move(newText));
 
 	// Update selection and cursor positions
 	if (editor_state.selection_start < editor_state.selection_end)
@@ -145,7 +145,7 @@ void EditorIndentation::handleSingleLineIndentation()
 		unique_cursor_positions.insert(mc_idx);
 	}
 
-	const char TAB_CHAR = '\t';
+	const char TAB_CHAR[] = "\t";
 	const size_t INSERT_LEN = 1;
 
 	int cumulative_offset = 0;
@@ -160,7 +160,7 @@ void EditorIndentation::handleSingleLineIndentation()
 					 std::min(actual_insert_pos,
 							  static_cast<int>(editor_state.fileContent.length())));
 
-		editor_state.fileContent.insert(actual_insert_pos, 1, TAB_CHAR);
+		gEditor.insertText(actual_insert_pos, TAB_CHAR);
 
 		// Get the proper default text color from the theme
 		TreeSitter::updateThemeColors();
@@ -289,7 +289,7 @@ void EditorIndentation::removeIndentation()
 	newText.append(editor_state.fileContent.substr(lastLineEnd));
 
 	// Update text
-	editor_state.fileContent = std::move(newText);
+	gEditor.replaceContent(std::move(newText));
 	if (totalSpacesRemoved > 0)
 	{
 		if (editor_state.selection_end > editor_state.selection_start)
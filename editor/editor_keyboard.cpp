@@ -3,6 +3,8 @@
 #include "../editor/editor_git.h"
 #include "../files/file_finder.h"
 #include "../files/files.h"
+#include "../files/symbol_search.h"
+#include "../files/workspace_search.h"
 #ifdef _WIN32
 // Fix for Windows UTF-8 library assert macro conflict
 #include <cassert>
@@ -21,6 +23,7 @@
 #include "editor/utf8_utils.h"
 #include "editor_bookmarks.h"
 #include "editor_copy_paste.h"
+#include "editor_folding.h"
 #include "editor_highlight.h"
 #include "editor_indentation.h"
 #include "editor_line_jump.h"
@@ -180,7 +183,7 @@ void EditorKeyboard::handleBackspaceKey()
 
 			if (length_to_delete > 0)
 			{
-				editor_state.fileContent.erase(effective_start, length_to_delete);
+				gEditor.eraseText(effective_start, length_to_delete);
 
 				if (static_cast<size_t>(effective_start) < editor_state.fileColors.size())
 				{
@@ -359,7 +362,7 @@ void EditorKeyboard::handleCharacterInput()
 
 			if (length_to_delete > 0)
 			{
-				editor_state.fileContent.erase(current_start, length_to_delete);
+				gEditor.eraseText(current_start, length_to_delete);
 				if (static_cast<size_t>(current_start) < editor_state.fileColors.size())
 				{
 					editor_state.fileColors.erase(
@@ -405,7 +408,7 @@ void EditorKeyboard::handleCharacterInput()
 					 std::min(actual_insert_pos,
 							  static_cast<int>(editor_state.fileContent.size())));
 
-		editor_state.fileContent.insert(actual_insert_pos, inputText);
+		gEditor.insertText(actual_insert_pos, inputText);
 
 		// Get the proper default text color from the theme
 		TreeSitter::updateThemeColors();
@@ -629,7 +632,7 @@ void EditorKeyboard::handleEnterKey()
 			if (length_to_delete > 0)
 			{
 				text_changed_by_deletion = true;
-				editor_state.fileContent.erase(effective_start, length_to_delete);
+				gEditor.eraseText(effective_start, length_to_delete);
 				if (static_cast<size_t>(effective_start) < editor_state.fileColors.size())
 				{
 					editor_state.fileColors.erase(
@@ -688,7 +691,7 @@ void EditorKeyboard::handleEnterKey()
 			std::string to_insert = "\n" + indent_str;
 			size_t insert_length = to_insert.length();
 
-			editor_state.fileContent.insert(actual_insert_pos, to_insert);
+			gEditor.insertText(actual_insert_pos, to_insert);
 
 			ImVec4 default_color =
 				ImVec4(1.0f, 1.0f, 1.0f, 1.0f); // Or your editor's default
@@ -871,7 +874,7 @@ void EditorKeyboard::handleDeleteKey()
 
 			if (length_to_delete > 0)
 			{
-				editor_state.fileContent.erase(effective_start, length_to_delete);
+				gEditor.eraseText(effective_start, length_to_delete);
 
 				if (static_cast<size_t>(effective_start) < editor_state.fileColors.size())
 				{
@@ -950,7 +953,7 @@ void EditorKeyboard::handleTextInput()
 	{
 		int start = editor_state.selection_start;
 		int end = editor_state.selection_end;
-		editor_state.fileContent.erase(start, end - start);
+		gEditor.eraseText(start, end - start);
 		editor_state.fileColors.erase(editor_state.fileColors.begin() + start,
 									  editor_state.fileColors.begin() + end);
 		editor_state.cursor_index = start;
@@ -1012,6 +1015,25 @@ void EditorKeyboard::processSelectAll()
 	}
 }
 
+void EditorKeyboard::processFolding()
+{
+	// fold_toggle folds or unfolds around the cursor; unfold_all is pressed
+	// with shift as well and opens every fold
+	ImGuiKey foldToggle = gKeybinds.getActionKey("fold_toggle");
+	ImGuiKey unfoldAll = gKeybinds.getActionKey("unfold_all");
+	bool shift = ImGui::GetIO().KeyShift;
+	if (shift && ImGui::IsKeyPressed(unfoldAll, false))
+	{
+		gEditorFolding.unfoldAll();
+		editor_state.ensure_cursor_visible.vertical = true;
+	} else if (!shift && ImGui::IsKeyPressed(foldToggle, false))
+	{
+		gEditorFolding.toggleFoldAtLine(
+			gEditor.getLineFromPos(editor_state.cursor_index));
+		editor_state.ensure_cursor_visible.vertical = true;
+	}
+}
+
 // New method implementations for the refactored code
 
 void EditorKeyboard::processTextEditorInput()
@@ -1044,7 +1066,8 @@ void EditorKeyboard::handleEditorKeyboardInput()
 	bool shift_pressed = ImGui::GetIO().KeyShift;
 
 	// block input if searching for file...
-	if (gFileFinder.showFFWindow || gLineJump.showLineJumpWindow)
+	if (gFileFinder.showFFWindow || gLineJump.showLineJumpWindow ||
+		gWorkspaceSearch.showWindow || gSymbolSearch.showWindow)
 	{
 		return;
 	}
@@ -1149,6 +1172,7 @@ void EditorKeyboard::handleEditorKeyboardInput()
 			}
 			processFontSizeAdjustment();
 			processSelectAll();
+			processFolding();
 			gBookmarks.handleBookmarkInput(gFileExplorer);
 			gEditorCursor.processCursorJump(editor_state.fileContent,
 											editor_state.ensure_cursor_visible);
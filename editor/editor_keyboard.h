@@ -23,6 +23,7 @@ class EditorKeyboard
 
 	void processFontSizeAdjustment();
 	void processSelectAll();
+	void processFolding();
 
 	void processTextEditorInput();
 
@@ -2,6 +2,7 @@
 #include "../files/files.h"
 #include "../util/settings.h"
 #include "editor.h"
+#include "editor_display_map.h"
 #include "editor_git.h"
 #include <algorithm>
 #include <cmath>
@@ -14,20 +15,49 @@ void EditorLineNumbers::setCurrentFilePath(const std::string &filepath)
 	current_filepath = filepath;
 }
 
+void EditorLineNumbers::syncGutterFont()
+{
+	ImFont *font = ImGui::GetFont();
+	float font_size = ImGui::GetFontSize();
+	if (font != gutter_font || font_size != gutter_font_size)
+	{
+		gutter_labels.clear();
+		gutter_font = font;
+		gutter_font_size = font_size;
+	}
+}
+
+const EditorLineNumbers::GutterLabel &EditorLineNumbers::getGutterLabel(int line_index)
+{
+	if (static_cast<int>(gutter_labels.size()) <= line_index)
+	{
+		gutter_labels.resize(line_index + 1, GutterLabel{{}, -1, 0.0f});
+	}
+
+	// Format and measure each label the first time its line is shown
+	GutterLabel &label = gutter_labels[line_index];
+	if (label.length < 0)
+	{
+		label.length = snprintf(label.text, sizeof(label.text), "%d", line_index + 1);
+		label.width = ImGui::CalcTextSize(label.text, label.text + label.length).x;
+	}
+	return label;
+}
+
 void EditorLineNumbers::renderLineNumbers()
 {
-	static char line_number_buffer[LINE_NUMBER_BUFFER_SIZE];
 	ImDrawList *draw_list = ImGui::GetWindowDrawList();
+	syncGutterFont();
 
-	// Calculate visible line range
-	int start_line =
+	// Calculate visible row range; with soft wrap a line spans several rows
+	int start_row =
 		static_cast<int>(gEditorScroll.getScrollPosition().y / editor_state.line_height);
-	int end_line = std::min(static_cast<int>(editor_state.editor_content_lines.size()),
-							static_cast<int>(
-								(gEditorScroll.getScrollPosition().y +
-								 (editor_state.size.y - editor_state.editor_top_margin)) /
-								editor_state.line_height) +
-								1);
+	int end_row = std::min(gEditorDisplayMap.rowCount(),
+						   static_cast<int>(
+							   (gEditorScroll.getScrollPosition().y +
+								(editor_state.size.y - editor_state.editor_top_margin)) /
+							   editor_state.line_height) +
+							   1);
 
 	// Pre-calculate rainbow color if needed
 	bool rainbow_mode = gSettings.getRainbowMode();
@@ -47,26 +77,36 @@ void EditorLineNumbers::renderLineNumbers()
 														editor_state.cursor_index);
 
 	// Get text color from theme
-	auto &theme = gSettings.getSettings()["themes"][gSettings.getCurrentTheme()];
-	ImVec4 text_color =
-		ImVec4(theme["text"][0], theme["text"][1], theme["text"][2], theme["text"][3]);
-	ImU32 text_color_u32 = ImGui::ColorConvertFloat4ToU32(text_color);
+	ImU32 text_color_u32 =
+		ImGui::ColorConvertFloat4ToU32(gSettings.getSnapshot()->textColor);
+
+	// Git gutter state for the whole file, rebuilt only when git reports changes
+	const std::vector<uint8_t> &edited_mask =
+		gEditorGit.getEditedLineMask(gFileExplorer.currentFile);
 
-	// Render each visible line number
-	for (int i = start_line; i < end_line; i++)
+	// Numbers are right aligned with 10.0f padding from the right edge
+	float right_edge =
+		ImGui::GetCursorScreenPos().x + editor_state.line_number_width - 10.0f;
+
+	// Render each visible line number on the first row of its line
+	for (int row = start_row; row < end_row; row++)
 	{
+		int i = gEditorDisplayMap.lineAtRow(row);
+		if (row != gEditorDisplayMap.rowOfLine(i))
+		{
+			continue;
+		}
+
 		// Calculate vertical position
-		float y_pos = editor_state.line_numbers_pos.y + (i * editor_state.line_height) -
+		float y_pos = editor_state.line_numbers_pos.y + (row * editor_state.line_height) -
 					  gEditorScroll.getScrollPosition().y;
 
-		// Format line number text
-		snprintf(line_number_buffer, sizeof(line_number_buffer), "%d", i + 1);
+		const GutterLabel &label = getGutterLabel(i);
 
 		// Determine color based on selection, current line, and edited status
 		ImU32 line_number_color;
-		bool is_edited = gEditorGit.isLineEdited(gFileExplorer.currentFile, i + 1);
-		float edit_alpha =
-			gEditorGit.getLineAnimationAlpha(gFileExplorer.currentFile, i + 1);
+		bool is_edited = i < static_cast<int>(edited_mask.size()) && edited_mask[i];
+		float edit_alpha = is_edited ? 1.0f : 0.0f;
 
 		if (i >= selection_start_line && i < selection_end_line &&
 			editor_state.selection_active)
@@ -105,13 +145,11 @@ void EditorLineNumbers::renderLineNumbers()
 			line_number_color = DEFAULT_LINE_NUMBER_COLOR;
 		}
 
-		// Calculate position for right-aligned text
-		float text_width = ImGui::CalcTextSize(line_number_buffer).x;
-		float x_pos = calculateTextRightAlignedPosition(line_number_buffer,
-														editor_state.line_number_width);
-
 		// Draw the line number
-		draw_list->AddText(ImVec2(x_pos, y_pos), line_number_color, line_number_buffer);
+		draw_list->AddText(ImVec2(right_edge - label.width, y_pos),
+						   line_number_color,
+						   label.text,
+						   label.text + label.length);
 	}
 }
 
@@ -155,15 +193,6 @@ ImVec2 EditorLineNumbers::createLineNumbersPanel()
 	return line_numbers_pos;
 }
 
-float EditorLineNumbers::calculateTextRightAlignedPosition(const char *text,
-														   float line_number_width,
-														   float right_margin) const
-{
-	float text_width = ImGui::CalcTextSize(text).x;
-	// Position text with 10.0f padding from the right edge
-	return ImGui::GetCursorScreenPos().x + line_number_width - text_width - 10.0f;
-}
-
 ImU32 EditorLineNumbers::calculateRainbowColor(float blink_time) const
 {
 	// Update color less frequently for better performance
@@ -43,11 +43,24 @@ class EditorLineNumbers
 	void calculateSelectionLines(int &selection_start_line, int &selection_end_line);
 
 	// Layout/positioning helpers
-	float calculateTextRightAlignedPosition(const char *text,
-											float line_number_width,
-											float right_margin = 4.0f) const;
 	float calculateRequiredLineNumberWidth() const;
 
+	// Preformatted line numbers, indexed by line. The text only depends on the
+	// line index, so entries survive edits; widths are dropped when the font
+	// changes.
+	struct GutterLabel
+	{
+		char text[LINE_NUMBER_BUFFER_SIZE];
+		int length; // -1 until first shown
+		float width;
+	};
+	const GutterLabel &getGutterLabel(int line_index);
+	void syncGutterFont();
+
+	std::vector<GutterLabel> gutter_labels;
+	ImFont *gutter_font = nullptr;
+	float gutter_font_size = 0.0f;
+
 	std::string current_filepath;
 };
 
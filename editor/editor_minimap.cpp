@@ -0,0 +1,418 @@
+/*
+	File: editor_minimap.cpp
+	Description: Code overview next to the editor, kept in GL textures that are
+   only ever patched row by row.
+*/
+
+#include "editor_minimap.h"
+#include "editor.h"
+#include "editor_display_map.h"
+#include "editor_scroll.h"
+#include "editor_tree_sitter.h"
+
+#include "../util/redraw.h"
+#include "../util/settings.h"
+
+#include <algorithm>
+
+// Global instance
+EditorMinimap gEditorMinimap;
+
+bool EditorMinimap::isEnabled() const { return gSettings.getSnapshot()->minimap; }
+
+float EditorMinimap::width() const
+{
+	return isEnabled() ? static_cast<float>(COLUMNS) : 0.0f;
+}
+
+void EditorMinimap::onLinesChanged(int first_line, int old_end_line, int new_end_line)
+{
+	int removed = old_end_line - first_line;
+	int added = new_end_line - first_line;
+	if (first_line < 0 || removed < 0 || added < 0 ||
+		old_end_line > static_cast<int>(line_slot.size()) ||
+		line_slot.size() - removed + added != editor_state.editor_content_lines.size())
+	{
+		reset(static_cast<int>(editor_state.editor_content_lines.size()));
+		return;
+	}
+
+	for (int i = first_line; i < old_end_line; ++i)
+	{
+		dirty_count -= dirty[i];
+	}
+
+	// Lines that keep their texture row keep its hash too, so an edit that
+	// does not change any texels uploads nothing
+	if (removed != added)
+	{
+		// Pushed highest first so the new lines take the old rows back in order
+		for (int i = old_end_line - 1; i >= first_line; --i)
+		{
+			free_slots.push_back(line_slot[i]);
+		}
+		line_slot.erase(line_slot.begin() + first_line, line_slot.begin() + old_end_line);
+		line_hash.erase(line_hash.begin() + first_line, line_hash.begin() + old_end_line);
+		dirty.erase(dirty.begin() + first_line, dirty.begin() + old_end_line);
+
+		line_slot.insert(line_slot.begin() + first_line, added, 0);
+		line_hash.insert(line_hash.begin() + first_line, added, 0);
+		dirty.insert(dirty.begin() + first_line, added, 0);
+		for (int i = first_line; i < new_end_line; ++i)
+		{
+			line_slot[i] = allocateSlot();
+		}
+	}
+
+	for (int i = first_line; i < new_end_line; ++i)
+	{
+		dirty[i] = 1;
+	}
+	dirty_count += added;
+	next_dirty = std::min(next_dirty, static_cast<size_t>(first_line));
+}
+
+void EditorMinimap::invalidateLines(int first_line, int end_line, size_t text_size)
+{
+	if (first_line >= end_line)
+	{
+		return;
+	}
+	std::lock_guard<std::mutex> lock(recolored_mutex);
+	if (recolored && recolored_size != text_size)
+	{
+		recolored_all = true;
+	}
+	recolored_first = recolored ? std::min(recolored_first, first_line) : first_line;
+	recolored_end = recolored ? std::max(recolored_end, end_line) : end_line;
+	recolored_size = text_size;
+	recolored = true;
+}
+
+void EditorMinimap::render(float scroll_y, float scroll_max_y)
+{
+	if (!isEnabled())
+	{
+		return;
+	}
+
+	const int line_count = static_cast<int>(editor_state.editor_content_lines.size());
+	if (static_cast<int>(line_slot.size()) != line_count)
+	{
+		reset(line_count);
+	}
+	{
+		std::lock_guard<std::mutex> lock(recolored_mutex);
+		if (recolored)
+		{
+			// Line numbers only hold for the text they were counted in
+			bool all = recolored_all || recolored_size != editor_state.fileContent.size();
+			int first = all ? 0 : std::clamp(recolored_first, 0, line_count);
+			int end = all ? line_count : std::clamp(recolored_end, first, line_count);
+			for (int i = first; i < end; ++i)
+			{
+				dirty_count += 1 - dirty[i];
+				dirty[i] = 1;
+			}
+			next_dirty = std::min(next_dirty, static_cast<size_t>(first));
+			recolored = recolored_all = false;
+		}
+	}
+
+	const ImVec2 origin = ImGui::GetCursorScreenPos();
+	const ImVec2 size(width(), ImGui::GetContentRegionAvail().y);
+	ImGui::InvisibleButton("##minimap", size);
+	const bool hovered = ImGui::IsItemHovered();
+	const bool dragging = ImGui::IsItemActive();
+
+	// The viewport in lines, and where the minimap has to start for it to be
+	// on screen. Past one screen of lines the minimap scrolls proportionally.
+	const float line_height = editor_state.line_height;
+	const float view_height = editor_state.size.y;
+	const int top_line =
+		gEditorDisplayMap.lineAtRow(static_cast<int>(scroll_y / line_height));
+	const int bottom_line = gEditorDisplayMap.lineAtRow(
+		static_cast<int>((scroll_y + view_height) / line_height));
+	const float slider_height = (bottom_line - top_line + 1) * ROW_HEIGHT;
+	const float lines_on_map = size.y / ROW_HEIGHT;
+	const bool overflows = line_count > lines_on_map;
+
+	float first_line = 0.0f;
+	if (overflows)
+	{
+		float fraction =
+			scroll_max_y > 0.0f ? std::clamp(scroll_y / scroll_max_y, 0.0f, 1.0f) : 0.0f;
+		float track = std::max(size.y - slider_height, 0.0f);
+		first_line = std::clamp(
+			top_line - fraction * track / ROW_HEIGHT, 0.0f, line_count - lines_on_map);
+	}
+	const float slider_top = (top_line - first_line) * ROW_HEIGHT;
+
+	if (ImGui::IsItemActivated())
+	{
+		// Grabbing the viewport keeps the grab point under the pointer;
+		// clicking elsewhere centers the viewport there
+		float mouse_y = ImGui::GetIO().MousePos.y - origin.y;
+		grab_offset = mouse_y >= slider_top && mouse_y < slider_top + slider_height
+						  ? mouse_y - slider_top
+						  : slider_height * 0.5f;
+	}
+	if (dragging)
+	{
+		float target_top = ImGui::GetIO().MousePos.y - origin.y - grab_offset;
+		float target_scroll;
+		if (overflows)
+		{
+			float track = std::max(size.y - slider_height, 1.0f);
+			target_scroll = std::clamp(target_top / track, 0.0f, 1.0f) * scroll_max_y;
+		} else
+		{
+			int line =
+				std::clamp(static_cast<int>(target_top / ROW_HEIGHT), 0, line_count);
+			target_scroll = gEditorDisplayMap.rowOfLine(line) * line_height;
+		}
+		target_scroll = std::clamp(target_scroll, 0.0f, std::max(scroll_max_y, 0.0f));
+		if (target_scroll != scroll_y)
+		{
+			gEditorScroll.requestScroll(
+				editor_state.current_scroll_x, target_scroll, false);
+			gRedraw.request();
+		}
+	}
+
+	const int first_visible = static_cast<int>(first_line);
+	const int end_visible =
+		std::min(line_count, first_visible + static_cast<int>(lines_on_map) + 2);
+	uploadDirty(first_visible, end_visible);
+
+	ImDrawList *draw_list = ImGui::GetWindowDrawList();
+	const ImVec2 max(origin.x + size.x, origin.y + size.y);
+	draw_list->PushClipRect(origin, max, true);
+	draw_list->AddRectFilled(origin, max, IM_COL32(0, 0, 0, 40));
+
+	// Lines whose rows happen to be adjacent in one texture share a quad; right
+	// after loading a file that is every line on screen.
+	float y = origin.y - (first_line - first_visible) * ROW_HEIGHT;
+	for (int line = first_visible; line < end_visible;)
+	{
+		const int slot = line_slot[line];
+		int run = 1;
+		while (line + run < end_visible && line_slot[line + run] == slot + run &&
+			   (slot + run) % TILE_ROWS != 0)
+		{
+			++run;
+		}
+
+		const size_t tile = slot / TILE_ROWS;
+		if (tile < tiles.size())
+		{
+			float v0 = static_cast<float>(slot % TILE_ROWS) / TILE_ROWS;
+			float v1 = v0 + static_cast<float>(run) / TILE_ROWS;
+			draw_list->AddImage((ImTextureID)(intptr_t)tiles[tile],
+								ImVec2(origin.x, y),
+								ImVec2(origin.x + size.x, y + run * ROW_HEIGHT),
+								ImVec2(0.0f, v0),
+								ImVec2(1.0f, v1));
+		}
+		y += run * ROW_HEIGHT;
+		line += run;
+	}
+
+	int slider_alpha = dragging ? 60 : (hovered ? 45 : 30);
+	draw_list->AddRectFilled(ImVec2(origin.x, origin.y + slider_top),
+							 ImVec2(max.x, origin.y + slider_top + slider_height),
+							 IM_COL32(255, 255, 255, slider_alpha));
+	draw_list->PopClipRect();
+}
+
+void EditorMinimap::reset(int line_count)
+{
+	// Textures are kept; every row gets overwritten before it is drawn again
+	free_slots.clear();
+	line_slot.resize(line_count);
+	for (int i = 0; i < line_count; ++i)
+	{
+		line_slot[i] = i;
+	}
+	slot_count = line_count;
+	line_hash.assign(line_count, 0);
+	dirty.assign(line_count, 1);
+	dirty_count = line_count;
+	next_dirty = 0;
+}
+
+int EditorMinimap::allocateSlot()
+{
+	if (!free_slots.empty())
+	{
+		int slot = free_slots.back();
+		free_slots.pop_back();
+		return slot;
+	}
+	return slot_count++;
+}
+
+void EditorMinimap::uploadDirty(int first_visible, int end_visible)
+{
+	if (dirty_count == 0)
+	{
+		return;
+	}
+
+	// The highlighter swaps colors under this lock
+	std::lock_guard<std::mutex> lock(editor_state.colorsMutex);
+
+	// Lines on screen first so the visible part never trails an edit
+	for (int line = first_visible; line < end_visible; ++line)
+	{
+		if (dirty[line])
+		{
+			uploadLine(line);
+		}
+	}
+	flushStaging();
+
+	// The rest a slice per frame, so opening a large file never stalls
+	const double slice_start = Redraw::now();
+	int visited = 0;
+	while (dirty_count > 0)
+	{
+		if (next_dirty >= dirty.size())
+		{
+			flushStaging();
+			next_dirty = 0;
+		}
+		if (dirty[next_dirty])
+		{
+			uploadLine(static_cast<int>(next_dirty));
+		}
+		++next_dirty;
+
+		if (++visited % 256 == 0 && Redraw::now() - slice_start >= UPLOAD_SLICE_SECONDS)
+		{
+			break;
+		}
+	}
+	flushStaging();
+
+	if (dirty_count > 0)
+	{
+		gRedraw.request(1);
+	}
+}
+
+void EditorMinimap::uploadLine(int line)
+{
+	dirty[line] = 0;
+	dirty_count--;
+
+	ImU32 row[COLUMNS];
+	buildRow(line, row);
+
+	// FNV-1a over the texels; never 0 so a fresh line always uploads
+	uint64_t hash = 1469598103934665603ull;
+	for (ImU32 texel : row)
+	{
+		hash = (hash ^ texel) * 1099511628211ull;
+	}
+	hash |= 1;
+	if (hash == line_hash[line])
+	{
+		return;
+	}
+	line_hash[line] = hash;
+
+	const int slot = line_slot[line];
+	if (staging_rows > 0 &&
+		(slot != staging_slot + staging_rows || slot % TILE_ROWS == 0))
+	{
+		flushStaging();
+	}
+	if (staging_rows == 0)
+	{
+		staging_slot = slot;
+	}
+	staging.insert(staging.end(), row, row + COLUMNS);
+	staging_rows++;
+}
+
+void EditorMinimap::buildRow(int line, ImU32 *row) const
+{
+	std::fill(row, row + COLUMNS, 0);
+
+	const std::string &text = editor_state.fileContent;
+	const std::vector<ImVec4> &colors = editor_state.fileColors;
+	const auto &line_starts = editor_state.editor_content_lines;
+	size_t start = line_starts[line];
+	size_t end = line + 1 < static_cast<int>(line_starts.size()) ? line_starts[line + 1]
+																 : text.size();
+
+	int column = 0;
+	for (size_t i = start; i < end && column < COLUMNS; ++i)
+	{
+		unsigned char c = static_cast<unsigned char>(text[i]);
+		if (c == '\t')
+		{
+			column += TAB_COLUMNS;
+			continue;
+		}
+		// One texel per character, not per UTF-8 byte
+		if ((c & 0xC0) == 0x80 || c == '\n' || c == '\r')
+		{
+			continue;
+		}
+		if (c != ' ')
+		{
+			ImVec4 color = i < colors.size() ? colors[i] : TreeSitter::cachedColors.text;
+			color.w *= TEXT_ALPHA;
+			row[column] = ImGui::ColorConvertFloat4ToU32(color);
+		}
+		column++;
+	}
+}
+
+void EditorMinimap::flushStaging()
+{
+	if (staging_rows == 0)
+	{
+		return;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, tileTexture(staging_slot / TILE_ROWS));
+	glTexSubImage2D(GL_TEXTURE_2D,
+					0,
+					0,
+					staging_slot % TILE_ROWS,
+					COLUMNS,
+					staging_rows,
+					GL_RGBA,
+					GL_UNSIGNED_BYTE,
+					staging.data());
+	staging.clear();
+	staging_rows = 0;
+}
+
+GLuint EditorMinimap::tileTexture(int tile)
+{
+	// Growing adds a texture; the existing ones are never reallocated
+	while (static_cast<int>(tiles.size()) <= tile)
+	{
+		GLuint texture;
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		// Rows next to each other belong to unrelated lines; never blend them
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexImage2D(GL_TEXTURE_2D,
+					 0,
+					 GL_RGBA,
+					 COLUMNS,
+					 TILE_ROWS,
+					 0,
+					 GL_RGBA,
+					 GL_UNSIGNED_BYTE,
+					 nullptr);
+		tiles.push_back(texture);
+	}
+	return tiles[tile];
+}
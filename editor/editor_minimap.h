@@ -0,0 +1,81 @@
+/*
+	File: editor_minimap.h
+	Description: Code overview drawn to the right of the editor. Every line is one
+   texel row in a set of fixed-size GL textures, colored from the highlight
+   colors at one texel per character. Lines own a texture row through an
+   indirection table, so inserting or deleting lines only moves integers and
+   re-uploads the rows of the lines that actually changed.
+*/
+
+#pragma once
+#include "imgui.h"
+
+#include <GLFW/glfw3.h>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Forward declarations
+class EditorMinimap;
+extern EditorMinimap gEditorMinimap;
+
+class EditorMinimap
+{
+  public:
+	bool isEnabled() const;
+	// Horizontal space to reserve next to the editor, 0 when hidden
+	float width() const;
+
+	// Old lines [first_line, old_end_line) were replaced by new lines
+	// [first_line, new_end_line). Only those lines are re-rendered.
+	void onLinesChanged(int first_line, int old_end_line, int new_end_line);
+
+	// Any thread: the highlighter recolored lines [first_line, end_line) of a
+	// text `text_size` bytes long. Only those are rebuilt, unless the text
+	// changed size since, when every line is.
+	void invalidateLines(int first_line, int end_line, size_t text_size);
+
+	// Draws at the current cursor position; dragging the viewport scrolls the editor
+	void render(float scroll_y, float scroll_max_y);
+
+  private:
+	static constexpr int COLUMNS = 100;	   // Characters shown per line
+	static constexpr int TILE_ROWS = 2048; // Lines per texture
+	static constexpr int TAB_COLUMNS = 4;
+	static constexpr float ROW_HEIGHT = 2.0f; // Screen pixels per line
+	static constexpr float TEXT_ALPHA = 0.6f;
+	static constexpr double UPLOAD_SLICE_SECONDS = 0.002;
+
+	std::vector<GLuint> tiles;
+	std::vector<int> line_slot;		 // Texture row owned by each line
+	std::vector<int> free_slots;	 // Reused from the back
+	std::vector<uint64_t> line_hash; // Hash of the uploaded row, 0 before the first
+	std::vector<uint8_t> dirty;
+	int dirty_count = 0;
+	size_t next_dirty = 0;
+	int slot_count = 0;
+
+	// Recolored lines not marked dirty yet, from invalidateLines()
+	std::mutex recolored_mutex;
+	bool recolored = false;
+	bool recolored_all = false;
+	int recolored_first = 0;
+	int recolored_end = 0;
+	size_t recolored_size = 0;
+
+	// Consecutive texture rows waiting for a single glTexSubImage2D
+	std::vector<ImU32> staging;
+	int staging_slot = 0;
+	int staging_rows = 0;
+
+	float grab_offset = 0.0f;
+
+	void reset(int line_count);
+	int allocateSlot();
+	void uploadDirty(int first_visible, int end_visible);
+	void uploadLine(int line);
+	void buildRow(int line, ImU32 *row) const;
+	void flushStaging();
+	GLuint tileTexture(int tile);
+};
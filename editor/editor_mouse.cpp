@@ -17,6 +17,8 @@
 #include "editor.h"
 #include "editor/utf8_utils.h"
 #include "editor_copy_paste.h"
+#include "editor_display_map.h"
+#include "editor_folding.h"
 #include <algorithm>
 #include <iostream>
 
@@ -87,6 +89,10 @@ void EditorMouse::handleMouseInput()
 	{
 		gAITab.cancel_request();
 		gAITab.dismiss_completion();
+		if (gEditorFolding.handleMarkerClick(ImGui::GetMousePos()))
+		{
+			return;
+		}
 		handleMouseClick(char_index);
 	}
 	// Handle drag
@@ -232,13 +238,6 @@ void EditorMouse::handleMouseClick(int char_index)
 			snapToUtf8CharBoundary(editor_state.fileContent, editor_state.cursor_index);
 	}
 	is_dragging = true;
-
-	// Update undo manager's pendingFinalCursor for first edit logic
-	if (gFileExplorer.currentUndoManager)
-	{
-		gFileExplorer.currentUndoManager->updatePendingFinalCursor(
-			editor_state.cursor_index);
-	}
 }
 
 void EditorMouse::handleMouseDrag(int char_index)
@@ -490,6 +489,19 @@ int EditorMouse::getCharIndexFromCoords()
 {
 	ImVec2 mouse_pos = ImGui::GetMousePos();
 
+	// With soft wrap or folds the click picks a visual row, which the display
+	// map resolves against the same glyph advances renderText uses
+	if (gEditorDisplayMap.isActive())
+	{
+		int clicked_row =
+			std::clamp(static_cast<int>((mouse_pos.y - editor_state.text_pos.y) /
+										editor_state.line_height),
+					   0,
+					   gEditorDisplayMap.rowCount() - 1);
+		float click_x = mouse_pos.x - editor_state.text_pos.x;
+		return gEditorDisplayMap.indexAt(clicked_row, click_x);
+	}
+
 	// Determine which line was clicked (clamped to valid indices)
 	int clicked_line =
 		std::clamp(static_cast<int>((mouse_pos.y - editor_state.text_pos.y) /
@@ -6,23 +6,38 @@
 
 #include "editor_render.h"
 #include "../files/file_finder.h"
+#include "../files/symbol_search.h"
+#include "../files/workspace_search.h"
 
 #include "../lsp/lsp_client.h"
 #include "editor.h"
 #include "editor_bookmarks.h"
 #include "editor_cursor.h"
+#include "editor_display_map.h"
+#include "editor_folding.h"
 #include "editor_highlight.h"
 #include "editor_line_jump.h"
 #include "editor_line_numbers.h"
+#include "editor_minimap.h"
 #include "editor_scroll.h"
 #include "editor_selection.h"
 #include "editor_tree_sitter.h"
 #include "editor_utils.h"
 
+#include <cfloat>
+#include <cstring>
 #include <iostream>
 
 EditorRender gEditorRender;
 
+EditorRender::~EditorRender()
+{
+	if (bake_draw_list)
+	{
+		IM_DELETE(bake_draw_list);
+	}
+}
+
 void EditorRender::renderEditorFrame()
 {
 
@@ -32,6 +47,10 @@ void EditorRender::renderEditorFrame()
 
 	gFileFinder.renderWindow();
 
+	gWorkspaceSearch.renderWindow();
+
+	gSymbolSearch.renderWindow();
+
 	// Render all LSP UI components
 	gLSPClient.render();
 
@@ -42,6 +61,7 @@ void EditorRender::renderEditorFrame()
 	// Get final scroll positions from ImGui
 	float scrollY = ImGui::GetScrollY();
 	float scrollX = ImGui::GetScrollX();
+	float scrollMaxY = ImGui::GetScrollMaxY();
 
 	// Update scroll manager with final positions
 	gEditorScroll.setScrollPosition(ImVec2(scrollX, scrollY));
@@ -52,6 +72,12 @@ void EditorRender::renderEditorFrame()
 	ImGui::PopStyleColor(4);
 	ImGui::PopStyleVar(4);
 
+	if (gEditorMinimap.isEnabled())
+	{
+		ImGui::SameLine(0.0f, 0.0f);
+		gEditorMinimap.render(scrollY, scrollMaxY);
+	}
+
 	// Render line numbers with proper clipping
 	ImGui::PushClipRect(editor_state.line_numbers_pos,
 						ImVec2(editor_state.line_numbers_pos.x +
@@ -210,130 +236,139 @@ void EditorRender::renderLineBackground(int line_num,
 											  highlight_color);
 }
 
-void EditorRender::renderCharacterAndSelection(size_t char_index,
-											   int selection_start,
-											   int selection_end,
-											   ImVec2 &current_draw_pos)
+bool EditorRender::isCharacterSelected(int char_index,
+										int selection_start,
+										int selection_end) const
 {
-	if (char_index >= editor_state.fileColors.size())
+	bool is_selected = (selection_start <= selection_end && // Normal order
+						char_index >= selection_start && char_index < selection_end) ||
+					   (selection_start > selection_end && // Inverse order
+						char_index >= selection_end && char_index < selection_start);
+
+	if (!is_selected && editor_state.selection_active &&
+		!editor_state.multi_selections.empty())
 	{
-		return; // Skip rendering this char if color is missing
+		for (const auto &multi_sel : editor_state.multi_selections)
+		{
+			if (char_index >= std::min(multi_sel.start_index, multi_sel.end_index) &&
+				char_index < std::max(multi_sel.start_index, multi_sel.end_index))
+			{
+				is_selected = true;
+				break;
+			}
+		}
 	}
+	return is_selected;
+}
 
-	const char *char_start = &editor_state.fileContent[char_index];
-	const char *char_end = (char_index + 1 < editor_state.fileContent.size())
-							   ? &editor_state.fileContent[char_index + 1]
-							   : nullptr;
+float EditorRender::characterAdvance(size_t char_index,
+									 float column_x,
+									 const char *&char_end) const
+{
+	const std::string &content = editor_state.fileContent;
+	const char *char_start = &content[char_index];
+	char_end = char_start + 1;
 
 	// Handle tab characters specially to avoid font-specific rendering issues
 	if (*char_start == '\t')
 	{
-		// Calculate tab width based on current position
 		float space_width = ImGui::CalcTextSize(" ").x;
 		const int TAB_SIZE = 4;
-		float current_column_pixels = current_draw_pos.x - editor_state.text_pos.x;
-		int current_column = static_cast<int>(current_column_pixels / space_width);
+		int current_column = static_cast<int>(column_x / space_width);
 		int next_tab_stop = ((current_column / TAB_SIZE) + 1) * TAB_SIZE;
-		float tab_width = (next_tab_stop - current_column) * space_width;
-
-		// Render selection if needed
-		int s_start = selection_start;
-		int s_end = selection_end;
-		int current_char_idx = static_cast<int>(char_index);
-
-		bool is_selected = (s_start <= s_end && // Normal order: start <= end
-							current_char_idx >= s_start && current_char_idx < s_end) ||
-						   (s_start > s_end && // Inverse order: start > end
-							current_char_idx >= s_end && current_char_idx < s_start);
-
-		if (!is_selected && editor_state.selection_active &&
-			!editor_state.multi_selections.empty())
-		{
-			for (const auto &multi_sel : editor_state.multi_selections)
-			{
-				if (static_cast<int>(char_index) >=
-						std::min(multi_sel.start_index, multi_sel.end_index) &&
-					static_cast<int>(char_index) <
-						std::max(multi_sel.start_index, multi_sel.end_index))
-				{
-					is_selected = true;
-					break;
-				}
-			}
-		}
-
-		if (is_selected)
-		{
-			ImVec2 sel_start_pos = current_draw_pos;
-			ImVec2 sel_end_pos = ImVec2(sel_start_pos.x + tab_width,
-										sel_start_pos.y + editor_state.line_height);
-			const ImU32 selection_color =
-				ImGui::ColorConvertFloat4ToU32(ImVec4(1.0f, 0.1f, 0.7f, 0.3f));
-			ImGui::GetWindowDrawList()->AddRectFilled(sel_start_pos,
-													  sel_end_pos,
-													  selection_color);
-		}
-
-		// Don't render anything - just advance the cursor by tab width
-		current_draw_pos.x += tab_width;
-		return;
+		return (next_tab_stop - current_column) * space_width;
 	}
 
-	// For multi-byte characters (like emojis), we need to find the end of the character
-	if (char_end && (*char_start & 0x80)) // Check if it's a multi-byte character
+	// For multi-byte characters (like emojis), find the end of the character
+	if (*char_start & 0x80)
 	{
-		// Find the end of this UTF-8 character
-		while (char_end < &editor_state.fileContent[editor_state.fileContent.size()] &&
-			   (*char_end & 0xC0) == 0x80) // Continuation byte
+		const char *content_end = content.data() + content.size();
+		while (char_end < content_end && (*char_end & 0xC0) == 0x80) // Continuation byte
 		{
 			char_end++;
 		}
 	}
 
-	float char_width = ImGui::CalcTextSize(char_start, char_end).x;
-
-	int s_start = selection_start; // Or editor_state.selection_start
-	int s_end = selection_end;	   // Or editor_state.selection_end
-	int current_char_idx = static_cast<int>(char_index);
+	return ImGui::CalcTextSize(char_start, char_end).x;
+}
 
-	bool is_selected = (s_start <= s_end && // Normal order: start <= end
-						current_char_idx >= s_start && current_char_idx < s_end) ||
-					   (s_start > s_end && // Inverse order: start > end
-						current_char_idx >= s_end && current_char_idx < s_start);
+void EditorRender::renderLineSelection(size_t line_start,
+									   size_t line_end,
+									   const ImVec2 &origin)
+{
+	const int sel_min = std::min(editor_state.selection_start, editor_state.selection_end);
+	const int sel_max = std::max(editor_state.selection_start, editor_state.selection_end);
 
-	if (!is_selected && editor_state.selection_active &&
-		!editor_state.multi_selections.empty())
+	// Cheap rejection so unselected lines never measure their characters
+	bool touches_selection = sel_min < sel_max && sel_min < static_cast<int>(line_end) &&
+							 sel_max > static_cast<int>(line_start);
+	if (!touches_selection && editor_state.selection_active)
 	{
 		for (const auto &multi_sel : editor_state.multi_selections)
 		{
-			if (static_cast<int>(char_index) >=
-					std::min(multi_sel.start_index, multi_sel.end_index) &&
-				static_cast<int>(char_index) <
-					std::max(multi_sel.start_index, multi_sel.end_index))
+			if (std::min(multi_sel.start_index, multi_sel.end_index) <
+					static_cast<int>(line_end) &&
+				std::max(multi_sel.start_index, multi_sel.end_index) >
+					static_cast<int>(line_start))
 			{
-				is_selected = true;
+				touches_selection = true;
 				break;
 			}
 		}
 	}
-	if (is_selected)
+	if (!touches_selection)
 	{
-		ImVec2 sel_start_pos = current_draw_pos;
-		ImVec2 sel_end_pos = ImVec2(sel_start_pos.x + char_width,
-									sel_start_pos.y + editor_state.line_height);
-		const ImU32 selection_color =
-			ImGui::ColorConvertFloat4ToU32(ImVec4(1.0f, 0.1f, 0.7f, 0.3f));
-		ImGui::GetWindowDrawList()->AddRectFilled(sel_start_pos,
-												  sel_end_pos,
-												  selection_color);
+		return;
 	}
 
-	ImU32 text_color =
-		ImGui::ColorConvertFloat4ToU32(editor_state.fileColors[char_index]);
-	ImGui::GetWindowDrawList()->AddText(
-		current_draw_pos, text_color, char_start, char_end);
+	const ImU32 selection_color =
+		ImGui::ColorConvertFloat4ToU32(ImVec4(1.0f, 0.1f, 0.7f, 0.3f));
+	ImDrawList *draw_list = ImGui::GetWindowDrawList();
+	const std::string &content = editor_state.fileContent;
 
-	current_draw_pos.x += char_width;
+	// Adjacent selected characters are merged into a single rectangle
+	float x = 0.0f;
+	float run_start_x = -1.0f;
+	for (size_t i = line_start; i < line_end;)
+	{
+		if ((content[i] & 0xC0) == 0x80)
+		{
+			i++;
+			continue;
+		}
+
+		const char *char_end = nullptr;
+		float char_width = characterAdvance(i, x, char_end);
+		bool selected = isCharacterSelected(static_cast<int>(i),
+											editor_state.selection_start,
+											editor_state.selection_end);
+
+		if (selected && run_start_x < 0.0f)
+		{
+			run_start_x = x;
+		} else if (!selected && run_start_x >= 0.0f)
+		{
+			draw_list->AddRectFilled(
+				ImVec2(origin.x + run_start_x, origin.y),
+				ImVec2(origin.x + x, origin.y + editor_state.line_height),
+				selection_color);
+			run_start_x = -1.0f;
+		}
+
+		x += char_width;
+		if (content[i] == '\n')
+		{
+			break;
+		}
+		i = static_cast<size_t>(char_end - content.data());
+	}
+
+	if (run_start_x >= 0.0f)
+	{
+		draw_list->AddRectFilled(ImVec2(origin.x + run_start_x, origin.y),
+								 ImVec2(origin.x + x, origin.y + editor_state.line_height),
+								 selection_color);
+	}
 }
 
 bool EditorRender::skipLineIfAboveVisible(size_t &char_index,
@@ -379,15 +414,13 @@ void EditorRender::renderWhitespaceGuides()
 		return;
 	}
 
-	// Calculate visible line range
-	int start_line_idx = static_cast<int>(scroll_y / line_height);
-	start_line_idx = std::max(0, start_line_idx - 2);
-	int end_line_idx = static_cast<int>((scroll_y + window_height) / line_height);
-	end_line_idx =
-		std::min(static_cast<int>(editor_state.editor_content_lines.size() - 1),
-				 end_line_idx + 2);
+	// Calculate visible row range
+	int start_row = static_cast<int>(scroll_y / line_height);
+	start_row = std::max(0, start_row - 2);
+	int end_row = static_cast<int>((scroll_y + window_height) / line_height);
+	end_row = std::min(gEditorDisplayMap.rowCount() - 1, end_row + 2);
 
-	if (start_line_idx > end_line_idx)
+	if (start_row > end_row)
 	{
 		return;
 	}
@@ -400,51 +433,31 @@ void EditorRender::renderWhitespaceGuides()
 	const ImU32 guide_color =
 		ImGui::ColorConvertFloat4ToU32(ImVec4(0.3f, 0.3f, 0.3f, 0.4f));
 
-	// Iterate through visible lines
-	for (int line_num = start_line_idx; line_num <= end_line_idx; ++line_num)
-	{
-		size_t line_char_start_idx = editor_state.editor_content_lines[line_num];
-		size_t line_char_end_idx;
+	// Indent depth per line is computed along with the line starts
+	const std::vector<int> &line_indents = editor_state.line_indents;
 
-		if (static_cast<size_t>(line_num + 1) < editor_state.editor_content_lines.size())
-		{
-			line_char_end_idx = editor_state.editor_content_lines[line_num + 1];
-		} else
+	// Iterate through visible rows. Wrapped continuation rows start at column
+	// zero, so guides would run through their text.
+	for (int row = start_row; row <= end_row; ++row)
+	{
+		int line_num = gEditorDisplayMap.lineAtRow(row);
+		if (line_num >= static_cast<int>(line_indents.size()))
 		{
-			line_char_end_idx = editor_state.fileContent.size();
+			break;
 		}
-
-		// Count leading whitespace and find first non-whitespace position
-		int total_whitespace_chars = 0;
-		size_t first_non_whitespace_idx = line_char_end_idx; // Default to end of line
-
-		for (size_t i = line_char_start_idx; i < line_char_end_idx; ++i)
+		if (row != gEditorDisplayMap.rowOfLine(line_num))
 		{
-			if (editor_state.fileContent[i] == ' ')
-			{
-				total_whitespace_chars++;
-			} else if (editor_state.fileContent[i] == '\t')
-			{
-				total_whitespace_chars += 4; // Convert tab to 4 spaces
-			} else if (editor_state.fileContent[i] != '\n')
-			{
-				// Found first non-whitespace character (excluding newline)
-				first_non_whitespace_idx = i;
-				break;
-			} else
-			{
-				// Hit newline, this is an empty/whitespace-only line
-				break;
-			}
+			continue;
 		}
+		int indent = line_indents[line_num];
 
 		// Draw vertical guides for each indentation level (full height, shifted up)
 		float line_y_start =
-			base_text_pos.y + (static_cast<float>(line_num) * line_height) - 2.0f;
+			base_text_pos.y + (static_cast<float>(row) * line_height) - 2.0f;
 		float line_y_end = line_y_start + line_height;
 
 		// Draw guides every 4 characters, but stop before where text begins
-		for (int level = 1; level * 4 < total_whitespace_chars; ++level)
+		for (int level = 1; level * 4 < indent; ++level)
 		{
 			float guide_x =
 				base_text_pos.x + (static_cast<float>(level * 4) * space_width);
@@ -532,25 +545,24 @@ void EditorRender::renderCurrentLineHighlight()
 		cached_cursor_pos = cursor_pos;
 	}
 
-	// Calculate visible line range
-	int start_line_idx = static_cast<int>(scroll_y / line_height);
-	start_line_idx = std::max(0, start_line_idx - 2);
-	int end_line_idx = static_cast<int>((scroll_y + window_height) / line_height);
-	end_line_idx =
-		std::min(static_cast<int>(editor_state.editor_content_lines.size() - 1),
-				 end_line_idx + 2);
-
-	// Only highlight if the cursor line is visible
-	if (static_cast<int>(cursor_line) < start_line_idx ||
-		static_cast<int>(cursor_line) > end_line_idx)
+	// Calculate visible row range
+	int start_row = static_cast<int>(scroll_y / line_height);
+	start_row = std::max(0, start_row - 2);
+	int end_row = static_cast<int>((scroll_y + window_height) / line_height);
+	end_row = std::min(gEditorDisplayMap.rowCount() - 1, end_row + 2);
+
+	// Only highlight if the cursor line is visible; a wrapped line is
+	// highlighted across all of its rows
+	int first_row = gEditorDisplayMap.rowOfLine(static_cast<int>(cursor_line));
+	int row_count = gEditorDisplayMap.rowsInLine(static_cast<int>(cursor_line));
+	if (first_row + row_count - 1 < start_row || first_row > end_row)
 	{
 		return;
 	}
 
 	// Calculate line position
-	float line_y_start =
-		base_text_pos.y + (static_cast<float>(cursor_line) * line_height);
-	float line_y_end = line_y_start + line_height;
+	float line_y_start = base_text_pos.y + (static_cast<float>(first_row) * line_height);
+	float line_y_end = line_y_start + line_height * row_count;
 
 	// Get window bounds for full-width highlight (shifted 6px to the right)
 	ImVec2 window_pos = ImGui::GetWindowPos();
@@ -568,18 +580,219 @@ void EditorRender::renderCurrentLineHighlight()
 											  highlight_color);
 }
 
+void EditorRender::syncLineCache()
+{
+	ImFont *font = ImGui::GetFont();
+	float font_size = ImGui::GetFontSize();
+	ImFontAtlas *atlas = ImGui::GetIO().Fonts;
+
+	// Glyph UVs are only valid for the atlas texture they were baked against,
+	// so a font switch or an atlas rebuild/grow drops every cached line.
+	if (font != cached_font || font_size != cached_font_size ||
+		atlas->TexData != cached_atlas_texture ||
+		atlas->TexUvScale.x != cached_atlas_uv_scale.x ||
+		atlas->TexUvScale.y != cached_atlas_uv_scale.y)
+	{
+		line_cache.clear();
+		cached_font = font;
+		cached_font_size = font_size;
+		cached_atlas_texture = atlas->TexData;
+		cached_atlas_uv_scale = atlas->TexUvScale;
+	}
+
+	line_cache_frame++;
+}
+
+void EditorRender::pruneLineCache()
+{
+	// Keep a generous working set so scrolling back and forth stays cached,
+	// but don't let long sessions accumulate geometry for lines long gone.
+	const size_t MAX_CACHED_LINES = 4096;
+	const uint64_t STALE_FRAMES = 300;
+
+	if (line_cache.size() <= MAX_CACHED_LINES)
+	{
+		return;
+	}
+
+	for (auto it = line_cache.begin(); it != line_cache.end();)
+	{
+		if (it->second.last_used_frame + STALE_FRAMES < line_cache_frame)
+		{
+			it = line_cache.erase(it);
+		} else
+		{
+			++it;
+		}
+	}
+
+	if (line_cache.size() > MAX_CACHED_LINES * 2)
+	{
+		line_cache.clear();
+	}
+}
+
+uint64_t EditorRender::hashLine(size_t line_start, size_t line_end) const
+{
+	// 64-bit multiply/xorshift mix, word at a time. Covers both the bytes and
+	// the syntax colors so re-highlighting or a theme change re-bakes the line.
+	uint64_t hash = 0x9E3779B97F4A7C15ULL ^ (line_end - line_start);
+	auto mix = [&hash](const void *data, size_t size) {
+		const unsigned char *bytes = static_cast<const unsigned char *>(data);
+		while (size >= 8)
+		{
+			uint64_t word;
+			memcpy(&word, bytes, 8);
+			hash = (hash ^ word) * 0xFF51AFD7ED558CCDULL;
+			hash ^= hash >> 32;
+			bytes += 8;
+			size -= 8;
+		}
+		uint64_t tail = 0;
+		memcpy(&tail, bytes, size);
+		hash = (hash ^ tail) * 0xC4CEB9FE1A85EC53ULL;
+		hash ^= hash >> 29;
+	};
+
+	mix(editor_state.fileContent.data() + line_start, line_end - line_start);
+
+	size_t colors_end = std::min(line_end, editor_state.fileColors.size());
+	if (colors_end > line_start)
+	{
+		mix(&editor_state.fileColors[line_start],
+			(colors_end - line_start) * sizeof(ImVec4));
+	}
+	return hash;
+}
+
+void EditorRender::emitLineGlyphs(ImDrawList *draw_list,
+								  size_t line_start,
+								  size_t line_end,
+								  const ImVec2 &origin)
+{
+	ImFont *font = ImGui::GetFont();
+	const float font_size = ImGui::GetFontSize();
+	const std::string &content = editor_state.fileContent;
+
+	float x = 0.0f;
+	for (size_t i = line_start; i < line_end;)
+	{
+		// Skip continuation bytes of multi-byte characters
+		if ((content[i] & 0xC0) == 0x80)
+		{
+			i++;
+			continue;
+		}
+
+		const char *char_end = nullptr;
+		float char_width = characterAdvance(i, x, char_end);
+
+		if (content[i] != '\t' && content[i] != '\n' &&
+			i < editor_state.fileColors.size())
+		{
+			ImU32 text_color = ImGui::ColorConvertFloat4ToU32(editor_state.fileColors[i]);
+			draw_list->AddText(font,
+							   font_size,
+							   ImVec2(origin.x + x, origin.y),
+							   text_color,
+							   &content[i],
+							   char_end);
+		}
+
+		x += char_width;
+		if (content[i] == '\n')
+		{
+			break;
+		}
+		i = static_cast<size_t>(char_end - content.data());
+	}
+}
+
+void EditorRender::bakeLine(size_t line_start, size_t line_end, CachedLine &line)
+{
+	if (!bake_draw_list)
+	{
+		bake_draw_list = IM_NEW(ImDrawList)(ImGui::GetDrawListSharedData());
+	}
+
+	// Bake at the origin with an unbounded clip rect so glyphs that are
+	// currently scrolled out of view are still part of the cached geometry.
+	ImDrawList *draw_list = bake_draw_list;
+	draw_list->_ResetForNewFrame();
+	draw_list->PushClipRect(ImVec2(-FLT_MAX, -FLT_MAX), ImVec2(FLT_MAX, FLT_MAX));
+	draw_list->PushTexture(ImGui::GetIO().Fonts->TexRef);
+
+	emitLineGlyphs(draw_list, line_start, line_end, ImVec2(0.0f, 0.0f));
+
+	line.vertices.assign(draw_list->VtxBuffer.begin(), draw_list->VtxBuffer.end());
+	line.indices.assign(draw_list->IdxBuffer.begin(), draw_list->IdxBuffer.end());
+}
+
+const EditorRender::CachedLine *EditorRender::getCachedLine(size_t line_start,
+															size_t line_end)
+{
+	// Lines this long would overflow 16-bit indices in a single reservation
+	const size_t MAX_CACHEABLE_LINE_BYTES = 8192;
+	if (line_end - line_start > MAX_CACHEABLE_LINE_BYTES)
+	{
+		return nullptr;
+	}
+
+	uint64_t key = hashLine(line_start, line_end);
+	auto it = line_cache.find(key);
+	if (it == line_cache.end())
+	{
+		it = line_cache.emplace(key, CachedLine()).first;
+		bakeLine(line_start, line_end, it->second);
+	}
+	it->second.last_used_frame = line_cache_frame;
+	return &it->second;
+}
+
+void EditorRender::replayLine(const CachedLine &line, const ImVec2 &origin)
+{
+	if (line.indices.empty())
+	{
+		return;
+	}
+
+	const int vtx_count = static_cast<int>(line.vertices.size());
+	const int idx_count = static_cast<int>(line.indices.size());
+
+	// PrimReserve may start a new command with a fresh vertex offset, so the
+	// index base has to be read after reserving.
+	ImDrawList *draw_list = ImGui::GetWindowDrawList();
+	draw_list->PrimReserve(idx_count, vtx_count);
+	const ImDrawIdx idx_base = static_cast<ImDrawIdx>(draw_list->_VtxCurrentIdx);
+
+	ImDrawVert *vtx_write = draw_list->_VtxWritePtr;
+	for (const ImDrawVert &vertex : line.vertices)
+	{
+		vtx_write->pos = ImVec2(vertex.pos.x + origin.x, vertex.pos.y + origin.y);
+		vtx_write->uv = vertex.uv;
+		vtx_write->col = vertex.col;
+		vtx_write++;
+	}
+
+	ImDrawIdx *idx_write = draw_list->_IdxWritePtr;
+	for (ImDrawIdx index : line.indices)
+	{
+		*idx_write++ = static_cast<ImDrawIdx>(idx_base + index);
+	}
+
+	draw_list->_VtxWritePtr = vtx_write;
+	draw_list->_IdxWritePtr = idx_write;
+	draw_list->_VtxCurrentIdx += static_cast<unsigned int>(vtx_count);
+}
+
 void EditorRender::renderText()
 {
 	ImVec2 base_text_pos = editor_state.text_pos; // Base screen position for text area
 
-	const float scroll_x = ImGui::GetScrollX(); // Current horizontal scroll
 	const float scroll_y = ImGui::GetScrollY(); // Current vertical scroll
-	// Use ImGui::GetContentRegionAvail().y for window_height if you are inside
-	// a child window or ImGui::GetWindowHeight() if 'this' is the main editor
-	// window. For a child window like "##editor", ImGui::GetWindowHeight()
+	// For a child window like "##editor", ImGui::GetWindowHeight()
 	// refers to child window height.
 	const float window_height = ImGui::GetWindowHeight();
-	const float window_width = ImGui::GetWindowWidth();
 	const float line_height = editor_state.line_height;
 
 	if (line_height <= 0.0f || editor_state.editor_content_lines.empty())
@@ -587,102 +800,64 @@ void EditorRender::renderText()
 		return; // Nothing to render or invalid state
 	}
 
-	// 1. Calculate the range of line numbers that are visible.
-	//    `start_line_idx` is the 0-based index for editor_content_lines.
-	const int VIRTUAL_RENDER_BUFFER_LINES = 2; // Render a few lines above/below viewport
-	int start_line_idx = static_cast<int>(scroll_y / line_height);
-	start_line_idx = std::max(0, start_line_idx - VIRTUAL_RENDER_BUFFER_LINES);
+	// 1. Calculate the range of visual rows that are visible. Without soft wrap
+	//    a row is a line; with it the display map splits long lines.
+	const int VIRTUAL_RENDER_BUFFER_LINES = 2; // Render a few rows above/below viewport
+	int start_row = static_cast<int>(scroll_y / line_height);
+	start_row = std::max(0, start_row - VIRTUAL_RENDER_BUFFER_LINES);
 
-	int end_line_idx = static_cast<int>((scroll_y + window_height) / line_height);
-	end_line_idx =
-		std::min(static_cast<int>(editor_state.editor_content_lines.size() - 1),
-				 end_line_idx + VIRTUAL_RENDER_BUFFER_LINES);
+	int end_row = static_cast<int>((scroll_y + window_height) / line_height);
+	end_row = std::min(gEditorDisplayMap.rowCount() - 1,
+					   end_row + VIRTUAL_RENDER_BUFFER_LINES);
 
-	if (start_line_idx > end_line_idx)
+	if (start_row > end_row)
 	{
-		return; // No lines in the visible range
+		return; // No rows in the visible range
 	}
 
-	// Horizontal culling values (for characters on a visible line)
-	const float visible_x_start_cull =
-		scroll_x - 100.0f; // Cull chars starting before this
-	const float visible_x_end_cull =
-		scroll_x + window_width + 100.0f; // Cull chars starting after this
-
-	ImVec2 current_draw_pos; // Will be set for each line
+	syncLineCache();
 
-	// 2. Iterate *only* through the visible lines using editor_content_lines.
-	for (int line_num = start_line_idx; line_num <= end_line_idx; ++line_num)
+	// 2. Iterate *only* through the visible rows
+	for (int row = start_row; row <= end_row; ++row)
 	{
-		// Determine the character range for the current line_num
-		size_t line_char_start_idx = editor_state.editor_content_lines[line_num];
-		size_t line_char_end_idx; // Exclusive: points to the newline or end of file
-
-		if (static_cast<size_t>(line_num + 1) < editor_state.editor_content_lines.size())
-		{
-			line_char_end_idx = editor_state.editor_content_lines[line_num + 1];
-		} else // This is the last line of the file
-		{
-			line_char_end_idx = editor_state.fileContent.size();
-		}
+		// Character range drawn on this row; exclusive end points past the
+		// newline, the end of file or the wrap point
+		EditorDisplayMap::Row visual_row = gEditorDisplayMap.rowAt(row);
+		size_t row_char_start_idx = static_cast<size_t>(visual_row.start);
+		size_t row_char_end_idx = static_cast<size_t>(visual_row.end);
 
-		// Set the drawing position for the start of this line.
 		// The Y position is relative to the top of the document, ImGui handles
 		// scrolling it into view.
-		current_draw_pos.x = base_text_pos.x;
-		current_draw_pos.y =
-			base_text_pos.y + (static_cast<float>(line_num) * line_height);
-
-		// 3. Iterate through characters *of this specific line*.
-		for (size_t char_idx_in_file = line_char_start_idx;
-			 char_idx_in_file < line_char_end_idx;)
-		{
-			// Skip continuation bytes of multi-byte characters
-			if (char_idx_in_file < editor_state.fileContent.size() &&
-				(editor_state.fileContent[char_idx_in_file] & 0xC0) == 0x80)
-			{
-				char_idx_in_file++;
-				continue;
-			}
+		ImVec2 row_origin(base_text_pos.x,
+						  base_text_pos.y + (static_cast<float>(row) * line_height));
 
-			// This character is (at least partially) horizontally visible.
-			renderCharacterAndSelection(
-				char_idx_in_file,
-				editor_state.selection_start,
-				editor_state.selection_end,
-				current_draw_pos); // This function advances current_draw_pos.x
+		// 3. Selection goes underneath the glyphs
+		renderLineSelection(row_char_start_idx, row_char_end_idx, row_origin);
 
-			if (editor_state.fileContent[char_idx_in_file] == '\n')
-			{
-				break; // Reached end of current line's content (before
-					   // line_char_end_idx if line_char_end_idx pointed to
-					   // newline itself)
-			}
+		// 4. Replay the baked glyph quads, re-baking only if the row changed
+		const CachedLine *cached = getCachedLine(row_char_start_idx, row_char_end_idx);
+		if (cached)
+		{
+			replayLine(*cached, row_origin);
+		} else
+		{
+			emitLineGlyphs(ImGui::GetWindowDrawList(),
+						   row_char_start_idx,
+						   row_char_end_idx,
+						   row_origin);
+		}
 
-			// Advance to next character, handling multi-byte UTF-8 characters
-			if (char_idx_in_file < editor_state.fileContent.size())
-			{
-				const char *current_char = &editor_state.fileContent[char_idx_in_file];
-				if ((*current_char & 0x80) == 0)
-				{
-					// Single byte character
-					char_idx_in_file++;
-				} else
-				{
-					// Multi-byte character, find the end
-					while (char_idx_in_file < editor_state.fileContent.size() &&
-						   (editor_state.fileContent[char_idx_in_file] & 0xC0) == 0x80)
-					{
-						char_idx_in_file++;
-					}
-					char_idx_in_file++; // Move past the last byte of the character
-				}
-			} else
-			{
-				char_idx_in_file++;
-			}
+		// 5. A collapsed fold header ends in a placeholder for the hidden lines
+		if (row_char_end_idx > row_char_start_idx &&
+			editor_state.fileContent[row_char_end_idx - 1] == '\n' &&
+			gEditorFolding.isCollapsed(visual_row.line))
+		{
+			float text_width =
+				gEditorDisplayMap.xOfIndex(static_cast<int>(row_char_end_idx) - 1);
+			gEditorFolding.renderFoldMarker(
+				visual_row.line, ImVec2(row_origin.x + text_width, row_origin.y));
 		}
-		// If the line ended without a newline char (e.g., last line of file),
-		// the inner loop completes when char_idx_in_file == line_char_end_idx.
 	}
-}
\ No newline at end of file
+
+	pruneLineCache();
+}
@@ -8,7 +8,9 @@
 #include "editor_types.h"
 #include "imgui.h"
 
+#include <cstdint>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 // Forward declarations
@@ -18,6 +20,8 @@ extern EditorRender gEditorRender;
 class EditorRender
 {
   public:
+	~EditorRender();
+
 	void renderEditorFrame();
 	void renderEditorContent();
 	void renderText();
@@ -30,16 +34,56 @@ class EditorRender
 							  float content_width,
 							  float content_height);
 
+	// Advance of the character at char_index when drawn at column_x, matching
+	// what renderText draws. Tabs snap to the next 4-column stop.
+	float
+	characterAdvance(size_t char_index, float column_x, const char *&char_end) const;
+
   private:
+	/*
+	 * Baked glyph geometry for one line of text. Vertices are stored relative
+	 * to the line origin so a cached line can be replayed at any scroll
+	 * position with a plain translation. Entries are keyed by a hash of the
+	 * line's bytes and syntax colors, so unchanged lines survive edits above
+	 * them and identical lines share geometry.
+	 */
+	struct CachedLine
+	{
+		std::vector<ImDrawVert> vertices;
+		std::vector<ImDrawIdx> indices;
+		uint64_t last_used_frame = 0;
+	};
+
+	std::unordered_map<uint64_t, CachedLine> line_cache;
+	uint64_t line_cache_frame = 0;
+
+	// Inputs the baked geometry depends on besides the line itself
+	ImFont *cached_font = nullptr;
+	float cached_font_size = 0.0f;
+	ImTextureData *cached_atlas_texture = nullptr;
+	ImVec2 cached_atlas_uv_scale = ImVec2(0.0f, 0.0f);
+
+	// Scratch list glyphs are baked into before being copied to the cache
+	ImDrawList *bake_draw_list = nullptr;
+
+	void syncLineCache();
+	void pruneLineCache();
+	uint64_t hashLine(size_t line_start, size_t line_end) const;
+	const CachedLine *getCachedLine(size_t line_start, size_t line_end);
+	void emitLineGlyphs(ImDrawList *draw_list,
+						size_t line_start,
+						size_t line_end,
+						const ImVec2 &origin);
+	void bakeLine(size_t line_start, size_t line_end, CachedLine &line);
+	void replayLine(const CachedLine &line, const ImVec2 &origin);
+	void renderLineSelection(size_t line_start, size_t line_end, const ImVec2 &origin);
+	bool isCharacterSelected(int char_index, int selection_start, int selection_end) const;
+
 	void renderLineBackground(int line_num,
 							  int start_visible_line,
 							  int end_visible_line,
 							  size_t cursor_line,
 							  const ImVec2 &line_start_draw_pos);
-	void renderCharacterAndSelection(size_t char_index,
-									 int selection_start,
-									 int selection_end,
-									 ImVec2 &current_draw_pos);
 	bool skipLineIfAboveVisible(size_t &char_index,
 								int line_num,
 								int start_visible_line,
@@ -1,5 +1,7 @@
 #include "editor_scroll.h"
 #include "editor.h"
+#include "editor_display_map.h"
+#include "editor_minimap.h"
 #include "editor_types.h"
 #include <algorithm>
 #include <cmath>
@@ -183,6 +185,12 @@ void EditorScroll::processMouseWheelScrolling()
 
 float EditorScroll::calculateCursorXPosition()
 {
+	if (gEditorDisplayMap.isWrapping())
+	{
+		return editor_state.text_pos.x +
+			   gEditorDisplayMap.xOfIndex(editor_state.cursor_index);
+	}
+
 	// Get the line number for the current cursor_index
 	// You can use the helper getLineFromPosition from this class if it exists,
 	// or EditorUtils::GetLineFromPosition, or gEditor.getLineFromPos.
@@ -258,15 +266,15 @@ ScrollChange EditorScroll::ensureCursorVisible()
 	// Calculate viewport dimensions
 	float scrollbar_width = ImGui::GetStyle().ScrollbarSize;
 	float additional_padding = 80.0f;
-	float viewport_width = editor_state.size.x - scrollbar_width - additional_padding;
+	float viewport_width = editor_state.size.x - gEditorMinimap.width() -
+						   scrollbar_width - additional_padding;
 	float viewport_height = editor_state.size.y;
 
 	// Calculate cursor position
 	float abs_cursor_x = calculateCursorXPosition();
-	// Use our own getLineFromPosition to avoid circular dependency
-	int cursor_line =
-		getLineFromPosition(editor_state.editor_content_lines, editor_state.cursor_index);
-	float abs_cursor_y = editor_state.text_pos.y + cursor_line * editor_state.line_height;
+	// Visual row of the cursor; the same as its line unless soft wrap is on
+	int cursor_row = gEditorDisplayMap.rowOfIndex(editor_state.cursor_index);
+	float abs_cursor_y = editor_state.text_pos.y + cursor_row * editor_state.line_height;
 
 	// Calculate cursor position relative to viewport
 	float visible_cursor_x = abs_cursor_x - editor_state.text_pos.x - scroll_x;
@@ -360,11 +368,20 @@ void EditorScroll::adjustScrollForCursorVisibility()
 	float requested_x, requested_y;
 	if (handleScrollRequest(requested_x, requested_y))
 	{
-		// Set animation targets for direct requests
-		scrollAnimation.active_x = true;
-		scrollAnimation.target_x = requested_x;
-		scrollAnimation.active_y = true;
-		scrollAnimation.target_y = requested_y;
+		if (requestedScrollAnimate)
+		{
+			// Set animation targets for direct requests
+			scrollAnimation.active_x = true;
+			scrollAnimation.target_x = requested_x;
+			scrollAnimation.active_y = true;
+			scrollAnimation.target_y = requested_y;
+		} else
+		{
+			scrollAnimation.active_x = false;
+			scrollAnimation.active_y = false;
+			editor_state.current_scroll_x = requested_x;
+			editor_state.current_scroll_y = requested_y;
+		}
 
 		// Store the targets in state variables too
 		scrollX = requested_x;
@@ -413,10 +430,8 @@ void EditorScroll::handleCursorMovementScroll()
 	float visible_end_x = visible_start_x + window_width;
 
 	// Get cursor position
-	// Use our own method for getting line from position
-	int cursor_line =
-		getLineFromPosition(editor_state.editor_content_lines, editor_state.cursor_index);
-	float cursor_y = editor_state.text_pos.y + (cursor_line * editor_state.line_height);
+	int cursor_row = gEditorDisplayMap.rowOfIndex(editor_state.cursor_index);
+	float cursor_y = editor_state.text_pos.y + (cursor_row * editor_state.line_height);
 	float cursor_x = calculateCursorXPosition();
 
 	// Handle vertical scrolling
@@ -440,10 +455,9 @@ void EditorScroll::handleCursorMovementScroll()
 
 void EditorScroll::centerCursorVertically()
 {
-	// Calculate cursor line position
-	int cursor_line =
-		getLineFromPosition(editor_state.editor_content_lines, editor_state.cursor_index);
-	float cursor_y = cursor_line * editor_state.line_height;
+	// Calculate cursor row position
+	int cursor_row = gEditorDisplayMap.rowOfIndex(editor_state.cursor_index);
+	float cursor_y = cursor_row * editor_state.line_height;
 
 	// Calculate center position
 	float viewport_height = editor_state.size.y;
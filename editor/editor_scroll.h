@@ -25,11 +25,13 @@ class EditorScroll
 
 	void adjustScrollForCursorVisibility();
 
-	// Direct scroll request handling
-	void requestScroll(float x, float y)
+	// Direct scroll request handling. Unanimated requests land on the next
+	// frame as-is, for dragging.
+	void requestScroll(float x, float y, bool animate = true)
 	{
 		requestedScrollX = x;
 		requestedScrollY = y;
+		requestedScrollAnimate = animate;
 		hasScrollRequest = true;
 	}
 
@@ -86,6 +88,7 @@ class EditorScroll
 	// Direct scroll request state
 	float requestedScrollX = 0;
 	float requestedScrollY = 0;
+	bool requestedScrollAnimate = true;
 	bool hasScrollRequest = false;
 
 	// Extra state variables for bookmark/specific scrolling
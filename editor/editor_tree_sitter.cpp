@@ -1,6 +1,7 @@
 #include "editor_tree_sitter.h"
 #include "../files/files.h"
 #include "editor.h"
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -16,6 +17,8 @@
 #include <limits.h> // Or <climits> for C++ style
 
 #include <algorithm>
+#include <cctype>
+#include <cstdlib>
 #include <iostream>
 
 #ifdef __APPLE__
@@ -32,6 +35,7 @@ std::unordered_map<std::string, TSQuery *> TreeSitter::queryCache;
 // incremental parsing
 TSTree *TreeSitter::previousTree = nullptr;
 std::string TreeSitter::previousContent;
+std::vector<FoldRange> TreeSitter::previousFolds;
 
 const TSLanguage *TreeSitter::currentLanguage = nullptr;
 std::string TreeSitter::currentExtension = "";
@@ -301,6 +305,19 @@ TSQuery *TreeSitter::loadQueryFromCacheOrFile(TSLanguage *lang,
 		return cacheIt->second;
 	}
 
+	TSQuery *query = compileQuery(lang, full_path);
+	if (!query)
+	{
+		return nullptr;
+	}
+
+	// Store using full_path as key
+	queryCache[full_path] = query;
+	return query;
+}
+
+TSQuery *TreeSitter::compileQuery(TSLanguage *lang, const std::string &full_path)
+{
 	std::ifstream file(full_path);
 	if (!file.is_open())
 	{
@@ -322,11 +339,82 @@ TSQuery *TreeSitter::loadQueryFromCacheOrFile(TSLanguage *lang,
 				  << "\n";
 		return nullptr;
 	}
-
-	// Store using full_path as key
-	queryCache[full_path] = query;
 	return query;
 }
+
+void TreeSitter::precompileQueries()
+{
+	// One extension per language detectLanguageAndQuery knows
+	static const char *const extensions[] = {".c",
+											 ".cpp",
+											 ".js",
+											 ".py",
+											 ".cs",
+											 ".html",
+											 ".tsx",
+											 ".css",
+											 ".java",
+											 ".go",
+											 ".tf",
+											 ".json",
+											 ".sh",
+											 ".kt",
+											 ".rs",
+											 ".toml",
+											 ".rb"};
+	for (const char *extension : extensions)
+	{
+		auto [lang, query_path] = detectLanguageAndQuery(extension);
+		if (!lang)
+		{
+			continue;
+		}
+		for (const std::string &path : {query_path, foldQueryPath(query_path)})
+		{
+			std::string full_path = getResourcePath(path);
+			{
+				std::lock_guard<std::mutex> lock(parserMutex);
+				if (queryCache.count(full_path))
+				{
+					continue;
+				}
+			}
+			// Not every language has fold queries
+			if (!std::filesystem::exists(full_path))
+			{
+				continue;
+			}
+
+			// Compiled outside the lock so a parse never waits for it
+			TSQuery *query = compileQuery(lang, full_path);
+			if (!query)
+			{
+				continue;
+			}
+			std::lock_guard<std::mutex> lock(parserMutex);
+			if (!queryCache.emplace(full_path, query).second)
+			{
+				ts_query_delete(query);
+			}
+		}
+	}
+}
+std::pair<TSLanguage *, std::string> TreeSitter::tagsQuery(const std::string &extension)
+{
+	auto [lang, query_path] = detectLanguageAndQuery(extension);
+	if (!lang)
+	{
+		return {};
+	}
+	// Only some languages have definitions worth indexing
+	std::string full_path = getResourcePath(queryPathIn(query_path, "tags"));
+	if (!std::filesystem::exists(full_path))
+	{
+		return {};
+	}
+	return {lang, full_path};
+}
+
 void TreeSitter::clearQueryCache()
 {
 	std::lock_guard<std::mutex> lock(parserMutex);
@@ -469,6 +557,17 @@ void TreeSitter::parse(const std::string &fileContent,
 	// Create new parse tree
 	TSTree *newTree = createNewTree(parser, initialParse, fileContent);
 	// printAST(newTree, fileContent); // <-- This line replaces the lambda
+
+	// Folds are updated from the edit while the old tree is still around
+	updateFolds(lang,
+				query_path,
+				initialParse ? nullptr : previousTree,
+				newTree,
+				fileContent,
+				start,
+				oldEnd,
+				newEnd);
+
 	//   Update state
 	if (previousTree)
 		ts_tree_delete(previousTree);
@@ -484,6 +583,155 @@ void TreeSitter::parse(const std::string &fileContent,
 		query, newTree, fileContent, fileColors, initialParse, start, newEnd);
 }
 
+std::string TreeSitter::foldQueryPath(const std::string &query_path)
+{
+	// Fold queries live next to the highlight queries: queries/folds/<lang>.scm
+	return queryPathIn(query_path, "folds");
+}
+
+std::string TreeSitter::queryPathIn(const std::string &query_path, const char *dir)
+{
+	size_t slash = query_path.rfind('/');
+	size_t name_start = slash == std::string::npos ? 0 : slash + 1;
+	return query_path.substr(0, name_start) + dir + "/" + query_path.substr(name_start);
+}
+
+void TreeSitter::updateFolds(TSLanguage *lang,
+							 const std::string &query_path,
+							 TSTree *oldTree,
+							 TSTree *newTree,
+							 const std::string &content,
+							 size_t start,
+							 size_t oldEnd,
+							 size_t newEnd)
+{
+	std::vector<uint32_t> lineStarts{0};
+	for (size_t pos = content.find('\n'); pos != std::string::npos;
+		 pos = content.find('\n', pos + 1))
+	{
+		lineStarts.push_back(static_cast<uint32_t>(pos + 1));
+	}
+	auto lineOf = [&lineStarts](uint32_t byte) {
+		auto it = std::upper_bound(lineStarts.begin(), lineStarts.end(), byte);
+		return static_cast<int>(it - lineStarts.begin()) - 1;
+	};
+
+	TSQuery *query = loadQueryFromCacheOrFile(lang, foldQueryPath(query_path));
+	if (!query)
+	{
+		previousFolds.clear();
+		gEditorFolding.publishRanges({}, lineStarts.size(), content.size());
+		return;
+	}
+
+	std::vector<FoldRange> folds;
+	TSQueryCursor *cursor = ts_query_cursor_new();
+
+	if (oldTree)
+	{
+		// Only folds touching the edit, or a region tree-sitter re-shaped because
+		// of it (an opened comment or string), need the query again.
+		uint32_t dirtyStart = static_cast<uint32_t>(start);
+		uint32_t dirtyEnd = static_cast<uint32_t>(newEnd);
+		uint32_t changedCount = 0;
+		TSRange *changed = ts_tree_get_changed_ranges(oldTree, newTree, &changedCount);
+		for (uint32_t i = 0; i < changedCount; ++i)
+		{
+			dirtyStart = std::min(dirtyStart, changed[i].start_byte);
+			dirtyEnd = std::max(dirtyEnd, changed[i].end_byte);
+		}
+		free(changed);
+
+		dirtyEnd = std::min(dirtyEnd, static_cast<uint32_t>(content.size()));
+		const int firstDirtyLine = lineOf(dirtyStart);
+		const int lastDirtyLine = lineOf(dirtyEnd);
+
+		// Lines after the dirty region sit in the unchanged suffix and only move
+		// by the number of newlines the edit added or removed
+		auto newlines = [](const std::string &text, size_t from, size_t to) {
+			return static_cast<int>(
+				std::count(text.begin() + from, text.begin() + to, '\n'));
+		};
+		const int lineDelta =
+			newlines(content, start, newEnd) - newlines(previousContent, start, oldEnd);
+		const int lastDirtyOldLine = lastDirtyLine - lineDelta;
+		for (const FoldRange &fold : previousFolds)
+		{
+			if (fold.end_line < firstDirtyLine)
+			{
+				folds.push_back(fold);
+			} else if (fold.start_line > lastDirtyOldLine)
+			{
+				folds.push_back(
+					FoldRange{fold.start_line + lineDelta, fold.end_line + lineDelta});
+			}
+		}
+
+		// Whole lines, so a node ending just before the edit on the same line is
+		// found again rather than lost
+		uint32_t rangeEnd = lastDirtyLine + 1 < static_cast<int>(lineStarts.size())
+								? lineStarts[lastDirtyLine + 1]
+								: static_cast<uint32_t>(content.size());
+		ts_query_cursor_set_byte_range(cursor, lineStarts[firstDirtyLine], rangeEnd);
+	}
+
+	ts_query_cursor_exec(cursor, query, ts_tree_root_node(newTree));
+	TSQueryMatch match;
+	while (ts_query_cursor_next_match(cursor, &match))
+	{
+		for (uint32_t i = 0; i < match.capture_count; ++i)
+		{
+			TSNode node = match.captures[i].node;
+			uint32_t startByte = ts_node_start_byte(node);
+			uint32_t lastByte = ts_node_end_byte(node);
+			if (lastByte <= startByte || lastByte > content.size())
+			{
+				continue;
+			}
+
+			// Trailing whitespace never decides where a fold ends
+			lastByte--;
+			while (lastByte > startByte &&
+				   std::isspace(static_cast<unsigned char>(content[lastByte])))
+			{
+				lastByte--;
+			}
+
+			int startLine = lineOf(startByte);
+			int endLine = lineOf(lastByte);
+
+			// A last line of only closing brackets stays visible under the header
+			size_t closingStart = content.find_first_not_of(" \t", lineStarts[endLine]);
+			if (closingStart != std::string::npos && closingStart <= lastByte &&
+				content.find_first_not_of("}])>;,", closingStart) > lastByte)
+			{
+				endLine--;
+			}
+
+			if (endLine > startLine)
+			{
+				folds.push_back(FoldRange{startLine, endLine});
+			}
+		}
+	}
+	ts_query_cursor_delete(cursor);
+
+	// One fold per header line, the outermost one
+	std::sort(folds.begin(), folds.end(), [](const FoldRange &a, const FoldRange &b) {
+		return a.start_line != b.start_line ? a.start_line < b.start_line
+											: a.end_line > b.end_line;
+	});
+	folds.erase(std::unique(folds.begin(),
+							folds.end(),
+							[](const FoldRange &a, const FoldRange &b) {
+								return a.start_line == b.start_line;
+							}),
+				folds.end());
+
+	previousFolds = folds;
+	gEditorFolding.publishRanges(std::move(folds), lineStarts.size(), content.size());
+}
+
 void TreeSitter::printAST(TSTree *tree, const std::string &fileContent)
 {
 	if (!tree)
@@ -1,6 +1,7 @@
 // editor_tree_sitter.h
 #pragma once
 #include "../util/settings.h"
+#include "editor_folding.h"
 #include "imgui.h"
 #include <iostream>
 #include <mutex>
@@ -26,6 +27,15 @@ class TreeSitter
   public:
 	static std::string getResourcePath(const std::string &relativePathToQuery);
 	static void clearQueryCache();
+	// Compiles the highlight and fold queries of every language ahead of the first
+	// parse. Meant for a worker thread; parsing meanwhile compiles what it needs.
+	static void precompileQueries();
+	// Language of `extension` and the resolved path of its tag query,
+	// queries/tags/<lang>.scm, which captures each definition as
+	// @definition.<kind> and its name as @name. Null language when there is none.
+	static std::pair<TSLanguage *, std::string> tagsQuery(const std::string &extension);
+	// Compiles a query file into a query the caller owns and deletes
+	static TSQuery *compileQuery(TSLanguage *lang, const std::string &full_path);
 	static void parse(const std::string &fileContent,
 					  std::vector<ImVec4> &fileColors,
 					  const std::string &extension,
@@ -51,6 +61,7 @@ class TreeSitter
 	// incremental parsing
 	static TSTree *previousTree;
 	static std::string previousContent;
+	static std::vector<FoldRange> previousFolds;
 
 	static std::pair<TSLanguage *, std::string>
 	detectLanguageAndQuery(const std::string &extension);
@@ -71,6 +82,17 @@ class TreeSitter
 										 bool initialParse,
 										 size_t start,
 										 size_t end);
+	static std::string foldQueryPath(const std::string &query_path);
+	// queries/<dir>/<lang>.scm for the highlight query queries/<lang>.scm
+	static std::string queryPathIn(const std::string &query_path, const char *dir);
+	static void updateFolds(TSLanguage *lang,
+							const std::string &query_path,
+							TSTree *oldTree,
+							TSTree *newTree,
+							const std::string &content,
+							size_t start,
+							size_t oldEnd,
+							size_t newEnd);
 	static const TSLanguage *currentLanguage;
 	static std::string currentExtension;
 	static void printAST(TSTree *tree, const std::string &fileContent);
@@ -88,11 +88,21 @@ struct EditorState
 	 */
 	std::vector<float> line_widths;
 
+	/*
+	 * Line Indents
+	 * Leading whitespace of each line in columns (tab = 4). Blank and
+	 * whitespace-only lines take the smaller indent of the nearest non-blank
+	 * lines above and below, so indent guides run through them unbroken.
+	 * Rebuilt with the line starts.
+	 */
+	std::vector<int> line_indents;
+
 	// scalling values
 	float current_scroll_x, current_scroll_y;
 
 	// Caching for expensive measurements
 	std::string cached_text;
+	size_t text_version = 0; // Bumped each time cached_text picks up an edit
 
 	// Miscellaneous state variables
 	bool rainbow_mode;		 // Visual setting for cursor mode, line numbers, and file
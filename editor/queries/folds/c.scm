@@ -0,0 +1,16 @@
+[
+  (function_definition)
+  (compound_statement)
+  (struct_specifier)
+  (enum_specifier)
+  (union_specifier)
+  (initializer_list)
+  (switch_statement)
+  (case_statement)
+  (comment)
+  (preproc_if)
+  (preproc_ifdef)
+  (preproc_else)
+  (preproc_elif)
+  (preproc_function_def)
+] @fold
@@ -0,0 +1,23 @@
+[
+  (function_definition)
+  (compound_statement)
+  (class_specifier)
+  (struct_specifier)
+  (enum_specifier)
+  (union_specifier)
+  (namespace_definition)
+  (template_declaration)
+  (field_declaration_list)
+  (initializer_list)
+  (lambda_expression)
+  (switch_statement)
+  (case_statement)
+  (try_statement)
+  (catch_clause)
+  (comment)
+  (preproc_if)
+  (preproc_ifdef)
+  (preproc_else)
+  (preproc_elif)
+  (preproc_function_def)
+] @fold
@@ -0,0 +1,12 @@
+[
+  (namespace_declaration)
+  (class_declaration)
+  (struct_declaration)
+  (interface_declaration)
+  (enum_declaration)
+  (method_declaration)
+  (constructor_declaration)
+  (block)
+  (initializer_expression)
+  (comment)
+] @fold
@@ -0,0 +1,7 @@
+[
+  (rule_set)
+  (media_statement)
+  (keyframes_statement)
+  (at_rule)
+  (comment)
+] @fold
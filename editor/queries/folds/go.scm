@@ -0,0 +1,13 @@
+[
+  (function_declaration)
+  (method_declaration)
+  (func_literal)
+  (block)
+  (type_declaration)
+  (import_declaration)
+  (const_declaration)
+  (var_declaration)
+  (composite_literal)
+  (expression_switch_statement)
+  (comment)
+] @fold
@@ -0,0 +1,7 @@
+[
+  (block)
+  (object)
+  (tuple)
+  (heredoc_template)
+  (comment)
+] @fold
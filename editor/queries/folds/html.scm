@@ -0,0 +1,6 @@
+[
+  (element)
+  (script_element)
+  (style_element)
+  (comment)
+] @fold
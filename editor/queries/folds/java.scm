@@ -0,0 +1,10 @@
+[
+  (class_body)
+  (interface_body)
+  (enum_body)
+  (constructor_body)
+  (block)
+  (switch_block)
+  (array_initializer)
+  (block_comment)
+] @fold
@@ -0,0 +1,11 @@
+[
+  (statement_block)
+  (class_body)
+  (switch_body)
+  (object)
+  (array)
+  (arguments)
+  (jsx_element)
+  (template_string)
+  (comment)
+] @fold
@@ -0,0 +1,10 @@
+[
+  (import_list)
+  (class_body)
+  (enum_class_body)
+  (function_body)
+  (lambda_literal)
+  (when_expression)
+  (control_structure_body)
+  (multiline_comment)
+] @fold
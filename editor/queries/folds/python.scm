@@ -0,0 +1,16 @@
+[
+  (function_definition)
+  (class_definition)
+  (if_statement)
+  (elif_clause)
+  (else_clause)
+  (for_statement)
+  (while_statement)
+  (with_statement)
+  (try_statement)
+  (except_clause)
+  (dictionary)
+  (list)
+  (argument_list)
+  (parameters)
+] @fold
@@ -0,0 +1,13 @@
+[
+  (class)
+  (module)
+  (singleton_class)
+  (method)
+  (singleton_method)
+  (do_block)
+  (block)
+  (if)
+  (case)
+  (hash)
+  (array)
+] @fold
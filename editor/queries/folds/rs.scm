@@ -0,0 +1,16 @@
+[
+  (mod_item)
+  (function_item)
+  (struct_item)
+  (enum_item)
+  (union_item)
+  (trait_item)
+  (impl_item)
+  (macro_definition)
+  (block)
+  (match_block)
+  (field_declaration_list)
+  (declaration_list)
+  (use_list)
+  (block_comment)
+] @fold
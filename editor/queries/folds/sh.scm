@@ -0,0 +1,9 @@
+[
+  (function_definition)
+  (compound_statement)
+  (if_statement)
+  (case_statement)
+  (for_statement)
+  (while_statement)
+  (heredoc_body)
+] @fold
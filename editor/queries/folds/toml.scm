@@ -0,0 +1,6 @@
+[
+  (table)
+  (table_array_element)
+  (array)
+  (inline_table)
+] @fold
@@ -0,0 +1,13 @@
+[
+  (statement_block)
+  (class_body)
+  (switch_body)
+  (enum_body)
+  (object_type)
+  (object)
+  (array)
+  (arguments)
+  (jsx_element)
+  (template_string)
+  (comment)
+] @fold
@@ -0,0 +1,58 @@
+; Definitions for the workspace symbol index: the name as @name, the whole
+; definition as @definition.<kind>. Where patterns overlap the later one wins.
+; Qualified names like Foo::bar are split into container and name by the index.
+
+(function_definition
+  declarator: (function_declarator
+    declarator: (_) @name)) @definition.function
+
+(function_definition
+  declarator: (pointer_declarator
+    declarator: (function_declarator
+      declarator: (_) @name))) @definition.function
+
+(function_definition
+  declarator: (reference_declarator
+    (function_declarator
+      declarator: (_) @name))) @definition.function
+
+; Methods defined inside the class body. Declarations are left out, so the
+; definition is found rather than the line in the header.
+(field_declaration_list
+  (function_definition
+    declarator: (function_declarator
+      declarator: (_) @name)) @definition.method)
+
+(class_specifier
+  name: (_) @name
+  body: (field_declaration_list)) @definition.class
+
+(struct_specifier
+  name: (_) @name
+  body: (field_declaration_list)) @definition.struct
+
+(union_specifier
+  name: (_) @name
+  body: (field_declaration_list)) @definition.struct
+
+(enum_specifier
+  name: (_) @name
+  body: (enumerator_list)) @definition.enum
+
+(enumerator
+  name: (identifier) @name) @definition.constant
+
+(namespace_definition
+  name: (_) @name) @definition.namespace
+
+(type_definition
+  declarator: (type_identifier) @name) @definition.type
+
+(alias_declaration
+  name: (type_identifier) @name) @definition.type
+
+(preproc_def
+  name: (identifier) @name) @definition.macro
+
+(preproc_function_def
+  name: (identifier) @name) @definition.macro
@@ -0,0 +1,32 @@
+; Definitions for the workspace symbol index: the name as @name, the whole
+; definition as @definition.<kind>. Where patterns overlap the later one wins.
+
+(namespace_declaration
+  name: (_) @name) @definition.namespace
+
+(class_declaration
+  name: (identifier) @name) @definition.class
+
+(record_declaration
+  name: (identifier) @name) @definition.class
+
+(interface_declaration
+  name: (identifier) @name) @definition.interface
+
+(struct_declaration
+  name: (identifier) @name) @definition.struct
+
+(enum_declaration
+  name: (identifier) @name) @definition.enum
+
+(enum_member_declaration
+  name: (identifier) @name) @definition.constant
+
+(method_declaration
+  name: (identifier) @name) @definition.method
+
+(constructor_declaration
+  name: (identifier) @name) @definition.method
+
+(property_declaration
+  name: (identifier) @name) @definition.property
@@ -0,0 +1,22 @@
+; Definitions for the workspace symbol index: the name as @name, the whole
+; definition as @definition.<kind>. Where patterns overlap the later one wins.
+
+(function_declaration
+  name: (identifier) @name) @definition.function
+
+(method_declaration
+  name: (field_identifier) @name) @definition.method
+
+(type_spec
+  name: (type_identifier) @name) @definition.type
+
+(type_spec
+  name: (type_identifier) @name
+  type: (struct_type)) @definition.struct
+
+(type_spec
+  name: (type_identifier) @name
+  type: (interface_type)) @definition.interface
+
+(const_spec
+  name: (identifier) @name) @definition.constant
@@ -0,0 +1,20 @@
+; Definitions for the workspace symbol index: the name as @name, the whole
+; definition as @definition.<kind>. Where patterns overlap the later one wins.
+
+(class_declaration
+  name: (identifier) @name) @definition.class
+
+(interface_declaration
+  name: (identifier) @name) @definition.interface
+
+(enum_declaration
+  name: (identifier) @name) @definition.enum
+
+(enum_constant
+  name: (identifier) @name) @definition.constant
+
+(method_declaration
+  name: (identifier) @name) @definition.method
+
+(constructor_declaration
+  name: (identifier) @name) @definition.method
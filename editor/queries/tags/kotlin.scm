@@ -0,0 +1,18 @@
+; Definitions for the workspace symbol index: the name as @name, the whole
+; definition as @definition.<kind>. Where patterns overlap the later one wins.
+
+(class_declaration
+  (type_identifier) @name) @definition.class
+
+(object_declaration
+  (type_identifier) @name) @definition.class
+
+(type_alias
+  (type_identifier) @name) @definition.type
+
+(function_declaration
+  (simple_identifier) @name) @definition.function
+
+(class_body
+  (function_declaration
+    (simple_identifier) @name) @definition.method)
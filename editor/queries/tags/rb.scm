@@ -0,0 +1,14 @@
+; Definitions for the workspace symbol index: the name as @name, the whole
+; definition as @definition.<kind>. Where patterns overlap the later one wins.
+
+(method
+  name: (_) @name) @definition.method
+
+(singleton_method
+  name: (_) @name) @definition.method
+
+(class
+  name: (_) @name) @definition.class
+
+(module
+  name: (_) @name) @definition.namespace
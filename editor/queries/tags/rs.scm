@@ -0,0 +1,40 @@
+; Definitions for the workspace symbol index: the name as @name, the whole
+; definition as @definition.<kind>. Where patterns overlap the later one wins.
+
+(function_item
+  name: (identifier) @name) @definition.function
+
+(impl_item
+  body: (declaration_list
+    (function_item
+      name: (identifier) @name) @definition.method))
+
+(function_signature_item
+  name: (identifier) @name) @definition.method
+
+(struct_item
+  name: (type_identifier) @name) @definition.struct
+
+(union_item
+  name: (type_identifier) @name) @definition.struct
+
+(enum_item
+  name: (type_identifier) @name) @definition.enum
+
+(trait_item
+  name: (type_identifier) @name) @definition.interface
+
+(type_item
+  name: (type_identifier) @name) @definition.type
+
+(mod_item
+  name: (identifier) @name) @definition.namespace
+
+(macro_definition
+  name: (identifier) @name) @definition.macro
+
+(const_item
+  name: (identifier) @name) @definition.constant
+
+(static_item
+  name: (identifier) @name) @definition.constant
@@ -0,0 +1,5 @@
+; Definitions for the workspace symbol index: the name as @name, the whole
+; definition as @definition.<kind>.
+
+(function_definition
+  name: (word) @name) @definition.function
@@ -1,5 +1,9 @@
 #include "file_content_search.h"
+#include "../editor/editor_highlight.h"
+#include "../editor/editor_tree_sitter.h"
 #include "../util/close_popper.h"
+#include "../util/settings.h"
+#include "files.h"
 #include <algorithm>
 #include <iostream>
 
@@ -7,152 +11,348 @@ FileContentSearch gFileContentSearch;
 
 FileContentSearch::FileContentSearch() {}
 
-std::string FileContentSearch::toLower(const std::string &s)
+const std::vector<size_t> &FileContentSearch::findAllOccurrences(bool ignoreCase)
 {
-	std::string result = s;
-	std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c) {
-		return std::tolower(c);
-	});
-	return result;
-}
+	// Edits made since the editor last laid out the text reach the index
+	// through onTextChanged; without any this returns right away
+	gEditor.updateLineStarts();
 
-void FileContentSearch::findNext(bool ignoreCase)
-{
 	if (findText.empty())
-		return;
-
-	size_t startPos;
-	if (lastFoundPos == std::string::npos)
 	{
-		startPos = editor_state.cursor_index;
-	} else
+		matches.clear();
+		matchEnds.clear();
+		regexError.clear();
+		matchesValid = false;
+		return matches;
+	}
+
+	if (matchesValid && matchesVersion == editor_state.text_version &&
+		matchesQuery == findText && matchesRegex == useRegex &&
+		searcher.ignoresCase() == ignoreCase)
 	{
-		startPos = lastFoundPos + 1;
+		return matches;
 	}
 
-	if (startPos >= editor_state.fileContent.length())
-		startPos = 0; // Wrap around if at end
+	searcher = LiteralSearch(findText, ignoreCase);
+	matchesQuery = findText;
+	matchesRegex = useRegex;
+	matches.clear();
+	matchEnds.clear();
+	regexError.clear();
+	// A bad pattern is cached too, so it is not recompiled every frame
+	if (!useRegex || regex.compile(findText, ignoreCase, regexError))
+	{
+		scanMatches(0, editor_state.fileContent.size(), matches, matchEnds);
+	}
+	matchesVersion = editor_state.text_version;
+	matchesValid = true;
+	return matches;
+}
 
-	size_t foundPos;
-	if (ignoreCase)
+void FileContentSearch::scanMatches(size_t begin,
+									size_t end,
+									std::vector<size_t> &starts,
+									std::vector<size_t> &ends)
+{
+	const std::string &text = editor_state.fileContent;
+	if (!matchesRegex)
 	{
-		std::string fileContentLower = toLower(editor_state.fileContent);
-		std::string findTextLower = toLower(findText);
-		foundPos = fileContentLower.find(findTextLower, startPos);
-	} else
+		size_t first = starts.size();
+		searcher.findAll(text.data(), begin, end, starts);
+		for (size_t i = first; i < starts.size(); ++i)
+		{
+			ends.push_back(starts[i] + searcher.length());
+		}
+		return;
+	}
+	if (!regex.valid())
 	{
-		foundPos = editor_state.fileContent.find(findText, startPos);
+		return;
+	}
+	std::vector<std::pair<size_t, size_t>> found;
+	regex.findAll(text.data(), begin, end, found);
+	for (const auto &[match_start, match_end] : found)
+	{
+		starts.push_back(match_start);
+		ends.push_back(match_end);
 	}
+}
 
-	std::cout << "Searching for '" << findText << "' starting from position " << startPos;
-	if (ignoreCase)
-		std::cout << " (case-insensitive)";
-	std::cout << std::endl;
+void FileContentSearch::onTextChanged(size_t start, size_t old_end, size_t new_end)
+{
+	// Matches never cross a newline, so only the lines the edit touched can
+	// gain or lose one; everything after them just moves
+	const std::string &text = editor_state.fileContent;
+	size_t line_begin = 0;
+	if (start > 0)
+	{
+		size_t newline = text.rfind('\n', start - 1);
+		line_begin = newline == std::string::npos ? 0 : newline + 1;
+	}
+	size_t new_line_end = text.find('\n', new_end);
+	if (new_line_end == std::string::npos)
+	{
+		new_line_end = text.size();
+	}
+	const size_t old_line_end = new_line_end - new_end + old_end;
 
-	if (foundPos == std::string::npos)
+	if (lastFoundPos != std::string::npos)
 	{
-		// Wrap around to the beginning
-		if (ignoreCase)
+		if (lastFoundPos >= old_line_end)
 		{
-			std::string fileContentLower = toLower(editor_state.fileContent);
-			std::string findTextLower = toLower(findText);
-			foundPos = fileContentLower.find(findTextLower);
-		} else
+			lastFoundPos = lastFoundPos - old_end + new_end;
+		} else if (lastFoundPos >= line_begin)
 		{
-			foundPos = editor_state.fileContent.find(findText);
+			lastFoundPos = std::string::npos;
 		}
-		std::cout << "Wrapped search to beginning" << std::endl;
 	}
 
-	if (foundPos != std::string::npos)
+	if (!matchesValid || matchesVersion + 1 != editor_state.text_version)
 	{
-		lastFoundPos = foundPos;
-		editor_state.cursor_index = foundPos;
-		editor_state.selection_start = foundPos;
-		editor_state.selection_end = foundPos + findText.length();
-		editor_state.center_cursor_vertical = true;
-
-		std::cout << "Found at position: " << foundPos
-				  << ", cursor now at: " << editor_state.cursor_index << std::endl;
-	} else
+		matchesValid = false;
+		return;
+	}
+	matchesVersion = editor_state.text_version;
+	if (!regexError.empty())
 	{
-		std::cout << "Not found" << std::endl;
+		return;
 	}
+
+	auto first = std::lower_bound(matches.begin(), matches.end(), line_begin);
+	auto last = std::lower_bound(first, matches.end(), old_line_end);
+	const size_t erase_from = first - matches.begin();
+	const size_t erase_to = last - matches.begin();
+	matches.erase(first, last);
+	matchEnds.erase(matchEnds.begin() + erase_from, matchEnds.begin() + erase_to);
+	for (size_t i = erase_from; i < matches.size(); ++i)
+	{
+		matches[i] = matches[i] - old_end + new_end;
+		matchEnds[i] = matchEnds[i] - old_end + new_end;
+	}
+
+	std::vector<size_t> starts;
+	std::vector<size_t> ends;
+	scanMatches(line_begin, new_line_end, starts, ends);
+	matches.insert(matches.begin() + erase_from, starts.begin(), starts.end());
+	matchEnds.insert(matchEnds.begin() + erase_from, ends.begin(), ends.end());
 }
 
-void FileContentSearch::findPrevious(bool ignoreCase)
+int FileContentSearch::currentMatchIndex() const
 {
-	if (findText.empty())
-		return;
-
-	size_t startPos;
 	if (lastFoundPos == std::string::npos)
 	{
-		startPos = editor_state.cursor_index;
-	} else
+		return -1;
+	}
+	auto it = std::lower_bound(matches.begin(), matches.end(), lastFoundPos);
+	if (it == matches.end() || *it != lastFoundPos)
 	{
-		startPos = (lastFoundPos == 0) ? editor_state.fileContent.length() - 1
-									   : lastFoundPos - 1;
+		return -1;
 	}
+	return static_cast<int>(it - matches.begin());
+}
 
-	size_t foundPos;
-	if (ignoreCase)
+void FileContentSearch::selectMatch(size_t index)
+{
+	lastFoundPos = matches[index];
+	editor_state.cursor_index = matches[index];
+	editor_state.selection_start = matches[index];
+	editor_state.selection_end = matchEnds[index];
+	editor_state.center_cursor_vertical = true;
+}
+
+void FileContentSearch::commitReplacement(std::string content,
+										  std::vector<ImVec4> colors,
+										  int cursor)
+{
+	gEditorHighlight.cancelHighlighting();
+	gFileExplorer.forceCommitUndoState();
+
+	gEditor.replaceContent(std::move(content));
+	editor_state.fileColors = std::move(colors);
+	editor_state.cursor_index = cursor;
+	editor_state.selection_active = false;
+	editor_state.selection_start = editor_state.selection_end = cursor;
+	editor_state.multi_cursor_indices.clear();
+	editor_state.multi_cursor_prefered_columns.clear();
+	editor_state.multi_selections.clear();
+	lastFoundPos = std::string::npos;
+
+	gEditor.updateLineStarts();
+	gEditorHighlight.highlightContent();
+
+	// One undo step however many matches were replaced
+	gFileExplorer.addUndoState();
+	gFileExplorer.forceCommitUndoState();
+	gFileExplorer._unsavedChanges = true;
+	gFileExplorer.saveCurrentFile();
+}
+
+void FileContentSearch::replaceCurrent(bool ignoreCase)
+{
+	if (findText.empty())
+		return;
+
+	findAllOccurrences(ignoreCase);
+	int index = currentMatchIndex();
+	if (index < 0 ||
+		editor_state.selection_start != static_cast<int>(matches[index]) ||
+		editor_state.selection_end != static_cast<int>(matchEnds[index]))
 	{
-		std::string fileContentLower = toLower(editor_state.fileContent);
-		std::string findTextLower = toLower(findText);
-		foundPos = fileContentLower.rfind(findTextLower, startPos);
-	} else
+		// Nothing selected yet: the first press only moves to a match
+		findNext(ignoreCase);
+		return;
+	}
+
+	const size_t start = matches[index];
+	const size_t end = matchEnds[index];
+	std::string content = editor_state.fileContent;
+	content.replace(start, end - start, replaceText);
+	std::vector<ImVec4> colors = editor_state.fileColors;
+	if (end <= colors.size())
 	{
-		foundPos = editor_state.fileContent.rfind(findText, startPos);
+		colors.erase(colors.begin() + start, colors.begin() + end);
+		colors.insert(
+			colors.begin() + start, replaceText.size(), TreeSitter::cachedColors.text);
 	}
+	colors.resize(content.size(), TreeSitter::cachedColors.text);
+	const int cursor = static_cast<int>(start + replaceText.size());
+	commitReplacement(std::move(content), std::move(colors), cursor);
+	findNext(ignoreCase);
+}
 
-	std::cout << "Searching backwards for '" << findText << "' starting from position "
-			  << startPos;
-	if (ignoreCase)
-		std::cout << " (case-insensitive)";
-	std::cout << std::endl;
+void FileContentSearch::replaceAll(bool ignoreCase)
+{
+	if (findText.empty())
+		return;
+
+	findAllOccurrences(ignoreCase);
+	if (matches.empty())
+		return;
 
-	if (foundPos == std::string::npos)
+	// Build the result in one pass instead of splicing match by match, which
+	// would move the tail of the buffer once per match
+	const std::string &text = editor_state.fileContent;
+	const std::vector<ImVec4> &oldColors = editor_state.fileColors;
+	std::string content;
+	std::vector<ImVec4> colors;
+	content.reserve(text.size() + matches.size() * replaceText.size());
+	colors.reserve(content.capacity());
+
+	// Colors may lag the text while a highlight is pending; pad with the default
+	auto copyColors = [&](size_t from, size_t to) {
+		const size_t target = colors.size() + (to - from);
+		const size_t available = std::min(to, oldColors.size());
+		if (from < available)
+		{
+			colors.insert(
+				colors.end(), oldColors.begin() + from, oldColors.begin() + available);
+		}
+		colors.resize(target, TreeSitter::cachedColors.text);
+	};
+
+	const size_t cursor = static_cast<size_t>(editor_state.cursor_index);
+	size_t newCursor = cursor;
+	size_t copied = 0;
+	size_t replaced = 0;
+	for (size_t i = 0; i < matches.size(); ++i)
 	{
-		// Wrap around to the end
-		if (ignoreCase)
+		// Literal matches may overlap; the leftmost one wins
+		if (matches[i] < copied)
 		{
-			std::string fileContentLower = toLower(editor_state.fileContent);
-			std::string findTextLower = toLower(findText);
-			foundPos = fileContentLower.rfind(findTextLower);
-		} else
+			continue;
+		}
+		content.append(text, copied, matches[i] - copied);
+		copyColors(copied, matches[i]);
+		if (cursor >= matchEnds[i])
+		{
+			newCursor = content.size() + replaceText.size() + (cursor - matchEnds[i]);
+		} else if (cursor >= matches[i])
 		{
-			foundPos = editor_state.fileContent.rfind(findText);
+			newCursor = content.size() + replaceText.size();
 		}
-		std::cout << "Wrapped search to end" << std::endl;
+		content += replaceText;
+		colors.insert(colors.end(), replaceText.size(), TreeSitter::cachedColors.text);
+		copied = matchEnds[i];
+		replaced++;
 	}
+	if (cursor < matches.front())
+	{
+		newCursor = cursor;
+	}
+	content.append(text, copied, std::string::npos);
+	copyColors(copied, text.size());
+
+	commitReplacement(std::move(content), std::move(colors), static_cast<int>(newCursor));
+	gSettings.renderNotification("Replaced " + std::to_string(replaced) + " matches");
+}
+
+void FileContentSearch::findNext(bool ignoreCase)
+{
+	if (findText.empty())
+		return;
 
-	if (foundPos != std::string::npos)
+	const std::vector<size_t> &positions = findAllOccurrences(ignoreCase);
+	if (positions.empty())
 	{
-		lastFoundPos = foundPos;
-		editor_state.cursor_index = foundPos;
-		editor_state.selection_start = foundPos;
-		editor_state.selection_end = foundPos + findText.length();
-		editor_state.center_cursor_vertical = true;
-
-		std::cout << "Found at position: " << foundPos
-				  << ", cursor now at: " << editor_state.cursor_index << std::endl;
-	} else
+		std::cout << "Not found" << std::endl;
+		return;
+	}
+
+	size_t startPos = lastFoundPos == std::string::npos
+						  ? static_cast<size_t>(editor_state.cursor_index)
+						  : lastFoundPos + 1;
+	auto it = std::lower_bound(positions.begin(), positions.end(), startPos);
+	if (it == positions.end())
+	{
+		// Wrap around to the beginning
+		it = positions.begin();
+	}
+	selectMatch(it - positions.begin());
+}
+
+void FileContentSearch::findPrevious(bool ignoreCase)
+{
+	if (findText.empty())
+		return;
+
+	const std::vector<size_t> &positions = findAllOccurrences(ignoreCase);
+	if (positions.empty())
 	{
 		std::cout << "Not found" << std::endl;
+		return;
+	}
+
+	// Last match at or before the start position, wrapping around to the end
+	auto it = positions.end();
+	if (lastFoundPos != 0)
+	{
+		size_t startPos = lastFoundPos == std::string::npos
+							  ? static_cast<size_t>(editor_state.cursor_index)
+							  : lastFoundPos - 1;
+		it = std::upper_bound(positions.begin(), positions.end(), startPos);
+		if (it == positions.begin())
+		{
+			it = positions.end();
+		}
 	}
+	selectMatch(std::prev(it) - positions.begin());
 }
 
 void FileContentSearch::handleFindBoxActivation()
 {
 	ImGuiIO &io = ImGui::GetIO();
-	// If Cmd+F is pressed, activate the find box (do not toggle off here)
-	if ((io.KeyCtrl || io.KeySuper) && ImGui::IsKeyPressed(ImGuiKey_F))
+	// If Cmd+F is pressed, activate the find box (do not toggle off here).
+	// Cmd+H opens it with the replace row.
+	bool findPressed = ImGui::IsKeyPressed(ImGuiKey_F);
+	bool replacePressed = ImGui::IsKeyPressed(ImGuiKey_H);
+	// Cmd+Shift+F belongs to the workspace search
+	if ((io.KeyCtrl || io.KeySuper) && !io.KeyShift && (findPressed || replacePressed))
 	{
 		ClosePopper::closeAllExcept(ClosePopper::Type::LineJump);
 		editor_state.active_find_box = true;
 		editor_state.block_input = true;
 		findText = "";
+		showReplace = replacePressed;
 		findBoxShouldFocus = true; // force focus on activation
 	}
 	// If Escape is pressed, deactivate the find box.
@@ -246,29 +446,21 @@ void FileContentSearch::renderFindBox()
 			ImGui::SameLine();
 
 			// Calculate current match position
-			int currentMatch = -1;
-			int totalMatches = 0;
-
-			if (!findText.empty())
+			const std::vector<size_t> &positions =
+				findAllOccurrences(ignoreCaseCheckbox);
+			int totalMatches = static_cast<int>(positions.size());
+			int currentMatch = currentMatchIndex();
+			if (currentMatch != -1)
 			{
-				std::vector<size_t> positions = findAllOccurrences(ignoreCaseCheckbox);
-				totalMatches = positions.size();
-
-				if (lastFoundPos != std::string::npos)
-				{
-					for (int i = 0; i < totalMatches; i++)
-					{
-						if (positions[i] == lastFoundPos)
-						{
-							currentMatch = i + 1;
-							break;
-						}
-					}
-				}
+				currentMatch++;
 			}
 
 			// Display the match counter
-			if (currentMatch == -1)
+			if (!regexError.empty())
+			{
+				ImGui::TextColored(
+					ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", regexError.c_str());
+			} else if (currentMatch == -1)
 			{
 				ImGui::Text("Not Found");
 			} else if (totalMatches > 0)
@@ -292,8 +484,62 @@ void FileContentSearch::renderFindBox()
 		ImGui::PushStyleColor(ImGuiCol_Border, Style::BORDER_COLOR);
 
 		ImGui::Checkbox("Case Insensitive", &ignoreCaseCheckbox);
+		ImGui::SameLine();
+		if (ImGui::Checkbox("Regex", &useRegex))
+		{
+			lastFoundPos = std::string::npos;
+		}
 		ImGui::PopStyleColor(2);
 		ImGui::PopStyleVar(2);
+
+		replaceSubmitted = false;
+		if (showReplace)
+		{
+			ImGui::PushStyleVar(ImGuiStyleVar_FrameRounding, Style::FRAME_ROUNDING);
+			ImGui::PushStyleVar(ImGuiStyleVar_FrameBorderSize, Style::BORDER_SIZE);
+			ImGui::PushStyleColor(
+				ImGuiCol_FrameBg,
+				ImVec4(gSettings.getSettings()["backgroundColor"][0].get<float>() * .8,
+					   gSettings.getSettings()["backgroundColor"][1].get<float>() * .8,
+					   gSettings.getSettings()["backgroundColor"][2].get<float>() * .8,
+					   1.0f));
+			ImGui::PushStyleColor(ImGuiCol_Border, Style::BORDER_COLOR);
+
+			ImGui::SetNextItemWidth(inputWidth);
+			bool submitted = ImGui::InputText("##replacebox",
+											  replaceBuffer,
+											  sizeof(replaceBuffer),
+											  ImGuiInputTextFlags_EnterReturnsTrue);
+			replaceText = replaceBuffer;
+			if (submitted)
+			{
+				// Enter replaces the current match, Alt+Enter all of them
+				replaceSubmitted = true;
+				if (ImGui::GetIO().KeyAlt)
+				{
+					replaceAll(ignoreCaseCheckbox);
+				} else
+				{
+					replaceCurrent(ignoreCaseCheckbox);
+				}
+				ImGui::SetKeyboardFocusHere(-1);
+			}
+
+			ImGui::SameLine();
+			ImGui::Dummy(ImVec2(10, 0)); // 10 pixels of spacing.
+			ImGui::SameLine();
+			if (ImGui::Button("Replace"))
+			{
+				replaceCurrent(ignoreCaseCheckbox);
+			}
+			ImGui::SameLine();
+			if (ImGui::Button("Replace All"))
+			{
+				replaceAll(ignoreCaseCheckbox);
+			}
+			ImGui::PopStyleColor(2);
+			ImGui::PopStyleVar(2);
+		}
 	}
 	ImGui::EndGroup(); // End entire find box group
 
@@ -304,38 +550,6 @@ void FileContentSearch::renderFindBox()
 
 	handleFindBoxKeyboardShortcuts(ignoreCaseCheckbox);
 }
-std::vector<size_t> FileContentSearch::findAllOccurrences(bool ignoreCase)
-{
-	std::vector<size_t> positions;
-	if (findText.empty())
-		return positions;
-
-	size_t startPos = 0;
-	while (true)
-	{
-		size_t foundPos;
-		if (ignoreCase)
-		{
-			std::string fileContentLower = toLower(editor_state.fileContent);
-			std::string findTextLower = toLower(findText);
-			foundPos = fileContentLower.find(findTextLower, startPos);
-		} else
-		{
-			foundPos = editor_state.fileContent.find(findText, startPos);
-		}
-
-		if (foundPos == std::string::npos)
-			break;
-
-		positions.push_back(foundPos);
-		startPos = foundPos + 1;
-
-		if (startPos >= editor_state.fileContent.length())
-			break;
-	}
-
-	return positions;
-}
 void FileContentSearch::handleFindBoxKeyboardShortcuts(bool ignoreCaseCheckbox)
 {
 	ImGuiIO &io = ImGui::GetIO();
@@ -344,7 +558,8 @@ void FileContentSearch::handleFindBoxKeyboardShortcuts(bool ignoreCaseCheckbox)
 		if (io.KeyCtrl)
 		{
 			// Handle Ctrl+Enter - add multi-cursors
-			std::vector<size_t> positions = findAllOccurrences(ignoreCaseCheckbox);
+			const std::vector<size_t> &positions =
+				findAllOccurrences(ignoreCaseCheckbox);
 			if (!positions.empty())
 			{
 				// Clear existing cursors
@@ -385,6 +600,9 @@ void FileContentSearch::handleFindBoxKeyboardShortcuts(bool ignoreCaseCheckbox)
 					// Keep block_input true for now
 				}
 			}
+		} else if (replaceSubmitted)
+		{
+			// Already handled by the replace box
 		} else if (io.KeyShift)
 		{
 			findPrevious(ignoreCaseCheckbox);
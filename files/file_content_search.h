@@ -3,7 +3,10 @@
 #include "../editor/editor.h"
 #include "../editor/editor_cursor.h"
 #include "imgui.h"
+#include "literal_search.h"
+#include "regex_search.h"
 #include <string>
+#include <vector>
 
 class FileContentSearch
 {
@@ -14,23 +17,56 @@ class FileContentSearch
 	void findNext(bool ignoreCase = true);
 	void findPrevious(bool ignoreCase = true);
 
+	// Replace operations. Each is a single buffer pass and a single undo step.
+	void replaceCurrent(bool ignoreCase = true);
+	void replaceAll(bool ignoreCase = true);
+
 	// UI functions
 	void renderFindBox();
 	void handleFindBoxActivation();
 
-	std::vector<size_t> findAllOccurrences(bool ignoreCase);
+	// Sorted starts of every match of the current query. Cached per query,
+	// mode and text version; edits rescan only the lines they touched.
+	const std::vector<size_t> &findAllOccurrences(bool ignoreCase);
+
+	// Bytes [start, old_end) of the previous text became [start, new_end)
+	void onTextChanged(size_t start, size_t old_end, size_t new_end);
+
 	bool needsInputUnblock;
 	int unblockDelayFrames;
 
   private:
 	// Core members
 	std::string findText; // the string we are searching for...
+	std::string replaceText;
+	char replaceBuffer[256] = ""; // Replace box input, backing replaceText
+	bool useRegex = false;
+	bool showReplace = false;
+	bool replaceSubmitted = false;
+	std::string regexError;
 
 	size_t lastFoundPos = std::string::npos;
 	bool findBoxShouldFocus = false;
 
+	// Match index. Matches never span lines: the find box is single-line and
+	// the regex engine scans line by line.
+	LiteralSearch searcher;
+	RegexSearch regex;
+	std::vector<size_t> matches;
+	std::vector<size_t> matchEnds;
+	std::string matchesQuery;
+	bool matchesRegex = false;
+	size_t matchesVersion = 0;
+	bool matchesValid = false;
+
 	// Helper functions
-	std::string toLower(const std::string &s);
+	void scanMatches(size_t begin,
+					 size_t end,
+					 std::vector<size_t> &starts,
+					 std::vector<size_t> &ends);
+	int currentMatchIndex() const;
+	void selectMatch(size_t index);
+	void commitReplacement(std::string content, std::vector<ImVec4> colors, int cursor);
 	void handleFindBoxKeyboardShortcuts(bool ignoreCaseCheckbox);
 
 	ImVec2 findBoxRectMin;
@@ -6,179 +6,244 @@
 #include "../util/close_popper.h"
 #include "../util/keybinds.h"
 #include "editor.h"
+#include "workspace_index.h"
+#include <algorithm>
+#include <functional>
 #include <thread>
+#include <unordered_map>
 FileFinder gFileFinder;
 
-FileFinder::FileFinder()
-	: stopThread(false), lastSelectionTime(std::chrono::steady_clock::now())
-{
-	workerThread = std::thread(&FileFinder::backgroundRefresh, this);
-}
+FileFinder::FileFinder() : lastSelectionTime(std::chrono::steady_clock::now()) {}
 
-FileFinder::~FileFinder()
+void FileFinder::updateFilteredList()
 {
-	stopThread = true;
-	if (workerThread.joinable())
+	std::string searchTerm(searchBuffer);
+	std::transform(searchTerm.begin(), searchTerm.end(), searchTerm.begin(), ::tolower);
+
+	if (searchTerm != previousSearch)
 	{
-		workerThread.join();
+		selectedIndex = 0;
+		previousSearch = searchTerm;
 	}
-}
 
-void FileFinder::backgroundRefresh()
-{
-	using namespace std::chrono;
-	auto lastScanTime = steady_clock::now();
-
-	while (!stopThread)
+	// The file list is the workspace index's; aliasing the snapshot keeps it
+	// alive without copying it
+	filteredVersion = gWorkspaceIndex.version();
+	std::shared_ptr<const PathTable> table;
+	std::shared_ptr<const WorkspaceSnapshot> snapshot = gWorkspaceIndex.snapshot();
+	if (snapshot && snapshot->root == gFileExplorer.selectedFolder)
 	{
-		auto now = steady_clock::now();
-		std::string projectDir = gFileExplorer.selectedFolder;
-
-		if (!projectDir.empty())
-		{
-			bool directoryChanged = (projectDir != currentProjectDir);
-			bool timeForScan = (duration_cast<seconds>(now - lastScanTime).count() >= 3);
+		table = std::shared_ptr<const PathTable>(snapshot, &snapshot->files);
+	}
 
-			if (directoryChanged || timeForScan)
-			{
-				currentProjectDir = projectDir;
-				refreshFileListBackground(projectDir);
-				lastScanTime = now;
-			}
-		}
+	filteredList.clear();
+	bool narrow = table && table == filteredTable &&
+				  searchTerm.compare(0, matchedQuery.size(), matchedQuery) == 0;
+	filteredTable = table;
+	if (!table)
+	{
+		matchedIds.clear();
+		return;
+	}
 
-		// Check every 100ms instead of waiting full 3 seconds
-		std::this_thread::sleep_for(milliseconds(100));
+	// Dotfiles only show up once the query asks for a dot, which also means
+	// a query gaining its first dot can match files its prefix did not
+	bool includeHidden = searchTerm.find('.') != std::string::npos;
+	if (includeHidden != (matchedQuery.find('.') != std::string::npos))
+	{
+		narrow = false;
 	}
-}
 
-void FileFinder::refreshFileListBackground(const std::string &projectDir)
-{
-	std::vector<FileEntry> newFileList;
+	FuzzyQuery query(searchTerm);
+	std::vector<Scored> scored =
+		scoreCandidates(*table, query, narrow ? &matchedIds : nullptr, includeHidden);
 
-	try
+	matchedQuery = searchTerm;
+	matchedIds.resize(scored.size());
+	for (size_t i = 0; i < scored.size(); i++)
 	{
-		// Add some debug output to see what's happening
-		std::cout << "[FileFinder] Scanning directory: " << projectDir << std::endl;
+		matchedIds[i] = scored[i].id;
+	}
 
-		auto directoryIterator = fs::recursive_directory_iterator(projectDir);
-		int fileCount = 0;
+	applyRecency(table, scored);
+
+	// Only the rows that can be shown get sorted
+	size_t keep = std::min(scored.size(), MAX_RESULTS);
+	const PathTable &paths = *table;
+	std::partial_sort(scored.begin(),
+					  scored.begin() + keep,
+					  scored.end(),
+					  [&paths](const Scored &a, const Scored &b) {
+						  if (a.score != b.score)
+						  {
+							  return a.score > b.score;
+						  }
+						  size_t lengthA = paths.offsets[a.id + 1] - paths.offsets[a.id];
+						  size_t lengthB = paths.offsets[b.id + 1] - paths.offsets[b.id];
+						  if (lengthA != lengthB)
+						  {
+							  return lengthA < lengthB;
+						  }
+						  return a.id < b.id;
+					  });
+	filteredList.reserve(keep);
+	for (size_t i = 0; i < keep; i++)
+	{
+		filteredList.push_back(scored[i].id);
+	}
+}
 
-		for (const auto &entry : directoryIterator)
+std::vector<FileFinder::Scored>
+FileFinder::scoreCandidates(const PathTable &table,
+							const FuzzyQuery &query,
+							const std::vector<uint32_t> *candidates,
+							bool includeHidden) const
+{
+	size_t count = candidates ? candidates->size() : table.size();
+	auto scoreRange = [&](size_t begin, size_t end, std::vector<Scored> &out) {
+		for (size_t i = begin; i < end; i++)
 		{
-			try
+			uint32_t id = candidates ? (*candidates)[i] : static_cast<uint32_t>(i);
+			if (!includeHidden && table.basename(id).front() == '.')
 			{
-				if (entry.is_regular_file())
-				{
-					fs::path fullPath = entry.path();
-					fs::path relativePath = fs::relative(fullPath, projectDir);
-
-#ifdef PLATFORM_WINDOWS
-					// On Windows, use UTF-8 string conversion to handle Unicode properly
-					auto u8fullPath = fullPath.u8string();
-					auto u8relativePath = relativePath.u8string();
-					auto u8filename = relativePath.filename().u8string();
-
-					std::string fullPathStr(u8fullPath.begin(), u8fullPath.end());
-					std::string relativePathStr(u8relativePath.begin(),
-												u8relativePath.end());
-					std::string filenameStr(u8filename.begin(), u8filename.end());
-#else
-					// On Unix systems, use normal string conversion
-					std::string fullPathStr = fullPath.string();
-					std::string relativePathStr = relativePath.string();
-					std::string filenameStr = relativePath.filename().string();
-#endif
-
-					std::string filenameLower = filenameStr;
-					std::transform(filenameLower.begin(),
-								   filenameLower.end(),
-								   filenameLower.begin(),
-								   ::tolower);
-
-					std::string fullPathLower = fullPathStr;
-					std::transform(fullPathLower.begin(),
-								   fullPathLower.end(),
-								   fullPathLower.begin(),
-								   ::tolower);
-
-					newFileList.push_back(
-						{fullPathStr, relativePathStr, fullPathLower, filenameLower});
-					fileCount++;
-				}
-			} catch (const std::exception &e)
-			{
-				// Skip files that cause Unicode conversion errors
-				std::cerr << "[FileFinder] Skipping file due to encoding error: "
-						  << e.what() << std::endl;
 				continue;
 			}
+			int score = query.empty() ? 0 : query.score(table, id);
+			if (score != FuzzyQuery::NO_MATCH)
+			{
+				out.push_back({id, score});
+			}
 		}
+	};
 
-		std::cout << "[FileFinder] Found " << fileCount << " files" << std::endl;
-
-		{
-			std::lock_guard<std::mutex> lock(fileListMutex);
-			fileList = std::move(newFileList);
-		}
-	} catch (const std::exception &e)
+	std::vector<Scored> scored;
+	size_t threads = std::min<size_t>(std::thread::hardware_concurrency(), MAX_THREADS);
+	if (count < PARALLEL_THRESHOLD || threads < 2)
 	{
-		std::cerr << "Error refreshing file list: " << e.what() << std::endl;
+		scoreRange(0, count, scored);
+		return scored;
 	}
-}
-void FileFinder::updateFilteredList()
-{
-	std::string searchTerm(searchBuffer);
-	std::transform(searchTerm.begin(), searchTerm.end(), searchTerm.begin(), ::tolower);
 
-	if (searchTerm != previousSearch)
+	// Each thread takes a contiguous slice, so the joined result stays in
+	// table order
+	std::vector<std::vector<Scored>> parts(threads);
+	std::vector<std::thread> workers;
+	size_t slice = (count + threads - 1) / threads;
+	for (size_t t = 1; t < threads; t++)
 	{
-		selectedIndex = 0;
-		previousSearch = searchTerm;
+		size_t begin = std::min(count, t * slice);
+		size_t end = std::min(count, begin + slice);
+		workers.emplace_back(scoreRange, begin, end, std::ref(parts[t]));
+	}
+	scoreRange(0, std::min(count, slice), parts[0]);
+	for (std::thread &worker : workers)
+	{
+		worker.join();
 	}
 
-	filteredList.clear();
-
-	std::vector<FileEntry> localFileList;
+	size_t total = 0;
+	for (const auto &part : parts)
+	{
+		total += part.size();
+	}
+	scored.reserve(total);
+	for (const auto &part : parts)
 	{
-		std::lock_guard<std::mutex> lock(fileListMutex);
-		localFileList = fileList;
+		scored.insert(scored.end(), part.begin(), part.end());
 	}
+	return scored;
+}
 
-	// Debug: Uncomment to see when filtering occurs
-	// std::cout << "[FileFinder] updateFilteredList: fileList size = " <<
-	// localFileList.size()
-	//		  << ", searchTerm = '" << searchTerm << "'" << std::endl;
+void FileFinder::noteRecentFile(const std::string &path)
+{
+	if (path.empty())
+	{
+		return;
+	}
+	auto existing = std::find(recentFiles.begin(), recentFiles.end(), path);
+	if (existing != recentFiles.end())
+	{
+		recentFiles.erase(existing);
+	}
+	recentFiles.push_back(path);
+	if (recentFiles.size() > MAX_RECENT)
+	{
+		recentFiles.erase(recentFiles.begin());
+	}
+	recentTable.reset(); // Resolve the ids again on the next filter
+}
 
-	for (const auto &file : localFileList)
+void FileFinder::applyRecency(const std::shared_ptr<const PathTable> &table,
+							  std::vector<Scored> &scored)
+{
+	if (recentTable != table)
 	{
-		std::string relativeLower = file.relativePath;
-		std::transform(
-			relativeLower.begin(), relativeLower.end(), relativeLower.begin(), ::tolower);
+		recentTable = table;
+		recentBonuses.clear();
+
+		// Relative path -> bonus. The file open when the finder was summoned
+		// gets none: jumping to it would go nowhere.
+		std::unordered_map<std::string_view, int> bonuses;
+		size_t longest = 0;
+		std::string root = table->root;
+		if (!root.empty() && root.back() != '/' && root.back() != '\\')
+		{
+			root += static_cast<char>(fs::path::preferred_separator);
+		}
+		for (size_t i = 0; i < recentFiles.size(); i++)
+		{
+			const std::string &path = recentFiles[i];
+			if (path == originalFile || path.compare(0, root.size(), root) != 0)
+			{
+				continue;
+			}
+			size_t age = recentFiles.size() - 1 - i;
+			std::string_view relative = std::string_view(path).substr(root.size());
+			bonuses[relative] = static_cast<int>(RECENT_BONUS * (MAX_RECENT - age) /
+												 MAX_RECENT);
+			longest = std::max(longest, relative.size());
+		}
 
-		if (relativeLower.find(searchTerm) != std::string::npos)
+		// Hash only the paths with a matching length
+		std::vector<bool> lengths(longest + 1, false);
+		for (const auto &entry : bonuses)
+		{
+			lengths[entry.first.size()] = true;
+		}
+		for (uint32_t id = 0; !bonuses.empty() && id < table->size(); id++)
 		{
-			if (searchTerm.find('.') == std::string::npos &&
-				!file.filenameLower.empty() && file.filenameLower[0] == '.')
+			size_t length = table->offsets[id + 1] - table->offsets[id];
+			if (length > longest || !lengths[length])
 			{
 				continue;
 			}
-			filteredList.push_back(file);
+			auto found = bonuses.find(table->path(id));
+			if (found != bonuses.end())
+			{
+				recentBonuses.push_back({id, found->second});
+			}
 		}
 	}
 
-	std::sort(filteredList.begin(),
-			  filteredList.end(),
-			  [](const FileEntry &a, const FileEntry &b) {
-				  return a.relativePath.size() < b.relativePath.size();
-			  });
+	for (const auto &[id, bonus] : recentBonuses)
+	{
+		auto it = std::lower_bound(
+			scored.begin(), scored.end(), id, [](const Scored &s, uint32_t value) {
+				return s.id < value;
+			});
+		if (it != scored.end() && it->id == id)
+		{
+			it->score += bonus;
+		}
+	}
 }
+
 void FileFinder::handleSelectionChange()
 {
 	if (!filteredList.empty() && selectedIndex >= 0 &&
 		selectedIndex < static_cast<int>(filteredList.size()))
 	{
-		const std::string &selectedFile = filteredList[selectedIndex].fullPath;
+		std::string selectedFile = filteredTable->fullPath(filteredList[selectedIndex]);
 
 		if (!isInitialSelection && selectedFile != currentlyLoadedFile)
 		{
@@ -215,6 +280,7 @@ void FileFinder::toggleWindow()
 	{
 		originalFile = gFileExplorer.currentFile;
 		currentlyLoadedFile = originalFile;
+		noteRecentFile(originalFile);
 		memset(searchBuffer, 0, sizeof(searchBuffer));
 		previousSearch = "";
 		wasKeyboardFocusSet = false;
@@ -366,16 +432,18 @@ void FileFinder::renderFileList()
 	for (int i = startIdx; i < endIdx; ++i)
 	{
 		bool is_selected = (i == selectedIndex);
-		const FileEntry &entry = filteredList[i];
+		std::string_view relativePath = filteredTable->path(filteredList[i]);
 		ImGui::PushID(i);
 		ImGui::Selectable("", is_selected, ImGuiSelectableFlags_SpanAllColumns);
 		ImGui::SameLine();
-		std::string filename = fs::path(entry.fullPath).filename().string();
-		ImTextureID fileIcon = gFileExplorer.getIconForFile(filename);
+		std::string filename(filteredTable->basename(filteredList[i]));
+		IconRef fileIcon = gFileExplorer.getIconForFile(filename);
 		float iconSize = ImGui::GetTextLineHeight();
-		ImGui::Image(fileIcon, ImVec2(iconSize, iconSize));
+		ImGui::Image(
+			fileIcon.texture, ImVec2(iconSize, iconSize), fileIcon.uv0, fileIcon.uv1);
 		ImGui::SameLine();
-		ImGui::TextUnformatted(entry.relativePath.c_str());
+		ImGui::TextUnformatted(relativePath.data(),
+							   relativePath.data() + relativePath.size());
 		if (is_selected)
 			ImGui::SetScrollHereY(0.5f);
 		ImGui::PopID();
@@ -454,6 +522,7 @@ void FileFinder::renderWindow()
 	bool enterPressed = renderSearchInput();
 	if (enterPressed)
 	{
+		noteRecentFile(currentlyLoadedFile);
 		toggleWindow(); // Just close the finder
 		editor_state.cursor_index = 0;
 		editor_state.selection_start = 0;
@@ -478,6 +547,10 @@ void FileFinder::renderWindow()
 		updateFilteredList();
 		isInitialSelection = false; // No longer initial when search changes
 		handleSelectionChange();
+	} else if (!filteredTable && filteredVersion != gWorkspaceIndex.version())
+	{
+		// Opened before the workspace index finished its first walk
+		updateFilteredList();
 	}
 
 	ImGui::Spacing();
@@ -2,20 +2,14 @@
 
 #pragma once
 #include "files.h"
+#include "fuzzy_match.h"
 #include "imgui.h"
 #include <filesystem>
+#include <memory>
 #include <vector>
 
 namespace fs = std::filesystem;
 
-struct FileEntry
-{
-	std::string fullPath;
-	std::string relativePath;
-	std::string fullPathLower; // Lower-case full path for searching
-	std::string filenameLower; // Lower-case file name (from relativePath.filename())
-};
-
 class FileFinder
 {
   private:
@@ -26,19 +20,45 @@ class FileFinder
 	std::string originalFile;
 	std::string currentlyLoadedFile;
 
-	std::vector<FileEntry> fileList;
-	std::vector<FileEntry> filteredList;
+	// Best matches first, as ids into `filteredTable`
+	std::shared_ptr<const PathTable> filteredTable;
+	std::vector<uint32_t> filteredList;
 	bool isInitialSelection = true; // Track if this is the first selection after opening
 
+	// Everything the last query matched, in table order. A query extending it
+	// only has to look at these.
+	std::vector<uint32_t> matchedIds;
+	std::string matchedQuery;
+
+	// Full paths of files opened through the finder or open when it was
+	// summoned, oldest first
+	std::vector<std::string> recentFiles;
+	std::shared_ptr<const PathTable> recentTable;
+	std::vector<std::pair<uint32_t, int>> recentBonuses; // (id, bonus), by id
+
+	struct Scored
+	{
+		uint32_t id;
+		int score;
+	};
+
+	static constexpr size_t MAX_RESULTS = 1000;
+	static constexpr size_t MAX_RECENT = 32;
+	static constexpr int RECENT_BONUS = 48; // For the newest, fading with age
+	// Below this many candidates spawning threads costs more than it saves
+	static constexpr size_t PARALLEL_THRESHOLD = 16384;
+	static constexpr size_t MAX_THREADS = 8;
+
 	int selectedIndex = 0;
+	uint64_t filteredVersion = 0; // gWorkspaceIndex version behind `filteredTable`
 	void updateFilteredList();
-	std::thread workerThread;
-	std::mutex fileListMutex;
-	std::atomic<bool> stopThread{false};
-	std::string currentProjectDir;
-
-	void backgroundRefresh();
-	void refreshFileListBackground(const std::string &projectDir);
+	std::vector<Scored> scoreCandidates(const PathTable &table,
+										const FuzzyQuery &query,
+										const std::vector<uint32_t> *candidates,
+										bool includeHidden) const;
+	void noteRecentFile(const std::string &path);
+	void applyRecency(const std::shared_ptr<const PathTable> &table,
+					  std::vector<Scored> &scored);
 	// Helper functions to break up the renderWindow() logic:
 	void renderHeader();
 	bool renderSearchInput();
@@ -74,7 +94,6 @@ class FileFinder
 	}
 
 	FileFinder();
-	~FileFinder();
 };
 
 extern FileFinder gFileFinder;
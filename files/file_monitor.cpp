@@ -4,27 +4,92 @@
 */
 
 #include "file_monitor.h"
-#include <GLFW/glfw3.h>
-#include <algorithm>
+#include "../util/redraw.h"
+
+#include <chrono>
+#include <cstring>
 #include <fstream>
 #include <iostream>
-#include <sstream>
+#include <set>
+#include <unordered_map>
+
+#ifdef PLATFORM_LINUX
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Longest a file that keeps changing waits for a quiet moment
+constexpr int MAX_DELAY_MS = 500;
+
+// 64-bit multiply-xorshift over 8-byte words. Not for hash tables or anything
+// adversarial, only to tell whether a file's content moved, at memory speed.
+class StreamHash
+{
+  public:
+	void update(const char *data, size_t size)
+	{
+		length += size;
+		while (carried > 0 && size > 0)
+		{
+			carry[carried++] = *data++;
+			size--;
+			if (carried == 8)
+			{
+				mixWord(carry);
+				carried = 0;
+			}
+		}
+		for (; size >= 8; data += 8, size -= 8)
+		{
+			mixWord(data);
+		}
+		std::memcpy(carry + carried, data, size);
+		carried += size;
+	}
+
+	uint64_t finish()
+	{
+		if (carried > 0)
+		{
+			std::memset(carry + carried, 0, 8 - carried);
+			mixWord(carry);
+		}
+		mix(length);
+		return state ^ (state >> 32);
+	}
+
+  private:
+	uint64_t state = 0x9E3779B97F4A7C15ull;
+	uint64_t length = 0;
+	char carry[8] = {};
+	size_t carried = 0;
+
+	void mixWord(const char *bytes)
+	{
+		uint64_t word;
+		std::memcpy(&word, bytes, 8);
+		mix(word);
+	}
+	void mix(uint64_t word)
+	{
+		state = (state ^ word) * 0xFF51AFD7ED558CCDull;
+		state ^= state >> 29;
+	}
+};
+
+} // namespace
 
 // Constructor
-FileMonitor::FileMonitor() { initializeMonitoredExtensions(); }
+FileMonitor::FileMonitor() = default;
 
 // Destructor
 FileMonitor::~FileMonitor() { stopMonitoring(); }
 
-void FileMonitor::initializeMonitoredExtensions()
-{
-	_monitoredExtensions = {".cpp",	 ".c",	  ".h",	  ".hpp", ".cc",   ".cxx",
-							".py",	 ".js",	  ".ts",  ".tsx", ".jsx",  ".java",
-							".go",	 ".rs",	  ".rb",  ".php", ".html", ".css",
-							".scss", ".json", ".xml", ".md",  ".txt",  ".yml",
-							".yaml", ".toml", ".sh",  ".bat", ".ps1",  ".sql"};
-}
-
 void FileMonitor::startMonitoring(const std::string &projectFolder)
 {
 	if (projectFolder.empty())
@@ -37,253 +102,475 @@ void FileMonitor::startMonitoring(const std::string &projectFolder)
 	_projectFolder = projectFolder;
 	std::cout << "[FileMonitor] Starting monitoring for: " << projectFolder << std::endl;
 
-	// Start background scanning
-	scanProjectFilesForMonitoring();
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stopping = false;
+		_filesChanged = true;
+	}
+#ifdef PLATFORM_LINUX
+	if (pipe2(_wakeFds, O_CLOEXEC) != 0)
+	{
+		_wakeFds[0] = _wakeFds[1] = -1;
+	}
+	_watchThread = std::thread([this]() {
+		if (!watchLoop())
+		{
+			pollLoop();
+		}
+	});
+#else
+	_watchThread = std::thread(&FileMonitor::pollLoop, this);
+#endif
 }
 
 void FileMonitor::stopMonitoring()
 {
 	// Clean up background thread
-	if (_fileScanThread.joinable())
 	{
-		_fileScanThread.join();
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stopping = true;
 	}
+	wake();
+	if (_watchThread.joinable())
+	{
+		_watchThread.join();
+	}
+#ifdef PLATFORM_LINUX
+	for (int &fd : _wakeFds)
+	{
+		if (fd >= 0)
+		{
+			::close(fd);
+			fd = -1;
+		}
+	}
+#endif
 
 	// Clear monitoring data
-	_monitoredFiles.clear();
-	_fileModificationTimes.clear();
-	_fileContentHashes.clear();
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_files.clear();
+		_changes.clear();
+		_hasChanges = false;
+	}
 	_projectFolder.clear();
 
 	std::cout << "[FileMonitor] Monitoring stopped" << std::endl;
 }
 
-void FileMonitor::checkForExternalFileChanges()
+void FileMonitor::wake()
 {
-	if (!isMonitoring())
+	_wakeup.notify_all();
+#ifdef PLATFORM_LINUX
+	if (_wakeFds[1] >= 0)
 	{
-		return;
+		char byte = 0;
+		(void)!write(_wakeFds[1], &byte, 1);
 	}
+#endif
+}
+
+bool FileMonitor::shouldStop()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _stopping;
+}
 
-	// Throttle checks to avoid performance impact - check every second like the old
-	// implementation
-	double currentTime = glfwGetTime();
-	const double FILE_CHANGE_CHECK_INTERVAL = 1.0; // Check every second
-	if (currentTime - _lastChangeCheckTime < FILE_CHANGE_CHECK_INTERVAL)
+void FileMonitor::checkForExternalFileChanges()
+{
+	// One atomic load per frame when nothing changed
+	if (!_hasChanges.load(std::memory_order_acquire))
 	{
 		return;
 	}
-	_lastChangeCheckTime = currentTime;
 
-	// Check all monitored files for external changes
-	std::vector<std::string> filesToRemove;
+	std::vector<Change> changes;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		changes.swap(_changes);
+		_hasChanges = false;
+	}
 
-	for (const auto &filePath : _monitoredFiles)
+	for (const Change &change : changes)
 	{
-		try
+		std::string filename = fs::path(change.path).filename().string();
+		if (change.deleted)
 		{
-			if (!fs::exists(filePath))
+			std::cout << "[FileMonitor] File was deleted externally: " << filename
+					  << std::endl;
+			continue;
+		}
+
+		{
+			// The editor may have saved or reloaded this very content since
+			std::lock_guard<std::mutex> lock(_mutex);
+			auto it = _files.find(change.path);
+			if (it == _files.end() || it->second.hash == change.hash)
 			{
-				// File was deleted externally
-				std::string filename = fs::path(filePath).filename().string();
-				std::cout << "[FileMonitor] File was deleted externally: " << filename
-						  << std::endl;
-				filesToRemove.push_back(filePath);
 				continue;
 			}
+		}
 
-			// Check modification time
-			auto currentModTime = fs::last_write_time(filePath);
-			auto modTimeIt = _fileModificationTimes.find(filePath);
+		std::cout << "[FileMonitor] File changed externally: " << filename << std::endl;
 
-			if (modTimeIt != _fileModificationTimes.end() &&
-				currentModTime > modTimeIt->second)
-			{
-				// File modification time changed, check if content actually changed
-				if (shouldReloadFile(filePath))
-				{
-					std::string filename = fs::path(filePath).filename().string();
-					std::cout << "[FileMonitor] File changed externally: " << filename
-							  << std::endl;
+		// Call the callback if set
+		if (onFileChanged)
+		{
+			onFileChanged(change.path, filename);
+		}
+	}
+}
 
-					// Call the callback if set
-					if (onFileChanged)
-					{
-						onFileChanged(filePath, filename);
-					}
-				}
-			}
+void FileMonitor::addFileToMonitoring(const std::string &filePath)
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_files.count(filePath))
+		{
+			return;
+		}
+	}
+
+	FileState state;
+	if (readState(filePath, state) && !hashFile(filePath, state.hash))
+	{
+		state.exists = false;
+	}
 
-			// Update the modification time
-			_fileModificationTimes[filePath] = currentModTime;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_files.emplace(filePath, state);
+		_filesChanged = true;
+	}
+	wake();
+}
 
-		} catch (const std::exception &e)
+void FileMonitor::removeFileFromMonitoring(const std::string &filePath)
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_files.erase(filePath) == 0)
 		{
-			std::cerr << "Error checking external file changes for " << filePath << ": "
-					  << e.what() << std::endl;
+			return;
 		}
+		_filesChanged = true;
 	}
+	wake();
+}
 
-	// Remove deleted files
-	for (const auto &filePath : filesToRemove)
+void FileMonitor::refreshFileState(const std::string &filePath,
+								   const std::string &content)
+{
+	FileState state;
+	readState(filePath, state);
+	state.hash = hashContent(content);
+
+	bool added;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		added = _files.insert_or_assign(filePath, state).second;
+		_filesChanged |= added;
+	}
+	if (added)
 	{
-		_monitoredFiles.erase(filePath);
-		_fileModificationTimes.erase(filePath);
-		_fileContentHashes.erase(filePath);
+		wake();
 	}
 }
 
-void FileMonitor::addFileToMonitoring(const std::string &filePath)
+size_t FileMonitor::getMonitoredFileCount() const
 {
-	if (_monitoredFiles.find(filePath) == _monitoredFiles.end())
-	{
-		_monitoredFiles.insert(filePath);
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _files.size();
+}
 
-		if (fs::exists(filePath))
-		{
-			_fileModificationTimes[filePath] = fs::last_write_time(filePath);
+bool FileMonitor::readState(const std::string &path, FileState &state)
+{
+	std::error_code ec;
+	state.modified = fs::last_write_time(path, ec);
+	if (!ec)
+	{
+		state.size = fs::file_size(path, ec);
+	}
+	state.exists = !ec;
+	return state.exists;
+}
 
-			// Calculate content hash for change detection
-			try
-			{
-				std::ifstream file(filePath, std::ios::binary);
-				if (file)
-				{
-					std::stringstream buffer;
-					buffer << file.rdbuf();
-					_fileContentHashes[filePath] = calculateFileHash(buffer.str());
-				}
-			} catch (...)
-			{
-				// Ignore errors for individual files
-			}
-		}
+bool FileMonitor::hashFile(const std::string &path, uint64_t &hash)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		return false;
 	}
+	StreamHash hasher;
+	char buffer[64 * 1024];
+	while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0)
+	{
+		hasher.update(buffer, static_cast<size_t>(file.gcount()));
+	}
+	hash = hasher.finish();
+	return true;
 }
 
-void FileMonitor::removeFileFromMonitoring(const std::string &filePath)
+uint64_t FileMonitor::hashContent(const std::string &content)
 {
-	_monitoredFiles.erase(filePath);
-	_fileModificationTimes.erase(filePath);
-	_fileContentHashes.erase(filePath);
+	StreamHash hasher;
+	hasher.update(content.data(), content.size());
+	return hasher.finish();
 }
 
-void FileMonitor::refreshFileState(const std::string &filePath)
+void FileMonitor::checkFiles(const std::vector<std::string> &paths)
 {
-	if (fs::exists(filePath))
+	bool queued = false;
+	for (const std::string &path : paths)
 	{
-		// Update the modification time to current
-		_fileModificationTimes[filePath] = fs::last_write_time(filePath);
+		FileState known;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			auto it = _files.find(path);
+			if (it == _files.end())
+			{
+				continue;
+			}
+			known = it->second;
+		}
 
-		// Update the content hash to current
-		try
+		FileState now;
+		if (!readState(path, now))
 		{
-			std::ifstream file(filePath, std::ios::binary);
-			if (file)
+			if (known.exists)
 			{
-				std::stringstream buffer;
-				buffer << file.rdbuf();
-				_fileContentHashes[filePath] = calculateFileHash(buffer.str());
+				std::lock_guard<std::mutex> lock(_mutex);
+				auto it = _files.find(path);
+				if (it != _files.end())
+				{
+					// Kept, so a file put back in its place still counts as a change
+					it->second.exists = false;
+					_changes.push_back({path, true, 0});
+					queued = true;
+				}
 			}
-		} catch (...)
+			continue;
+		}
+		// Only read the content when the timestamp or size moved
+		if (known.exists && now.modified == known.modified && now.size == known.size)
+		{
+			continue;
+		}
+		if (!hashFile(path, now.hash))
+		{
+			continue;
+		}
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto it = _files.find(path);
+		if (it == _files.end())
+		{
+			continue;
+		}
+		// The stored hash stays that of the editor's content, so a change it
+		// has not taken is reported again when the file moves on
+		it->second.exists = true;
+		it->second.modified = now.modified;
+		it->second.size = now.size;
+		if (now.hash != it->second.hash)
 		{
-			// Ignore errors for individual files
+			_changes.push_back({path, false, now.hash});
+			queued = true;
 		}
 	}
+
+	if (queued)
+	{
+		_hasChanges.store(true, std::memory_order_release);
+		gRedraw.request();
+	}
 }
 
-void FileMonitor::scanProjectFilesForMonitoring()
+void FileMonitor::pollLoop()
 {
-	if (_projectFolder.empty())
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (!_stopping)
 	{
-		return;
+		_wakeup.wait_for(lock, std::chrono::milliseconds(POLL_INTERVAL_MS));
+		if (_stopping)
+		{
+			break;
+		}
+		std::vector<std::string> paths;
+		paths.reserve(_files.size());
+		for (const auto &entry : _files)
+		{
+			paths.push_back(entry.first);
+		}
+		_filesChanged = false;
+
+		// A stat per open file, off the main thread
+		lock.unlock();
+		checkFiles(paths);
+		lock.lock();
 	}
+}
+
+#ifdef PLATFORM_LINUX
+bool FileMonitor::watchLoop()
+{
+	using namespace std::chrono;
 
-	// If already scanning, don't start another scan
-	if (_fileScanThread.joinable())
+	int inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (inotifyFd < 0)
 	{
-		return;
+		return false;
 	}
 
-	std::cout << "[FileMonitor] Starting background scan for: " << _projectFolder
-			  << std::endl;
+	// Directories are watched rather than files, so editors that save by
+	// writing a new file and renaming it over the old one are still seen
+	constexpr uint32_t MASK = IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE |
+							  IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
 
-	// Launch scan in background thread
-	_fileScanThread = std::thread([this]() {
-		try
+	struct Watch
+	{
+		std::string dir;
+		// Monitored file names in the directory, to their monitored paths
+		std::unordered_map<std::string, std::string> files;
+	};
+	std::unordered_map<int, Watch> watches;
+	std::set<std::string> pending;
+	steady_clock::time_point pendingSince;
+
+	// Brings the watches in line with the monitored files
+	auto updateWatches = [&]() {
+		std::unordered_map<std::string, Watch> wanted;
 		{
-			for (const auto &entry : fs::recursive_directory_iterator(_projectFolder))
+			std::lock_guard<std::mutex> lock(_mutex);
+			_filesChanged = false;
+			for (const auto &entry : _files)
 			{
-				if (entry.is_regular_file())
-				{
-					std::string filePath = entry.path().string();
-					std::string filename = entry.path().filename().string();
-
-					// Skip specific files
-					if (filename == ".undo-redo-ned.json" ||
-						filename == ".ned-agent-history.json" ||
-						filename == "open_router_key.json")
-					{
-						continue;
-					}
-
-					// Check extension
-					std::string extension = entry.path().extension().string();
-					if (_monitoredExtensions.find(extension) != _monitoredExtensions.end())
-					{
-						addFileToMonitoring(filePath);
-					}
-				}
+				fs::path path(entry.first);
+				Watch &watch = wanted[path.parent_path().string()];
+				watch.files.emplace(path.filename().string(), entry.first);
 			}
-
-			std::cout << "[FileMonitor] Scan completed! Monitoring "
-					  << _monitoredFiles.size() << " files" << std::endl;
-
-		} catch (const std::exception &e)
+		}
+		for (auto it = watches.begin(); it != watches.end();)
 		{
-			std::cerr << "Error in background file scan: " << e.what() << std::endl;
+			if (!wanted.count(it->second.dir))
+			{
+				inotify_rm_watch(inotifyFd, it->first);
+				it = watches.erase(it);
+			} else
+			{
+				++it;
+			}
 		}
-	});
-}
+		for (auto &entry : wanted)
+		{
+			// Watching an already watched directory returns its descriptor
+			int wd = inotify_add_watch(inotifyFd, entry.first.c_str(), MASK);
+			if (wd < 0)
+			{
+				continue;
+			}
+			Watch &watch = watches[wd];
+			watch.dir = entry.first;
+			watch.files = std::move(entry.second.files);
+		}
+	};
 
-bool FileMonitor::shouldReloadFile(const std::string &filePath)
-{
-	try
+	alignas(inotify_event) char buffer[16 * 1024];
+	bool failed = false;
+	while (!shouldStop())
 	{
-		// Read the current file content
-		std::ifstream file(filePath, std::ios::binary);
-		if (!file)
+		bool filesChanged;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			filesChanged = _filesChanged;
+		}
+		if (filesChanged)
 		{
-			return false;
+			updateWatches();
 		}
 
-		std::stringstream buffer;
-		buffer << file.rdbuf();
-		std::string currentContent = buffer.str();
+		pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {_wakeFds[0], POLLIN, 0}};
+		int timeout = !pending.empty() ? DEBOUNCE_MS : _wakeFds[0] >= 0 ? -1 : 250;
+		int ready = poll(fds, 2, timeout);
+		if (ready < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			failed = true;
+			break;
+		}
+		if (fds[1].revents)
+		{
+			char drain[64];
+			(void)!read(_wakeFds[0], drain, sizeof(drain));
+			continue;
+		}
 
-		// Calculate hash of current content
-		std::string currentHash = calculateFileHash(currentContent);
+		if (ready > 0)
+		{
+			ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+			for (ssize_t offset = 0; offset < length;)
+			{
+				const auto *event =
+					reinterpret_cast<const inotify_event *>(buffer + offset);
+				offset += sizeof(inotify_event) + event->len;
 
-		// Compare with stored hash
-		auto it = _fileContentHashes.find(filePath);
-		if (it != _fileContentHashes.end())
+				if (event->mask & IN_Q_OVERFLOW)
+				{
+					// Events were lost: look at every file
+					for (const auto &watch : watches)
+					{
+						for (const auto &file : watch.second.files)
+						{
+							pending.insert(file.second);
+						}
+					}
+					continue;
+				}
+				if (event->mask & IN_IGNORED)
+				{
+					// The directory went away; it is watched again the next time
+					// the monitored files change
+					watches.erase(event->wd);
+					continue;
+				}
+				auto it = watches.find(event->wd);
+				if (it == watches.end() || event->len == 0)
+				{
+					continue;
+				}
+				auto file = it->second.files.find(event->name);
+				if (file != it->second.files.end())
+				{
+					if (pending.empty())
+					{
+						pendingSince = steady_clock::now();
+					}
+					pending.insert(file->second);
+				}
+			}
+		}
+
+		// Look once the burst settles, or after MAX_DELAY_MS of steady writes
+		bool settled = ready == 0;
+		bool overdue = !pending.empty() &&
+					   steady_clock::now() - pendingSince >= milliseconds(MAX_DELAY_MS);
+		if (!pending.empty() && (settled || overdue))
 		{
-			return it->second != currentHash;
+			checkFiles(std::vector<std::string>(pending.begin(), pending.end()));
+			pending.clear();
 		}
+	}
 
-		return false;
-	} catch (const std::exception &e)
+	::close(inotifyFd);
+	if (failed)
 	{
-		std::cerr << "Error checking if file should be reloaded: " << e.what()
-				  << std::endl;
+		std::cout << "[FileMonitor] inotify failed, polling instead" << std::endl;
 		return false;
 	}
+	return true;
 }
-
-std::string FileMonitor::calculateFileHash(const std::string &content)
-{
-	std::hash<std::string> hasher;
-	std::stringstream ss;
-	ss << std::hex << hasher(content);
-	return ss.str();
-}
+#endif
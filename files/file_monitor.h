@@ -1,16 +1,25 @@
 /*
 	File: file_monitor.h
 	Description: Dedicated file monitoring class for external file change detection
+
+   Only files open in the editor are monitored. A background thread watches
+   their directories through inotify on Linux, or polls their timestamps once a
+   second elsewhere, and hashes a file only when its timestamp or size moved.
+   Changes are gathered there and handed to the main thread in one batch.
 */
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <filesystem>
 #include <functional>
 #include <map>
-#include <set>
+#include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
 
 namespace fs = std::filesystem;
 
@@ -24,46 +33,74 @@ class FileMonitor
 	void startMonitoring(const std::string &projectFolder);
 	void stopMonitoring();
 
-	// Add/remove files from monitoring
+	// Add/remove files from monitoring. Adding a file hashes it from disk once.
 	void addFileToMonitoring(const std::string &filePath);
 	void removeFileFromMonitoring(const std::string &filePath);
 
-	// Refresh file state after internal save to prevent false external change detection
-	void refreshFileState(const std::string &filePath);
+	// The editor saved or reloaded the file and now holds `content`; changes
+	// are judged against it from here on
+	void refreshFileState(const std::string &filePath, const std::string &content);
 
 	// Get monitoring status
 	bool isMonitoring() const { return !_projectFolder.empty(); }
-	size_t getMonitoredFileCount() const { return _monitoredFiles.size(); }
+	size_t getMonitoredFileCount() const;
 
-	// Check for external file changes (called from main thread)
+	// Deliver changes found by the watcher thread (called from main thread)
 	void checkForExternalFileChanges();
 
 	// Callback for when files change externally
 	std::function<void(const std::string &, const std::string &)> onFileChanged;
 
-  private:
-	// Background scanning methods
-	void scanProjectFilesForMonitoring();
+	// Quiet time before a burst of events on a file is looked at
+	static constexpr int DEBOUNCE_MS = 50;
+	static constexpr int POLL_INTERVAL_MS = 1000;
 
-	// File change detection helpers
-	bool shouldReloadFile(const std::string &filePath);
-	std::string calculateFileHash(const std::string &content);
+  private:
+	struct FileState
+	{
+		bool exists = false;
+		fs::file_time_type modified;
+		uintmax_t size = 0;
+		uint64_t hash = 0; // Of the content the editor holds
+	};
+
+	struct Change
+	{
+		std::string path;
+		bool deleted = false;
+		uint64_t hash = 0; // Of the content on disk
+	};
 
 	// Member variables
 	std::string _projectFolder;
-	std::set<std::string> _monitoredFiles;
-	std::map<std::string, fs::file_time_type> _fileModificationTimes;
-	std::map<std::string, std::string> _fileContentHashes;
 
-	// Background thread
-	std::thread _fileScanThread;
+	mutable std::mutex _mutex; // Guards everything below
+	std::map<std::string, FileState> _files;
+	std::vector<Change> _changes; // Found by the watcher, not yet delivered
+	bool _filesChanged = false;	  // The watcher must update its watches
+	bool _stopping = false;
+	std::condition_variable _wakeup;
+	std::atomic<bool> _hasChanges{false};
 
-	// File extensions to monitor
-	std::set<std::string> _monitoredExtensions;
-
-	// Throttling for checkForExternalFileChanges
-	double _lastChangeCheckTime = 0.0;
-
-	// Initialize monitored extensions
-	void initializeMonitoredExtensions();
+	// Background thread
+	std::thread _watchThread;
+#ifdef PLATFORM_LINUX
+	int _wakeFds[2] = {-1, -1}; // Pipe that interrupts the inotify wait
+#endif
+
+	void wake();
+	bool shouldStop();
+	void pollLoop();
+#ifdef PLATFORM_LINUX
+	// Returns false when inotify is unavailable
+	bool watchLoop();
+#endif
+
+	// Stats `paths`, hashes the ones whose timestamp or size moved and queues
+	// those whose content differs from the editor's
+	void checkFiles(const std::vector<std::string> &paths);
+
+	static bool readState(const std::string &path, FileState &state);
+	static bool hashFile(const std::string &path, uint64_t &hash);
+	static uint64_t hashContent(const std::string &content);
 };
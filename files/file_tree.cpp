@@ -2,12 +2,27 @@
 #include "../editor/editor_git.h"
 #include "../editor/editor_utils.h"
 #include "../files/files.h"
+#include "../util/redraw.h"
 #include "../util/settings.h"
 #include "editor.h"
-#include <GLFW/glfw3.h>
 #include <algorithm>
 #include <iostream>
 
+namespace {
+
+bool snapshotCoversFolder(const std::shared_ptr<const WorkspaceSnapshot> &snapshot)
+{
+	return snapshot && snapshot->root == gFileExplorer.selectedFolder;
+}
+
+// Hidden system files and specific unwanted files
+bool shouldSkipFile(const std::string &filename)
+{
+	return filename == ".DS_Store" || filename == "thumbs.db";
+}
+
+} // namespace
+
 void FileTree::startGitStatusTracking()
 {
 	gitStatusEnabled = true;
@@ -32,10 +47,17 @@ void FileTree::gitStatusBackgroundTask()
 		std::set<std::string> modifiedFiles = gEditorGit.getModifiedFilePaths();
 
 		// Cache the results thread-safely
+		bool changed = false;
 		{
 			std::lock_guard<std::mutex> lock(modifiedFilesMutex);
+			changed = cachedModifiedFiles != modifiedFiles;
 			cachedModifiedFiles = modifiedFiles;
 		}
+		if (changed)
+		{
+			gitStatusVersion++;
+			gRedraw.request();
+		}
 
 		std::this_thread::sleep_for(std::chrono::seconds(1));
 	}
@@ -43,59 +65,99 @@ void FileTree::gitStatusBackgroundTask()
 
 FileTree gFileTree;
 
-FileTree::FileTree()
-	: initialRefreshDone(false), hasAutoOpenedReadme(false), shouldCheckForReadme(true)
-{
-}
+FileTree::FileTree() : hasAutoOpenedReadme(false), shouldCheckForReadme(true) {}
 
-void FileTree::displayFileTree(FileNode &node)
+void FileTree::displayFileTree()
 {
-	static int current_depth = 0;
-	TreeDisplayMetrics metrics = calculateDisplayMetrics();
+	refreshFileTree();
+	if (visibleDirty)
+	{
+		visibleRows.clear();
+		appendVisibleRows(rootNode, 0);
+		visibleDirty = false;
+	}
 
+	TreeDisplayMetrics metrics = calculateDisplayMetrics();
 	pushTreeStyles();
-	ImGui::PushID(node.fullPath.c_str());
 
-	ImGui::SetCursorPosX(ImGui::GetCursorPosX() + current_depth * metrics.indentWidth);
+	// Icons all come from the icon atlas; drawing them in their own channel
+	// lets ImGui batch them into one draw call instead of alternating with the
+	// font texture row by row
+	ImDrawList *drawList = ImGui::GetWindowDrawList();
+	drawList->ChannelsSplit(2);
+
+	// Every row is one button of the same height, so the clipper can skip
+	// straight to the rows on screen
+	FileNode *clicked = nullptr;
+	ImGuiListClipper clipper;
+	clipper.Begin(static_cast<int>(visibleRows.size()),
+				  metrics.itemHeight + TreeStyleSettings::ITEM_SPACING.y);
+	while (clipper.Step())
+	{
+		for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++)
+		{
+			const VisibleRow &row = visibleRows[i];
+			if (displayRow(*row.node, metrics, row.depth))
+			{
+				clicked = row.node;
+			}
+		}
+	}
+
+	drawList->ChannelsMerge();
+	ImGui::PopStyleVar(3);
 
-	if (node.isDirectory)
+	if (!clicked)
 	{
-		displayDirectoryNode(node, metrics, current_depth);
+		return;
+	}
+	if (clicked->isDirectory)
+	{
+		clicked->isOpen = !clicked->isOpen;
+		if (clicked->isOpen)
+		{
+			syncOpenDirectories(*clicked, gWorkspaceIndex.snapshot());
+		}
+		visibleDirty = true;
 	} else
 	{
-		displayFileNode(node, metrics, current_depth);
+		editor_state.cursor_index = 0;
+		editor_state.selection_start = 0;
+		editor_state.selection_end = 0;
+		editor_state.selection_active = false;
+		gFileExplorer.loadFileContent(clicked->fullPath);
 	}
+}
 
-	ImGui::PopID();
-	ImGui::PopStyleVar(3);
+void FileTree::appendVisibleRows(FileNode &node, int depth)
+{
+	visibleRows.push_back({&node, depth});
+	if (node.isDirectory && node.isOpen)
+	{
+		for (const auto &child : node.children)
+		{
+			appendVisibleRows(*child, depth + 1);
+		}
+	}
 }
 
-void FileTree::renderNodeText(const std::string &name,
-							  const std::string &fullPath,
-							  bool isCurrentFile)
+ImVec4 FileTree::nodeTextColor(FileNode &node, bool isCurrentFile)
 {
 	// Get current theme text color as default
 	extern Settings gSettings;
 	ImVec4 textColor = gSettings.getCurrentTextColor();
-
-	// Convert fullPath to relative path for Git status check
-	std::string relativePath = fullPath;
-	if (fullPath.rfind(gFileExplorer.selectedFolder, 0) == 0)
+	if (node.isDirectory)
 	{
-		if (gFileExplorer.selectedFolder.length() < fullPath.length())
-		{
-			relativePath = fullPath.substr(gFileExplorer.selectedFolder.length() + 1);
-		} else
-		{
-			relativePath = "."; // Root folder itself
-		}
+		return textColor;
 	}
 
 	// Check if file is modified (use cached results from background thread)
-	bool isModified = false;
+	uint64_t version = gitStatusVersion.load();
+	if (node.gitVersion != version)
 	{
 		std::lock_guard<std::mutex> lock(modifiedFilesMutex);
-		isModified = cachedModifiedFiles.find(relativePath) != cachedModifiedFiles.end();
+		node.gitModified = cachedModifiedFiles.count(node.relativePath) > 0;
+		node.gitVersion = version;
 	}
 
 	// Prioritize active file rainbow color
@@ -109,20 +171,13 @@ void FileTree::renderNodeText(const std::string &name,
 		textColor = gSettings.getCurrentTextColor();
 	}
 	// Dark grey color for modified files (but not the current file)
-	else if (isModified)
+	else if (node.gitModified)
 	{
 		textColor = ImVec4(0.4f, 0.4f, 0.4f, 1.0f); // Dark grey for modified files
 	}
-	// Default color for other files - use theme color
-	else
-	{
-		textColor = gSettings.getCurrentTextColor();
-	}
-
-	ImGui::PushStyleColor(ImGuiCol_Text, textColor);
-	ImGui::Text("%s", name.c_str());
-	ImGui::PopStyleColor();
+	return textColor;
 }
+
 std::string FileTree::findReadmeInRoot()
 {
 	if (!rootNode.isDirectory)
@@ -131,292 +186,294 @@ std::string FileTree::findReadmeInRoot()
 	// Case-insensitive search for readme.md variations
 	for (const auto &child : rootNode.children)
 	{
-		if (!child.isDirectory)
+		if (!child->isDirectory)
 		{
-			std::string lowerName = child.name;
+			std::string lowerName = child->name;
 			std::transform(
 				lowerName.begin(), lowerName.end(), lowerName.begin(), ::tolower);
 
 			if (lowerName == "readme.md" || lowerName == "readme")
 			{
-				return child.fullPath;
+				return child->fullPath;
 			}
 		}
 	}
 	return "";
 }
 
-void FileTree::displayDirectoryNode(const FileNode &node,
-									const TreeDisplayMetrics &metrics,
-									int &depth)
+bool FileTree::displayRow(FileNode &node, const TreeDisplayMetrics &metrics, int depth)
 {
 	float multiplier = 1.1f;
-	float iconSize = metrics.folderIconSize * multiplier;
-	ImVec2 iconDimensions(iconSize, iconSize);
-	ImTextureID folderIcon = getFolderIcon(node.isOpen);
-
+	float indent = depth * metrics.indentWidth;
+	float rowX = ImGui::GetCursorPosX();
+	float rowY = ImGui::GetCursorPosY();
+
+	// Icon and text as local x positions, and the width the row needs
+	float iconSize;
+	float iconX;
+	float textX;
+	float requiredWidth;
+	IconRef icon;
 	ImVec2 textSize = ImGui::CalcTextSize(node.name.c_str());
+	if (node.isDirectory)
+	{
+		iconSize = metrics.folderIconSize * multiplier;
+		icon = getFolderIcon(node.isOpen);
+		iconX = rowX + indent + TreeStyleSettings::HORIZONTAL_PADDING;
+		textX = iconX + iconSize + TreeStyleSettings::TEXT_PADDING;
+		requiredWidth = indent + TreeStyleSettings::HORIZONTAL_PADDING + iconSize +
+						TreeStyleSettings::TEXT_PADDING + textSize.x;
+	} else
+	{
+		iconSize = metrics.fileIconSize * multiplier;
+		if (!node.icon)
+		{
+			node.icon = gFileExplorer.getIconForFile(node.name);
+		}
+		icon = node.icon;
+		iconX = rowX + indent + TreeStyleSettings::LEFT_MARGIN;
+		textX = indent + iconSize + TreeStyleSettings::LEFT_MARGIN + 10;
+		requiredWidth = indent + TreeStyleSettings::LEFT_MARGIN + iconSize +
+						10.0f // Spacing between icon and text
+						+ textSize.x;
+	}
 
-	float requiredWidth = (depth * metrics.indentWidth) +
-						  TreeStyleSettings::HORIZONTAL_PADDING + iconDimensions.x +
-						  TreeStyleSettings::TEXT_PADDING // Spacing between icon and text
-														  // (matches SameLine offset)
-						  + textSize.x;
-
+	// The button covers the whole row; icon and text are drawn over it
+	ImGui::SetCursorPosX(rowX + indent);
 	float availableWidth = ImGui::GetContentRegionAvail().x;
-
 	float buttonWidth = std::max(requiredWidth, availableWidth);
 
+	ImGui::PushID(&node);
 	ImGui::PushStyleColor(ImGuiCol_Button, TreeStyleSettings::TRANSPARENT_BG);
 	ImGui::PushStyleColor(ImGuiCol_ButtonHovered, TreeStyleSettings::HOVER_COLOR);
 	ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(0, 0));
 
-	bool isOpen = ImGui::Button(("##" + node.fullPath).c_str(),
-								ImVec2(buttonWidth, metrics.itemHeight));
+	bool clicked = ImGui::Button("##row", ImVec2(buttonWidth, metrics.itemHeight));
 
 	ImGui::PopStyleVar();
 	ImGui::PopStyleColor(2);
+	ImGui::PopID();
 
-	float lineCenterY = metrics.cursorPos.y + (metrics.itemHeight / 2.0f);
-	float iconTopY = lineCenterY - (iconDimensions.y / 2.0f);
-	float textHeight = ImGui::GetTextLineHeight();
-	float textTopY = lineCenterY - (textHeight / 2.0f);
-
-	// Position icon and text on the same line with proper alignment
-	ImGui::SetCursorPosX(metrics.cursorPos.x + depth * metrics.indentWidth +
-						 TreeStyleSettings::HORIZONTAL_PADDING);
-	ImGui::SetCursorPosY(iconTopY);
-	ImGui::Image(folderIcon, iconDimensions);
-
-	ImGui::SameLine(metrics.cursorPos.x + depth * metrics.indentWidth + iconDimensions.x +
-					TreeStyleSettings::HORIZONTAL_PADDING +
-					TreeStyleSettings::TEXT_PADDING);
-	ImGui::SetCursorPosY(textTopY);
-
-	// Use theme text color for folder names
-	extern Settings gSettings;
-	ImVec4 folderTextColor = gSettings.getCurrentTextColor();
-	ImGui::PushStyleColor(ImGuiCol_Text, folderTextColor);
-	ImGui::Text("%s", node.name.c_str());
-	ImGui::PopStyleColor();
+	// Local to screen coordinates
+	ImVec2 origin = ImGui::GetWindowPos();
+	origin.x -= ImGui::GetScrollX();
+	origin.y -= ImGui::GetScrollY();
+
+	float lineCenterY = origin.y + rowY + metrics.itemHeight / 2.0f;
+	ImVec2 iconMin(origin.x + iconX, lineCenterY - iconSize / 2.0f);
+	ImDrawList *drawList = ImGui::GetWindowDrawList();
+	drawList->ChannelsSetCurrent(1);
+	drawList->AddImage(icon.texture,
+					   iconMin,
+					   ImVec2(iconMin.x + iconSize, iconMin.y + iconSize),
+					   icon.uv0,
+					   icon.uv1);
+	drawList->ChannelsSetCurrent(0);
+
+	bool isCurrentFile = !node.isDirectory && node.fullPath == gFileExplorer.currentFile;
+	ImVec2 textPos(origin.x + textX, lineCenterY - ImGui::GetTextLineHeight() / 2.0f);
+	drawList->AddText(textPos,
+					  ImGui::GetColorU32(nodeTextColor(node, isCurrentFile)),
+					  node.name.c_str(),
+					  node.name.c_str() + node.name.size());
+
+	return clicked;
+}
 
-	if (isOpen)
+void FileTree::openFolder(const std::string &folder)
+{
+	rootNode = FileNode();
+	rootNode.name = fs::path(folder).filename().string();
+	rootNode.fullPath = folder;
+	rootNode.isDirectory = true;
+	rootNode.isOpen = true;
+	visibleDirty = true;
+
+	indexVersion = gWorkspaceIndex.version();
+	loadChildren(rootNode, gWorkspaceIndex.snapshot());
+
+	// Auto-open README for the first folder
+	if (shouldCheckForReadme)
 	{
-		const_cast<FileNode &>(node).isOpen = !node.isOpen;
-		if (node.isOpen)
+		std::string readmePath = findReadmeInRoot();
+		if (!readmePath.empty() && gFileExplorer.currentFile.empty())
 		{
-			buildFileTree(node.fullPath, const_cast<FileNode &>(node));
+			gFileExplorer.loadFileContent(readmePath);
+			hasAutoOpenedReadme = true;
 		}
+		shouldCheckForReadme = false;
 	}
+}
 
-	if (node.isOpen)
+void FileTree::refreshFileTree()
+{
+	if (gFileExplorer.selectedFolder.empty())
 	{
-		depth++;
-		for (const auto &child : node.children)
-		{
-			displayFileTree(const_cast<FileNode &>(child));
-		}
-		depth--;
+		return;
+	}
+	if (rootNode.fullPath != gFileExplorer.selectedFolder)
+	{
+		openFolder(gFileExplorer.selectedFolder);
+		return;
+	}
+
+	// The workspace index reports every change as a new version; directories
+	// it has no listing of are read from disk again on a timer
+	uint64_t version = gWorkspaceIndex.version();
+	double now = Redraw::now();
+	if (version != indexVersion)
+	{
+		indexVersion = version;
+		lastDiskRefresh = now;
+		diskListed = false;
+		syncOpenDirectories(rootNode, gWorkspaceIndex.snapshot());
+	} else if (diskListed && now - lastDiskRefresh >= DISK_REFRESH_SECONDS)
+	{
+		lastDiskRefresh = now;
+		diskListed = false;
+		syncDiskDirectories(rootNode, gWorkspaceIndex.snapshot());
+	}
+	if (diskListed)
+	{
+		gRedraw.requestAt(lastDiskRefresh + DISK_REFRESH_SECONDS);
 	}
 }
 
-void FileTree::displayFileNode(const FileNode &node,
-							   const TreeDisplayMetrics &metrics,
-							   int depth)
+void FileTree::syncOpenDirectories(
+	FileNode &node, const std::shared_ptr<const WorkspaceSnapshot> &snapshot)
 {
-	float multiplier = 1.1f;
-	float iconSize = metrics.fileIconSize * multiplier;
-	ImVec2 iconDimensions(iconSize, iconSize);
-	ImTextureID fileIcon = gFileExplorer.getIconForFile(node.name);
-
-	// Calculate the width of the node's text
-	ImVec2 textSize = ImGui::CalcTextSize(node.name.c_str());
-
-	// Calculate the required width to fit indentation, icon, spacing, and text
-	float requiredWidth = (depth * metrics.indentWidth) + TreeStyleSettings::LEFT_MARGIN +
-						  iconSize +
-						  10.0f // Spacing between icon and text (matches SameLine offset)
-						  + textSize.x;
-
-	// Get the available width in the content region
-	float availableWidth = ImGui::GetContentRegionAvail().x;
-
-	// Use the larger of required or available width to prevent cutoff
-	float buttonWidth = std::max(requiredWidth, availableWidth);
-
-	ImGui::PushStyleColor(ImGuiCol_Button, TreeStyleSettings::TRANSPARENT_BG);
-	ImGui::PushStyleColor(ImGuiCol_ButtonHovered, TreeStyleSettings::HOVER_COLOR);
-	ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(0, 0));
-
-	// Create button with calculated width to cover full content
-	bool clicked = ImGui::Button(("##" + node.fullPath).c_str(),
-								 ImVec2(buttonWidth, metrics.itemHeight));
-
-	ImGui::PopStyleVar();
-	ImGui::PopStyleColor(2);
-
-	// Position icon and text as before...
-	float lineCenterY = metrics.cursorPos.y + (metrics.itemHeight / 2.0f);
-	float iconTopY = lineCenterY - (iconDimensions.y / 2.0f);
-	float textHeight = ImGui::GetTextLineHeight();
-	float textTopY = lineCenterY - (textHeight / 2.0f);
-
-	// Position icon and text on the same line with proper alignment
-	ImGui::SetCursorPosX(metrics.cursorPos.x + depth * metrics.indentWidth +
-						 TreeStyleSettings::LEFT_MARGIN);
-	ImGui::SetCursorPosY(iconTopY);
-	ImGui::Image(fileIcon, iconDimensions);
-
-	ImGui::SameLine(depth * metrics.indentWidth + iconDimensions.x +
-					TreeStyleSettings::LEFT_MARGIN + 10);
-	ImGui::SetCursorPosY(textTopY);
-	renderNodeText(node.name, node.fullPath, node.fullPath == gFileExplorer.currentFile);
-
-	if (clicked)
+	if (!node.isDirectory || !node.isOpen)
 	{
-		editor_state.cursor_index = 0;
-		editor_state.selection_start = 0;
-		editor_state.selection_end = 0;
-		editor_state.selection_active = false;
-		gFileExplorer.loadFileContent(node.fullPath);
+		return;
+	}
+	loadChildren(node, snapshot);
+	for (const auto &child : node.children)
+	{
+		syncOpenDirectories(*child, snapshot);
 	}
 }
 
-void FileTree::refreshFileTree()
+void FileTree::syncDiskDirectories(
+	FileNode &node, const std::shared_ptr<const WorkspaceSnapshot> &snapshot)
 {
-	// Always allow immediate refresh for initial load
-	if (!initialRefreshDone)
+	if (!node.isDirectory || !node.isOpen)
 	{
-		// Force initial refresh
-		lastFileTreeRefreshTime = 0;
-		initialRefreshDone = true;
-	} else
+		return;
+	}
+	if (!node.listing)
 	{
-		// Use normal interval checks after initial load
-		double currentTime = glfwGetTime();
-		if (currentTime - lastFileTreeRefreshTime < FILE_TREE_REFRESH_INTERVAL)
-		{
-			return;
-		}
-		lastFileTreeRefreshTime = currentTime;
+		loadChildren(node, snapshot);
 	}
-	if (!gFileExplorer.selectedFolder.empty())
+	for (const auto &child : node.children)
 	{
-		FileNode oldRoot = rootNode;
-
-		// Rebuild root node
-		rootNode.name = fs::path(gFileExplorer.selectedFolder).filename().string();
-		rootNode.fullPath = gFileExplorer.selectedFolder;
-		rootNode.isDirectory = true;
-		rootNode.isOpen = true;
-
-		buildFileTree(gFileExplorer.selectedFolder, rootNode);
-		preserveOpenStates(oldRoot, rootNode);
-
-		// Auto-open README on first refresh
-		if (shouldCheckForReadme && initialRefreshDone)
-		{
-			std::string readmePath = findReadmeInRoot();
-			if (!readmePath.empty() && gFileExplorer.currentFile.empty())
-			{
-				gFileExplorer.loadFileContent(readmePath);
-				hasAutoOpenedReadme = true;
-			}
-			shouldCheckForReadme = false;
-		}
+		syncDiskDirectories(*child, snapshot);
 	}
 }
-void FileTree::preserveOpenStates(const FileNode &oldNode, FileNode &newNode)
+
+void FileTree::loadChildren(FileNode &node,
+							const std::shared_ptr<const WorkspaceSnapshot> &snapshot)
 {
-	for (auto &newChild : newNode.children)
+	// Directories the workspace index walked are listed from memory; ignored
+	// ones, and any before the first walk ends, are read from disk. Listings
+	// the index did not touch are shared between snapshots, so an unchanged
+	// directory costs one pointer comparison.
+	std::shared_ptr<const WorkspaceSnapshot::Listing> listing;
+	if (snapshotCoversFolder(snapshot))
 	{
-		auto it = std::find_if(oldNode.children.begin(),
-							   oldNode.children.end(),
-							   [&newChild](const FileNode &oldChild) {
-								   return oldChild.fullPath == newChild.fullPath;
-							   });
-
-		if (it != oldNode.children.end())
+		auto it = snapshot->directories.find(node.relativePath);
+		if (it != snapshot->directories.end())
 		{
-			newChild.isOpen = it->isOpen;
-			if (newChild.isDirectory && newChild.isOpen)
-			{
-				preserveOpenStates(*it, newChild);
-			}
+			listing = it->second;
 		}
 	}
-}
-void FileTree::buildFileTree(const fs::path &path, FileNode &node)
-{
-	// Helper function to check if file should be skipped
-	auto shouldSkipFile = [](const std::string &filename) {
-		return filename == ".DS_Store" || filename == "thumbs.db";
-	};
-
-	// Don't clear children if they already exist and the node is open
-	if (!node.isOpen && !node.children.empty())
+	if (listing && node.loaded && listing == node.listing)
 	{
 		return;
 	}
 
-	std::vector<FileNode> newChildren;
-	try
+	std::vector<std::pair<std::string, bool>> entries; // Name, is directory
+	if (listing)
 	{
-		for (const auto &entry : fs::directory_iterator(path))
+		entries.reserve(listing->size());
+		for (const WorkspaceSnapshot::Entry &entry : *listing)
 		{
-			// Skip hidden system files and specific unwanted files
-			std::string filename = entry.path().filename().string();
-			if (shouldSkipFile(filename))
+			entries.push_back({entry.name, entry.isDirectory});
+		}
+	} else
+	{
+		if (node.isOpen)
+		{
+			diskListed = true;
+		}
+		try
+		{
+			fs::path path(node.fullPath);
+#ifdef PLATFORM_WINDOWS
+			path = fs::u8path(node.fullPath);
+#endif
+			for (const auto &entry : fs::directory_iterator(path))
 			{
-				continue;
+				std::error_code ec;
+				entries.push_back(
+					{entry.path().filename().string(), entry.is_directory(ec)});
 			}
+		} catch (const fs::filesystem_error &e)
+		{
+			std::cerr << "Error accessing directory " << node.fullPath << ": "
+					  << e.what() << std::endl;
+		}
 
-			FileNode child;
-			child.name = filename;
-			child.fullPath = entry.path().string();
-			child.isDirectory = entry.is_directory();
-
-			// Find existing child to preserve its state
-			auto existingChild =
-				std::find_if(node.children.begin(),
-							 node.children.end(),
-							 [&child](const FileNode &existing) {
-								 return existing.fullPath == child.fullPath;
-							 });
-
-			if (existingChild != node.children.end())
+		// Sort directories first, then files by name, like the index
+		std::sort(entries.begin(), entries.end(), [](const auto &a, const auto &b) {
+			if (a.second != b.second)
 			{
-				// Preserve the existing child's state and children
-				child.isOpen = existingChild->isOpen;
-				child.children = std::move(existingChild->children);
+				return a.second > b.second;
 			}
+			return a.first < b.first;
+		});
+	}
 
-			// If it's a directory and it's open, build its tree
-			if (child.isDirectory && child.isOpen)
-			{
-				buildFileTree(child.fullPath, child);
-			}
+	// Children that are still there keep their node, with its open state,
+	// resolved icon and git flag, and its own children
+	std::vector<std::unique_ptr<FileNode>> children;
+	std::unordered_map<std::string, size_t> childIndex;
+	children.reserve(entries.size());
+	childIndex.reserve(entries.size());
+	for (auto &[filename, isDirectory] : entries)
+	{
+		if (shouldSkipFile(filename))
+		{
+			continue;
+		}
 
-			newChildren.push_back(std::move(child));
+		std::unique_ptr<FileNode> child;
+		auto existing = node.childIndex.find(filename);
+		if (existing != node.childIndex.end() &&
+			node.children[existing->second]->isDirectory == isDirectory)
+		{
+			child = std::move(node.children[existing->second]);
+		} else
+		{
+			child = std::make_unique<FileNode>();
+			child->name = filename;
+#ifdef PLATFORM_WINDOWS
+			child->fullPath = (fs::u8path(node.fullPath) / fs::u8path(filename)).string();
+#else
+			child->fullPath = (fs::path(node.fullPath) / filename).string();
+#endif
+			child->relativePath =
+				node.relativePath.empty() ? filename : node.relativePath + "/" + filename;
+			child->isDirectory = isDirectory;
 		}
-	} catch (const fs::filesystem_error &e)
-	{
-		std::cerr << "Error accessing directory " << path << ": " << e.what()
-				  << std::endl;
+		childIndex.emplace(std::move(filename), children.size());
+		children.push_back(std::move(child));
 	}
 
-	// Sort directories first, then files by name (existing code)
-	std::sort(newChildren.begin(),
-			  newChildren.end(),
-			  [](const FileNode &a, const FileNode &b) {
-				  if (a.isDirectory != b.isDirectory)
-				  {
-					  return a.isDirectory > b.isDirectory;
-				  }
-				  return a.name < b.name;
-			  });
-
-	node.children = std::move(newChildren);
+	node.children = std::move(children);
+	node.childIndex = std::move(childIndex);
+	node.listing = std::move(listing);
+	node.loaded = true;
+	visibleDirty = true;
 }
 
 FileTree::TreeDisplayMetrics FileTree::calculateDisplayMetrics()
@@ -427,7 +484,6 @@ FileTree::TreeDisplayMetrics FileTree::calculateDisplayMetrics()
 	metrics.fileIconSize = metrics.currentFontSize * 1.2f;
 	metrics.itemHeight = ImGui::GetFrameHeight();
 	metrics.indentWidth = 18.0f;
-	metrics.cursorPos = ImGui::GetCursorPos();
 	return metrics;
 }
 
@@ -438,13 +494,8 @@ void FileTree::pushTreeStyles()
 	ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, TreeStyleSettings::ITEM_SPACING);
 }
 
-ImTextureID FileTree::getFolderIcon(bool isOpen)
+IconRef FileTree::getFolderIcon(bool isOpen)
 {
-	ImTextureID icon =
-		isOpen ? gFileExplorer.getIcon("folder-open") : gFileExplorer.getIcon("folder");
-	if (!icon)
-	{
-		icon = gFileExplorer.getIcon("folder");
-	}
-	return icon ? icon : gFileExplorer.getIcon("default");
+	// Missing icons already fall back to "default"
+	return gFileExplorer.getIcon(isOpen ? "folder-open" : "folder");
 }
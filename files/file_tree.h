@@ -1,12 +1,16 @@
 #pragma once
 
+#include "icon_atlas.h"
 #include "imgui.h"
+#include "workspace_index.h"
 #include <atomic>
 #include <filesystem>
+#include <memory>
 #include <mutex>
 #include <set>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 namespace fs = std::filesystem;
@@ -15,10 +19,21 @@ struct FileNode
 {
 	std::string name;
 	std::string fullPath;
-	bool isDirectory;
-	std::vector<FileNode> children;
+	std::string relativePath; // To the open folder with '/', as git reports it
+	bool isDirectory = false;
 	bool isOpen = false;
-	ImTextureID iconTexture = 0;
+	bool loaded = false; // Children listed at least once
+	IconRef icon; // Files only, resolved when first drawn
+
+	// Git state, resolved again only when the git status changes
+	bool gitModified = false;
+	uint64_t gitVersion = 0;
+
+	// Directories first, then by name; `childIndex` maps a name to its position
+	std::vector<std::unique_ptr<FileNode>> children;
+	std::unordered_map<std::string, size_t> childIndex;
+	// Index listing the children came from; null when read from disk
+	std::shared_ptr<const WorkspaceSnapshot::Listing> listing;
 };
 
 class FileTree
@@ -28,10 +43,9 @@ class FileTree
 	~FileTree();
 
 	// Core file tree operations
-	void buildFileTree(const fs::path &path, FileNode &node);
+	void openFolder(const std::string &folder);
 	void refreshFileTree();
-	void preserveOpenStates(const FileNode &oldNode, FileNode &newNode);
-	void displayFileTree(FileNode &node);
+	void displayFileTree();
 
 	// Simple git status tracking
 	void startGitStatusTracking();
@@ -42,9 +56,36 @@ class FileTree
 	FileNode rootNode;
 
   private:
-	double lastFileTreeRefreshTime = 0.0;
-	const double FILE_TREE_REFRESH_INTERVAL = 0.5;
-	bool initialRefreshDone = false; // Track if initial refresh has occurred
+	// gWorkspaceIndex version the tree was synced with
+	uint64_t indexVersion = 0;
+
+	// Open directories the index does not walk, such as ignored ones, are read
+	// from disk again this often, as nothing reports their changes
+	static constexpr double DISK_REFRESH_SECONDS = 1.0;
+	double lastDiskRefresh = 0.0;
+	bool diskListed = false; // An open directory was read from disk
+
+	// Open directories flattened into rows, so only the rows on screen are
+	// drawn. Rebuilt when a directory opens, closes or changes.
+	struct VisibleRow
+	{
+		FileNode *node;
+		int depth;
+	};
+	std::vector<VisibleRow> visibleRows;
+	bool visibleDirty = true;
+
+	// Lists `node`'s children, from the index when it has the directory.
+	// Existing children are kept, with their open state and their own children.
+	void loadChildren(FileNode &node,
+					  const std::shared_ptr<const WorkspaceSnapshot> &snapshot);
+	// Brings open directories below `node` up to date with `snapshot`
+	void syncOpenDirectories(FileNode &node,
+							 const std::shared_ptr<const WorkspaceSnapshot> &snapshot);
+	// Reads the open directories below `node` that were read from disk again
+	void syncDiskDirectories(FileNode &node,
+							 const std::shared_ptr<const WorkspaceSnapshot> &snapshot);
+	void appendVisibleRows(FileNode &node, int depth);
 
 	struct TreeDisplayMetrics
 	{
@@ -53,7 +94,6 @@ class FileTree
 		float fileIconSize;
 		float itemHeight;
 		float indentWidth;
-		ImVec2 cursorPos;
 	};
 
 	struct TreeStyleSettings
@@ -72,15 +112,10 @@ class FileTree
 	// Display helper methods
 	TreeDisplayMetrics calculateDisplayMetrics();
 	void pushTreeStyles();
-	void displayDirectoryNode(const FileNode &node,
-							  const TreeDisplayMetrics &metrics,
-							  int &depth);
-	void
-	displayFileNode(const FileNode &node, const TreeDisplayMetrics &metrics, int depth);
-	ImTextureID getFolderIcon(bool isOpen);
-	void renderNodeText(const std::string &name,
-						const std::string &fullPath,
-						bool isCurrentFile);
+	// Returns true when the row was clicked
+	bool displayRow(FileNode &node, const TreeDisplayMetrics &metrics, int depth);
+	IconRef getFolderIcon(bool isOpen);
+	ImVec4 nodeTextColor(FileNode &node, bool isCurrentFile);
 
 	bool hasAutoOpenedReadme = false;
 	bool shouldCheckForReadme = true;
@@ -95,6 +130,7 @@ class FileTree
 	// Cached git status results
 	std::set<std::string> cachedModifiedFiles;
 	std::mutex modifiedFilesMutex;
+	std::atomic<uint64_t> gitStatusVersion{1}; // Bumped when the results change
 };
 
 extern FileTree gFileTree;
\ No newline at end of file
@@ -0,0 +1,435 @@
+/*
+	File: file_undo_redo.cpp
+	Description: Packing old undo steps into compressed blocks and writing
+   and replaying the undo journal. See file_undo_redo.h.
+*/
+
+#include "file_undo_redo.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+void writeVarint(std::string &out, uint32_t value)
+{
+	while (value >= 0x80)
+	{
+		out.push_back(static_cast<char>(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<char>(value));
+}
+
+bool readVarint(std::string_view &in, uint32_t &value)
+{
+	value = 0;
+	for (int shift = 0; shift < 35 && !in.empty(); shift += 7)
+	{
+		uint8_t byte = static_cast<uint8_t>(in.front());
+		in.remove_prefix(1);
+		value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void writeString(std::string &out, const std::string &text)
+{
+	writeVarint(out, static_cast<uint32_t>(text.size()));
+	out.append(text);
+}
+
+bool readString(std::string_view &in, std::string &text)
+{
+	uint32_t size;
+	if (!readVarint(in, size) || size > in.size())
+	{
+		return false;
+	}
+	text.assign(in.substr(0, size));
+	in.remove_prefix(size);
+	return true;
+}
+
+// Byte-oriented LZ77: varint literal count, the literals, then, unless the
+// input ends there, a varint match length (minus MIN_MATCH) and distance.
+// Undo text repeats itself a lot (identifiers, indentation, the same line
+// typed and deleted), so even this simple scheme packs it several times over.
+constexpr size_t MIN_MATCH = 4;
+constexpr size_t MAX_DISTANCE = 1 << 16;
+constexpr int HASH_BITS = 14;
+
+uint32_t read32(const char *p)
+{
+	uint32_t value;
+	std::memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+std::string compress(std::string_view in)
+{
+	std::string out;
+	out.reserve(in.size() / 2);
+	std::vector<int32_t> table(size_t(1) << HASH_BITS, -1);
+
+	size_t anchor = 0;
+	size_t i = 0;
+	while (i + MIN_MATCH <= in.size())
+	{
+		uint32_t word = read32(in.data() + i);
+		uint32_t hash = (word * 2654435761u) >> (32 - HASH_BITS);
+		int32_t candidate = table[hash];
+		table[hash] = static_cast<int32_t>(i);
+		if (candidate < 0 || i - candidate > MAX_DISTANCE ||
+			read32(in.data() + candidate) != word)
+		{
+			i++;
+			continue;
+		}
+
+		size_t length = MIN_MATCH;
+		while (i + length < in.size() && in[candidate + length] == in[i + length])
+		{
+			length++;
+		}
+		writeVarint(out, static_cast<uint32_t>(i - anchor));
+		out.append(in.substr(anchor, i - anchor));
+		writeVarint(out, static_cast<uint32_t>(length - MIN_MATCH));
+		writeVarint(out, static_cast<uint32_t>(i - candidate));
+		i += length;
+		anchor = i;
+	}
+	writeVarint(out, static_cast<uint32_t>(in.size() - anchor));
+	out.append(in.substr(anchor));
+	return out;
+}
+
+bool decompress(std::string_view in, std::string &out)
+{
+	out.clear();
+	while (true)
+	{
+		uint32_t literals;
+		if (!readVarint(in, literals) || literals > in.size())
+		{
+			return false;
+		}
+		out.append(in.substr(0, literals));
+		in.remove_prefix(literals);
+		if (in.empty())
+		{
+			return true;
+		}
+
+		uint32_t length;
+		uint32_t distance;
+		if (!readVarint(in, length) || !readVarint(in, distance) || distance == 0 ||
+			distance > out.size())
+		{
+			return false;
+		}
+		// Byte by byte: a match may overlap the text it produces
+		size_t from = out.size() - distance;
+		for (size_t k = 0; k < length + MIN_MATCH; k++)
+		{
+			out.push_back(out[from + k]);
+		}
+	}
+}
+
+using Operation = UndoRedoManager::Operation;
+using Edit = UndoRedoManager::Edit;
+
+void writeOperation(std::string &out, const Operation &op)
+{
+	writeVarint(out, static_cast<uint32_t>(op.cursor_before));
+	writeVarint(out, static_cast<uint32_t>(op.cursor_after));
+	for (const std::vector<int> *cursors : {&op.cursors_before, &op.cursors_after})
+	{
+		writeVarint(out, static_cast<uint32_t>(cursors->size()));
+		for (int cursor : *cursors)
+		{
+			writeVarint(out, static_cast<uint32_t>(cursor));
+		}
+	}
+	writeVarint(out, static_cast<uint32_t>(op.edits.size()));
+	for (const Edit &edit : op.edits)
+	{
+		writeVarint(out, static_cast<uint32_t>(edit.position));
+		writeString(out, edit.removed);
+		writeString(out, edit.inserted);
+	}
+}
+
+bool readOperation(std::string_view &in, Operation &op)
+{
+	uint32_t before, after, count;
+	if (!readVarint(in, before) || !readVarint(in, after))
+	{
+		return false;
+	}
+	op.cursor_before = static_cast<int>(before);
+	op.cursor_after = static_cast<int>(after);
+	for (std::vector<int> *cursors : {&op.cursors_before, &op.cursors_after})
+	{
+		cursors->clear();
+		if (!readVarint(in, count) || count > in.size())
+		{
+			return false;
+		}
+		for (uint32_t i = 0; i < count; i++)
+		{
+			uint32_t cursor;
+			if (!readVarint(in, cursor))
+			{
+				return false;
+			}
+			cursors->push_back(static_cast<int>(cursor));
+		}
+	}
+	if (!readVarint(in, count))
+	{
+		return false;
+	}
+	op.edits.clear();
+	for (uint32_t i = 0; i < count; i++)
+	{
+		Edit edit;
+		uint32_t position;
+		if (!readVarint(in, position) || !readString(in, edit.removed) ||
+			!readString(in, edit.inserted))
+		{
+			return false;
+		}
+		edit.position = static_cast<int>(position);
+		op.edits.push_back(std::move(edit));
+	}
+	return true;
+}
+
+bool readBlock(const std::string &data, std::vector<Operation> &ops)
+{
+	std::string packed;
+	if (!decompress(data, packed))
+	{
+		return false;
+	}
+	std::string_view in(packed);
+	while (!in.empty())
+	{
+		Operation op;
+		if (!readOperation(in, op))
+		{
+			return false;
+		}
+		ops.push_back(std::move(op));
+	}
+	return true;
+}
+
+void writeHash(std::string &out, uint64_t hash)
+{
+	for (int i = 0; i < 8; i++)
+	{
+		out.push_back(static_cast<char>(hash >> (i * 8)));
+	}
+}
+
+} // namespace
+
+void UndoRedoManager::freeze()
+{
+	std::string packed;
+	for (size_t i = 0; i < COLD_BATCH; i++)
+	{
+		writeOperation(packed, undoStack.front());
+		hotBytes -= operationBytes(undoStack.front());
+		undoStack.pop_front();
+	}
+
+	ColdBlock block{compress(packed), COLD_BATCH};
+	block.data.shrink_to_fit();
+	coldBytes += block.data.size();
+	coldStack.push_back(std::move(block));
+}
+
+bool UndoRedoManager::thaw()
+{
+	while (!coldStack.empty())
+	{
+		ColdBlock block = std::move(coldStack.back());
+		coldStack.pop_back();
+		coldBytes -= block.data.size();
+
+		std::vector<Operation> ops;
+		if (!readBlock(block.data, ops))
+		{
+			// Older blocks can't be undone past this one either
+			std::cerr << "Corrupt undo block, dropping older history" << std::endl;
+			coldStack.clear();
+			coldBytes = 0;
+			return false;
+		}
+
+		for (auto it = ops.rbegin(); it != ops.rend(); ++it)
+		{
+			hotBytes += operationBytes(*it);
+			undoStack.push_front(std::move(*it));
+		}
+		if (!undoStack.empty())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void UndoRedoManager::flushBack()
+{
+	if (backChanged && !undoStack.empty())
+	{
+		journalTail.push_back(backJournaled ? RECORD_AMEND : RECORD_STEP);
+		writeOperation(journalTail, undoStack.back());
+		backJournaled = true;
+	}
+	backChanged = false;
+}
+
+std::string UndoRedoManager::takeJournal(uint64_t contentHash)
+{
+	flushBack();
+	journalTail.push_back(RECORD_SYNC);
+	writeHash(journalTail, contentHash);
+	std::string records = std::move(journalTail);
+	journalTail.clear();
+	return records;
+}
+
+std::string UndoRedoManager::snapshotJournal(uint64_t contentHash) const
+{
+	std::string out;
+	auto writeStep = [&out](const Operation &op) {
+		out.push_back(RECORD_STEP);
+		writeOperation(out, op);
+	};
+
+	for (const ColdBlock &block : coldStack)
+	{
+		std::vector<Operation> ops;
+		if (readBlock(block.data, ops))
+		{
+			for (const Operation &op : ops)
+			{
+				writeStep(op);
+			}
+		}
+	}
+	for (const Operation &op : undoStack)
+	{
+		writeStep(op);
+	}
+	// Redo steps go back on as steps and are undone again, the last undone
+	// one last
+	for (auto it = redoStack.rbegin(); it != redoStack.rend(); ++it)
+	{
+		writeStep(*it);
+	}
+	out.append(redoStack.size(), RECORD_UNDO);
+
+	out.push_back(RECORD_SYNC);
+	writeHash(out, contentHash);
+	return out;
+}
+
+bool UndoRedoManager::replayJournal(std::string_view records, uint64_t &contentHash)
+{
+	// First find where the last complete batch ends, as a crash can leave
+	// a torn one behind it
+	size_t end = 0;
+	std::string_view in = records;
+	while (!in.empty())
+	{
+		char type = in.front();
+		in.remove_prefix(1);
+		Operation op;
+		if (type == RECORD_STEP || type == RECORD_AMEND)
+		{
+			if (!readOperation(in, op))
+			{
+				break;
+			}
+		} else if (type == RECORD_SYNC)
+		{
+			if (in.size() < 8)
+			{
+				break;
+			}
+			contentHash = 0;
+			for (int i = 0; i < 8; i++)
+			{
+				contentHash |= uint64_t(static_cast<uint8_t>(in[i])) << (i * 8);
+			}
+			in.remove_prefix(8);
+			end = records.size() - in.size();
+		} else if (type != RECORD_UNDO && type != RECORD_REDO && type != RECORD_CLEAR)
+		{
+			break;
+		}
+	}
+	if (end == 0)
+	{
+		return false;
+	}
+
+	clear();
+	in = records.substr(0, end);
+	while (!in.empty())
+	{
+		char type = in.front();
+		in.remove_prefix(1);
+		Operation op;
+		if (type == RECORD_STEP)
+		{
+			readOperation(in, op);
+			hotBytes += operationBytes(op);
+			for (const Operation &undone : redoStack)
+			{
+				hotBytes -= operationBytes(undone);
+			}
+			redoStack.clear();
+			undoStack.push_back(std::move(op));
+			enforceBudget();
+		} else if (type == RECORD_AMEND)
+		{
+			readOperation(in, op);
+			if (!undoStack.empty())
+			{
+				hotBytes -= operationBytes(undoStack.back());
+				hotBytes += operationBytes(op);
+				undoStack.back() = std::move(op);
+			}
+		} else if (type == RECORD_UNDO)
+		{
+			undo();
+		} else if (type == RECORD_REDO)
+		{
+			redo();
+		} else if (type == RECORD_CLEAR)
+		{
+			clear();
+		} else
+		{
+			in.remove_prefix(8); // The hash, read above
+		}
+	}
+
+	// Replaying journaled nothing new
+	journalTail.clear();
+	backJournaled = !undoStack.empty();
+	backChanged = false;
+	return true;
+}
@@ -1,299 +1,330 @@
+/*
+	File: file_undo_redo.h
+	Description: Per file undo and redo history, bounded by bytes, with a
+   journal of its changes for persisting it to disk.
+*/
+
 #pragma once
-#include "../lib/json.hpp"
 #include <algorithm>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
 
-using json = nlohmann::json;
-
+// Undo journal of one file. The editor's edit primitives record each change
+// as it is made, so an edit costs as much as the text it touches, never a copy
+// of the file. History is bounded by bytes, not steps: the newest steps stay
+// as they are and older ones are packed into compressed blocks, which are
+// dropped oldest first once the whole history outgrows its budget.
+//
+// Every change to the history is also noted as a journal record, which the
+// caller collects with takeJournal() and appends to disk, so persisting the
+// history costs as much as what changed since the last time.
 class UndoRedoManager
 {
   public:
+	// One contiguous change: `removed` replaced by `inserted` at `position`
+	struct Edit
+	{
+		int position;
+		std::string removed;
+		std::string inserted;
+	};
+
+	// One undo step: its edits in the order they were made, each against the
+	// text the previous one left
 	struct Operation
 	{
-		int position;		  // Where the change occurred
-		std::string removed;  // Text that was removed
-		std::string inserted; // Text that was inserted
-		int cursor_before;	  // Cursor position before the change
-		int cursor_after;	  // Cursor position after the change
-
-		// Helper to apply this operation to a string
-		std::string apply(const std::string &current) const
+		std::vector<Edit> edits;
+		int cursor_before = 0; // Cursor position before the change
+		int cursor_after = 0;  // Cursor position after the change
+		// The extra cursors of a multi-cursor edit, before and after it
+		std::vector<int> cursors_before;
+		std::vector<int> cursors_after;
+	};
+
+	// Records an edit about to be made to the buffer, with the cursor and the
+	// extra cursors as they are before it. Edits join the open step while
+	// they come within COALESCE_MS of each other and the cursors stay where
+	// the last command left them, so a typing burst is one step and moving a
+	// cursor starts a new one. All edits of one command, such as a
+	// multi-cursor keystroke, share a step.
+	void recordEdit(int position,
+					std::string_view removed,
+					std::string_view inserted,
+					int cursor,
+					const std::vector<int> &cursors)
+	{
+		if (removed.empty() && inserted.empty())
 		{
-			std::string result = current;
-			if (position >= 0 && position <= static_cast<int>(result.length()))
-			{
-				result.replace(position, inserted.length(), removed);
-			}
-			return result;
+			return;
+		}
+		for (const Operation &op : redoStack)
+		{
+			hotBytes -= operationBytes(op);
 		}
+		redoStack.clear(); // Clear redo stack on new changes
 
-		// Helper to apply inverse (redo) operation
-		std::string applyInverse(const std::string &current) const
+		auto now = std::chrono::steady_clock::now();
+		bool coalesce = stepOpen && !undoStack.empty() &&
+						now - lastEditTime < std::chrono::milliseconds(COALESCE_MS) &&
+						(inCommand || (undoStack.back().cursor_after == cursor &&
+									   undoStack.back().cursors_after == cursors));
+		if (!coalesce)
 		{
-			std::string result = current;
-			if (position >= 0 && position <= static_cast<int>(result.length()))
-			{
-				result.replace(position, removed.length(), inserted);
-			}
-			return result;
+			flushBack();
+			undoStack.push_back({{}, cursor, cursor, cursors, cursors});
+			backJournaled = false;
+			hotBytes += operationBytes(undoStack.back());
+			stepOpen = true;
 		}
-	};
+		lastEditTime = now;
+		inCommand = true;
+		backChanged = true;
 
-	json toJson() const
-	{
-		json j;
-		j["maxStackSize"] = maxStackSize;
-		j["lastCommittedState"] = lastCommittedState;
-		j["undoStack"] = json::array();
-		j["redoStack"] = json::array();
-
-		// Only serialize recent operations to reduce memory usage
-		size_t undoCount = std::min(undoStack.size(), static_cast<size_t>(50));
-		for (size_t i = undoStack.size() - undoCount; i < undoStack.size(); ++i)
+		std::vector<Edit> &edits = undoStack.back().edits;
+		size_t lastBytes = edits.empty() ? 0 : editBytes(edits.back());
+		if (edits.empty() || !extend(edits.back(), position, removed, inserted))
+		{
+			edits.push_back({position, std::string(removed), std::string(inserted)});
+			hotBytes += editBytes(edits.back());
+		} else if (edits.back().removed.empty() && edits.back().inserted.empty())
+		{
+			edits.pop_back(); // Typed and deleted again
+			hotBytes -= lastBytes;
+		} else
 		{
-			j["undoStack"].push_back({{"position", undoStack[i].position},
-									  {"removed", undoStack[i].removed},
-									  {"inserted", undoStack[i].inserted},
-									  {"cursor_before", undoStack[i].cursor_before},
-									  {"cursor_after", undoStack[i].cursor_after}});
+			hotBytes = hotBytes - lastBytes + editBytes(edits.back());
 		}
 
-		size_t redoCount = std::min(redoStack.size(), static_cast<size_t>(20));
-		for (size_t i = redoStack.size() - redoCount; i < redoStack.size(); ++i)
+		if (!coalesce)
 		{
-			j["redoStack"].push_back({{"position", redoStack[i].position},
-									  {"removed", redoStack[i].removed},
-									  {"inserted", redoStack[i].inserted},
-									  {"cursor_before", redoStack[i].cursor_before},
-									  {"cursor_after", redoStack[i].cursor_after}});
+			enforceBudget();
 		}
-		return j;
 	}
 
-	void fromJson(const json &j)
+	// Largest size the history may take, compressed part included
+	void setBudget(size_t bytes)
 	{
-		try
-		{
-			maxStackSize = j.value("maxStackSize", 50); // Reduced default
-			lastCommittedState = j.value("lastCommittedState", "");
-			undoStack.clear();
-			redoStack.clear();
-
-			if (j.contains("undoStack") && j["undoStack"].is_array())
-			{
-				for (const auto &item : j["undoStack"])
-				{
-					if (item.is_object() && item.contains("position") &&
-						item["position"].is_number() && item.contains("removed") &&
-						item["removed"].is_string() && item.contains("inserted") &&
-						item["inserted"].is_string() && item.contains("cursor_before") &&
-						item["cursor_before"].is_number() &&
-						item.contains("cursor_after") && item["cursor_after"].is_number())
-					{
-
-						undoStack.push_back({item["position"].get<int>(),
-											 item["removed"].get<std::string>(),
-											 item["inserted"].get<std::string>(),
-											 item["cursor_before"].get<int>(),
-											 item["cursor_after"].get<int>()});
-					}
-				}
-			}
-
-			if (j.contains("redoStack") && j["redoStack"].is_array())
-			{
-				for (const auto &item : j["redoStack"])
-				{
-					if (item.is_object() && item.contains("position") &&
-						item["position"].is_number() && item.contains("removed") &&
-						item["removed"].is_string() && item.contains("inserted") &&
-						item["inserted"].is_string() && item.contains("cursor_before") &&
-						item["cursor_before"].is_number() &&
-						item.contains("cursor_after") && item["cursor_after"].is_number())
-					{
-
-						redoStack.push_back({item["position"].get<int>(),
-											 item["removed"].get<std::string>(),
-											 item["inserted"].get<std::string>(),
-											 item["cursor_before"].get<int>(),
-											 item["cursor_after"].get<int>()});
-					}
-				}
-			}
-		} catch (const std::exception &e)
-		{
-			// If there's any error loading the JSON, just reset to empty state
-			std::cerr << "Error loading undo/redo state: " << e.what() << std::endl;
-			undoStack.clear();
-			redoStack.clear();
-			lastCommittedState = "";
-			maxStackSize = 50;
-		}
+		budgetBytes = std::max(bytes, MIN_BUDGET_BYTES);
+		enforceBudget();
 	}
 
-	// Simplified API: Only current content and cursor index
-	void addState(const std::string &currentContent, int cursor_after)
+	// Ends an editing command, noting the cursors it left behind
+	void noteCursor(int cursor, const std::vector<int> &cursors)
 	{
-		std::cout << "Adding state: " << cursor_after << std::endl;
-		if (!hasPending)
+		if (stepOpen && !undoStack.empty())
 		{
-			// First change in a series
-			pendingInitialContent = lastCommittedState;
-			pendingInitialCursor = pendingFinalCursor;
-			hasPending = true;
-			redoStack.clear(); // Clear redo stack on new changes
+			Operation &op = undoStack.back();
+			hotBytes -= op.cursors_after.size() * sizeof(int);
+			op.cursor_after = cursor;
+			op.cursors_after = cursors;
+			hotBytes += op.cursors_after.size() * sizeof(int);
 		}
-
-		pendingFinalContent = currentContent;
-		pendingFinalCursor = cursor_after;
-		lastAddTime = std::chrono::steady_clock::now();
+		inCommand = false;
 	}
 
-	void update()
+	// Ends the open step, so the next edit starts a new one
+	void closeStep()
 	{
-		if (!hasPending)
-			return;
-
-		auto now = std::chrono::steady_clock::now();
-		auto elapsed =
-			std::chrono::duration_cast<std::chrono::milliseconds>(now - lastAddTime)
-				.count();
-
-		if (elapsed >= 300)
-		{ // Reduced debounce time for better responsiveness
-			computeAndSaveOperation();
-			hasPending = false;
-		}
+		stepOpen = false;
+		inCommand = false;
 	}
 
 	std::pair<Operation, bool> undo()
 	{
-		commitPending();
-		if (undoStack.empty())
+		closeStep();
+		flushBack();
+		if (undoStack.empty() && !thaw())
 		{
 			return {{}, false};
 		}
 
-		Operation op = undoStack.back();
+		Operation op = std::move(undoStack.back());
 		undoStack.pop_back();
-
-		// Update last committed state by applying inverse operation
-		lastCommittedState = op.apply(lastCommittedState);
 		redoStack.push_back(op);
+		journalTail.push_back(RECORD_UNDO);
 
 		return {op, true};
 	}
 
 	std::pair<Operation, bool> redo()
 	{
-		commitPending();
+		closeStep();
+		flushBack();
 		if (redoStack.empty())
 		{
 			return {{}, false};
 		}
 
-		Operation op = redoStack.back();
+		Operation op = std::move(redoStack.back());
 		redoStack.pop_back();
-
-		// Update last committed state by applying operation
-		lastCommittedState = op.applyInverse(lastCommittedState);
 		undoStack.push_back(op);
+		journalTail.push_back(RECORD_REDO);
 
 		return {op, true};
 	}
 
-	void initialize(const std::string &content, int cursor)
+	// Drops the whole history, e.g. once it no longer matches the buffer
+	void clear()
 	{
-		lastCommittedState = content;
-		pendingFinalCursor = cursor;
+		undoStack.clear();
+		redoStack.clear();
+		coldStack.clear();
+		hotBytes = 0;
+		coldBytes = 0;
+		stepOpen = false;
+		inCommand = false;
+		backJournaled = backChanged = false;
+		journalTail.push_back(RECORD_CLEAR);
 	}
 
+	// Whether takeJournal() has anything new
+	bool hasJournal() const { return !journalTail.empty() || backChanged; }
+
+	// Journal records of the changes since the last call, closed by a record
+	// of `contentHash`: the hash of the text the history now leads to
+	std::string takeJournal(uint64_t contentHash);
+
+	// The whole history as journal records, to start a journal afresh
+	std::string snapshotJournal(uint64_t contentHash) const;
+
+	// Rebuilds the history from journal records, up to the last complete
+	// batch. False when there is none; `contentHash` is the hash it closes
+	// with, to check against the text before trusting the history.
+	bool replayJournal(std::string_view records, uint64_t &contentHash);
+
 	void printStacks() const
 	{
-		std::cout << "Undo stack: " << undoStack.size()
+		size_t coldCount = 0;
+		for (const ColdBlock &block : coldStack)
+		{
+			coldCount += block.count;
+		}
+		std::cout << "Undo stack: " << undoStack.size() << " (+" << coldCount
+				  << " compressed, " << coldBytes << " bytes)"
 				  << " Redo stack: " << redoStack.size() << std::endl;
 	}
 
 	// Check if there are any operations to save
-	bool hasOperations() const { return !undoStack.empty() || !redoStack.empty(); }
+	bool hasOperations() const
+	{
+		return !undoStack.empty() || !redoStack.empty() || !coldStack.empty();
+	}
+
+  private:
+	// Longest pause between two edits of one step
+	static constexpr int COALESCE_MS = 500;
+	static constexpr size_t DEFAULT_BUDGET_BYTES = 8 << 20;
+	static constexpr size_t MIN_BUDGET_BYTES = 64 << 10;
+	// Steps packed into one compressed block
+	static constexpr size_t COLD_BATCH = 64;
+
+	// Journal record types, each followed by its payload
+	static constexpr char RECORD_STEP = 'S';  // Operation: pushed as a new step
+	static constexpr char RECORD_AMEND = 'A'; // Operation: replaces the last step
+	static constexpr char RECORD_UNDO = 'U';
+	static constexpr char RECORD_REDO = 'R';
+	static constexpr char RECORD_CLEAR = 'C';
+	static constexpr char RECORD_SYNC = 'H'; // 8 byte content hash, ends a batch
+
+	// Steps packed by freeze(), oldest first
+	struct ColdBlock
+	{
+		std::string data;
+		size_t count;
+	};
+
+	std::deque<Operation> undoStack; // Newest at the back
+	std::deque<Operation> redoStack;
+	std::deque<ColdBlock> coldStack; // Older than all of undoStack
+	size_t hotBytes = 0;			 // Held by undoStack and redoStack
+	size_t coldBytes = 0;
+	size_t budgetBytes = DEFAULT_BUDGET_BYTES;
 
-	// Force commit pending state immediately (useful for paste operations)
-	void forceCommitPending() { commitPending(); }
+	// Whether undoStack.back() still takes edits
+	bool stepOpen = false;
+	// Whether edits were recorded since the last noteCursor
+	bool inCommand = false;
 
-	void updatePendingFinalCursor(int cursor)
+	std::string journalTail;	// Records not taken yet
+	bool backJournaled = false;	// undoStack.back() has a step record
+	bool backChanged = false;	// undoStack.back() changed since its last record
+	std::chrono::steady_clock::time_point lastEditTime;
+
+	static size_t editBytes(const Edit &edit)
 	{
-		if (!hasPending)
-		{
-			pendingFinalCursor = cursor;
-		}
+		return sizeof(Edit) + edit.removed.size() + edit.inserted.size();
 	}
 
-  private:
-	std::vector<Operation> undoStack;
-	std::vector<Operation> redoStack;
-	size_t maxStackSize = 50;		// Reduced from 100 to 50
-	std::string lastCommittedState; // Last known state after commit
-
-	// Debounce members
-	std::string pendingInitialContent;
-	std::string pendingFinalContent;
-	int pendingInitialCursor = 0;
-	int pendingFinalCursor = 0;
-	bool hasPending = false;
-	std::chrono::steady_clock::time_point lastAddTime;
-
-	void commitPending()
+	static size_t operationBytes(const Operation &op)
 	{
-		if (hasPending)
+		size_t bytes = sizeof(Operation) +
+					   (op.cursors_before.size() + op.cursors_after.size()) * sizeof(int);
+		for (const Edit &edit : op.edits)
 		{
-			computeAndSaveOperation();
-			hasPending = false;
+			bytes += editBytes(edit);
 		}
+		return bytes;
 	}
 
-	// Optimized diff computation
-	void computeAndSaveOperation()
+	// Keeps the newest quarter of the budget uncompressed and drops whole
+	// compressed blocks once everything together is over it
+	void enforceBudget()
 	{
-		// Compute diff between initial and final states
-		const std::string &oldStr = pendingInitialContent;
-		const std::string &newStr = pendingFinalContent;
-
-		// Find first difference
-		size_t start = 0;
-		size_t minLen = std::min(oldStr.length(), newStr.length());
-
-		while (start < minLen && oldStr[start] == newStr[start])
+		// The open step still grows, so it is never packed
+		while (hotBytes > budgetBytes / 4 && undoStack.size() > COLD_BATCH)
 		{
-			start++;
+			freeze();
 		}
-
-		// Find last difference
-		size_t oldEnd = oldStr.length();
-		size_t newEnd = newStr.length();
-
-		while (oldEnd > start && newEnd > start &&
-			   oldStr[oldEnd - 1] == newStr[newEnd - 1])
+		while (hotBytes + coldBytes > budgetBytes && !coldStack.empty())
 		{
-			oldEnd--;
-			newEnd--;
+			coldBytes -= coldStack.front().data.size();
+			coldStack.pop_front();
 		}
+		while (hotBytes > budgetBytes && undoStack.size() > 1)
+		{
+			hotBytes -= operationBytes(undoStack.front());
+			undoStack.pop_front();
+		}
+	}
 
-		// Create operation
-		Operation op{static_cast<int>(start),
-					 oldStr.substr(start, oldEnd - start),
-					 newStr.substr(start, newEnd - start),
-					 pendingInitialCursor,
-					 pendingFinalCursor};
-
-		// Save operation and update state
-		undoStack.push_back(op);
-		if (undoStack.size() > maxStackSize)
+	// Packs the oldest COLD_BATCH steps of undoStack into a compressed block
+	void freeze();
+	// Unpacks the newest compressed block back into undoStack
+	bool thaw();
+	// Journals the last step if it changed since it was last journaled
+	void flushBack();
+
+	// Folds an edit into the one before it when it continues it: typing on at
+	// its end, or deleting backwards or forwards from there
+	static bool
+	extend(Edit &last, int position, std::string_view removed, std::string_view inserted)
+	{
+		const int lastEnd = last.position + static_cast<int>(last.inserted.size());
+		if (position == lastEnd)
+		{
+			last.removed.append(removed);
+			last.inserted.append(inserted);
+			return true;
+		}
+		if (inserted.empty() && position + static_cast<int>(removed.size()) == lastEnd)
 		{
-			undoStack.erase(undoStack.begin());
+			if (position >= last.position)
+			{
+				last.inserted.erase(position - last.position);
+			} else
+			{
+				last.removed.insert(0, removed.substr(0, last.position - position));
+				last.inserted.clear();
+				last.position = position;
+			}
+			return true;
 		}
-		lastCommittedState = pendingFinalContent;
+		return false;
 	}
-};
\ No newline at end of file
+};
@@ -6,8 +6,10 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
+#include <iterator>
 #include <nfd.h>
 #include <sstream>
 #include <thread>
@@ -24,170 +26,61 @@
 #include <fstream>
 using json = nlohmann::json;
 
-#define NANOSVG_IMPLEMENTATION
-#include "lib/nanosvg.h"
-#define NANOSVGRAST_IMPLEMENTATION
-#include "lib/nanosvgrast.h"
-
 #include "../ai/ai_agent.h"
 #include "../editor/editor_git.h"
 #include "../lsp/lsp_client.h"
 #include "file_tree.h"
+#include "recovery_journal.h"
+#include "symbol_index.h"
+#include "trigram_index.h"
+#include "workspace_index.h"
 extern AIAgent gAIAgent;
 
-const std::string UNDO_FILE = ".undo-redo-ned.json";
-
-extern FileExplorer gFileExplorer;
+// Journals larger than this are rewritten from the live history on load
+const size_t UNDO_JOURNAL_COMPACT_BYTES = 1 << 20;
 
-void FileExplorer::loadIcons()
+// FNV-1a; names journals by path and checks them against file contents
+static uint64_t undoContentHash(std::string_view text)
 {
-	for (const auto &iconFile : IconDefinitions::DEFAULT_ICONS)
+	uint64_t hash = 14695981039346656037ull;
+	for (unsigned char c : text)
 	{
-		loadSingleIcon(iconFile);
-	}
-
-	if (fileTypeIcons.empty())
-	{
-		createDefaultIcon();
+		hash = (hash ^ c) * 1099511628211ull;
 	}
+	return hash;
 }
 
-GLuint FileExplorer::createTexture(const unsigned char *pixels, int width, int height)
+// Journal layout: this header, then the records of UndoRedoManager::takeJournal
+static std::string undoJournalHeader(const std::string &path)
 {
-	GLuint texture;
-	glGenTextures(1, &texture);
-	glBindTexture(GL_TEXTURE_2D, texture);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexImage2D(
-		GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
-	return texture;
+	std::string header = "NEDU2";
+	header += path;
+	header.push_back('\0');
+	return header;
 }
 
-bool FileExplorer::loadSingleIcon(
-	const std::string &iconFile) // iconFile is like "file.svg" or "folder.png"
-{
-	std::string primaryPath = "icons/" + iconFile;
-	std::string finalPathToLoad;
+extern FileExplorer gFileExplorer;
 
-	if (std::filesystem::exists(primaryPath))
-	{
-		finalPathToLoad = primaryPath;
-		// std::cout << "[IconLoader] Found icon at primary path: " <<
-		// finalPathToLoad << std::endl;
-	} else
+void FileExplorer::loadIcons()
+{
+	if (!_iconsPrepared)
 	{
-#ifndef __APPLE__ // Only try the Debian package path if NOT on macOS
-		std::string debian_package_icon_base_path = "/usr/share/Ned/icons/";
-		std::string packagedPath = debian_package_icon_base_path + iconFile;
-
-		if (std::filesystem::exists(packagedPath))
-		{
-			finalPathToLoad = packagedPath;
-			// std::cout << "[IconLoader] Found icon at Debian package path: "
-			//           << finalPathToLoad << std::endl;
-		} else
+		// Icons are rasterized when first drawn, at the display's pixel density
+		float scale = 1.0f;
+		if (GLFWwindow *window = glfwGetCurrentContext())
 		{
-			// std::cerr << "[IconLoader] Icon not found. Tried:\n"
-			//           << "  1. Relative/Dev path: " << primaryPath << "\n"
-			//           << "  2. Debian package path: " << packagedPath <<
-			//           std::endl;
-			return false; // Icon not found at either location on Linux
+			float yScale = 1.0f;
+			glfwGetWindowContentScale(window, &scale, &yScale);
 		}
-#else
-		// On macOS, if not found at primaryPath, it's just not found for this
-		// simple logic. std::cerr << "[IconLoader] Icon not found at primary
-		// path (macOS): " << primaryPath << std::endl;
-		return false; // Icon not found at primary path on macOS
-#endif
+		prepareIcons(scale);
 	}
-
-	// If finalPathToLoad is empty here, it means it wasn't found (should be
-	// caught by returns above)
-	if (finalPathToLoad.empty())
-	{
-		// This case should ideally not be reached if the logic above is
-		// correct. std::cerr << "[IconLoader] Critical error: finalPathToLoad
-		// is empty for icon: " << iconFile << std::endl;
-		return false;
-	}
-
-	// Load SVG (or other image type if you adapt this part)
-	// Assuming nsvgParseFromFile, IconDimensions, nsvgCreateRasterizer, etc.
-	// are available.
-	NSVGimage *image =
-		nsvgParseFromFile(finalPathToLoad.c_str(), "px", IconDimensions::SVG_DPI);
-	if (!image)
-	{
-		std::cerr << "Error loading SVG file: " << finalPathToLoad << std::endl;
-		return false;
-	}
-
-	// Create rasterizer
-	NSVGrasterizer *rast = nsvgCreateRasterizer();
-	if (!rast)
-	{
-		std::cerr << "Error creating SVG rasterizer" << std::endl;
-		nsvgDelete(image);
-		return false;
-	}
-
-	// Allocate pixel buffer
-	// Ensure IconDimensions::WIDTH and IconDimensions::HEIGHT are correctly defined.
-	auto pixels = std::make_unique<unsigned char[]>(IconDimensions::WIDTH *
-													IconDimensions::HEIGHT * 4);
-
-	// Rasterize SVG
-	nsvgRasterize(rast,
-				  image,
-				  0,
-				  0,
-				  IconDimensions::WIDTH / image->width, // Or some other scaling factor
-				  pixels.get(),
-				  IconDimensions::WIDTH,
-				  IconDimensions::HEIGHT,
-				  IconDimensions::WIDTH * 4); // Stride
-
-	// Create OpenGL texture
-	// Ensure createTexture is correctly defined and returns a GLuint.
-	GLuint texture =
-		createTexture(pixels.get(), IconDimensions::WIDTH, IconDimensions::HEIGHT);
-	if (texture == 0)
-	{ // Assuming 0 indicates failure in createTexture
-		std::cerr << "Error creating OpenGL texture for icon: " << finalPathToLoad
-				  << std::endl;
-		nsvgDeleteRasterizer(rast);
-		nsvgDelete(image);
-		return false;
-	}
-
-	// Store in icon map
-	std::string iconName =
-		iconFile.substr(0, iconFile.find('.')); // Gets "file" from "file.svg"
-	fileTypeIcons[iconName] = static_cast<ImTextureID>(texture);
-
-	// Cleanup
-	nsvgDeleteRasterizer(rast);
-	nsvgDelete(image);
-
-	return true;
+	_iconAtlas.upload();
 }
 
-void FileExplorer::createDefaultIcon()
+void FileExplorer::prepareIcons(float scale)
 {
-	unsigned char defaultIcon[] = {
-		255,
-		255,
-		255,
-		255, // White pixel
-		0,
-		0,
-		0,
-		255 // Black pixel
-	};
-
-	GLuint texture = createTexture(defaultIcon, 2, 1);
-	fileTypeIcons["default"] = static_cast<ImTextureID>(texture);
+	_iconAtlas.prepare(IconDefinitions::DEFAULT_ICONS, scale);
+	_iconsPrepared = true;
 }
 
 void FileExplorer::openFolderDialog()
@@ -203,7 +96,6 @@ void FileExplorer::openFolderDialog()
 		free(outPath);
 		_showFileDialog = false;
 		showWelcomeScreen = false;
-		loadUndoRedoState();
 
 		// Load AI agent conversation history
 		gAIAgent.getHistoryManager().loadConversationHistory();
@@ -215,7 +107,17 @@ void FileExplorer::openFolderDialog()
 		gFileTree.stopGitStatusTracking();
 		gFileTree.startGitStatusTracking();
 
-		// Scan project files for external change monitoring
+		// Walk and watch the folder once for the finder, tree and monitor
+		gWorkspaceIndex.open(selectedFolder);
+		if (gSettings.getSnapshot()->symbolIndex)
+		{
+			gSymbolIndex.open(selectedFolder);
+		} else
+		{
+			gSymbolIndex.close();
+		}
+
+		// Watch open files for external changes
 		_fileMonitor.startMonitoring(selectedFolder);
 
 		// Set up callback for external file changes
@@ -246,7 +148,8 @@ void FileExplorer::openFolderDialog()
 						}
 
 						// Update tracking
-						_fileMonitor.addFileToMonitoring(currentFile);
+						_fileMonitor.refreshFileState(currentFile,
+													  editor_state.fileContent);
 
 						gSettings.renderNotification("File Modified", 2.0f);
 					} else
@@ -292,12 +195,7 @@ bool FileExplorer::handleFileDialogWorkflow()
 		gLSPClient.setWorkspace(selectedFolder);
 
 		// Initialize the file tree with the selected folder
-		auto &rootNode = gFileTree.rootNode;
-		rootNode.name = fs::path(selectedFolder).filename().string();
-		rootNode.fullPath = selectedFolder;
-		rootNode.isDirectory = true;
-		rootNode.children.clear();
-		gFileTree.buildFileTree(selectedFolder, rootNode);
+		gFileTree.openFolder(selectedFolder);
 
 		// Hide welcome screen since we now have a project loaded
 		showWelcomeScreen = false;
@@ -427,13 +325,19 @@ void FileExplorer::updateFilePathStates(const std::string &path)
 void FileExplorer::setupUndoManager(const std::string &path)
 {
 	auto it = fileUndoManagers.find(path);
-	if (it == fileUndoManagers.end())
+	bool created = it == fileUndoManagers.end();
+	if (created)
 	{
 		it = fileUndoManagers.emplace(path, UndoRedoManager()).first;
-		// Initialize with current state
-		it->second.initialize(editor_state.fileContent, editor_state.cursor_index);
 	}
 	currentUndoManager = &(it->second);
+	currentUndoManager->setBudget(
+		static_cast<size_t>(gSettings.getSnapshot()->undoHistoryMb * (1 << 20)));
+	if (created)
+	{
+		// Journals are read the first time their file is opened
+		loadUndoJournal(path, *currentUndoManager);
+	}
 }
 
 void FileExplorer::handleLoadError()
@@ -447,7 +351,9 @@ void FileExplorer::handleLoadError()
 void FileExplorer::loadFileContent(const std::string &path,
 								   std::function<void()> afterLoadCallback)
 {
-	saveCurrentFile(); // Save current before loading new
+	saveCurrentFile();	 // Save current before loading new
+	saveUndoRedoState(); // Journal its history against the content just saved
+	gLSPClient.didClose(currentFile);
 	editor_state.cursor_index = 0;
 	editor_state.ensure_cursor_visible.horizontal = true;
 	editor_state.ensure_cursor_visible.vertical = true;
@@ -467,12 +373,13 @@ void FileExplorer::loadFileContent(const std::string &path,
 		updateFilePathStates(path);
 		updateFileColorBuffer();
 		setupUndoManager(path);
+		gRecoveryJournal.noteLoaded(path, editor_state.fileContent);
 
 		// Use synchronous highlighting to prevent white flash on file load
 		gEditorHighlight.highlightContent(false, true);
 
 		// Initialize file tracking for external change detection
-		_fileMonitor.addFileToMonitoring(path);
+		_fileMonitor.refreshFileState(path, editor_state.fileContent);
 
 		// Set current file path for line numbers
 		gEditorLineNumbers.setCurrentFilePath(path);
@@ -499,27 +406,38 @@ void FileExplorer::loadFileContent(const std::string &path,
 	}
 }
 
-void FileExplorer::addUndoState()
+void FileExplorer::recordEdit(int position,
+							  std::string_view removed,
+							  std::string_view inserted)
 {
+	gRecoveryJournal.noteEdit(currentFile, position, removed, inserted);
+	gLSPClient.didChange(
+		currentFile, editor_state.fileContent, position, removed, inserted);
 	if (currentUndoManager)
 	{
-		// Print the cursor index before saving the undo state
-		printf("[addUndoState] Saving undo state. Cursor index: %d\n",
-			   editor_state.cursor_index);
-		currentUndoManager->addState(editor_state.fileContent, editor_state.cursor_index);
+		currentUndoManager->recordEdit(position,
+									   removed,
+									   inserted,
+									   editor_state.cursor_index,
+									   editor_state.multi_cursor_indices);
 
 		// Mark that we have unsaved undo state
 		_undoStateDirty = true;
+	}
+}
+
+void FileExplorer::addUndoState()
+{
+	if (currentUndoManager)
+	{
+		currentUndoManager->noteCursor(editor_state.cursor_index,
+									   editor_state.multi_cursor_indices);
 
 		// Update file tracking for external change detection
 		if (!currentFile.empty())
 		{
 			_fileMonitor.addFileToMonitoring(currentFile);
 		}
-
-		// Use a more efficient approach - let the existing debouncing in
-		// UndoRedoManager handle it The save will happen periodically through
-		// the existing update() calls
 	}
 }
 
@@ -527,7 +445,7 @@ void FileExplorer::forceCommitUndoState()
 {
 	if (currentUndoManager)
 	{
-		currentUndoManager->forceCommitPending();
+		currentUndoManager->closeStep();
 	}
 }
 
@@ -545,12 +463,6 @@ void FileExplorer::renderFileContent()
 	bool text_changed;
 	renderEditor(text_changed);
 
-	// Process debounced undo states
-	if (currentUndoManager)
-	{
-		currentUndoManager->update();
-	}
-
 	// Periodic save of undo state (every 3 seconds)
 	static auto lastSaveTime = std::chrono::steady_clock::now();
 	auto now = std::chrono::steady_clock::now();
@@ -577,7 +489,7 @@ void FileExplorer::renderFileExplorer(float explorerWidth)
 
 	if (!selectedFolder.empty())
 	{
-		gFileTree.displayFileTree(gFileTree.rootNode); // Changed to use gFileTree
+		gFileTree.displayFileTree();
 	}
 	ImGui::EndChild();
 	ImGui::PopStyleColor();
@@ -615,91 +527,51 @@ void FileExplorer::applyOperation(const UndoRedoManager::Operation &op, bool isU
 {
 	gEditorHighlight.cancelHighlighting();
 
-	// Apply the operation to get new content
-	std::string newContent = isUndo ? op.apply(editor_state.fileContent)
-									: op.applyInverse(editor_state.fileContent);
-
-	// Synchronize colors vector with content changes
-	// This prevents the visual glitch where colors vector doesn't match content
-	// vector
-	if (isUndo)
-	{
-		// For undo: we need to reverse the original operation
-		// If original operation inserted text, we need to remove colors
-		// If original operation removed text, we need to add colors back
-		if (op.inserted.length() > 0)
-		{
-			// Original operation inserted text, so we need to remove colors
-			if (op.position >= 0 &&
-				op.position + op.inserted.length() <= editor_state.fileColors.size())
-			{
-				editor_state.fileColors.erase(
-					editor_state.fileColors.begin() + op.position,
-					editor_state.fileColors.begin() + op.position + op.inserted.length());
-			}
-		}
-		if (op.removed.length() > 0)
-		{
-			// Original operation removed text, so we need to add colors back
-			// Get the proper default text color from the theme
-			ImVec4 defaultColor = ImVec4(1.0f, 1.0f, 1.0f, 1.0f); // Default white
-			if (op.position >= 0 && op.position <= editor_state.fileColors.size())
-			{
-				editor_state.fileColors.insert(editor_state.fileColors.begin() +
-												   op.position,
-											   op.removed.length(),
-											   defaultColor);
-			}
-		}
-	} else
-	{
-		// For redo: we need to apply the original operation
-		// If original operation inserted text, we need to add colors
-		// If original operation removed text, we need to remove colors
-		if (op.inserted.length() > 0)
+	std::string &content = editor_state.fileContent;
+	std::vector<ImVec4> &colors = editor_state.fileColors;
+	ImVec4 defaultColor = ImVec4(1.0f, 1.0f, 1.0f, 1.0f); // Default white
+	const size_t count = op.edits.size();
+	for (size_t i = 0; i < count; i++)
+	{
+		// Undo reverts the edits last to first
+		const UndoRedoManager::Edit &edit = op.edits[isUndo ? count - 1 - i : i];
+		const std::string &from = isUndo ? edit.inserted : edit.removed;
+		const std::string &to = isUndo ? edit.removed : edit.inserted;
+
+		// The buffer can only disagree when something bypassed the journal,
+		// such as a reload; its history is useless from then on
+		if (edit.position < 0 || edit.position > static_cast<int>(content.size()) ||
+			content.compare(edit.position, from.size(), from) != 0)
 		{
-			// Original operation inserted text, so we need to add colors
-			// Get the proper default text color from the theme
-			ImVec4 defaultColor = ImVec4(1.0f, 1.0f, 1.0f, 1.0f); // Default white
-			if (op.position >= 0 && op.position <= editor_state.fileColors.size())
-			{
-				editor_state.fileColors.insert(editor_state.fileColors.begin() +
-												   op.position,
-											   op.inserted.length(),
-											   defaultColor);
-			}
+			std::cerr << "Undo history does not match " << currentFile
+					  << ", dropping it" << std::endl;
+			currentUndoManager->clear();
+			break;
 		}
-		if (op.removed.length() > 0)
+		gLSPClient.didChange(currentFile, content, edit.position, from, to);
+		content.replace(edit.position, from.size(), to);
+		gRecoveryJournal.noteEdit(currentFile, edit.position, from, to);
+
+		// Keep colors in step with the content until highlighting catches up
+		if (static_cast<size_t>(edit.position) <= colors.size())
 		{
-			// Original operation removed text, so we need to remove colors
-			if (op.position >= 0 &&
-				op.position + op.removed.length() <= editor_state.fileColors.size())
-			{
-				editor_state.fileColors.erase(
-					editor_state.fileColors.begin() + op.position,
-					editor_state.fileColors.begin() + op.position + op.removed.length());
-			}
+			size_t erase = std::min(from.size(), colors.size() - edit.position);
+			colors.erase(colors.begin() + edit.position,
+						 colors.begin() + edit.position + erase);
+			colors.insert(colors.begin() + edit.position, to.size(), defaultColor);
 		}
 	}
+	colors.resize(content.size(), defaultColor);
 
-	// Update editor state
-	editor_state.fileContent = newContent;
-
-	// Set appropriate cursor position based on the operation
-	int cursor_pos = isUndo ? op.cursor_before : op.cursor_after;
-
-	if (cursor_pos < 0)
-		cursor_pos = 0;
-	if (cursor_pos > static_cast<int>(newContent.length()))
+	// Set appropriate cursor positions based on the operation
+	int length = static_cast<int>(content.length());
+	int cursor_pos = std::clamp(isUndo ? op.cursor_before : op.cursor_after, 0, length);
+	editor_state.cursor_index = cursor_pos;
+	editor_state.multi_cursor_indices.clear();
+	for (int cursor : isUndo ? op.cursors_before : op.cursors_after)
 	{
-		cursor_pos = newContent.length();
+		editor_state.multi_cursor_indices.push_back(std::clamp(cursor, 0, length));
 	}
-	editor_state.cursor_index = cursor_pos;
-
-	// Print the cursor index after applying the operation (undo/redo)
-	printf("[applyOperation] Cursor index after %s: %d\n",
-		   isUndo ? "undo" : "redo",
-		   editor_state.cursor_index);
 
 	// Reset selection state
 	editor_state.selection_start = editor_state.selection_end = cursor_pos;
@@ -707,6 +579,7 @@ void FileExplorer::applyOperation(const UndoRedoManager::Operation &op, bool isU
 	editor_state.multi_selections.clear();
 
 	// Trigger highlighting to apply proper colors
+	gEditor.updateLineStarts();
 	gEditorHighlight.highlightContent(true);
 
 	_unsavedChanges = true;
@@ -722,10 +595,6 @@ void FileExplorer::handleUndo()
 			applyOperation(op, true);
 			_undoStateDirty = true; // Mark as dirty instead of immediate save
 			saveCurrentFile();		// Save file after undo operation
-
-			// Update pendingFinalCursor after undo so cursor movements are tracked for
-			// next "first edit"
-			currentUndoManager->updatePendingFinalCursor(editor_state.cursor_index);
 		}
 	}
 }
@@ -744,107 +613,94 @@ void FileExplorer::handleRedo()
 	}
 }
 
-// In files.cpp
 void FileExplorer::saveUndoRedoState()
 {
-	if (selectedFolder.empty() || !_undoStateDirty)
+	_undoStateDirty = false;
+	if (!currentUndoManager || currentFile.empty() || !currentUndoManager->hasJournal())
 	{
-		return; // Skip if no changes or no folder
+		return;
 	}
 
-	fs::path undoPath = fs::path(selectedFolder) / ".undo-redo-ned.json";
-
-	try
+	std::string records =
+		currentUndoManager->takeJournal(undoContentHash(editor_state.fileContent));
+	fs::path path = undoJournalPath(currentFile);
+	std::error_code ec;
+	bool fresh = !fs::exists(path, ec);
+	if (fresh)
 	{
-		json root;
-		bool hasChanges = false;
-
-		for (const auto &[path, manager] : fileUndoManagers)
-		{
-			// Only serialize if the manager has operations
-			if (manager.hasOperations())
-			{
-				try
-				{
-					root["files"][path] = manager.toJson();
-					hasChanges = true;
-				} catch (const std::exception &e)
-				{
-					std::cerr << "Error serializing undo state for " << path << ": "
-							  << e.what() << "\n";
-					// Continue with other files
-				}
-			}
-		}
+		fs::create_directories(path.parent_path(), ec);
+	}
 
-		// Only write to disk if there are actual changes
-		if (hasChanges)
-		{
-			std::ofstream file(undoPath);
-			if (file)
-			{
-				file << root.dump(4);
-				_undoStateDirty = false; // Mark as saved
-			} else
-			{
-				std::cerr << "Failed to save undo/redo state to " << undoPath << "\n";
-			}
-		} else
-		{
-			_undoStateDirty = false; // No changes to save
-		}
-	} catch (const std::exception &e)
+	// Only what changed since the last save is written
+	std::ofstream file(path, std::ios::binary | std::ios::app);
+	if (!file)
 	{
-		std::cerr << "Error saving undo/redo state: " << e.what() << "\n";
-		// Don't mark as saved if there was an error
+		std::cerr << "Failed to save undo/redo state to " << path << "\n";
+		return;
+	}
+	if (fresh)
+	{
+		file << undoJournalHeader(currentFile);
 	}
+	file.write(records.data(), records.size());
 }
 
-void FileExplorer::loadUndoRedoState()
+void FileExplorer::loadUndoJournal(const std::string &path, UndoRedoManager &manager)
 {
-	if (selectedFolder.empty())
-		return;
-
-	fs::path undoPath = fs::path(selectedFolder) / ".undo-redo-ned.json";
-	std::ifstream file(undoPath);
+	std::string journalPath = undoJournalPath(path);
+	std::ifstream file(journalPath, std::ios::binary);
 	if (!file)
+	{
 		return;
+	}
+	std::string data((std::istreambuf_iterator<char>(file)),
+					 std::istreambuf_iterator<char>());
+	file.close();
 
-	try
+	std::string header = undoJournalHeader(path);
+	uint64_t hash = 0;
+	if (data.compare(0, header.size(), header) != 0 ||
+		!manager.replayJournal(std::string_view(data).substr(header.size()), hash) ||
+		hash != undoContentHash(editor_state.fileContent))
 	{
-		json root;
-		file >> root;
+		// The file changed outside the editor since, so its history no longer
+		// applies
+		manager.clear();
+		std::error_code ec;
+		fs::remove(journalPath, ec);
+		return;
+	}
 
-		if (root.contains("files") && root["files"].is_object())
+	// Rewrite journals that are mostly steps trimmed or amended since
+	if (data.size() > UNDO_JOURNAL_COMPACT_BYTES)
+	{
+		std::string compact = header + manager.snapshotJournal(hash);
+		if (compact.size() * 2 < data.size())
 		{
-			for (auto &[key, value] : root["files"].items())
+			std::string tempPath = journalPath + ".tmp";
+			std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+			if (out.write(compact.data(), compact.size()))
 			{
-				try
-				{
-					fileUndoManagers[key].fromJson(value);
-				} catch (const std::exception &e)
-				{
-					std::cerr << "Error loading undo state for file " << key << ": "
-							  << e.what() << "\n";
-					// Continue loading other files even if one fails
-				}
+				out.close();
+				std::error_code ec;
+				fs::rename(tempPath, journalPath, ec);
 			}
 		}
-	} catch (const std::exception &e)
-	{
-		std::cerr << "Error loading undo/redo state: " << e.what() << "\n";
-		// If the file is corrupted, delete it to prevent future crashes
-		try
-		{
-			fs::remove(undoPath);
-			std::cerr << "Removed corrupted undo/redo state file\n";
-		} catch (...)
-		{
-			// Ignore errors when trying to delete the file
-		}
 	}
 }
 
+std::string FileExplorer::undoJournalPath(const std::string &path)
+{
+	// Next to the settings directory, e.g. ~/ned/cache/undo, named by path hash
+	fs::path settingsDir = fs::path(Settings::getUserSettingsPath()).parent_path();
+	char name[24];
+	std::snprintf(name,
+				  sizeof(name),
+				  "%016llx.bin",
+				  static_cast<unsigned long long>(undoContentHash(path)));
+	return (settingsDir.parent_path() / "cache" / "undo" / name).string();
+}
+
 void FileExplorer::saveCurrentFile()
 {
 	if (!currentFile.empty() && _unsavedChanges)
@@ -865,23 +721,14 @@ void FileExplorer::saveCurrentFile()
 			file << editor_state.fileContent;
 			file.close();
 			_unsavedChanges = false;
+			gRecoveryJournal.noteSaved(currentFile, editor_state.fileContent);
 			// std::cout << "File saved: " << currentFile << std::endl;
-			//  Track document version - start at 1 and increment on each save
-			int &version = _documentVersions[currentFile];
-			version = version == 0 ? 1 : version + 1;
 
-			// Update tracking and refresh the file's stored state to prevent false
-			// external change detection
-			_fileMonitor.addFileToMonitoring(currentFile);
-			_fileMonitor.refreshFileState(currentFile);
-
-			// Notify LSP about the file change
-			if (gLSPClient.isInitialized())
-			{
-				// std::cout << "LSP: File saved, sending didChange: " << currentFile
-				//		  << " (v" << version << ")" << std::endl;
-				gLSPClient.didEdit(currentFile, editor_state.fileContent);
-			}
+			// Refresh the file's stored state to prevent false external change
+			// detection
+			_fileMonitor.refreshFileState(currentFile, editor_state.fileContent);
+			gTrigramIndex.noteFileChanged(currentFile);
+			gSymbolIndex.noteFileChanged(currentFile);
 		} else
 		{
 			std::cerr << "Unable to save file: " << currentFile << std::endl;
@@ -926,6 +773,9 @@ void FileExplorer::reloadCurrentFile()
 	{
 		updateFileColorBuffer();
 		gEditorHighlight.highlightContent();
+		forceCommitUndoState(); // Don't fold later edits into one made before
+		gRecoveryJournal.noteLoaded(currentFile, editor_state.fileContent);
+		gLSPClient.didReload(currentFile);
 
 		// Try to restore cursor position (clamp to new content size)
 		if (currentCursorPos < static_cast<int>(editor_state.fileContent.length()))
@@ -937,7 +787,7 @@ void FileExplorer::reloadCurrentFile()
 		}
 
 		// Update tracking
-		_fileMonitor.addFileToMonitoring(currentFile);
+		_fileMonitor.refreshFileState(currentFile, editor_state.fileContent);
 
 		gSettings.renderNotification("File reloaded successfully", 2.0f);
 	} else
@@ -13,6 +13,7 @@
 #include "file_monitor.h"
 #include "file_tree.h"
 #include "file_undo_redo.h"
+#include "icon_atlas.h"
 
 #include <chrono>
 #include <filesystem>
@@ -21,6 +22,7 @@
 #include <map>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace fs = std::filesystem;
@@ -48,11 +50,14 @@ class FileExplorer
 	// Undo/Redo
 	void handleUndo();
 	void handleRedo();
+	// Records an edit of the open file; see Editor::replaceText
+	void recordEdit(int position, std::string_view removed, std::string_view inserted);
+	// Ends an editing command: notes the cursor it left behind
 	void addUndoState();
-	void forceCommitUndoState(); // Force commit pending undo state immediately
+	void forceCommitUndoState(); // Start a new undo step with the next edit
 
+	// Appends the open file's new undo history to its journal
 	void saveUndoRedoState();
-	void loadUndoRedoState();
 	void forceSaveUndoState(); // Force save when needed (e.g., on app close)
 
 	// UI functions
@@ -67,8 +72,10 @@ class FileExplorer
 	// Icon handling
 	// by file exntension for example .py or .cpp
 	void loadIcons();
+	// The part of loadIcons() that needs no GL context, for a worker thread
+	void prepareIcons(float scale);
 
-	ImTextureID getIconForFile(const std::string &filename)
+	IconRef getIconForFile(const std::string &filename)
 	{
 		// Get the filename without path
 		std::string fileName = fs::path(filename).filename().string();
@@ -77,31 +84,26 @@ class FileExplorer
 
 		if (fileName == "CMakeLists.txt" || fileName == "cmake")
 		{
-			auto it = fileTypeIcons.find("cmake");
-			if (it != fileTypeIcons.end())
-				return it->second;
+			if (_iconAtlas.contains("cmake"))
+				return _iconAtlas.get("cmake");
 		}
 		if (fileName == ".clangd" || fileName == ".clang-format")
 		{
-			auto it = fileTypeIcons.find("clangd");
-			if (it != fileTypeIcons.end())
-				return it->second;
+			if (_iconAtlas.contains("clangd"))
+				return _iconAtlas.get("clangd");
 		}
 		if (fileName == "Dockerfile")
 		{
-			auto it = fileTypeIcons.find("Dockerfile");
-			if (it != fileTypeIcons.end())
-				return it->second;
+			if (_iconAtlas.contains("Dockerfile"))
+				return _iconAtlas.get("Dockerfile");
 		} else if (fileName == ".gitignore")
 		{
-			auto it = fileTypeIcons.find("gitignore");
-			if (it != fileTypeIcons.end())
-				return it->second;
+			if (_iconAtlas.contains("gitignore"))
+				return _iconAtlas.get("gitignore");
 		} else if (fileName == ".gitmodules")
 		{
-			auto it = fileTypeIcons.find("gitmodule");
-			if (it != fileTypeIcons.end())
-				return it->second;
+			if (_iconAtlas.contains("gitmodule"))
+				return _iconAtlas.get("gitmodule");
 		}
 
 		// Proceed with extension-based lookup for other files
@@ -111,20 +113,15 @@ class FileExplorer
 			extension = extension.substr(1);
 		}
 
-		auto it = fileTypeIcons.find(extension);
-		return (it != fileTypeIcons.end()) ? it->second : fileTypeIcons["default"];
+		// Unknown extensions get the default icon
+		return _iconAtlas.get(extension);
 	}
 
 	// by icon name for example folder or folder-open
-	ImTextureID getIcon(const std::string &iconName) const
-	{
-		auto it = fileTypeIcons.find(iconName);
-		if (it != fileTypeIcons.end())
-		{
-			return it->second;
-		}
-		return fileTypeIcons.at("default");
-	}
+	IconRef getIcon(const std::string &iconName) { return _iconAtlas.get(iconName); }
+
+	// Keeps rasterized icons for the next start
+	void saveIconCache() { _iconAtlas.saveCache(); }
 
 	// Dialog state
 	bool showFileDialog() const { return _showFileDialog; }
@@ -144,26 +141,17 @@ class FileExplorer
 	void reloadCurrentFile();
 
   private:
-	std::map<std::string, ImTextureID> fileTypeIcons;
-
-	std::unordered_map<std::string, int> _documentVersions;
-
-	// Icon loading helpers
-	struct IconDimensions
-	{
-		static constexpr int WIDTH = 32;
-		static constexpr int HEIGHT = 32;
-		static constexpr float SVG_DPI = 96.0f;
-	};
-
-	GLuint createTexture(const unsigned char *pixels, int width, int height);
-	bool loadSingleIcon(const std::string &iconFile);
-	void createDefaultIcon();
+	IconAtlas _iconAtlas;
+	bool _iconsPrepared = false;
 
 	// File loading helpers
 	bool readFileContent(const std::string &path);
 	void updateFileColorBuffer();
 	void setupUndoManager(const std::string &path);
+	// Rebuilds a file's undo history from its journal if it still fits the
+	// loaded content
+	void loadUndoJournal(const std::string &path, UndoRedoManager &manager);
+	static std::string undoJournalPath(const std::string &path);
 	void handleLoadError();
 	void updateFilePathStates(const std::string &path);
 
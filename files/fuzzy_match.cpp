@@ -0,0 +1,226 @@
+/*
+	File: fuzzy_match.cpp
+	Description: Fuzzy path scoring. See fuzzy_match.h.
+*/
+
+#include "fuzzy_match.h"
+
+#include <algorithm>
+#include <filesystem>
+
+namespace {
+
+constexpr int SCORE_MATCH = 16;
+constexpr int GAP_START = -3;
+constexpr int GAP_EXTENSION = -1;
+// Start of a path segment, e.g. the 'f' in "src/files"
+constexpr int BONUS_SEGMENT = 10;
+// After '_', '-', '.' or a space
+constexpr int BONUS_BOUNDARY = 8;
+// camelCase hump, or the first digit of a number
+constexpr int BONUS_CAMEL = 7;
+constexpr int BONUS_CONSECUTIVE = 4;
+constexpr int FIRST_CHAR_MULTIPLIER = 2;
+// A term that fits inside the file name beats one spread over directories
+constexpr int BONUS_BASENAME = 24;
+
+bool isSeparator(char c) { return c == '/' || c == '\\'; }
+
+char toLower(char c) { return c >= 'A' && c <= 'Z' ? static_cast<char>(c + 32) : c; }
+
+bool isLower(char c) { return c >= 'a' && c <= 'z'; }
+bool isUpper(char c) { return c >= 'A' && c <= 'Z'; }
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+} // namespace
+
+void PathTable::add(std::string_view relative)
+{
+	size_t base = relative.size();
+	while (base > 0 && !isSeparator(relative[base - 1]))
+	{
+		base--;
+	}
+	text.append(relative);
+	uint64_t mask = 0;
+	for (char c : relative)
+	{
+		lower.push_back(toLower(c));
+		mask |= maskOf(lower.back());
+	}
+	charMasks.push_back(mask);
+	offsets.push_back(static_cast<uint32_t>(text.size()));
+	basenames.push_back(static_cast<uint32_t>(base));
+}
+
+std::string PathTable::fullPath(uint32_t id) const
+{
+	std::string full = root;
+	if (!full.empty() && !isSeparator(full.back()))
+	{
+		full += static_cast<char>(std::filesystem::path::preferred_separator);
+	}
+	full.append(path(id));
+	return full;
+}
+
+FuzzyQuery::FuzzyQuery(std::string_view query)
+{
+	std::string term;
+	for (char c : query)
+	{
+		if (c == ' ')
+		{
+			if (!term.empty())
+			{
+				terms.push_back(std::move(term));
+				term.clear();
+			}
+			continue;
+		}
+		term.push_back(toLower(c));
+	}
+	if (!term.empty())
+	{
+		terms.push_back(std::move(term));
+	}
+	for (const std::string &t : terms)
+	{
+		for (char c : t)
+		{
+			mask |= PathTable::maskOf(c);
+		}
+	}
+}
+
+int FuzzyQuery::bonusAt(std::string_view text, size_t i)
+{
+	if (i == 0)
+	{
+		return BONUS_SEGMENT;
+	}
+	char prev = text[i - 1];
+	char c = text[i];
+	if (isSeparator(prev))
+	{
+		return BONUS_SEGMENT;
+	}
+	if (prev == '_' || prev == '-' || prev == '.' || prev == ' ')
+	{
+		return BONUS_BOUNDARY;
+	}
+	if ((isLower(prev) && isUpper(c)) || (!isDigit(prev) && isDigit(c)))
+	{
+		return BONUS_CAMEL;
+	}
+	return 0;
+}
+
+int FuzzyQuery::scoreTerm(std::string_view lower,
+						  std::string_view text,
+						  size_t from,
+						  std::string_view term)
+{
+	// Forward: where the earliest match ends
+	size_t q = 0;
+	size_t end = 0;
+	for (size_t i = from; i < lower.size(); i++)
+	{
+		if (lower[i] == term[q] && ++q == term.size())
+		{
+			end = i + 1;
+			break;
+		}
+	}
+	if (q < term.size())
+	{
+		return FuzzyQuery::NO_MATCH;
+	}
+
+	// Backward from there: the latest start, giving the tightest window
+	size_t start = end;
+	while (q > 0)
+	{
+		start--;
+		if (lower[start] == term[q - 1])
+		{
+			q--;
+		}
+	}
+
+	int score = 0;
+	int runBonus = 0; // Bonus of the first character of the current run
+	bool inRun = false;
+	bool inGap = false;
+	for (size_t i = start; i < end && q < term.size(); i++)
+	{
+		if (lower[i] != term[q])
+		{
+			score += inGap ? GAP_EXTENSION : GAP_START;
+			inGap = true;
+			inRun = false;
+			continue;
+		}
+		int bonus = bonusAt(text, i);
+		if (!inRun)
+		{
+			runBonus = bonus;
+		} else
+		{
+			// A run carries the bonus of where it started
+			if (bonus >= BONUS_BOUNDARY && bonus > runBonus)
+			{
+				runBonus = bonus;
+			}
+			bonus = std::max({bonus, runBonus, BONUS_CONSECUTIVE});
+		}
+		score += SCORE_MATCH + (q == 0 ? bonus * FIRST_CHAR_MULTIPLIER : bonus);
+		inRun = true;
+		inGap = false;
+		q++;
+	}
+	return score;
+}
+
+int FuzzyQuery::score(const PathTable &table, uint32_t id) const
+{
+	if ((table.charMasks[id] & mask) != mask)
+	{
+		return NO_MATCH;
+	}
+	return score(table.path(id), table.pathLower(id), table.basenames[id], mask);
+}
+
+int FuzzyQuery::score(std::string_view text,
+					  std::string_view lower,
+					  size_t base,
+					  uint64_t charMask) const
+{
+	if ((charMask & mask) != mask)
+	{
+		return NO_MATCH;
+	}
+
+	int total = 0;
+	for (const std::string &term : terms)
+	{
+		int best = scoreTerm(lower, text, 0, term);
+		if (best == NO_MATCH)
+		{
+			return NO_MATCH;
+		}
+		if (base > 0)
+		{
+			int inName = scoreTerm(lower, text, base, term);
+			if (inName != NO_MATCH)
+			{
+				best = std::max(best, inName + BONUS_BASENAME);
+			}
+		} else
+		{
+			best += BONUS_BASENAME;
+		}
+		total += best;
+	}
+	return total;
+}
@@ -0,0 +1,85 @@
+/*
+	File: fuzzy_match.h
+	Description: Fuzzy path matching for the file finder, in the style of fzf.
+   Query characters must appear in order; the score rewards matches at the start
+   of path segments and words, consecutive runs and matches inside the file
+   name, and charges for the gaps between them.
+
+   Paths are kept in a PathTable, one buffer per column instead of one object
+   per file, so a full scan walks a few contiguous arrays.
+*/
+
+#pragma once
+
+#include <climits>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct PathTable
+{
+	std::string root;
+	std::string text;				// Relative paths, back to back
+	std::string lower;				// `text` with ASCII lower-cased
+	std::vector<uint32_t> offsets{0}; // Path i is [offsets[i], offsets[i + 1])
+	std::vector<uint32_t> basenames;  // Start of each file name within its path
+	// Which lower-cased bytes each path contains, folded to 64 bits, so most
+	// paths fail a query without reading them
+	std::vector<uint64_t> charMasks;
+
+	void add(std::string_view relative);
+	size_t size() const { return basenames.size(); }
+
+	std::string_view path(uint32_t id) const
+	{
+		return std::string_view(text).substr(offsets[id], offsets[id + 1] - offsets[id]);
+	}
+	std::string_view pathLower(uint32_t id) const
+	{
+		return std::string_view(lower).substr(offsets[id],
+											  offsets[id + 1] - offsets[id]);
+	}
+	std::string_view basename(uint32_t id) const
+	{
+		return path(id).substr(basenames[id]);
+	}
+	std::string fullPath(uint32_t id) const;
+
+	static uint64_t maskOf(char lowered)
+	{
+		return uint64_t(1) << (static_cast<unsigned char>(lowered) & 63);
+	}
+};
+
+class FuzzyQuery
+{
+  public:
+	// Case-insensitive. Spaces separate terms that must all match.
+	explicit FuzzyQuery(std::string_view query);
+
+	bool empty() const { return terms.empty(); }
+
+	// NO_MATCH when some term does not match
+	int score(const PathTable &table, uint32_t id) const;
+	// Same for any text: `lower` is `text` lower-cased, `base` where the part
+	// that earns the name bonus starts and `charMask` PathTable::maskOf every
+	// byte of `lower`
+	int score(std::string_view text,
+			  std::string_view lower,
+			  size_t base,
+			  uint64_t charMask) const;
+
+	static constexpr int NO_MATCH = INT_MIN;
+
+  private:
+	std::vector<std::string> terms;
+	uint64_t mask = 0; // PathTable::maskOf every character of every term
+
+	// Best placement of `term` starting at or after `from`
+	static int scoreTerm(std::string_view lower,
+						 std::string_view text,
+						 size_t from,
+						 std::string_view term);
+	static int bonusAt(std::string_view text, size_t i);
+};
@@ -0,0 +1,372 @@
+/*
+	File: icon_atlas.cpp
+	Description: Lazily rasterized icon atlas. See icon_atlas.h.
+*/
+
+#include "icon_atlas.h"
+#include "../util/settings.h"
+
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+#define NANOSVG_IMPLEMENTATION
+#include "lib/nanosvg.h"
+#define NANOSVGRAST_IMPLEMENTATION
+#include "lib/nanosvgrast.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char CACHE_MAGIC[8] = {'N', 'E', 'D', 'I', 'C', 'O', 'N', '1'};
+
+template <typename T> void writeValue(std::ofstream &out, T value)
+{
+	out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <typename T> bool readValue(std::ifstream &in, T &value)
+{
+	return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(value)));
+}
+
+} // namespace
+
+void IconAtlas::prepare(const std::vector<std::string> &iconFiles, float scale)
+{
+	iconSize = std::max(ICON_SIZE, static_cast<int>(std::lround(ICON_SIZE * scale)));
+	cellSize = iconSize + 2;
+
+	slots.clear();
+	for (const std::string &file : iconFiles)
+	{
+		std::string name = file.substr(0, file.find('.')); // "file" from "file.svg"
+		Slot slot;
+		slot.file = file;
+		slot.cell = static_cast<int>(slots.size());
+		slots.emplace(name, std::move(slot));
+	}
+
+	// Square power of two holding every cell, plus one left empty
+	emptyCell = static_cast<int>(slots.size());
+	columns = static_cast<int>(std::ceil(std::sqrt(emptyCell + 1)));
+	atlasSize = 64;
+	while (atlasSize < columns * cellSize)
+	{
+		atlasSize *= 2;
+	}
+	columns = atlasSize / cellSize;
+	pixels.assign(static_cast<size_t>(atlasSize) * atlasSize * 4, 0);
+
+	loadCache();
+}
+
+void IconAtlas::upload()
+{
+	if (texture == 0)
+	{
+		glGenTextures(1, &texture);
+	}
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexImage2D(GL_TEXTURE_2D,
+				 0,
+				 GL_RGBA,
+				 atlasSize,
+				 atlasSize,
+				 0,
+				 GL_RGBA,
+				 GL_UNSIGNED_BYTE,
+				 pixels.data());
+}
+
+bool IconAtlas::contains(const std::string &name) const
+{
+	auto it = slots.find(name);
+	return it != slots.end() && it->second.state != SlotState::Failed;
+}
+
+IconAtlas::Slot *IconAtlas::resolve(const std::string &name)
+{
+	auto it = slots.find(name);
+	if (it == slots.end())
+	{
+		return nullptr;
+	}
+	Slot &slot = it->second;
+	if (slot.state == SlotState::Pending && !rasterize(slot))
+	{
+		slot.state = SlotState::Failed;
+	}
+	return slot.state == SlotState::Ready ? &slot : nullptr;
+}
+
+IconRef IconAtlas::get(const std::string &name)
+{
+	if (texture == 0)
+	{
+		return IconRef();
+	}
+	if (const Slot *slot = resolve(name))
+	{
+		return refFor(slot->cell);
+	}
+	if (const Slot *slot = resolve("default"))
+	{
+		return refFor(slot->cell);
+	}
+	// No usable icon at all: the empty cell draws nothing
+	return refFor(emptyCell);
+}
+
+IconRef IconAtlas::refFor(int cell) const
+{
+	float x = static_cast<float>((cell % columns) * cellSize + 1);
+	float y = static_cast<float>((cell / columns) * cellSize + 1);
+	float size = static_cast<float>(atlasSize);
+
+	IconRef ref;
+	ref.texture = static_cast<ImTextureID>(texture);
+	ref.uv0 = ImVec2(x / size, y / size);
+	ref.uv1 = ImVec2((x + iconSize) / size, (y + iconSize) / size);
+	return ref;
+}
+
+void IconAtlas::copyToCell(int cell, const unsigned char *icon)
+{
+	size_t x = static_cast<size_t>((cell % columns) * cellSize + 1);
+	size_t y = static_cast<size_t>((cell / columns) * cellSize + 1);
+	size_t rowBytes = static_cast<size_t>(iconSize) * 4;
+	for (int row = 0; row < iconSize; row++)
+	{
+		std::memcpy(
+			&pixels[((y + row) * atlasSize + x) * 4], icon + row * rowBytes, rowBytes);
+	}
+}
+
+std::string IconAtlas::findIconFile(const std::string &file)
+{
+	std::string primaryPath = "icons/" + file;
+	if (fs::exists(primaryPath))
+	{
+		return primaryPath;
+	}
+#ifndef __APPLE__ // Only try the Debian package path if NOT on macOS
+	std::string packagedPath = "/usr/share/Ned/icons/" + file;
+	if (fs::exists(packagedPath))
+	{
+		return packagedPath;
+	}
+#endif
+	return "";
+}
+
+bool IconAtlas::sourceStamp(const std::string &path, int64_t &time, uint64_t &size)
+{
+	std::error_code ec;
+	auto modified = fs::last_write_time(path, ec);
+	if (ec)
+	{
+		return false;
+	}
+	size = fs::file_size(path, ec);
+	time = static_cast<int64_t>(modified.time_since_epoch().count());
+	return !ec;
+}
+
+bool IconAtlas::rasterize(Slot &slot)
+{
+	std::string path = findIconFile(slot.file);
+	if (path.empty() || !sourceStamp(path, slot.sourceTime, slot.sourceSize))
+	{
+		return false;
+	}
+
+	NSVGimage *image = nsvgParseFromFile(path.c_str(), "px", SVG_DPI);
+	if (!image)
+	{
+		std::cerr << "Error loading SVG file: " << path << std::endl;
+		return false;
+	}
+	NSVGrasterizer *rast = nsvgCreateRasterizer();
+	if (!rast)
+	{
+		std::cerr << "Error creating SVG rasterizer" << std::endl;
+		nsvgDelete(image);
+		return false;
+	}
+
+	size_t byteCount = static_cast<size_t>(iconSize) * iconSize * 4;
+	auto icon = std::make_unique<unsigned char[]>(byteCount);
+	nsvgRasterize(rast,
+				  image,
+				  0,
+				  0,
+				  iconSize / image->width,
+				  icon.get(),
+				  iconSize,
+				  iconSize,
+				  iconSize * 4); // Stride
+	nsvgDeleteRasterizer(rast);
+	nsvgDelete(image);
+
+	copyToCell(slot.cell, icon.get());
+	int x = (slot.cell % columns) * cellSize + 1;
+	int y = (slot.cell / columns) * cellSize + 1;
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexSubImage2D(GL_TEXTURE_2D,
+					0,
+					x,
+					y,
+					iconSize,
+					iconSize,
+					GL_RGBA,
+					GL_UNSIGNED_BYTE,
+					icon.get());
+
+	slot.state = SlotState::Ready;
+	cacheDirty = true;
+	return true;
+}
+
+std::string IconAtlas::cachePath() const
+{
+	// Next to the settings directory, e.g. ~/ned/cache
+	fs::path settingsDir = fs::path(Settings::getUserSettingsPath()).parent_path();
+	fs::path cacheDir = settingsDir.parent_path() / "cache";
+	return (cacheDir / ("icons-" + std::to_string(iconSize) + ".bin")).string();
+}
+
+// Cache layout: magic, icon size, count, then per icon its name, the stamp of
+// its SVG and its pixels
+void IconAtlas::loadCache()
+{
+	std::ifstream in(cachePath(), std::ios::binary);
+	if (!in)
+	{
+		return;
+	}
+	char magic[sizeof(CACHE_MAGIC)];
+	uint32_t size = 0;
+	uint32_t count = 0;
+	if (!in.read(magic, sizeof(magic)) ||
+		std::memcmp(magic, CACHE_MAGIC, sizeof(magic)) != 0 || !readValue(in, size) ||
+		size != static_cast<uint32_t>(iconSize) || !readValue(in, count))
+	{
+		return;
+	}
+
+	size_t byteCount = static_cast<size_t>(iconSize) * iconSize * 4;
+	std::vector<unsigned char> icon(byteCount);
+	size_t restored = 0;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint16_t nameLength = 0;
+		std::string name;
+		int64_t sourceTime = 0;
+		uint64_t sourceSize = 0;
+		if (!readValue(in, nameLength))
+		{
+			break;
+		}
+		name.resize(nameLength);
+		if (!in.read(name.data(), nameLength) || !readValue(in, sourceTime) ||
+			!readValue(in, sourceSize) ||
+			!in.read(reinterpret_cast<char *>(icon.data()), byteCount))
+		{
+			break;
+		}
+
+		// Icons whose SVG changed or went away are rasterized again
+		auto it = slots.find(name);
+		if (it == slots.end())
+		{
+			continue;
+		}
+		int64_t time = 0;
+		uint64_t bytes = 0;
+		std::string path = findIconFile(it->second.file);
+		if (path.empty() || !sourceStamp(path, time, bytes) || time != sourceTime ||
+			bytes != sourceSize)
+		{
+			cacheDirty = true;
+			continue;
+		}
+		Slot &slot = it->second;
+		copyToCell(slot.cell, icon.data());
+		slot.state = SlotState::Ready;
+		slot.sourceTime = sourceTime;
+		slot.sourceSize = sourceSize;
+		restored++;
+	}
+	std::cout << "[IconAtlas] Restored " << restored << " icons from cache" << std::endl;
+}
+
+void IconAtlas::saveCache()
+{
+	if (!cacheDirty || texture == 0)
+	{
+		return;
+	}
+
+	std::string path = cachePath();
+	std::string tempPath = path + ".tmp";
+	std::error_code ec;
+	fs::create_directories(fs::path(path).parent_path(), ec);
+	{
+		std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+		if (!out)
+		{
+			return;
+		}
+		uint32_t count = 0;
+		for (const auto &entry : slots)
+		{
+			count += entry.second.state == SlotState::Ready;
+		}
+		out.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+		writeValue(out, static_cast<uint32_t>(iconSize));
+		writeValue(out, count);
+
+		std::vector<unsigned char> icon(static_cast<size_t>(iconSize) * iconSize * 4);
+		size_t rowBytes = static_cast<size_t>(iconSize) * 4;
+		for (const auto &[name, slot] : slots)
+		{
+			if (slot.state != SlotState::Ready)
+			{
+				continue;
+			}
+			size_t x = static_cast<size_t>((slot.cell % columns) * cellSize + 1);
+			size_t y = static_cast<size_t>((slot.cell / columns) * cellSize + 1);
+			for (int row = 0; row < iconSize; row++)
+			{
+				std::memcpy(icon.data() + row * rowBytes,
+							&pixels[((y + row) * atlasSize + x) * 4],
+							rowBytes);
+			}
+			writeValue(out, static_cast<uint16_t>(name.size()));
+			out.write(name.data(), static_cast<std::streamsize>(name.size()));
+			writeValue(out, slot.sourceTime);
+			writeValue(out, slot.sourceSize);
+			out.write(reinterpret_cast<const char *>(icon.data()),
+					  static_cast<std::streamsize>(icon.size()));
+		}
+		if (!out)
+		{
+			fs::remove(tempPath, ec);
+			return;
+		}
+	}
+	fs::rename(tempPath, path, ec);
+	if (!ec)
+	{
+		cacheDirty = false;
+	}
+}
@@ -0,0 +1,94 @@
+/*
+	File: icon_atlas.h
+	Description: All file and UI icons in one texture. An icon is rasterized
+   from its SVG the first time it is drawn and copied into its cell of the
+   atlas, so startup parses no SVGs and every icon shares one texture.
+
+   Rasterized icons are kept in a cache file per icon size and restored on the
+   next start, as long as their SVG did not change.
+*/
+
+#pragma once
+
+#include "imgui.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// An icon's texture and where it sits in it
+struct IconRef
+{
+	ImTextureID texture = 0;
+	ImVec2 uv0 = ImVec2(0, 0);
+	ImVec2 uv1 = ImVec2(1, 1);
+
+	explicit operator bool() const { return texture != 0; }
+};
+
+class IconAtlas
+{
+  public:
+	// Lays out a cell for each of `iconFiles` ("file.svg" is the icon "file")
+	// and restores cached icons. `scale` is the display's content scale. Needs
+	// no GL context, so startup runs it on a worker thread.
+	void prepare(const std::vector<std::string> &iconFiles, float scale);
+	// Creates the texture from what prepare() laid out. Needs the GL context.
+	void upload();
+	void init(const std::vector<std::string> &iconFiles, float scale)
+	{
+		prepare(iconFiles, scale);
+		upload();
+	}
+
+	// Whether `name` is a known icon that did not fail to load
+	bool contains(const std::string &name) const;
+	// Falls back to the "default" icon for unknown or broken ones
+	IconRef get(const std::string &name);
+
+	// Writes the cache when icons were rasterized since it was read
+	void saveCache();
+
+	static constexpr int ICON_SIZE = 32; // At a content scale of 1
+	static constexpr float SVG_DPI = 96.0f;
+
+  private:
+	enum class SlotState : uint8_t
+	{
+		Pending,
+		Ready,
+		Failed
+	};
+
+	struct Slot
+	{
+		std::string file;
+		int cell = 0;
+		SlotState state = SlotState::Pending;
+		// Of the SVG it was rasterized from, to tell when the cache is stale
+		int64_t sourceTime = 0;
+		uint64_t sourceSize = 0;
+	};
+
+	std::unordered_map<std::string, Slot> slots;
+	int iconSize = ICON_SIZE;
+	int cellSize = ICON_SIZE + 2; // A transparent pixel on each side
+	int columns = 1;
+	int emptyCell = 0; // Never written, for when no icon can be loaded
+	int atlasSize = 0;
+	unsigned int texture = 0;
+	std::vector<unsigned char> pixels; // Copy of the texture, for the cache
+	bool cacheDirty = false;
+
+	Slot *resolve(const std::string &name);
+	bool rasterize(Slot &slot);
+	void copyToCell(int cell, const unsigned char *icon);
+	IconRef refFor(int cell) const;
+
+	std::string cachePath() const;
+	void loadCache();
+
+	static std::string findIconFile(const std::string &file);
+	static bool sourceStamp(const std::string &path, int64_t &time, uint64_t &size);
+};
@@ -0,0 +1,234 @@
+/*
+	File: ignore_rules.cpp
+	Description: Parsing and matching of .gitignore files.
+*/
+
+#include "ignore_rules.h"
+
+#include <fstream>
+#include <sstream>
+
+std::shared_ptr<const IgnoreRules>
+IgnoreRules::forDirectory(const std::filesystem::path &dir,
+						  const std::string &relative_dir,
+						  std::shared_ptr<const IgnoreRules> parent)
+{
+	std::ifstream file(dir / ".gitignore", std::ios::binary);
+	if (!file)
+	{
+		return parent;
+	}
+	std::stringstream buffer;
+	buffer << file.rdbuf();
+
+	auto node = std::make_shared<IgnoreRules>();
+	node->base = relative_dir.empty() ? "" : relative_dir + "/";
+	node->parse(buffer.str());
+	if (node->rules.empty())
+	{
+		return parent;
+	}
+	node->parent = std::move(parent);
+	return node;
+}
+
+void IgnoreRules::parse(const std::string &content)
+{
+	std::istringstream lines(content);
+	std::string line;
+	while (std::getline(lines, line))
+	{
+		if (!line.empty() && line.back() == '\r')
+		{
+			line.pop_back();
+		}
+		// Trailing spaces are ignored unless escaped
+		while (!line.empty() && line.back() == ' ' &&
+			   (line.size() < 2 || line[line.size() - 2] != '\\'))
+		{
+			line.pop_back();
+		}
+		if (line.empty() || line[0] == '#')
+		{
+			continue;
+		}
+
+		Rule rule;
+		size_t begin = 0;
+		if (line[0] == '!')
+		{
+			rule.negate = true;
+			begin = 1;
+		} else if (line[0] == '\\' && line.size() > 1 &&
+				   (line[1] == '#' || line[1] == '!'))
+		{
+			begin = 1;
+		}
+		std::string pattern = line.substr(begin);
+		if (!pattern.empty() && pattern.back() == '/')
+		{
+			rule.dir_only = true;
+			pattern.pop_back();
+		}
+		if (!pattern.empty() && pattern[0] == '/')
+		{
+			rule.anchored = true;
+			pattern.erase(0, 1);
+		}
+		if (pattern.empty())
+		{
+			continue;
+		}
+		if (pattern.find('/') != std::string::npos)
+		{
+			rule.anchored = true;
+		}
+		rule.pattern = std::move(pattern);
+		rules.push_back(std::move(rule));
+	}
+}
+
+bool IgnoreRules::isIgnored(const IgnoreRules *rules,
+							std::string_view relative_path,
+							bool is_dir)
+{
+	for (const IgnoreRules *node = rules; node; node = node->parent.get())
+	{
+		if (relative_path.substr(0, node->base.size()) != node->base)
+		{
+			continue;
+		}
+		std::string_view path = relative_path.substr(node->base.size());
+		size_t slash = path.rfind('/');
+		std::string_view name = slash == std::string_view::npos ? path
+																: path.substr(slash + 1);
+
+		// Within one file the last matching rule decides
+		for (auto it = node->rules.rbegin(); it != node->rules.rend(); ++it)
+		{
+			if (it->dir_only && !is_dir)
+			{
+				continue;
+			}
+			if (globMatch(it->pattern, it->anchored ? path : name))
+			{
+				return !it->negate;
+			}
+		}
+	}
+	return false;
+}
+
+bool IgnoreRules::globMatch(std::string_view pattern, std::string_view text)
+{
+	size_t p = 0;
+	size_t t = 0;
+	while (p < pattern.size())
+	{
+		char c = pattern[p];
+		if (c == '*')
+		{
+			if (p + 1 < pattern.size() && pattern[p + 1] == '*')
+			{
+				// "**/" also matches zero directories
+				if (p + 2 < pattern.size() && pattern[p + 2] == '/')
+				{
+					std::string_view rest = pattern.substr(p + 3);
+					if (globMatch(rest, text.substr(t)))
+					{
+						return true;
+					}
+					for (size_t k = t; k < text.size(); ++k)
+					{
+						if (text[k] == '/' && globMatch(rest, text.substr(k + 1)))
+						{
+							return true;
+						}
+					}
+					return false;
+				}
+				std::string_view rest = pattern.substr(p + 2);
+				for (size_t k = t; k <= text.size(); ++k)
+				{
+					if (globMatch(rest, text.substr(k)))
+					{
+						return true;
+					}
+				}
+				return false;
+			}
+
+			std::string_view rest = pattern.substr(p + 1);
+			for (size_t k = t; k <= text.size(); ++k)
+			{
+				if (globMatch(rest, text.substr(k)))
+				{
+					return true;
+				}
+				if (k < text.size() && text[k] == '/')
+				{
+					break;
+				}
+			}
+			return false;
+		}
+
+		if (t >= text.size())
+		{
+			return false;
+		}
+		if (c == '?')
+		{
+			if (text[t] == '/')
+			{
+				return false;
+			}
+			++p;
+			++t;
+			continue;
+		}
+		if (c == '[')
+		{
+			size_t close = pattern.find(']', p + 2);
+			if (close != std::string_view::npos)
+			{
+				size_t i = p + 1;
+				bool negate = pattern[i] == '!' || pattern[i] == '^';
+				if (negate)
+				{
+					++i;
+				}
+				bool matched = false;
+				for (; i < close; ++i)
+				{
+					if (i + 2 < close && pattern[i + 1] == '-')
+					{
+						matched |= text[t] >= pattern[i] && text[t] <= pattern[i + 2];
+						i += 2;
+					} else
+					{
+						matched |= text[t] == pattern[i];
+					}
+				}
+				if (matched == negate || text[t] == '/')
+				{
+					return false;
+				}
+				p = close + 1;
+				++t;
+				continue;
+			}
+		}
+		if (c == '\\' && p + 1 < pattern.size())
+		{
+			c = pattern[++p];
+		}
+		if (c != text[t])
+		{
+			return false;
+		}
+		++p;
+		++t;
+	}
+	return t == text.size();
+}
@@ -0,0 +1,58 @@
+/*
+	File: ignore_rules.h
+	Description: .gitignore matching for workspace walks. Each directory with a
+   .gitignore gets one IgnoreRules node chained to its parent's, so a walker
+   carries a single pointer per directory and deeper files take precedence the
+   way git does.
+*/
+
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class IgnoreRules
+{
+  public:
+	// Reads `dir`/.gitignore when present and chains it to `parent`. Returns
+	// `parent` unchanged when the directory has no rules. `relative_dir` is the
+	// directory relative to the workspace root, "" for the root itself.
+	static std::shared_ptr<const IgnoreRules>
+	forDirectory(const std::filesystem::path &dir,
+				 const std::string &relative_dir,
+				 std::shared_ptr<const IgnoreRules> parent);
+
+	// `rules` may be null, meaning nothing is ignored
+	static bool isIgnored(const IgnoreRules *rules,
+						  std::string_view relative_path,
+						  bool is_dir);
+
+	// Entries a workspace walk never enters, ignore file or not: git's own
+	// directory and the search and symbol indexes with their temporary files
+	static bool isAlwaysSkipped(std::string_view name)
+	{
+		return name == ".git" || name.substr(0, 17) == ".ned-search-index" ||
+			   name.substr(0, 17) == ".ned-symbol-index";
+	}
+
+  private:
+	struct Rule
+	{
+		std::string pattern;
+		bool negate = false;
+		bool dir_only = false;
+		bool anchored = false; // Contains a slash: matched against the full path
+	};
+
+	std::string base; // Directory of the .gitignore, "" or ending in '/'
+	std::vector<Rule> rules;
+	std::shared_ptr<const IgnoreRules> parent;
+
+	void parse(const std::string &content);
+
+	// Glob with git semantics: '*' and '?' stop at '/', "**" does not
+	static bool globMatch(std::string_view pattern, std::string_view text);
+};
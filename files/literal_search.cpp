@@ -0,0 +1,179 @@
+/*
+	File: literal_search.cpp
+	Description: Vectorized first/last-byte filter with in-place verification.
+*/
+
+#include "literal_search.h"
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NED_SEARCH_SSE2 1
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define NED_SEARCH_NEON 1
+#endif
+
+namespace {
+
+inline unsigned char foldAscii(unsigned char c)
+{
+	return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c + ('a' - 'A')) : c;
+}
+
+inline unsigned char upperAscii(unsigned char c)
+{
+	return (c >= 'a' && c <= 'z') ? static_cast<unsigned char>(c - ('a' - 'A')) : c;
+}
+
+} // namespace
+
+LiteralSearch::LiteralSearch(const std::string &needle, bool ignoreCase)
+	: pattern(needle), ignore_case(ignoreCase)
+{
+	if (pattern.empty())
+	{
+		return;
+	}
+	if (ignore_case)
+	{
+		for (char &c : pattern)
+		{
+			c = static_cast<char>(foldAscii(static_cast<unsigned char>(c)));
+		}
+	}
+
+	first_lower = static_cast<unsigned char>(pattern.front());
+	last_lower = static_cast<unsigned char>(pattern.back());
+	first_upper = ignore_case ? upperAscii(first_lower) : first_lower;
+	last_upper = ignore_case ? upperAscii(last_lower) : last_lower;
+}
+
+bool LiteralSearch::matchesAt(const char *text) const
+{
+	if (!ignore_case)
+	{
+		return std::memcmp(text, pattern.data(), pattern.size()) == 0;
+	}
+	for (size_t i = 0; i < pattern.size(); ++i)
+	{
+		if (foldAscii(static_cast<unsigned char>(text[i])) !=
+			static_cast<unsigned char>(pattern[i]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void LiteralSearch::findAll(const char *text,
+							size_t begin,
+							size_t end,
+							std::vector<size_t> &out) const
+{
+	scan(text, begin, end, &out);
+}
+
+size_t LiteralSearch::findFirst(const char *text, size_t begin, size_t end) const
+{
+	return scan(text, begin, end, nullptr);
+}
+
+size_t LiteralSearch::scan(const char *text,
+						   size_t begin,
+						   size_t end,
+						   std::vector<size_t> *out) const
+{
+	const size_t k = pattern.size();
+	if (k == 0 || end < begin || end - begin < k)
+	{
+		return std::string::npos;
+	}
+
+	// Candidate starts are [begin, stop); the last byte of a candidate at p is
+	// text[p + k - 1], which stays below `end`
+	const size_t stop = end - k + 1;
+	size_t p = begin;
+
+	auto accept = [&](size_t pos) -> bool {
+		if (!matchesAt(text + pos))
+		{
+			return false;
+		}
+		if (out)
+		{
+			out->push_back(pos);
+			return false;
+		}
+		return true;
+	};
+
+#if defined(NED_SEARCH_SSE2)
+	const __m128i first_lo = _mm_set1_epi8(static_cast<char>(first_lower));
+	const __m128i first_up = _mm_set1_epi8(static_cast<char>(first_upper));
+	const __m128i last_lo = _mm_set1_epi8(static_cast<char>(last_lower));
+	const __m128i last_up = _mm_set1_epi8(static_cast<char>(last_upper));
+	for (; p + 16 <= stop; p += 16)
+	{
+		__m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + p));
+		__m128i tail =
+			_mm_loadu_si128(reinterpret_cast<const __m128i *>(text + p + k - 1));
+		__m128i head_eq =
+			_mm_or_si128(_mm_cmpeq_epi8(head, first_lo), _mm_cmpeq_epi8(head, first_up));
+		__m128i tail_eq =
+			_mm_or_si128(_mm_cmpeq_epi8(tail, last_lo), _mm_cmpeq_epi8(tail, last_up));
+		uint32_t mask =
+			static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(head_eq, tail_eq)));
+		while (mask)
+		{
+			size_t pos = p + std::countr_zero(mask);
+			if (accept(pos))
+			{
+				return pos;
+			}
+			mask &= mask - 1;
+		}
+	}
+#elif defined(NED_SEARCH_NEON)
+	const uint8x16_t first_lo = vdupq_n_u8(first_lower);
+	const uint8x16_t first_up = vdupq_n_u8(first_upper);
+	const uint8x16_t last_lo = vdupq_n_u8(last_lower);
+	const uint8x16_t last_up = vdupq_n_u8(last_upper);
+	for (; p + 16 <= stop; p += 16)
+	{
+		uint8x16_t head = vld1q_u8(reinterpret_cast<const uint8_t *>(text + p));
+		uint8x16_t tail = vld1q_u8(reinterpret_cast<const uint8_t *>(text + p + k - 1));
+		uint8x16_t head_eq = vorrq_u8(vceqq_u8(head, first_lo), vceqq_u8(head, first_up));
+		uint8x16_t tail_eq = vorrq_u8(vceqq_u8(tail, last_lo), vceqq_u8(tail, last_up));
+		// No movemask on NEON: narrowing leaves four bits per byte
+		uint64_t mask = vget_lane_u64(
+			vreinterpret_u64_u8(
+				vshrn_n_u16(vreinterpretq_u16_u8(vandq_u8(head_eq, tail_eq)), 4)),
+			0);
+		while (mask)
+		{
+			size_t pos = p + (std::countr_zero(mask) >> 2);
+			if (accept(pos))
+			{
+				return pos;
+			}
+			mask &= ~(uint64_t(0xF) << (std::countr_zero(mask) & ~3));
+		}
+	}
+#endif
+
+	for (; p < stop; ++p)
+	{
+		unsigned char head = static_cast<unsigned char>(text[p]);
+		unsigned char tail = static_cast<unsigned char>(text[p + k - 1]);
+		if ((head == first_lower || head == first_upper) &&
+			(tail == last_lower || tail == last_upper) && accept(p))
+		{
+			return p;
+		}
+	}
+	return std::string::npos;
+}
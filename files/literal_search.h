@@ -0,0 +1,51 @@
+/*
+	File: literal_search.h
+	Description: Plain-text substring search, optionally ASCII case-insensitive.
+   Candidates are found 16 bytes at a time by matching the needle's first and
+   last byte together, then verified in place, so the haystack is never copied
+   or lowercased.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class LiteralSearch
+{
+  public:
+	LiteralSearch() = default;
+	LiteralSearch(const std::string &needle, bool ignoreCase);
+
+	const std::string &needle() const { return pattern; }
+	bool ignoresCase() const { return ignore_case; }
+	size_t length() const { return pattern.size(); }
+	bool empty() const { return pattern.empty(); }
+
+	// Appends the start of every match lying wholly inside text[begin, end).
+	// Matches may overlap.
+	void findAll(const char *text,
+				 size_t begin,
+				 size_t end,
+				 std::vector<size_t> &out) const;
+
+	// First match inside text[begin, end), or std::string::npos
+	size_t findFirst(const char *text, size_t begin, size_t end) const;
+
+	bool matchesAt(const char *text) const;
+
+  private:
+	std::string pattern; // Lowercased when ignoring case
+	bool ignore_case = false;
+	unsigned char first_lower = 0;
+	unsigned char first_upper = 0;
+	unsigned char last_lower = 0;
+	unsigned char last_upper = 0;
+
+	// Shared scan; stops at the first match when `out` is null
+	size_t scan(const char *text,
+				size_t begin,
+				size_t end,
+				std::vector<size_t> *out) const;
+};
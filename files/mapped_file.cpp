@@ -0,0 +1,98 @@
+/*
+	File: mapped_file.cpp
+	Description: Read-only file mapping. See mapped_file.h.
+*/
+
+#include "mapped_file.h"
+
+#ifdef PLATFORM_WINDOWS
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+MappedFile::~MappedFile()
+{
+#ifdef PLATFORM_WINDOWS
+	if (ptr)
+		UnmapViewOfFile(ptr);
+	if (mappingHandle)
+		CloseHandle(mappingHandle);
+	if (fileHandle)
+		CloseHandle(fileHandle);
+#else
+	if (ptr)
+		munmap(const_cast<char *>(ptr), length);
+#endif
+}
+
+bool MappedFile::open(const fs::path &path)
+{
+#ifdef PLATFORM_WINDOWS
+	HANDLE file = CreateFileW(path.c_str(),
+							  GENERIC_READ,
+							  FILE_SHARE_READ | FILE_SHARE_DELETE,
+							  nullptr,
+							  OPEN_EXISTING,
+							  FILE_ATTRIBUTE_NORMAL,
+							  nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping)
+	{
+		CloseHandle(file);
+		return false;
+	}
+	void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!view)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	fileHandle = file;
+	mappingHandle = mapping;
+	ptr = static_cast<const char *>(view);
+	length = static_cast<size_t>(fileSize.QuadPart);
+	return true;
+#else
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+	void *view =
+		mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (view == MAP_FAILED)
+	{
+		return false;
+	}
+	ptr = static_cast<const char *>(view);
+	length = static_cast<size_t>(st.st_size);
+	return true;
+#endif
+}
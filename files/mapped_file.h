@@ -0,0 +1,31 @@
+/*
+	File: mapped_file.h
+	Description: Read-only memory mapping of a whole file, for the on-disk
+   workspace indexes. Empty files cannot be mapped and fail to open.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+class MappedFile
+{
+  public:
+	MappedFile() = default;
+	~MappedFile();
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	bool open(const std::filesystem::path &path);
+	const char *data() const { return ptr; }
+	size_t size() const { return length; }
+
+  private:
+	const char *ptr = nullptr;
+	size_t length = 0;
+#ifdef PLATFORM_WINDOWS
+	void *fileHandle = nullptr;
+	void *mappingHandle = nullptr;
+#endif
+};
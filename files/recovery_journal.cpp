@@ -0,0 +1,625 @@
+/*
+	File: recovery_journal.cpp
+	Description: Journaling edits of open buffers and replaying the journals
+   of sessions that crashed. See recovery_journal.h.
+*/
+
+#include "recovery_journal.h"
+#include "../util/redraw.h"
+#include "../util/settings.h"
+#include "files.h"
+
+#include <cerrno>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#ifdef PLATFORM_WINDOWS
+#include <io.h>
+#include <process.h>
+#include <windows.h>
+#else
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+RecoveryJournal gRecoveryJournal;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Journal layout: MAGIC, then records, each a type byte and its payload
+constexpr char MAGIC[6] = {'N', 'E', 'D', 'R', '2', '\0'};
+constexpr char RECORD_PATH = 'P';	// Path id, path: names the id from here on
+constexpr char RECORD_LOADED = 'L'; // Path id, 8 byte content hash
+constexpr char RECORD_SAVED = 'S';	// Path id, 8 byte content hash
+constexpr char RECORD_EDIT = 'E';	// Path id, position, removed, inserted
+
+void writeVarint(std::string &out, uint32_t value)
+{
+	while (value >= 0x80)
+	{
+		out.push_back(static_cast<char>(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<char>(value));
+}
+
+bool readVarint(std::string_view &in, uint32_t &value)
+{
+	value = 0;
+	for (int shift = 0; shift < 35 && !in.empty(); shift += 7)
+	{
+		uint8_t byte = static_cast<uint8_t>(in.front());
+		in.remove_prefix(1);
+		value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void writeString(std::string &out, std::string_view text)
+{
+	writeVarint(out, static_cast<uint32_t>(text.size()));
+	out.append(text);
+}
+
+bool readString(std::string_view &in, std::string &text)
+{
+	uint32_t size;
+	if (!readVarint(in, size) || size > in.size())
+	{
+		return false;
+	}
+	text.assign(in.substr(0, size));
+	in.remove_prefix(size);
+	return true;
+}
+
+// FNV-1a
+uint64_t contentHash(std::string_view text)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for (unsigned char c : text)
+	{
+		hash = (hash ^ c) * 1099511628211ull;
+	}
+	return hash;
+}
+
+int currentPid()
+{
+#ifdef PLATFORM_WINDOWS
+	return _getpid();
+#else
+	return static_cast<int>(getpid());
+#endif
+}
+
+bool processAlive(int pid)
+{
+#ifdef PLATFORM_WINDOWS
+	HANDLE process =
+		OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, static_cast<DWORD>(pid));
+	if (!process)
+	{
+		return false;
+	}
+	DWORD exitCode = 0;
+	bool alive = GetExitCodeProcess(process, &exitCode) && exitCode == STILL_ACTIVE;
+	CloseHandle(process);
+	return alive;
+#else
+	return kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM;
+#endif
+}
+
+void writeHash(std::string &out, uint64_t hash)
+{
+	for (int i = 0; i < 8; i++)
+	{
+		out.push_back(static_cast<char>(hash >> (i * 8)));
+	}
+}
+
+bool readHash(std::string_view &in, uint64_t &hash)
+{
+	if (in.size() < 8)
+	{
+		return false;
+	}
+	hash = 0;
+	for (int i = 0; i < 8; i++)
+	{
+		hash |= uint64_t(static_cast<uint8_t>(in[i])) << (i * 8);
+	}
+	in.remove_prefix(8);
+	return true;
+}
+
+bool readFile(const std::string &path, std::string &data)
+{
+	std::ifstream in(path, std::ios::binary);
+	if (!in)
+	{
+		return false;
+	}
+	data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	return true;
+}
+
+} // namespace
+
+RecoveryJournal::~RecoveryJournal()
+{
+	// Quitting without close(), e.g. from the crash handler: commit what is
+	// pending but keep the journal for the next start
+	if (writer.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wake.notify_one();
+		writer.join();
+	}
+	if (file)
+	{
+		std::fclose(file);
+	}
+}
+
+std::string RecoveryJournal::recoveryDir() const
+{
+	// Next to the settings directory, e.g. ~/ned/cache/recovery
+	fs::path settingsDir = fs::path(Settings::getUserSettingsPath()).parent_path();
+	return (settingsDir.parent_path() / "cache" / "recovery").string();
+}
+
+void RecoveryJournal::open()
+{
+	if (file)
+	{
+		return;
+	}
+	std::error_code ec;
+	fs::create_directories(recoveryDir(), ec);
+	filePath = (fs::path(recoveryDir()) /
+				("session-" + std::to_string(currentPid()) + ".bin"))
+				   .string();
+	file = std::fopen(filePath.c_str(), "wb");
+	if (!file)
+	{
+		std::cerr << "[Recovery] Cannot create " << filePath << std::endl;
+		return;
+	}
+	std::fwrite(MAGIC, 1, sizeof(MAGIC), file);
+	std::fflush(file);
+	writer = std::thread(&RecoveryJournal::writerLoop, this);
+}
+
+void RecoveryJournal::close()
+{
+	if (!writer.joinable())
+	{
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_one();
+	writer.join();
+	std::fclose(file);
+	file = nullptr;
+	std::error_code ec;
+	fs::remove(filePath, ec);
+}
+
+void RecoveryJournal::writerLoop()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true)
+	{
+		// Group commit: whatever piled up in the interval is one write and
+		// one fsync
+		wake.wait_for(lock, COMMIT_INTERVAL, [this] { return stopping; });
+		std::string records;
+		records.swap(pending);
+		bool truncate = rewind;
+		rewind = false;
+		bool stop = stopping;
+
+		lock.unlock();
+		if (truncate)
+		{
+			rewindFile();
+		}
+		commit(records);
+		lock.lock();
+		if (stop)
+		{
+			return;
+		}
+	}
+}
+
+void RecoveryJournal::commit(std::string &records)
+{
+	if (records.empty())
+	{
+		return;
+	}
+	std::fwrite(records.data(), 1, records.size(), file);
+	std::fflush(file);
+#ifdef PLATFORM_WINDOWS
+	_commit(_fileno(file));
+#else
+	fsync(fileno(file));
+#endif
+}
+
+void RecoveryJournal::rewindFile()
+{
+	std::fflush(file);
+#ifdef PLATFORM_WINDOWS
+	_chsize_s(_fileno(file), sizeof(MAGIC));
+#else
+	if (ftruncate(fileno(file), sizeof(MAGIC)) != 0)
+	{
+		std::cerr << "[Recovery] Cannot truncate " << filePath << std::endl;
+	}
+#endif
+	std::fseek(file, sizeof(MAGIC), SEEK_SET);
+}
+
+void RecoveryJournal::writePathId(const std::string &path)
+{
+	if (path != lastPath)
+	{
+		auto [it, inserted] =
+			pathIds.emplace(path, static_cast<uint32_t>(pathIds.size()));
+		if (inserted)
+		{
+			pending.push_back(RECORD_PATH);
+			writeVarint(pending, it->second);
+			writeString(pending, path);
+		}
+		lastPath = path;
+		lastPathId = it->second;
+	}
+	writeVarint(pending, lastPathId);
+}
+
+void RecoveryJournal::noteLoaded(const std::string &path, std::string_view content)
+{
+	if (!writer.joinable() || path.empty())
+	{
+		return;
+	}
+	uint64_t hash = contentHash(content);
+	unsavedPaths.erase(path);
+	std::lock_guard<std::mutex> lock(mutex);
+	pending.push_back(RECORD_LOADED);
+	writePathId(path);
+	writeHash(pending, hash);
+}
+
+void RecoveryJournal::noteSaved(const std::string &path, std::string_view content)
+{
+	if (!writer.joinable() || path.empty())
+	{
+		return;
+	}
+	uint64_t hash = contentHash(content);
+	unsavedPaths.erase(path);
+	std::lock_guard<std::mutex> lock(mutex);
+	if (unsavedPaths.empty())
+	{
+		// Nothing in the journal could be replayed any more, so start it over
+		// rather than let it grow by every edit of the session
+		pending.clear();
+		rewind = true;
+		pathIds.clear();
+		lastPath.clear();
+	}
+	pending.push_back(RECORD_SAVED);
+	writePathId(path);
+	writeHash(pending, hash);
+}
+
+void RecoveryJournal::noteEdit(const std::string &path,
+							   int position,
+							   std::string_view removed,
+							   std::string_view inserted)
+{
+	if (!writer.joinable() || path.empty())
+	{
+		return;
+	}
+	unsavedPaths.insert(path);
+	std::lock_guard<std::mutex> lock(mutex);
+	pending.push_back(RECORD_EDIT);
+	writePathId(path);
+	writeVarint(pending, static_cast<uint32_t>(position));
+	writeString(pending, removed);
+	writeString(pending, inserted);
+}
+
+bool RecoveryJournal::replay(const std::string &journal,
+							 std::vector<Recovered> &recovered)
+{
+	std::string data;
+	if (!readFile(journal, data) ||
+		data.compare(0, sizeof(MAGIC), MAGIC, sizeof(MAGIC)) != 0)
+	{
+		return false;
+	}
+
+	struct Edit
+	{
+		uint32_t position;
+		std::string removed;
+		std::string inserted;
+	};
+	// Edits since the file was last known to match the disk
+	struct FileState
+	{
+		std::string path;
+		bool loaded = false; // Or saved: `hash` is what the disk held
+		uint64_t hash = 0;
+		std::vector<Edit> edits;
+	};
+	std::unordered_map<uint32_t, FileState> files;
+
+	// Stops at the first torn record, which is where the crash hit
+	std::string_view in(data);
+	in.remove_prefix(sizeof(MAGIC));
+	while (!in.empty())
+	{
+		char type = in.front();
+		in.remove_prefix(1);
+		uint32_t id;
+		if (!readVarint(in, id))
+		{
+			break;
+		}
+		FileState &state = files[id];
+		if (type == RECORD_PATH)
+		{
+			if (!readString(in, state.path))
+			{
+				break;
+			}
+		} else if (type == RECORD_LOADED || type == RECORD_SAVED)
+		{
+			if (!readHash(in, state.hash))
+			{
+				break;
+			}
+			state.loaded = true;
+			state.edits.clear();
+		} else if (type == RECORD_EDIT)
+		{
+			Edit edit;
+			if (!readVarint(in, edit.position) || !readString(in, edit.removed) ||
+				!readString(in, edit.inserted))
+			{
+				break;
+			}
+			if (state.loaded)
+			{
+				state.edits.push_back(std::move(edit));
+			}
+		} else
+		{
+			break;
+		}
+	}
+
+	for (auto &[id, state] : files)
+	{
+		std::string disk;
+		if (state.edits.empty() || state.path.empty() || !readFile(state.path, disk))
+		{
+			continue;
+		}
+		// The disk must still hold what was last loaded or saved, or the edit
+		// positions no longer point where they did
+		if (contentHash(disk) != state.hash)
+		{
+			continue;
+		}
+		std::string content = disk;
+		bool valid = true;
+		for (const Edit &edit : state.edits)
+		{
+			if (edit.position > content.size() ||
+				content.compare(edit.position, edit.removed.size(), edit.removed) != 0)
+			{
+				valid = false;
+				break;
+			}
+			content.replace(edit.position, edit.removed.size(), edit.inserted);
+		}
+		if (valid && content != disk)
+		{
+			recovered.push_back({state.path, std::move(content), contentHash(disk)});
+		}
+	}
+	return true;
+}
+
+void RecoveryJournal::findAbandoned()
+{
+	std::vector<Recovered> found;
+	std::vector<std::string> journals;
+	std::error_code ec;
+	for (const auto &entry : fs::directory_iterator(recoveryDir(), ec))
+	{
+		std::string name = entry.path().filename().string();
+		if (name.rfind("session-", 0) != 0 || entry.path().string() == filePath)
+		{
+			continue;
+		}
+		int pid = std::atoi(name.c_str() + 8);
+		if (pid > 0 && processAlive(pid))
+		{
+			continue; // Another instance is still running
+		}
+		replay(entry.path().string(), found);
+		journals.push_back(entry.path().string());
+	}
+
+	if (found.empty())
+	{
+		for (const std::string &journal : journals)
+		{
+			fs::remove(journal, ec);
+		}
+		return;
+	}
+
+	std::cout << "[Recovery] Unsaved changes to " << found.size()
+			  << " files from a session that quit unexpectedly" << std::endl;
+	{
+		std::lock_guard<std::mutex> lock(abandonedMutex);
+		recovered = std::move(found);
+		abandonedJournals = std::move(journals);
+	}
+	promptReady = true;
+	gRedraw.request();
+}
+
+void RecoveryJournal::renderPrompt()
+{
+	if (!promptReady)
+	{
+		return;
+	}
+
+	ImGuiViewport *viewport = ImGui::GetMainViewport();
+	ImGui::SetNextWindowPos(viewport->GetCenter(), ImGuiCond_Always, ImVec2(0.5f, 0.5f));
+	ImGui::SetNextWindowSize(ImVec2(480, 0), ImGuiCond_Always);
+	ImVec4 background = gSettings.getSnapshot()->backgroundColor;
+	ImGui::PushStyleVar(ImGuiStyleVar_WindowRounding, 10.0f);
+	ImGui::PushStyleVar(ImGuiStyleVar_WindowBorderSize, 1.0f);
+	ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(16.0f, 16.0f));
+	ImGui::PushStyleColor(
+		ImGuiCol_WindowBg,
+		ImVec4(background.x * 0.8f, background.y * 0.8f, background.z * 0.8f, 1.0f));
+	ImGui::PushStyleColor(ImGuiCol_Border, ImVec4(0.3f, 0.3f, 0.3f, 1.0f));
+
+	ImGui::Begin("RecoveryPrompt",
+				 nullptr,
+				 ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize |
+					 ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse);
+	ImGui::TextWrapped("Ned quit without saving changes to these files:");
+	ImGui::Spacing();
+	{
+		std::lock_guard<std::mutex> lock(abandonedMutex);
+		for (const Recovered &file : recovered)
+		{
+			ImGui::BulletText("%s", fs::path(file.path).filename().string().c_str());
+			if (ImGui::IsItemHovered())
+			{
+				ImGui::SetTooltip("%s", file.path.c_str());
+			}
+		}
+	}
+	ImGui::Spacing();
+	bool restoreClicked = ImGui::Button("Recover");
+	ImGui::SameLine();
+	bool discardClicked = ImGui::Button("Discard");
+	ImGui::End();
+
+	ImGui::PopStyleColor(2);
+	ImGui::PopStyleVar(3);
+
+	if (restoreClicked)
+	{
+		restore();
+	} else if (discardClicked)
+	{
+		discard();
+	}
+}
+
+void RecoveryJournal::restore()
+{
+	std::vector<Recovered> files;
+	{
+		std::lock_guard<std::mutex> lock(abandonedMutex);
+		files = std::move(recovered);
+	}
+
+	int restored = 0;
+	std::vector<std::string> written;
+	for (const Recovered &file : files)
+	{
+		// The file may have been edited, even auto-saved, while the prompt
+		// was up; writing then would lose that
+		std::string disk;
+		if (!readFile(file.path, disk) || contentHash(disk) != file.diskHash)
+		{
+			std::cerr << "[Recovery] Skipping " << file.path
+					  << ", it changed since the journal was read" << std::endl;
+			continue;
+		}
+		std::ofstream out(file.path, std::ios::binary | std::ios::trunc);
+		if (out.write(file.content.data(), file.content.size()))
+		{
+			restored++;
+			written.push_back(file.path);
+		} else
+		{
+			std::cerr << "[Recovery] Cannot write " << file.path << std::endl;
+		}
+	}
+	discard();
+
+	if (!written.empty())
+	{
+		// Reload the open file if it was recovered, so its stale buffer isn't
+		// saved over the result; otherwise show the first one
+		std::string show = written.front();
+		for (const std::string &path : written)
+		{
+			if (path == gFileExplorer.currentFile)
+			{
+				show = path;
+			}
+		}
+		gFileExplorer._unsavedChanges = false;
+		gFileExplorer.loadFileContent(show);
+	}
+	std::string message = "Recovered " + std::to_string(restored) + " file(s)";
+	size_t skipped = files.size() - written.size();
+	if (skipped > 0)
+	{
+		message += ", " + std::to_string(skipped) + " not written";
+	}
+	gSettings.renderNotification(message, 3.0f);
+}
+
+void RecoveryJournal::discard()
+{
+	std::vector<std::string> journals;
+	{
+		std::lock_guard<std::mutex> lock(abandonedMutex);
+		journals = std::move(abandonedJournals);
+		abandonedJournals.clear();
+		recovered.clear();
+	}
+	std::error_code ec;
+	for (const std::string &journal : journals)
+	{
+		fs::remove(journal, ec);
+	}
+	promptReady = false;
+}
@@ -0,0 +1,100 @@
+/*
+	File: recovery_journal.h
+	Description: Crash recovery for unsaved buffers. Every edit of an open
+   buffer, and every load and save of one, is appended to a journal of this
+   session in ~/ned/cache/recovery. The UI thread only copies the record into
+   memory; a writer thread commits what piled up every 500 ms with one write
+   and one fsync. A save that leaves no buffer with unsaved edits cuts the
+   journal back to its header, as nothing before it could be replayed.
+
+   A clean exit deletes the journal. One left by a session that is no longer
+   running is replayed on the next start: for every file with edits after its
+   last save, they are applied to the file on disk, and the user is offered
+   to restore the result.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class RecoveryJournal
+{
+  public:
+	~RecoveryJournal();
+
+	// Starts this session's journal and its writer thread
+	void open();
+	// Looks for journals of sessions that quit without closing theirs. Reads
+	// files, so runs on a worker.
+	void findAbandoned();
+	// Commits and deletes this session's journal, as nothing needs recovering
+	void close();
+
+	// The buffer of `path` now matches the file on disk
+	void noteLoaded(const std::string &path, std::string_view content);
+	void noteSaved(const std::string &path, std::string_view content);
+	void noteEdit(const std::string &path,
+				  int position,
+				  std::string_view removed,
+				  std::string_view inserted);
+
+	// Offers to restore what findAbandoned() found
+	void renderPrompt();
+
+  private:
+	// A file an abandoned journal has unsaved edits for, as they would leave it
+	struct Recovered
+	{
+		std::string path;
+		std::string content;
+		uint64_t diskHash; // Of the file the edits were applied to
+	};
+
+	static constexpr std::chrono::milliseconds COMMIT_INTERVAL{500};
+
+	void writerLoop();
+	void commit(std::string &records);
+	// Cuts the journal back to its header
+	void rewindFile();
+	// Record prefix naming `path`, declaring it the first time it is seen
+	void writePathId(const std::string &path);
+	std::string recoveryDir() const;
+	static bool replay(const std::string &journal, std::vector<Recovered> &recovered);
+	void restore();
+	void discard();
+
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::string pending; // Records the writer has not taken yet
+	bool stopping = false;
+	bool rewind = false; // Truncate the journal before writing `pending`
+	std::thread writer;
+	std::FILE *file = nullptr;
+	std::string filePath;
+
+	// Path ids of this session; used on the UI thread only
+	std::unordered_map<std::string, uint32_t> pathIds;
+	std::string lastPath;
+	uint32_t lastPathId = 0;
+	// Paths with edits since they were last loaded or saved
+	std::unordered_set<std::string> unsavedPaths;
+
+	// Found by findAbandoned() on a worker, shown by renderPrompt()
+	std::mutex abandonedMutex;
+	std::vector<Recovered> recovered;
+	std::vector<std::string> abandonedJournals;
+	std::atomic<bool> promptReady{false};
+};
+
+extern RecoveryJournal gRecoveryJournal;
@@ -0,0 +1,963 @@
+/*
+	File: regex_search.cpp
+	Description: Pattern parser, Thompson NFA construction and the lazy DFA.
+*/
+
+#include "regex_search.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace {
+
+using NfaState = RegexSearch::NfaState;
+using ByteSetTable = RegexSearch::ByteSetTable;
+
+constexpr int MAX_REPEAT = 1000;
+constexpr size_t MAX_NFA_STATES = 20000;
+
+struct Node
+{
+	enum Type
+	{
+		Set,
+		Concat,
+		Alt,
+		Repeat,
+		Empty,
+		Begin,
+		End
+	};
+	Type type = Empty;
+	int set = -1;
+	int min = 0;
+	int max = 0; // -1 when unbounded
+	std::vector<Node> kids;
+};
+
+class Parser
+{
+  public:
+	Parser(const std::string &pattern, bool ignoreCase, ByteSetTable &sets)
+		: p(pattern), ignore_case(ignoreCase), sets(sets)
+	{
+	}
+
+	bool parse(Node &root, std::string &error)
+	{
+		bool ok = parseAlt(root);
+		if (ok && pos < p.size())
+		{
+			ok = fail("Unmatched )");
+		}
+		if (!ok)
+		{
+			error = message;
+		}
+		return ok;
+	}
+
+  private:
+	const std::string &p;
+	size_t pos = 0;
+	bool ignore_case;
+	ByteSetTable &sets;
+	std::string message;
+
+	bool fail(const std::string &text)
+	{
+		message = text;
+		return false;
+	}
+
+	int addSet(std::bitset<256> set, bool fold)
+	{
+		if (fold && ignore_case)
+		{
+			for (int c = 'a'; c <= 'z'; ++c)
+			{
+				if (set.test(c) || set.test(c - 'a' + 'A'))
+				{
+					set.set(c);
+					set.set(c - 'a' + 'A');
+				}
+			}
+		}
+		sets.push_back(set);
+		return static_cast<int>(sets.size()) - 1;
+	}
+
+	static Node setNode(int set)
+	{
+		Node node;
+		node.type = Node::Set;
+		node.set = set;
+		return node;
+	}
+
+	bool parseAlt(Node &out)
+	{
+		Node first;
+		if (!parseConcat(first))
+		{
+			return false;
+		}
+		if (pos >= p.size() || p[pos] != '|')
+		{
+			out = std::move(first);
+			return true;
+		}
+
+		out = Node();
+		out.type = Node::Alt;
+		out.kids.push_back(std::move(first));
+		while (pos < p.size() && p[pos] == '|')
+		{
+			++pos;
+			Node next;
+			if (!parseConcat(next))
+			{
+				return false;
+			}
+			out.kids.push_back(std::move(next));
+		}
+		return true;
+	}
+
+	bool parseConcat(Node &out)
+	{
+		out = Node();
+		out.type = Node::Concat;
+		while (pos < p.size() && p[pos] != '|' && p[pos] != ')')
+		{
+			Node item;
+			if (!parseRepeat(item))
+			{
+				return false;
+			}
+			out.kids.push_back(std::move(item));
+		}
+		if (out.kids.empty())
+		{
+			out.type = Node::Empty;
+		} else if (out.kids.size() == 1)
+		{
+			Node only = std::move(out.kids[0]);
+			out = std::move(only);
+		}
+		return true;
+	}
+
+	// {m}, {m,} or {m,n}; anything else leaves '{' to be read as a literal
+	bool parseBraces(int &min, int &max)
+	{
+		size_t i = pos + 1;
+		auto number = [&](int &value) {
+			size_t digits_start = i;
+			value = 0;
+			while (i < p.size() && std::isdigit(static_cast<unsigned char>(p[i])) &&
+				   value <= MAX_REPEAT)
+			{
+				value = value * 10 + (p[i++] - '0');
+			}
+			return i > digits_start;
+		};
+
+		if (!number(min))
+		{
+			return false;
+		}
+		max = min;
+		if (i < p.size() && p[i] == ',')
+		{
+			++i;
+			if (!number(max))
+			{
+				max = -1;
+			}
+		}
+		if (i >= p.size() || p[i] != '}')
+		{
+			return false;
+		}
+		pos = i + 1;
+		return true;
+	}
+
+	bool parseRepeat(Node &out)
+	{
+		if (!parseAtom(out))
+		{
+			return false;
+		}
+
+		while (pos < p.size())
+		{
+			int min;
+			int max;
+			char c = p[pos];
+			if (c == '*' || c == '+' || c == '?')
+			{
+				min = c == '+' ? 1 : 0;
+				max = c == '?' ? 1 : -1;
+				++pos;
+			} else if (c != '{' || !parseBraces(min, max))
+			{
+				break;
+			}
+
+			if (min > MAX_REPEAT || max > MAX_REPEAT || (max >= 0 && max < min))
+			{
+				return fail("Invalid repetition count");
+			}
+			// Lazy quantifiers mean nothing under leftmost-longest matching
+			if (pos < p.size() && p[pos] == '?')
+			{
+				++pos;
+			}
+
+			Node repeat;
+			repeat.type = Node::Repeat;
+			repeat.min = min;
+			repeat.max = max;
+			repeat.kids.push_back(std::move(out));
+			out = std::move(repeat);
+		}
+		return true;
+	}
+
+	bool parseAtom(Node &out)
+	{
+		unsigned char c = static_cast<unsigned char>(p[pos++]);
+		switch (c)
+		{
+		case '(':
+			if (p.compare(pos, 2, "?:") == 0)
+			{
+				pos += 2;
+			} else if (pos < p.size() && p[pos] == '?')
+			{
+				return fail("Unsupported group syntax");
+			}
+			if (!parseAlt(out))
+			{
+				return false;
+			}
+			if (pos >= p.size() || p[pos] != ')')
+			{
+				return fail("Missing )");
+			}
+			++pos;
+			return true;
+		case '[':
+		{
+			std::bitset<256> set;
+			if (!parseClass(set))
+			{
+				return false;
+			}
+			out = setNode(addSet(set, false));
+			return true;
+		}
+		case '.':
+		{
+			std::bitset<256> set;
+			set.set();
+			set.reset('\n');
+			out = setNode(addSet(set, false));
+			return true;
+		}
+		case '^':
+			out = Node();
+			out.type = Node::Begin;
+			return true;
+		case '$':
+			out = Node();
+			out.type = Node::End;
+			return true;
+		case '\\':
+		{
+			std::bitset<256> set;
+			int single;
+			if (!parseEscape(set, single))
+			{
+				return false;
+			}
+			out = setNode(addSet(set, true));
+			return true;
+		}
+		case '*':
+		case '+':
+		case '?':
+			return fail("Nothing to repeat");
+		default:
+		{
+			std::bitset<256> set;
+			set.set(c);
+			out = setNode(addSet(set, true));
+			return true;
+		}
+		}
+	}
+
+	// After a backslash. `single` is the byte for escapes naming one character,
+	// -1 for classes like \d.
+	bool parseEscape(std::bitset<256> &set, int &single)
+	{
+		if (pos >= p.size())
+		{
+			return fail("Trailing backslash");
+		}
+		unsigned char c = static_cast<unsigned char>(p[pos++]);
+		auto range = [&set](int lo, int hi) {
+			for (int b = lo; b <= hi; ++b)
+			{
+				set.set(b);
+			}
+		};
+		auto negate = [&set]() {
+			set.flip();
+			set.reset('\n');
+		};
+
+		single = -1;
+		switch (c)
+		{
+		case 'd':
+		case 'D':
+			range('0', '9');
+			break;
+		case 'w':
+		case 'W':
+			range('a', 'z');
+			range('A', 'Z');
+			range('0', '9');
+			set.set('_');
+			break;
+		case 's':
+		case 'S':
+			for (char space : {' ', '\t', '\n', '\r', '\f', '\v'})
+			{
+				set.set(static_cast<unsigned char>(space));
+			}
+			break;
+		case 't':
+			single = '\t';
+			break;
+		case 'n':
+			single = '\n';
+			break;
+		case 'r':
+			single = '\r';
+			break;
+		case 'f':
+			single = '\f';
+			break;
+		case 'v':
+			single = '\v';
+			break;
+		case 'x':
+		{
+			if (pos + 2 > p.size() ||
+				!std::isxdigit(static_cast<unsigned char>(p[pos])) ||
+				!std::isxdigit(static_cast<unsigned char>(p[pos + 1])))
+			{
+				return fail("Invalid \\x escape");
+			}
+			single = std::stoi(p.substr(pos, 2), nullptr, 16);
+			pos += 2;
+			break;
+		}
+		default:
+			if (std::isalnum(c))
+			{
+				return fail(std::string("Unsupported escape \\") + static_cast<char>(c));
+			}
+			single = c;
+			break;
+		}
+
+		if (c == 'D' || c == 'W' || c == 'S')
+		{
+			negate();
+		}
+		if (single >= 0)
+		{
+			set.set(single);
+		}
+		return true;
+	}
+
+	// After the opening bracket
+	bool parseClass(std::bitset<256> &set)
+	{
+		bool negated = pos < p.size() && p[pos] == '^';
+		if (negated)
+		{
+			++pos;
+		}
+
+		bool first = true;
+		while (true)
+		{
+			if (pos >= p.size())
+			{
+				return fail("Missing ]");
+			}
+			unsigned char c = static_cast<unsigned char>(p[pos++]);
+			if (c == ']' && !first)
+			{
+				break;
+			}
+			first = false;
+
+			int lo = c;
+			if (c == '\\')
+			{
+				std::bitset<256> escaped;
+				if (!parseEscape(escaped, lo))
+				{
+					return false;
+				}
+				if (lo < 0)
+				{
+					set |= escaped;
+					continue;
+				}
+			}
+
+			if (pos + 1 < p.size() && p[pos] == '-' && p[pos + 1] != ']')
+			{
+				++pos;
+				int hi = static_cast<unsigned char>(p[pos++]);
+				if (hi == '\\')
+				{
+					std::bitset<256> escaped;
+					if (!parseEscape(escaped, hi))
+					{
+						return false;
+					}
+				}
+				if (hi < lo)
+				{
+					return fail("Invalid range in character class");
+				}
+				for (int b = lo; b <= hi; ++b)
+				{
+					set.set(b);
+				}
+			} else
+			{
+				set.set(lo);
+			}
+		}
+
+		// Fold before negating so [^a] excludes 'A' as well
+		if (ignore_case)
+		{
+			for (int c = 'a'; c <= 'z'; ++c)
+			{
+				if (set.test(c) || set.test(c - 'a' + 'A'))
+				{
+					set.set(c);
+					set.set(c - 'a' + 'A');
+				}
+			}
+		}
+		if (negated)
+		{
+			set.flip();
+			set.reset('\n');
+		}
+		return true;
+	}
+};
+
+// Thompson construction, built back to front: each node is compiled with
+// the state that follows it already known. The reversed NFA matches the
+// reversed language, with the line anchors swapped.
+class NfaBuilder
+{
+  public:
+	NfaBuilder(std::vector<NfaState> &states, bool reversed)
+		: states(states), reversed(reversed)
+	{
+	}
+
+	int build(const Node &root)
+	{
+		int match = add(NfaState::Match, -1, -1);
+		int start = build(root, match);
+		return states.size() > MAX_NFA_STATES ? -1 : start;
+	}
+
+  private:
+	std::vector<NfaState> &states;
+	bool reversed;
+
+	int add(NfaState::Kind kind, int set, int out, int out1 = -1)
+	{
+		NfaState state;
+		state.kind = kind;
+		state.set = set;
+		state.out = out;
+		state.out1 = out1;
+		states.push_back(state);
+		return static_cast<int>(states.size()) - 1;
+	}
+
+	int build(const Node &node, int next)
+	{
+		if (states.size() > MAX_NFA_STATES)
+		{
+			return next;
+		}
+
+		switch (node.type)
+		{
+		case Node::Empty:
+			return next;
+		case Node::Set:
+			return add(NfaState::ByteSet, node.set, next);
+		case Node::Begin:
+			return add(reversed ? NfaState::LineEnd : NfaState::LineBegin, -1, next);
+		case Node::End:
+			return add(reversed ? NfaState::LineBegin : NfaState::LineEnd, -1, next);
+		case Node::Concat:
+			if (reversed)
+			{
+				for (const Node &kid : node.kids)
+				{
+					next = build(kid, next);
+				}
+			} else
+			{
+				for (auto it = node.kids.rbegin(); it != node.kids.rend(); ++it)
+				{
+					next = build(*it, next);
+				}
+			}
+			return next;
+		case Node::Alt:
+		{
+			int branches = build(node.kids.back(), next);
+			for (size_t i = node.kids.size() - 1; i-- > 0;)
+			{
+				int branch = build(node.kids[i], next);
+				branches = add(NfaState::Split, -1, branch, branches);
+			}
+			return branches;
+		}
+		case Node::Repeat:
+		{
+			const Node &body = node.kids[0];
+			int current = next;
+			if (node.max < 0)
+			{
+				int loop = add(NfaState::Split, -1, -1, next);
+				int start = build(body, loop);
+				states[loop].out = start;
+				current = loop;
+			} else
+			{
+				// x{0,2} is (x(x)?)?
+				for (int i = node.min; i < node.max; ++i)
+				{
+					int start = build(body, current);
+					current = add(NfaState::Split, -1, start, next);
+				}
+			}
+			for (int i = 0; i < node.min; ++i)
+			{
+				current = build(body, current);
+			}
+			return current;
+		}
+		}
+		return next;
+	}
+};
+
+} // namespace
+
+bool RegexSearch::compile(const std::string &pattern, bool ignoreCase, std::string &error)
+{
+	compiled = false;
+
+	ByteSetTable sets;
+	Node root;
+	Parser parser(pattern, ignoreCase, sets);
+	if (!parser.parse(root, error))
+	{
+		return false;
+	}
+
+	std::vector<NfaState> forward_nfa;
+	std::vector<NfaState> reverse_nfa;
+	int forward_start = NfaBuilder(forward_nfa, false).build(root);
+	int reverse_start = NfaBuilder(reverse_nfa, true).build(root);
+	if (forward_start < 0 || reverse_start < 0)
+	{
+		error = "Pattern is too large";
+		return false;
+	}
+
+	forward.reset(std::move(forward_nfa), sets, forward_start, false);
+	reverse.reset(std::move(reverse_nfa), std::move(sets), reverse_start, true);
+	compiled = true;
+	return true;
+}
+
+void RegexSearch::findAll(const char *text,
+						  size_t begin,
+						  size_t end,
+						  std::vector<std::pair<size_t, size_t>> &out)
+{
+	if (!compiled)
+	{
+		return;
+	}
+
+	size_t line_start = begin;
+	while (line_start <= end)
+	{
+		const void *newline = std::memchr(text + line_start, '\n', end - line_start);
+		size_t line_end =
+			newline ? static_cast<const char *>(newline) - text : end;
+		scanLine(text, line_start, line_end, out);
+		if (!newline)
+		{
+			break;
+		}
+		line_start = line_end + 1;
+	}
+}
+
+void RegexSearch::scanLine(const char *text,
+						   size_t line_start,
+						   size_t line_end,
+						   std::vector<std::pair<size_t, size_t>> &out)
+{
+	const size_t length = line_end - line_start;
+	const unsigned char *line =
+		reinterpret_cast<const unsigned char *>(text + line_start);
+
+	// Backwards over the reversed pattern: wherever it accepts, some match
+	// starts. Lines without any are rejected in this one pass.
+	can_start.assign(length + 1, 0);
+	bool any = false;
+	int state = reverse.startState(true);
+	can_start[length] = reverse.accepts(state, length == 0);
+	for (size_t i = length; i-- > 0;)
+	{
+		state = reverse.step(state, line[i]);
+		can_start[i] = reverse.accepts(state, i == 0);
+		any = any || can_start[i];
+	}
+	if (!any)
+	{
+		return;
+	}
+
+	// Plain scans are cheapest while they stay short; past this many bytes on
+	// one line they are memoized instead
+	const size_t budget = 4 * length + 256;
+	size_t steps = 0;
+	longest.clear();
+
+	size_t pos = 0;
+	while (pos < length)
+	{
+		while (pos < length && !can_start[pos])
+		{
+			++pos;
+		}
+		if (pos >= length)
+		{
+			break;
+		}
+
+		size_t best = steps < budget ? longestMatch(line, length, pos, steps)
+									 : longestMatchMemoized(line, length, pos);
+		if (best > pos)
+		{
+			out.emplace_back(line_start + pos, line_start + best);
+			pos = best;
+		} else
+		{
+			++pos;
+		}
+	}
+}
+
+size_t RegexSearch::longestMatch(const unsigned char *line,
+								 size_t length,
+								 size_t pos,
+								 size_t &steps)
+{
+	size_t best = pos;
+	int state = forward.startState(pos == 0);
+	for (size_t i = pos; i < length; ++i)
+	{
+		++steps;
+		state = forward.step(state, line[i]);
+		if (state == Dfa::DEAD)
+		{
+			break;
+		}
+		if (forward.accepts(state, i + 1 == length))
+		{
+			best = i + 1;
+		}
+	}
+	return best;
+}
+
+size_t RegexSearch::longestMatchMemoized(const unsigned char *line,
+										 size_t length,
+										 size_t pos)
+{
+	constexpr size_t NO_MATCH = SIZE_MAX;
+	auto key = [](size_t offset, int state) {
+		return (uint64_t(offset) << 16) | uint64_t(state);
+	};
+
+	// Scan until the DFA dies, the line ends or a pair an earlier scan
+	// already resolved comes up
+	const uint32_t generation = forward.generation();
+	size_t tail = NO_MATCH;
+	size_t i = pos;
+	int state = forward.startState(pos == 0);
+	path.clear();
+	while (true)
+	{
+		auto known = longest.find(key(i, state));
+		if (known != longest.end())
+		{
+			tail = known->second;
+			break;
+		}
+		path.emplace_back(i, state);
+		if (i == length)
+		{
+			break;
+		}
+		state = forward.step(state, line[i++]);
+		if (state == Dfa::DEAD)
+		{
+			break;
+		}
+	}
+
+	// A flushed cache reuses state ids, so nothing recorded holds any more
+	if (forward.generation() != generation)
+	{
+		longest.clear();
+		size_t steps = 0;
+		return longestMatch(line, length, pos, steps);
+	}
+
+	// Back along the path, the longest match on is the one found further
+	// ahead, or else the pair itself when it accepts
+	for (auto it = path.rbegin(); it != path.rend(); ++it)
+	{
+		if (tail == NO_MATCH && forward.accepts(it->second, it->first == length))
+		{
+			tail = it->first;
+		}
+		longest[key(it->first, it->second)] = tail;
+	}
+	return tail == NO_MATCH ? pos : tail;
+}
+
+void RegexSearch::Dfa::reset(std::vector<NfaState> nfa_states,
+							 ByteSetTable byte_sets,
+							 int start,
+							 bool unanchored_search)
+{
+	nfa = std::move(nfa_states);
+	sets = std::move(byte_sets);
+	nfa_start = start;
+	unanchored = unanchored_search;
+	marks.assign(nfa.size(), 0);
+	mark_generation = 0;
+	clearCache();
+}
+
+void RegexSearch::Dfa::clearCache()
+{
+	cache_generation++;
+	states.clear();
+	ids.clear();
+	starts[0] = starts[1] = -1;
+
+	State dead;
+	dead.next.fill(DEAD);
+	states.push_back(std::move(dead));
+	ids[{}] = DEAD;
+}
+
+int RegexSearch::Dfa::startState(bool at_line_begin)
+{
+	int &start = starts[at_line_begin ? 1 : 0];
+	if (start < 0)
+	{
+		start = intern(closure({nfa_start}, at_line_begin));
+	}
+	return start;
+}
+
+int RegexSearch::Dfa::step(int state, unsigned char byte)
+{
+	int cached = states[state].next[byte];
+	if (cached >= 0)
+	{
+		return cached;
+	}
+
+	// Callers only keep the returned state, so the cache can go at any step
+	if (states.size() >= MAX_STATES)
+	{
+		std::vector<int> current = states[state].nfa;
+		clearCache();
+		state = intern(std::move(current));
+	}
+
+	std::vector<int> seeds;
+	for (int s : states[state].nfa)
+	{
+		const NfaState &nfa_state = nfa[s];
+		if (nfa_state.kind == NfaState::ByteSet && sets[nfa_state.set].test(byte))
+		{
+			seeds.push_back(nfa_state.out);
+		}
+	}
+	if (unanchored)
+	{
+		seeds.push_back(nfa_start);
+	}
+
+	int next = intern(closure(std::move(seeds), false));
+	states[state].next[byte] = next;
+	return next;
+}
+
+std::vector<int> RegexSearch::Dfa::closure(std::vector<int> seeds, bool at_line_begin)
+{
+	if (++mark_generation == 0)
+	{
+		std::fill(marks.begin(), marks.end(), 0);
+		mark_generation = 1;
+	}
+
+	// Keeps the states that consume a byte, accept, or wait for the line end
+	std::vector<int> result;
+	std::vector<int> &stack = seeds;
+	while (!stack.empty())
+	{
+		int s = stack.back();
+		stack.pop_back();
+		if (s < 0 || marks[s] == mark_generation)
+		{
+			continue;
+		}
+		marks[s] = mark_generation;
+
+		const NfaState &nfa_state = nfa[s];
+		switch (nfa_state.kind)
+		{
+		case NfaState::Split:
+			stack.push_back(nfa_state.out1);
+			stack.push_back(nfa_state.out);
+			break;
+		case NfaState::Empty:
+			stack.push_back(nfa_state.out);
+			break;
+		case NfaState::LineBegin:
+			if (at_line_begin)
+			{
+				stack.push_back(nfa_state.out);
+			}
+			break;
+		case NfaState::ByteSet:
+		case NfaState::LineEnd:
+		case NfaState::Match:
+			result.push_back(s);
+			break;
+		}
+	}
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+bool RegexSearch::Dfa::reachesMatch(std::vector<int> seeds)
+{
+	if (++mark_generation == 0)
+	{
+		std::fill(marks.begin(), marks.end(), 0);
+		mark_generation = 1;
+	}
+
+	std::vector<int> &stack = seeds;
+	while (!stack.empty())
+	{
+		int s = stack.back();
+		stack.pop_back();
+		if (s < 0 || marks[s] == mark_generation)
+		{
+			continue;
+		}
+		marks[s] = mark_generation;
+
+		const NfaState &nfa_state = nfa[s];
+		switch (nfa_state.kind)
+		{
+		case NfaState::Match:
+			return true;
+		case NfaState::Split:
+			stack.push_back(nfa_state.out1);
+			stack.push_back(nfa_state.out);
+			break;
+		case NfaState::Empty:
+		case NfaState::LineEnd:
+			stack.push_back(nfa_state.out);
+			break;
+		default:
+			break;
+		}
+	}
+	return false;
+}
+
+int RegexSearch::Dfa::intern(std::vector<int> set)
+{
+	auto it = ids.find(set);
+	if (it != ids.end())
+	{
+		return it->second;
+	}
+
+	State state;
+	state.next.fill(-1);
+
+	// Accepting at the line end may first pass any number of $ assertions
+	std::vector<int> at_end;
+	for (int s : set)
+	{
+		if (nfa[s].kind == NfaState::Match)
+		{
+			state.accept = true;
+		} else if (nfa[s].kind == NfaState::LineEnd)
+		{
+			at_end.push_back(nfa[s].out);
+		}
+	}
+	state.accept_at_end = state.accept || reachesMatch(std::move(at_end));
+
+	state.nfa = std::move(set);
+	int id = static_cast<int>(states.size());
+	ids[state.nfa] = id;
+	states.push_back(std::move(state));
+	return id;
+}
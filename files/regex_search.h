@@ -0,0 +1,129 @@
+/*
+	File: regex_search.h
+	Description: Regular expressions for searching text. Patterns compile to a
+   Thompson NFA that is turned into a DFA lazily, one state and one byte at a
+   time as the text asks for it, so scanning is linear with no backtracking.
+   The price is no capture groups, backreferences or lookaround.
+
+   Matches are leftmost-longest and never cross a newline: each line is
+   scanned backwards once to find where matches can start, then forwards from
+   each start for the longest match. Once those forward scans overlap too
+   much, the longest match on from every (position, state) pair reached is
+   remembered, so no pair is scanned twice and a line costs at most its length
+   times the number of DFA states.
+*/
+
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class RegexSearch
+{
+  public:
+	// Returns false and fills `error` when the pattern is invalid or unsupported
+	bool compile(const std::string &pattern, bool ignoreCase, std::string &error);
+	bool valid() const { return compiled; }
+
+	// Appends [start, end) of every non-empty match inside text[begin, end),
+	// which must start at a line start
+	void findAll(const char *text,
+				 size_t begin,
+				 size_t end,
+				 std::vector<std::pair<size_t, size_t>> &out);
+
+	struct NfaState
+	{
+		enum Kind : uint8_t
+		{
+			ByteSet,
+			Split,
+			Empty,
+			LineBegin,
+			LineEnd,
+			Match
+		};
+		Kind kind;
+		int set = -1; // Index into the byte sets, for ByteSet
+		int out = -1;
+		int out1 = -1; // Second branch of Split
+	};
+	using ByteSetTable = std::vector<std::bitset<256>>;
+
+  private:
+	// DFA over one NFA, built on demand and flushed when it grows too large
+	class Dfa
+	{
+	  public:
+		static constexpr int DEAD = 0;
+
+		void reset(std::vector<NfaState> nfa_states,
+				   ByteSetTable byte_sets,
+				   int start,
+				   bool unanchored_search);
+		int startState(bool at_line_begin);
+		int step(int state, unsigned char byte);
+		bool accepts(int state, bool at_line_end) const
+		{
+			return at_line_end ? states[state].accept_at_end : states[state].accept;
+		}
+		// Changes whenever the cache is flushed and state ids are reused
+		uint32_t generation() const { return cache_generation; }
+
+	  private:
+		static constexpr size_t MAX_STATES = 2048;
+
+		struct State
+		{
+			std::vector<int> nfa; // Sorted NFA states after the epsilon closure
+			bool accept = false;
+			bool accept_at_end = false;
+			std::array<int, 256> next;
+		};
+
+		std::vector<NfaState> nfa;
+		ByteSetTable sets;
+		int nfa_start = -1;
+		bool unanchored = false;
+
+		std::vector<State> states;
+		std::map<std::vector<int>, int> ids;
+		int starts[2] = {-1, -1};
+
+		std::vector<int> marks;
+		int mark_generation = 0;
+		uint32_t cache_generation = 0;
+
+		void clearCache();
+		std::vector<int> closure(std::vector<int> seeds, bool at_line_begin);
+		// Whether the seeds reach a match through $ assertions alone
+		bool reachesMatch(std::vector<int> seeds);
+		int intern(std::vector<int> set);
+	};
+
+	bool compiled = false;
+	Dfa forward; // Anchored at the match start
+	Dfa reverse; // Reversed pattern, unanchored, run from the line end
+	std::vector<uint8_t> can_start;
+	// End of the longest match on from (offset << 16 | forward state), or
+	// NO_MATCH; per line, once the scans overlap too much
+	std::unordered_map<uint64_t, size_t> longest;
+	std::vector<std::pair<size_t, int>> path;
+
+	void scanLine(const char *text,
+				  size_t line_start,
+				  size_t line_end,
+				  std::vector<std::pair<size_t, size_t>> &out);
+	// End of the longest match starting at `pos`, or `pos` when there is none.
+	// `steps` counts the bytes scanned.
+	size_t
+	longestMatch(const unsigned char *line, size_t length, size_t pos, size_t &steps);
+	size_t longestMatchMemoized(const unsigned char *line, size_t length, size_t pos);
+};
@@ -0,0 +1,1214 @@
+/*
+	File: symbol_index.cpp
+	Description: Parsing, storing and querying workspace symbols.
+*/
+
+#include "symbol_index.h"
+#include "../editor/editor_tree_sitter.h"
+#include "../util/redraw.h"
+#include "../util/settings.h"
+#include "workspace_index.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <tree_sitter/api.h>
+
+SymbolIndex gSymbolIndex;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char MAGIC[8] = {'N', 'E', 'D', 'S', 'Y', 'M', 'B', '\0'};
+
+// Longer names are not worth jumping to, and longer containers are dropped
+constexpr size_t MAX_NAME = 255;
+constexpr size_t MAX_CONTAINER = 512;
+
+// Extensions TreeSitter knows a grammar for that may have a tag query
+constexpr const char *EXTENSIONS[] = {".c",
+									  ".h",
+									  ".cpp",
+									  ".hpp",
+									  ".mm",
+									  ".js",
+									  ".jsx",
+									  ".ts",
+									  ".tsx",
+									  ".py",
+									  ".cs",
+									  ".java",
+									  ".go",
+									  ".sh",
+									  ".kt",
+									  ".rs",
+									  ".rb"};
+
+// Relative paths are kept as the workspace index lists them, with native
+// separators
+std::string nativeUtf8(fs::path path)
+{
+#ifdef PLATFORM_WINDOWS
+	auto u8 = path.make_preferred().u8string();
+	return std::string(u8.begin(), u8.end());
+#else
+	return path.string();
+#endif
+}
+
+fs::path pathFromUtf8(const std::string &path)
+{
+#ifdef PLATFORM_WINDOWS
+	return fs::u8path(path);
+#else
+	return fs::path(path);
+#endif
+}
+
+char toLower(char c) { return c >= 'A' && c <= 'Z' ? static_cast<char>(c + 32) : c; }
+
+std::string_view extensionOf(std::string_view relative)
+{
+	size_t dot = relative.rfind('.');
+	size_t slash = relative.find_last_of("/\\");
+	// No extension, or a dotfile
+	if (dot == std::string_view::npos ||
+		(slash != std::string_view::npos && dot < slash) || dot == slash + 1)
+	{
+		return {};
+	}
+	return relative.substr(dot);
+}
+
+bool statFile(const fs::path &path, uint64_t &size, int64_t &mtime)
+{
+	std::error_code ec;
+	size = fs::file_size(path, ec);
+	if (ec)
+	{
+		return false;
+	}
+	auto time = fs::last_write_time(path, ec);
+	mtime = static_cast<int64_t>(time.time_since_epoch().count());
+	return !ec;
+}
+
+SymbolKind kindFromCapture(std::string_view kind)
+{
+	static const std::pair<std::string_view, SymbolKind> kinds[] = {
+		{"function", SymbolKind::Function},
+		{"method", SymbolKind::Method},
+		{"class", SymbolKind::Class},
+		{"struct", SymbolKind::Struct},
+		{"interface", SymbolKind::Interface},
+		{"enum", SymbolKind::Enum},
+		{"type", SymbolKind::Type},
+		{"namespace", SymbolKind::Namespace},
+		{"module", SymbolKind::Namespace},
+		{"macro", SymbolKind::Macro},
+		{"constant", SymbolKind::Constant},
+		{"property", SymbolKind::Property}};
+	for (const auto &[name, value] : kinds)
+	{
+		if (kind == name)
+		{
+			return value;
+		}
+	}
+	return SymbolKind::Other;
+}
+
+} // namespace
+
+const char *symbolKindName(SymbolKind kind)
+{
+	switch (kind)
+	{
+	case SymbolKind::Function:
+		return "function";
+	case SymbolKind::Method:
+		return "method";
+	case SymbolKind::Class:
+		return "class";
+	case SymbolKind::Struct:
+		return "struct";
+	case SymbolKind::Interface:
+		return "interface";
+	case SymbolKind::Enum:
+		return "enum";
+	case SymbolKind::Type:
+		return "type";
+	case SymbolKind::Namespace:
+		return "namespace";
+	case SymbolKind::Macro:
+		return "macro";
+	case SymbolKind::Constant:
+		return "constant";
+	case SymbolKind::Property:
+		return "property";
+	case SymbolKind::Other:
+		break;
+	}
+	return "symbol";
+}
+
+const SymbolSnapshot::Segment &SymbolSnapshot::segmentOf(uint32_t &id) const
+{
+	if (id < base.symbolCount)
+	{
+		return base;
+	}
+	id -= base.symbolCount;
+	return overlay;
+}
+
+bool SymbolSnapshot::live(uint32_t id) const
+{
+	return id >= base.symbolCount || !shadowed[base.symbols[id].fileId];
+}
+
+int SymbolSnapshot::score(const FuzzyQuery &query, uint32_t id) const
+{
+	const Segment &segment = segmentOf(id);
+	const SymbolRecord &symbol = segment.symbols[id];
+	return query.score(segment.textOf(symbol),
+					   std::string_view(segment.lower + symbol.textOffset,
+										symbol.textLength),
+					   symbol.nameStart,
+					   symbol.charMask);
+}
+
+std::string_view SymbolSnapshot::qualifiedName(uint32_t id) const
+{
+	const Segment &segment = segmentOf(id);
+	return segment.textOf(segment.symbols[id]);
+}
+
+std::string_view SymbolSnapshot::name(uint32_t id) const
+{
+	const Segment &segment = segmentOf(id);
+	const SymbolRecord &symbol = segment.symbols[id];
+	return segment.textOf(symbol).substr(symbol.nameStart);
+}
+
+std::string_view SymbolSnapshot::container(uint32_t id) const
+{
+	const Segment &segment = segmentOf(id);
+	const SymbolRecord &symbol = segment.symbols[id];
+	// Without the '.' before the name
+	return symbol.nameStart == 0 ? std::string_view()
+								 : segment.textOf(symbol).substr(0, symbol.nameStart - 1);
+}
+
+std::string_view SymbolSnapshot::path(uint32_t id) const
+{
+	const Segment &segment = segmentOf(id);
+	return segment.path(segment.symbols[id].fileId);
+}
+
+std::string SymbolSnapshot::fullPath(uint32_t id) const
+{
+	std::string full = root;
+	if (!full.empty() && full.back() != '/' && full.back() != '\\')
+	{
+		full += static_cast<char>(fs::path::preferred_separator);
+	}
+	full.append(path(id));
+	return full;
+}
+
+SymbolKind SymbolSnapshot::kind(uint32_t id) const
+{
+	const Segment &segment = segmentOf(id);
+	return static_cast<SymbolKind>(segment.symbols[id].kind);
+}
+
+uint32_t SymbolSnapshot::line(uint32_t id) const
+{
+	const Segment &segment = segmentOf(id);
+	return segment.symbols[id].line;
+}
+
+uint32_t SymbolSnapshot::column(uint32_t id) const
+{
+	const Segment &segment = segmentOf(id);
+	return segment.symbols[id].column;
+}
+
+std::vector<uint32_t> SymbolSnapshot::find(std::string_view target) const
+{
+	std::vector<uint32_t> ids;
+	if (base.byName)
+	{
+		auto nameOf = [this](uint32_t id) {
+			const SymbolRecord &symbol = base.symbols[id];
+			return base.textOf(symbol).substr(symbol.nameStart);
+		};
+		const uint32_t *end = base.byName + base.symbolCount;
+		auto before = [&](uint32_t id, std::string_view t) { return nameOf(id) < t; };
+		const uint32_t *it = std::lower_bound(base.byName, end, target, before);
+		for (; it != end && nameOf(*it) == target; ++it)
+		{
+			if (live(*it))
+			{
+				ids.push_back(*it);
+			}
+		}
+	}
+	// The overlay stays small enough to scan
+	for (uint32_t i = 0; i < overlay.symbolCount; ++i)
+	{
+		const SymbolRecord &symbol = overlay.symbols[i];
+		if (overlay.textOf(symbol).substr(symbol.nameStart) == target)
+		{
+			ids.push_back(base.symbolCount + i);
+		}
+	}
+	return ids;
+}
+
+SymbolIndex::~SymbolIndex() { close(); }
+
+void SymbolIndex::open(const std::string &indexRoot)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (indexRoot == root && worker.joinable())
+		{
+			return;
+		}
+	}
+	close();
+	if (indexRoot.empty())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		root = indexRoot;
+		stopping = false;
+		worker = std::thread(&SymbolIndex::run, this, indexRoot);
+	}
+	// Files written outside the editor, where inotify reports them
+	listenerId = gWorkspaceIndex.addChangeListener([this](const std::string &relative) {
+		noteRelative(nativeUtf8(pathFromUtf8(relative)));
+	});
+}
+
+void SymbolIndex::close()
+{
+	// First, so no listener call is left waiting on the lock below
+	if (listenerId >= 0)
+	{
+		gWorkspaceIndex.removeChangeListener(listenerId);
+		listenerId = -1;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wakeup.notify_all();
+	if (worker.joinable())
+	{
+		worker.join();
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	bool hadSnapshot = current != nullptr;
+	root.clear();
+	noted.clear();
+	current.reset();
+	if (hadSnapshot)
+	{
+		publishedVersion++;
+	}
+}
+
+void SymbolIndex::followSetting(const std::string &folder)
+{
+	std::shared_ptr<const SettingsSnapshot> settings = gSettings.getSnapshot();
+	if (settings == seenSettings)
+	{
+		return;
+	}
+	bool wasEnabled = seenSettings && seenSettings->symbolIndex;
+	seenSettings = settings;
+	if (settings->symbolIndex && !wasEnabled)
+	{
+		open(folder);
+	} else if (!settings->symbolIndex && wasEnabled)
+	{
+		close();
+	}
+}
+
+std::shared_ptr<const SymbolSnapshot> SymbolIndex::snapshot() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return current;
+}
+
+bool SymbolIndex::shouldStop()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stopping;
+}
+
+fs::path SymbolIndex::indexPath(const std::string &indexRoot) const
+{
+	return pathFromUtf8(indexRoot) / FILE_NAME;
+}
+
+void SymbolIndex::noteFileChanged(const std::string &path)
+{
+	std::string relative;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (root.empty())
+		{
+			return;
+		}
+		relative =
+			nativeUtf8(pathFromUtf8(path).lexically_relative(pathFromUtf8(root)));
+	}
+	if (relative.empty() || relative.rfind("..", 0) == 0)
+	{
+		return;
+	}
+	noteRelative(std::move(relative));
+}
+
+void SymbolIndex::noteRelative(std::string relative)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (root.empty() || stopping)
+		{
+			return;
+		}
+		noted.insert(std::move(relative));
+	}
+	wakeup.notify_all();
+}
+
+void SymbolIndex::run(std::string indexRoot)
+{
+	using namespace std::chrono;
+
+	loadLanguages();
+	if (languages.empty())
+	{
+		std::cerr << "[SymbolIndex] No tag queries found, not indexing" << std::endl;
+	} else if (loadBase(indexPath(indexRoot)))
+	{
+		// Served right away; what changed since is parsed below
+		publish(indexRoot);
+	}
+
+	uint64_t seenWorkspace = 0;
+	steady_clock::time_point lastStat{};
+	while (!languages.empty() && !shouldStop())
+	{
+		std::vector<std::string> files;
+		bool dropped = false;
+
+		// Files that appeared or went away whenever the workspace changes, and
+		// a stat of every file now and then for edits nobody reported
+		auto now = steady_clock::now();
+		bool statFiles = lastStat == steady_clock::time_point{} ||
+						 now - lastStat >= seconds(REFRESH_SECONDS);
+		uint64_t workspaceVersion = gWorkspaceIndex.version();
+		if (statFiles || workspaceVersion != seenWorkspace)
+		{
+			auto workspace = gWorkspaceIndex.snapshot();
+			if (workspace && workspace->root == indexRoot)
+			{
+				seenWorkspace = workspaceVersion;
+				if (statFiles)
+				{
+					lastStat = now;
+				}
+				dropped = reconcile(indexRoot, *workspace, statFiles, files);
+			}
+		}
+		takeNoted(indexRoot, files);
+		std::sort(files.begin(), files.end());
+		files.erase(std::unique(files.begin(), files.end()), files.end());
+
+		if (!files.empty())
+		{
+			auto start = steady_clock::now();
+			parseFiles(indexRoot, files);
+			if (files.size() > 1)
+			{
+				auto elapsed = duration_cast<milliseconds>(steady_clock::now() - start);
+				std::cout << "[SymbolIndex] Parsed " << files.size() << " files in "
+						  << elapsed.count() << " ms" << std::endl;
+			}
+		}
+		if (!files.empty() || dropped)
+		{
+			publish(indexRoot);
+		}
+		if (!shouldStop() && needsRewrite())
+		{
+			rewrite(indexRoot);
+		}
+
+		std::unique_lock<std::mutex> lock(mutex);
+		wakeup.wait_for(lock, seconds(1), [this] { return stopping || !noted.empty(); });
+		if (!stopping && !noted.empty())
+		{
+			// Let a burst of writes, like a checkout, settle into one pass
+			wakeup.wait_for(lock, milliseconds(DEBOUNCE_MS), [this] { return stopping; });
+		}
+	}
+
+	freeLanguages();
+	languageByExtension.clear();
+	overlay.clear();
+	eligible.clear();
+	baseIds.clear();
+	shadowed.clear();
+	base = Segment();
+	baseMapping.reset();
+	rewriteFailed = false;
+	indexing = false;
+}
+
+void SymbolIndex::loadLanguages()
+{
+	// Extensions sharing a grammar share its compiled query
+	std::unordered_map<std::string, const Language *> byQuery;
+	for (const char *extension : EXTENSIONS)
+	{
+		auto [lang, queryPath] = TreeSitter::tagsQuery(extension);
+		if (!lang)
+		{
+			continue;
+		}
+		auto known = byQuery.find(queryPath);
+		if (known != byQuery.end())
+		{
+			languageByExtension[extension] = known->second;
+			continue;
+		}
+		TSQuery *query = TreeSitter::compileQuery(lang, queryPath);
+		if (!query)
+		{
+			continue;
+		}
+
+		auto language = std::make_unique<Language>();
+		language->language = lang;
+		language->query = query;
+		uint32_t captures = ts_query_capture_count(query);
+		for (uint32_t id = 0; id < captures; ++id)
+		{
+			uint32_t length = 0;
+			const char *name = ts_query_capture_name_for_id(query, id, &length);
+			std::string_view capture(name, length);
+			int role = OTHER_CAPTURE;
+			if (capture == "name")
+			{
+				role = NAME_CAPTURE;
+			} else if (capture.rfind("definition.", 0) == 0)
+			{
+				role = static_cast<int>(kindFromCapture(capture.substr(11)));
+			}
+			language->captureRoles.push_back(role);
+		}
+		byQuery.emplace(queryPath, language.get());
+		languageByExtension[extension] = language.get();
+		languages.push_back(std::move(language));
+	}
+}
+
+void SymbolIndex::freeLanguages()
+{
+	for (const auto &language : languages)
+	{
+		ts_query_delete(language->query);
+	}
+	languages.clear();
+}
+
+const SymbolIndex::Language *SymbolIndex::languageFor(std::string_view relative) const
+{
+	std::string_view extension = extensionOf(relative);
+	if (extension.empty())
+	{
+		return nullptr;
+	}
+	auto it = languageByExtension.find(std::string(extension));
+	return it == languageByExtension.end() ? nullptr : it->second;
+}
+
+bool SymbolIndex::loadBase(const fs::path &path)
+{
+	auto mapping = std::make_shared<MappedFile>();
+	if (!mapping->open(path) || mapping->size() < sizeof(Header))
+	{
+		return false;
+	}
+	const char *data = mapping->data();
+	const size_t size = mapping->size();
+	const Header *header = reinterpret_cast<const Header *>(data);
+
+	// Reject anything truncated or from another version rather than trusting it
+	const uint64_t files = header->fileCount;
+	const uint64_t symbols = header->symbolCount;
+	bool valid =
+		std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0 &&
+		header->version == VERSION && header->totalSize == size &&
+		header->filesOffset == sizeof(Header) &&
+		header->symbolsOffset == header->filesOffset + files * sizeof(FileRecord) &&
+		header->byNameOffset == header->symbolsOffset + symbols * sizeof(SymbolRecord) &&
+		header->pathsOffset == header->byNameOffset + symbols * sizeof(uint32_t) &&
+		header->pathsOffset <= header->textOffset &&
+		header->textOffset <= header->lowerOffset &&
+		header->lowerOffset <= header->totalSize &&
+		header->lowerOffset - header->textOffset ==
+			header->totalSize - header->lowerOffset;
+
+	Segment segment;
+	if (valid)
+	{
+		segment.files = reinterpret_cast<const FileRecord *>(data + header->filesOffset);
+		segment.fileCount = header->fileCount;
+		segment.symbols =
+			reinterpret_cast<const SymbolRecord *>(data + header->symbolsOffset);
+		segment.symbolCount = header->symbolCount;
+		segment.byName = reinterpret_cast<const uint32_t *>(data + header->byNameOffset);
+		segment.paths = data + header->pathsOffset;
+		segment.text = data + header->textOffset;
+		segment.lower = data + header->lowerOffset;
+
+		const uint64_t pathsSize = header->textOffset - header->pathsOffset;
+		const uint64_t textSize = header->lowerOffset - header->textOffset;
+		uint64_t nextSymbol = 0;
+		for (uint32_t i = 0; valid && i < segment.fileCount; ++i)
+		{
+			const FileRecord &file = segment.files[i];
+			valid = uint64_t(file.pathOffset) + file.pathLength <= pathsSize &&
+					file.firstSymbol == nextSymbol;
+			nextSymbol += file.symbolCount;
+		}
+		valid = valid && nextSymbol == symbols;
+		for (uint32_t i = 0; valid && i < segment.symbolCount; ++i)
+		{
+			const SymbolRecord &symbol = segment.symbols[i];
+			valid = uint64_t(symbol.textOffset) + symbol.textLength <= textSize &&
+					symbol.nameStart <= symbol.textLength &&
+					symbol.fileId < segment.fileCount &&
+					symbol.kind <= static_cast<uint8_t>(SymbolKind::Other) &&
+					segment.byName[i] < segment.symbolCount;
+		}
+	}
+	if (!valid)
+	{
+		std::cerr << "[SymbolIndex] Ignoring invalid index " << path << std::endl;
+		return false;
+	}
+
+	baseMapping = std::move(mapping);
+	base = segment;
+	shadowed.assign(base.fileCount, false);
+	baseIds.clear();
+	baseIds.reserve(base.fileCount);
+	for (uint32_t i = 0; i < base.fileCount; ++i)
+	{
+		baseIds.emplace(base.path(i), i);
+	}
+	return true;
+}
+
+bool SymbolIndex::reconcile(const std::string &indexRoot,
+							const WorkspaceSnapshot &workspace,
+							bool statFiles,
+							std::vector<std::string> &out)
+{
+	std::unordered_set<std::string_view> present;
+	present.reserve(workspace.files.size());
+	for (uint32_t id = 0; id < workspace.files.size(); ++id)
+	{
+		std::string_view relative = workspace.files.path(id);
+		if (languageFor(relative))
+		{
+			present.insert(relative);
+		}
+	}
+
+	bool dropped = false;
+	for (auto it = overlay.begin(); it != overlay.end();)
+	{
+		if (present.count(it->first))
+		{
+			++it;
+			continue;
+		}
+		it = overlay.erase(it);
+		dropped = true;
+	}
+	for (uint32_t i = 0; i < base.fileCount; ++i)
+	{
+		if (!shadowed[i] && !present.count(base.path(i)))
+		{
+			shadowed[i] = true;
+			dropped = true;
+		}
+	}
+
+	const fs::path rootPath = pathFromUtf8(indexRoot);
+	for (std::string_view view : present)
+	{
+		std::string relative(view);
+		auto baseId = baseIds.find(view);
+		bool known = overlay.count(relative) ||
+					 (baseId != baseIds.end() && !shadowed[baseId->second]);
+		if (known && statFiles)
+		{
+			uint64_t size = 0;
+			int64_t mtime = 0;
+			known = statFile(rootPath / pathFromUtf8(relative), size, mtime) &&
+					isCurrent(relative, size, mtime);
+		}
+		if (!known)
+		{
+			out.push_back(std::move(relative));
+		}
+	}
+
+	eligible.clear();
+	eligible.reserve(present.size());
+	for (std::string_view relative : present)
+	{
+		eligible.emplace(relative);
+	}
+	return dropped;
+}
+
+void SymbolIndex::takeNoted(const std::string &indexRoot, std::vector<std::string> &out)
+{
+	std::unordered_set<std::string> paths;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		paths.swap(noted);
+	}
+	const fs::path rootPath = pathFromUtf8(indexRoot);
+	for (const std::string &relative : paths)
+	{
+		// Ignored files and files without a tag query are not indexed; new
+		// files come in through the workspace index
+		if (!eligible.count(relative))
+		{
+			continue;
+		}
+		// A save reported by both the editor and inotify is parsed once
+		uint64_t size = 0;
+		int64_t mtime = 0;
+		if (statFile(rootPath / pathFromUtf8(relative), size, mtime) &&
+			isCurrent(relative, size, mtime))
+		{
+			continue;
+		}
+		out.push_back(relative);
+	}
+}
+
+bool SymbolIndex::isCurrent(const std::string &relative,
+							uint64_t size,
+							int64_t mtime) const
+{
+	auto parsedFile = overlay.find(relative);
+	if (parsedFile != overlay.end())
+	{
+		return parsedFile->second.size == size && parsedFile->second.mtime == mtime;
+	}
+	auto baseId = baseIds.find(relative);
+	if (baseId == baseIds.end() || shadowed[baseId->second])
+	{
+		return false;
+	}
+	const FileRecord &record = base.files[baseId->second];
+	return record.size == size && record.mtime == mtime;
+}
+
+void SymbolIndex::replaceFile(const std::string &relative, ParsedFile parsedFile)
+{
+	overlay[relative] = std::move(parsedFile);
+	auto baseId = baseIds.find(relative);
+	if (baseId != baseIds.end())
+	{
+		shadowed[baseId->second] = true;
+	}
+}
+
+void SymbolIndex::dropFile(const std::string &relative)
+{
+	overlay.erase(relative);
+	auto baseId = baseIds.find(relative);
+	if (baseId != baseIds.end())
+	{
+		shadowed[baseId->second] = true;
+	}
+}
+
+void SymbolIndex::parseFiles(const std::string &indexRoot,
+							 const std::vector<std::string> &files)
+{
+	using namespace std::chrono;
+
+	// Files are parsed in parallel a wave at a time, each thread with its own
+	// parser, and merged in between so long passes can show partial results
+	const fs::path rootPath = pathFromUtf8(indexRoot);
+	const size_t threadCount =
+		std::max<size_t>(1,
+						 std::min<size_t>(std::thread::hardware_concurrency(),
+										  (files.size() + 15) / 16));
+	const size_t waveSize = threadCount * 64;
+	struct Worker
+	{
+		TSParser *parser;
+		TSQueryCursor *cursor;
+		std::string buffer;
+	};
+	std::vector<Worker> workers(threadCount);
+	for (Worker &worker : workers)
+	{
+		worker.parser = ts_parser_new();
+		worker.cursor = ts_query_cursor_new();
+	}
+
+	parsed = 0;
+	toParse = files.size();
+	indexing = true;
+	auto lastPublish = steady_clock::now();
+	std::vector<ParsedFile> results;
+	std::vector<char> readable;
+	for (size_t waveStart = 0; waveStart < files.size() && !shouldStop();
+		 waveStart += waveSize)
+	{
+		const size_t waveEnd = std::min(files.size(), waveStart + waveSize);
+		results.assign(waveEnd - waveStart, ParsedFile());
+		readable.assign(waveEnd - waveStart, 0);
+		std::atomic<size_t> next{waveStart};
+		auto parse = [&](size_t thread) {
+			Worker &worker = workers[thread];
+			for (size_t i; (i = next++) < waveEnd;)
+			{
+				const Language *language = languageFor(files[i]);
+				readable[i - waveStart] =
+					language && parseFile(rootPath / pathFromUtf8(files[i]),
+										  *language,
+										  worker.parser,
+										  worker.cursor,
+										  worker.buffer,
+										  results[i - waveStart]);
+				parsed++;
+			}
+		};
+		std::vector<std::thread> pool;
+		for (size_t t = 1; t < threadCount; ++t)
+		{
+			pool.emplace_back(parse, t);
+		}
+		parse(0);
+		for (std::thread &thread : pool)
+		{
+			thread.join();
+		}
+
+		for (size_t i = waveStart; i < waveEnd; ++i)
+		{
+			if (readable[i - waveStart])
+			{
+				replaceFile(files[i], std::move(results[i - waveStart]));
+			} else
+			{
+				dropFile(files[i]);
+			}
+		}
+		if (waveEnd < files.size() &&
+			steady_clock::now() - lastPublish >= milliseconds(PUBLISH_MS))
+		{
+			publish(indexRoot);
+			lastPublish = steady_clock::now();
+		}
+	}
+
+	for (Worker &worker : workers)
+	{
+		ts_query_cursor_delete(worker.cursor);
+		ts_parser_delete(worker.parser);
+	}
+	indexing = false;
+}
+
+bool SymbolIndex::parseFile(const fs::path &path,
+							const Language &language,
+							TSParser *parser,
+							TSQueryCursor *cursor,
+							std::string &buffer,
+							ParsedFile &out)
+{
+	if (!statFile(path, out.size, out.mtime))
+	{
+		return false;
+	}
+	// Oversized and binary files are kept, without symbols, so they are not
+	// read again until they change
+	out.symbols.clear();
+	if (out.size > MAX_FILE_BYTES)
+	{
+		return true;
+	}
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+	buffer.resize(out.size);
+	file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+	buffer.resize(static_cast<size_t>(file.gcount()));
+	if (std::memchr(buffer.data(), 0, std::min(buffer.size(), BINARY_CHECK_BYTES)))
+	{
+		return true;
+	}
+	extractSymbols(language, parser, cursor, buffer, out.symbols);
+	return true;
+}
+
+void SymbolIndex::extractSymbols(const Language &language,
+								 TSParser *parser,
+								 TSQueryCursor *cursor,
+								 const std::string &content,
+								 std::vector<ParsedSymbol> &out)
+{
+	if (!ts_parser_set_language(parser, language.language))
+	{
+		return;
+	}
+	TSTree *tree = ts_parser_parse_string(
+		parser, nullptr, content.data(), static_cast<uint32_t>(content.size()));
+	if (!tree)
+	{
+		return;
+	}
+
+	struct Definition
+	{
+		uint32_t start; // Of the whole definition
+		uint32_t end;
+		uint32_t nameStart;
+		uint32_t nameEnd;
+		TSPoint position; // Of the name
+		SymbolKind kind;
+		uint32_t pattern;
+	};
+	std::vector<Definition> definitions;
+	ts_query_cursor_exec(cursor, language.query, ts_tree_root_node(tree));
+	TSQueryMatch match;
+	while (ts_query_cursor_next_match(cursor, &match))
+	{
+		Definition definition{};
+		bool hasName = false;
+		bool hasDefinition = false;
+		for (uint16_t i = 0; i < match.capture_count; ++i)
+		{
+			const TSQueryCapture &capture = match.captures[i];
+			int role = language.captureRoles[capture.index];
+			if (role == NAME_CAPTURE)
+			{
+				definition.nameStart = ts_node_start_byte(capture.node);
+				definition.nameEnd = ts_node_end_byte(capture.node);
+				definition.position = ts_node_start_point(capture.node);
+				hasName = true;
+			} else if (role >= 0)
+			{
+				definition.start = ts_node_start_byte(capture.node);
+				definition.end = ts_node_end_byte(capture.node);
+				definition.kind = static_cast<SymbolKind>(role);
+				hasDefinition = true;
+			}
+		}
+		if (hasName && hasDefinition && definition.nameEnd > definition.nameStart)
+		{
+			definition.pattern = match.pattern_index;
+			definitions.push_back(definition);
+		}
+	}
+	ts_tree_delete(tree);
+
+	// A name several patterns match keeps the last, most specific pattern
+	std::sort(definitions.begin(),
+			  definitions.end(),
+			  [](const Definition &a, const Definition &b) {
+				  if (a.nameStart != b.nameStart)
+				  {
+					  return a.nameStart < b.nameStart;
+				  }
+				  return a.pattern > b.pattern;
+			  });
+	definitions.erase(std::unique(definitions.begin(),
+								  definitions.end(),
+								  [](const Definition &a, const Definition &b) {
+									  return a.nameStart == b.nameStart;
+								  }),
+					  definitions.end());
+
+	// Outer definitions first, so the ones around each are on the stack
+	std::sort(definitions.begin(),
+			  definitions.end(),
+			  [](const Definition &a, const Definition &b) {
+				  return a.start != b.start ? a.start < b.start : a.end > b.end;
+			  });
+	struct Enclosing
+	{
+		uint32_t end;
+		std::string text;
+	};
+	std::vector<Enclosing> stack;
+	for (const Definition &definition : definitions)
+	{
+		while (!stack.empty() && stack.back().end <= definition.start)
+		{
+			stack.pop_back();
+		}
+		std::string container = stack.empty() ? std::string() : stack.back().text;
+		std::string_view name(content.data() + definition.nameStart,
+							  definition.nameEnd - definition.nameStart);
+
+		// Qualified names like Foo::bar, e.g. C++ methods defined out of line
+		size_t scope = name.rfind("::");
+		if (scope != std::string_view::npos)
+		{
+			std::string_view prefix = name.substr(0, scope);
+			for (size_t part = 0; part < prefix.size();)
+			{
+				size_t next = std::min(prefix.find("::", part), prefix.size());
+				container += container.empty() ? "" : ".";
+				container.append(prefix.substr(part, next - part));
+				part = next + 2;
+			}
+			name.remove_prefix(scope + 2);
+		}
+		if (name.empty() || name.size() > MAX_NAME ||
+			name.find('\n') != std::string_view::npos)
+		{
+			continue;
+		}
+		if (container.size() > MAX_CONTAINER)
+		{
+			container.clear();
+		}
+
+		ParsedSymbol symbol;
+		symbol.text = container.empty() ? std::string(name)
+										: container + "." + std::string(name);
+		symbol.nameStart = static_cast<uint16_t>(symbol.text.size() - name.size());
+		symbol.kind = definition.kind;
+		symbol.line = definition.position.row;
+		symbol.column = definition.position.column;
+		stack.push_back({definition.end, symbol.text});
+		out.push_back(std::move(symbol));
+	}
+}
+
+void SymbolIndex::flatten(SymbolSnapshot &snap) const
+{
+	for (const auto &[relative, parsedFile] : overlay)
+	{
+		FileRecord file{};
+		file.size = parsedFile.size;
+		file.mtime = parsedFile.mtime;
+		file.pathOffset = static_cast<uint32_t>(snap.overlayPaths.size());
+		file.pathLength = static_cast<uint32_t>(relative.size());
+		file.firstSymbol = static_cast<uint32_t>(snap.overlaySymbols.size());
+		file.symbolCount = static_cast<uint32_t>(parsedFile.symbols.size());
+		snap.overlayPaths += relative;
+
+		const uint32_t fileId = static_cast<uint32_t>(snap.overlayFiles.size());
+		for (const ParsedSymbol &parsedSymbol : parsedFile.symbols)
+		{
+			SymbolRecord symbol{};
+			symbol.textOffset = static_cast<uint32_t>(snap.overlayText.size());
+			symbol.textLength = static_cast<uint16_t>(parsedSymbol.text.size());
+			symbol.nameStart = parsedSymbol.nameStart;
+			symbol.fileId = fileId;
+			symbol.line = parsedSymbol.line;
+			symbol.column = parsedSymbol.column;
+			symbol.kind = static_cast<uint8_t>(parsedSymbol.kind);
+			snap.overlayText += parsedSymbol.text;
+			for (char c : parsedSymbol.text)
+			{
+				snap.overlayLower.push_back(toLower(c));
+				symbol.charMask |= PathTable::maskOf(snap.overlayLower.back());
+			}
+			snap.overlaySymbols.push_back(symbol);
+		}
+		snap.overlayFiles.push_back(file);
+	}
+
+	snap.overlay.files = snap.overlayFiles.data();
+	snap.overlay.fileCount = static_cast<uint32_t>(snap.overlayFiles.size());
+	snap.overlay.symbols = snap.overlaySymbols.data();
+	snap.overlay.symbolCount = static_cast<uint32_t>(snap.overlaySymbols.size());
+	snap.overlay.paths = snap.overlayPaths.data();
+	snap.overlay.text = snap.overlayText.data();
+	snap.overlay.lower = snap.overlayLower.data();
+}
+
+void SymbolIndex::publish(const std::string &indexRoot)
+{
+	auto snap = std::make_shared<SymbolSnapshot>();
+	snap->root = indexRoot;
+	snap->mapping = baseMapping;
+	snap->base = base;
+	snap->shadowed = shadowed;
+	flatten(*snap);
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		snap->version = publishedVersion + 1;
+		current = std::move(snap);
+		publishedVersion++;
+	}
+	gRedraw.request();
+}
+
+bool SymbolIndex::needsRewrite() const
+{
+	if (rewriteFailed)
+	{
+		return false;
+	}
+	if (!baseMapping)
+	{
+		return !overlay.empty();
+	}
+	size_t changed = overlay.size() + std::count(shadowed.begin(), shadowed.end(), true);
+	return changed > std::max<size_t>(MIN_REWRITE_FILES, base.fileCount / 20);
+}
+
+bool SymbolIndex::rewrite(const std::string &indexRoot)
+{
+	using namespace std::chrono;
+	auto start = steady_clock::now();
+
+	// Everything moves into the overlay first so the old mapping can go:
+	// Windows cannot replace a file that is still mapped
+	for (uint32_t i = 0; i < base.fileCount; ++i)
+	{
+		if (shadowed[i])
+		{
+			continue;
+		}
+		const FileRecord &file = base.files[i];
+		ParsedFile parsedFile;
+		parsedFile.size = file.size;
+		parsedFile.mtime = file.mtime;
+		parsedFile.symbols.reserve(file.symbolCount);
+		for (uint32_t s = file.firstSymbol; s < file.firstSymbol + file.symbolCount; ++s)
+		{
+			const SymbolRecord &symbol = base.symbols[s];
+			parsedFile.symbols.push_back({std::string(base.textOf(symbol)),
+										  symbol.nameStart,
+										  static_cast<SymbolKind>(symbol.kind),
+										  symbol.line,
+										  symbol.column});
+		}
+		overlay.emplace(std::string(base.path(i)), std::move(parsedFile));
+	}
+	baseIds.clear();
+	shadowed.clear();
+	base = Segment();
+	baseMapping.reset();
+	publish(indexRoot);
+
+	const fs::path target = indexPath(indexRoot);
+	if (!write(target) || !loadBase(target))
+	{
+		// The symbols stay in memory for as long as the folder is open
+		std::cerr << "[SymbolIndex] Failed to write " << target << std::endl;
+		rewriteFailed = true;
+		return false;
+	}
+	overlay.clear();
+	publish(indexRoot);
+
+	auto elapsed = duration_cast<milliseconds>(steady_clock::now() - start);
+	std::cout << "[SymbolIndex] Wrote " << base.symbolCount << " symbols of "
+			  << base.fileCount << " files in " << elapsed.count() << " ms" << std::endl;
+	return true;
+}
+
+bool SymbolIndex::write(const fs::path &target)
+{
+	SymbolSnapshot flat;
+	flatten(flat);
+	const Segment &segment = flat.overlay;
+
+	std::vector<uint32_t> byName(segment.symbolCount);
+	std::iota(byName.begin(), byName.end(), 0);
+	auto nameOf = [&segment](uint32_t id) {
+		const SymbolRecord &symbol = segment.symbols[id];
+		return segment.textOf(symbol).substr(symbol.nameStart);
+	};
+	std::sort(byName.begin(), byName.end(), [&](uint32_t a, uint32_t b) {
+		return nameOf(a) < nameOf(b);
+	});
+
+	Header header{};
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.fileCount = segment.fileCount;
+	header.symbolCount = segment.symbolCount;
+	header.filesOffset = sizeof(Header);
+	header.symbolsOffset =
+		header.filesOffset + flat.overlayFiles.size() * sizeof(FileRecord);
+	header.byNameOffset =
+		header.symbolsOffset + flat.overlaySymbols.size() * sizeof(SymbolRecord);
+	header.pathsOffset = header.byNameOffset + byName.size() * sizeof(uint32_t);
+	header.textOffset = header.pathsOffset + flat.overlayPaths.size();
+	header.lowerOffset = header.textOffset + flat.overlayText.size();
+	header.totalSize = header.lowerOffset + flat.overlayLower.size();
+
+	fs::path temp = target;
+	temp += ".tmp";
+	std::error_code ec;
+	{
+		std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+		auto writeBytes = [&out](const void *data, size_t size) {
+			out.write(static_cast<const char *>(data),
+					  static_cast<std::streamsize>(size));
+		};
+		writeBytes(&header, sizeof(header));
+		writeBytes(flat.overlayFiles.data(),
+				   flat.overlayFiles.size() * sizeof(FileRecord));
+		writeBytes(flat.overlaySymbols.data(),
+				   flat.overlaySymbols.size() * sizeof(SymbolRecord));
+		writeBytes(byName.data(), byName.size() * sizeof(uint32_t));
+		writeBytes(flat.overlayPaths.data(), flat.overlayPaths.size());
+		writeBytes(flat.overlayText.data(), flat.overlayText.size());
+		writeBytes(flat.overlayLower.data(), flat.overlayLower.size());
+		out.close();
+		if (!out)
+		{
+			fs::remove(temp, ec);
+			return false;
+		}
+	}
+	fs::rename(temp, target, ec);
+	if (ec)
+	{
+		fs::remove(temp, ec);
+		return false;
+	}
+	return true;
+}
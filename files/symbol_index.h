@@ -0,0 +1,315 @@
+/*
+	File: symbol_index.h
+	Description: Workspace symbol index, for going to a symbol or a definition
+   without a language server. Every file of a language with a tag query
+   (editor/queries/tags) is parsed in the background with its tree-sitter
+   grammar, and each definition the query marks is kept with the definitions
+   around it as its container, e.g. "Editor.render".
+
+   Symbols are written to .ned-symbol-index in the workspace and memory-mapped
+   when opened, so a restart answers queries before anything is parsed again.
+   Files that change later, found through saves, inotify and a periodic stat
+   walk, are parsed again into an in-memory overlay that shadows their symbols
+   in the file; once the overlay grows, the file is rewritten from both.
+*/
+
+#pragma once
+
+#include "fuzzy_match.h"
+#include "mapped_file.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+struct SettingsSnapshot;
+
+struct TSLanguage;
+struct TSParser;
+struct TSQuery;
+struct TSQueryCursor;
+struct WorkspaceSnapshot;
+
+enum class SymbolKind : uint8_t {
+	Function,
+	Method,
+	Class,
+	Struct,
+	Interface,
+	Enum,
+	Type,
+	Namespace,
+	Macro,
+	Constant,
+	Property,
+	Other
+};
+
+const char *symbolKindName(SymbolKind kind);
+
+// One immutable view of the index: the mapped file plus the files parsed since
+// it was written. Symbol ids only mean something within one snapshot.
+class SymbolSnapshot
+{
+  public:
+	std::string root;
+	uint64_t version = 0;
+
+	// Ids run up to size(); symbols of files that changed or went away since
+	// the file was written are not live
+	size_t size() const { return base.symbolCount + overlay.symbolCount; }
+	bool live(uint32_t id) const;
+
+	// Fuzzy score of "Container.name", where the name earns the basename bonus
+	int score(const FuzzyQuery &query, uint32_t id) const;
+
+	std::string_view qualifiedName(uint32_t id) const;
+	std::string_view name(uint32_t id) const;
+	std::string_view container(uint32_t id) const;
+	std::string_view path(uint32_t id) const; // Relative to the root
+	std::string fullPath(uint32_t id) const;
+	SymbolKind kind(uint32_t id) const;
+	uint32_t line(uint32_t id) const;	// 0-based
+	uint32_t column(uint32_t id) const; // 0-based, in bytes
+
+	// Live symbols named exactly `name`
+	std::vector<uint32_t> find(std::string_view name) const;
+
+  private:
+	friend class SymbolIndex;
+
+	struct Header
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t fileCount;
+		uint32_t symbolCount;
+		uint32_t reserved;
+		uint64_t filesOffset;
+		uint64_t symbolsOffset;
+		uint64_t byNameOffset;
+		uint64_t pathsOffset;
+		uint64_t textOffset;
+		uint64_t lowerOffset; // The lower-cased text, as long as the text
+		uint64_t totalSize;
+	};
+
+	// Files are sorted by path and own a contiguous run of symbols
+	struct FileRecord
+	{
+		uint64_t size;
+		int64_t mtime;
+		uint32_t pathOffset;
+		uint32_t pathLength;
+		uint32_t firstSymbol;
+		uint32_t symbolCount;
+	};
+
+	struct SymbolRecord
+	{
+		uint64_t charMask;	 // PathTable::maskOf every byte of the text
+		uint32_t textOffset; // "Container.name", in the text and lower pools
+		uint32_t fileId;
+		uint32_t line;
+		uint32_t column;
+		uint16_t textLength;
+		uint16_t nameStart; // Where the name starts within the text
+		uint8_t kind;
+		uint8_t reserved[3];
+	};
+
+	struct Segment
+	{
+		const FileRecord *files = nullptr;
+		uint32_t fileCount = 0;
+		const SymbolRecord *symbols = nullptr;
+		uint32_t symbolCount = 0;
+		const uint32_t *byName = nullptr; // Symbol ids by name; the file only
+		const char *paths = nullptr;
+		const char *text = nullptr;
+		const char *lower = nullptr;
+
+		std::string_view path(uint32_t file) const
+		{
+			return {paths + files[file].pathOffset, files[file].pathLength};
+		}
+		std::string_view textOf(const SymbolRecord &symbol) const
+		{
+			return {text + symbol.textOffset, symbol.textLength};
+		}
+	};
+
+	// The mapped file, with a flag per file whose symbols are shadowed
+	std::shared_ptr<const MappedFile> mapping;
+	Segment base;
+	std::vector<bool> shadowed;
+
+	// Files parsed since, flattened
+	Segment overlay;
+	std::vector<FileRecord> overlayFiles;
+	std::vector<SymbolRecord> overlaySymbols;
+	std::string overlayPaths;
+	std::string overlayText;
+	std::string overlayLower;
+
+	// The segment holding `id`, with `id` made relative to it
+	const Segment &segmentOf(uint32_t &id) const;
+};
+
+class SymbolIndex
+{
+  public:
+	~SymbolIndex();
+
+	// Opens the index of `root`, parsing in the background whatever is missing
+	// or stale. Cheap when `root` is already open.
+	void open(const std::string &root);
+	void close();
+	// Opens or closes the index of `folder` when the symbol_index setting
+	// changed since the last call; called every frame
+	void followSetting(const std::string &folder);
+
+	// The latest snapshot, or null until the file is loaded or parsing starts
+	std::shared_ptr<const SymbolSnapshot> snapshot() const;
+	uint64_t version() const { return publishedVersion; }
+
+	// Progress of the files being parsed, for the symbol picker
+	bool isIndexing() const { return indexing; }
+	size_t filesParsed() const { return parsed; }
+	size_t filesToParse() const { return toParse; }
+
+	// A file changed on disk; it is parsed again shortly
+	void noteFileChanged(const std::string &path);
+
+	static constexpr const char *FILE_NAME = ".ned-symbol-index";
+
+  private:
+	using Header = SymbolSnapshot::Header;
+	using FileRecord = SymbolSnapshot::FileRecord;
+	using SymbolRecord = SymbolSnapshot::SymbolRecord;
+	using Segment = SymbolSnapshot::Segment;
+
+	static constexpr uint32_t VERSION = 1;
+	static constexpr int REFRESH_SECONDS = 60;
+	static constexpr int DEBOUNCE_MS = 100;
+	// Partial results of a long pass are published this often
+	static constexpr int PUBLISH_MS = 1000;
+	// Larger files are generated or minified more often than not
+	static constexpr size_t MAX_FILE_BYTES = 4 * 1024 * 1024;
+	static constexpr size_t BINARY_CHECK_BYTES = 8000;
+	// The file is rewritten once more files than this, or a twentieth of the
+	// indexed ones, changed since it was written
+	static constexpr size_t MIN_REWRITE_FILES = 256;
+
+	struct Language
+	{
+		TSLanguage *language = nullptr;
+		TSQuery *query = nullptr;
+		// Per capture id: a SymbolKind, NAME_CAPTURE or OTHER_CAPTURE
+		std::vector<int> captureRoles;
+	};
+	static constexpr int NAME_CAPTURE = -1;
+	static constexpr int OTHER_CAPTURE = -2;
+
+	struct ParsedSymbol
+	{
+		std::string text; // "Container.name"
+		uint16_t nameStart;
+		SymbolKind kind;
+		uint32_t line;
+		uint32_t column;
+	};
+
+	struct ParsedFile
+	{
+		uint64_t size = 0;
+		int64_t mtime = 0;
+		std::vector<ParsedSymbol> symbols;
+	};
+
+	mutable std::mutex mutex; // Guards everything up to the worker
+	std::condition_variable wakeup;
+	std::string root;
+	std::shared_ptr<const SymbolSnapshot> current;
+	std::unordered_set<std::string> noted; // Relative paths to parse again
+	bool stopping = false;
+	std::thread worker;
+	int listenerId = -1; // gWorkspaceIndex change listener
+	// Settings followSetting() last looked at; UI thread only
+	std::shared_ptr<const SettingsSnapshot> seenSettings;
+
+	std::atomic<uint64_t> publishedVersion{0};
+	std::atomic<bool> indexing{false};
+	std::atomic<size_t> parsed{0};
+	std::atomic<size_t> toParse{0};
+
+	// Worker state. The overlay holds the files parsed since the file was
+	// written, by relative path; `shadowed` flags the file's entries they
+	// replace or that went away.
+	std::shared_ptr<const MappedFile> baseMapping;
+	Segment base;
+	std::unordered_map<std::string_view, uint32_t> baseIds;
+	std::vector<bool> shadowed;
+	std::map<std::string, ParsedFile> overlay;
+	// Files with a tag query, as of the last look at the workspace
+	std::unordered_set<std::string> eligible;
+	bool rewriteFailed = false; // Not tried again until the next open
+	std::vector<std::unique_ptr<Language>> languages;
+	std::unordered_map<std::string, const Language *> languageByExtension;
+
+	void run(std::string indexRoot);
+	bool shouldStop();
+	void noteRelative(std::string relative);
+	std::filesystem::path indexPath(const std::string &indexRoot) const;
+
+	void loadLanguages();
+	void freeLanguages();
+	const Language *languageFor(std::string_view relative) const;
+
+	bool loadBase(const std::filesystem::path &path);
+	// Compares the workspace with what is indexed: drops files that went away
+	// and collects the ones to parse. Without `statFiles` only files that
+	// appeared are collected. Returns true when something was dropped.
+	bool reconcile(const std::string &indexRoot,
+				   const WorkspaceSnapshot &workspace,
+				   bool statFiles,
+				   std::vector<std::string> &out);
+	// Files noted since the last pass that differ from what is indexed
+	void takeNoted(const std::string &indexRoot, std::vector<std::string> &out);
+	// Parses `files` into the overlay, publishing along the way when it takes long
+	void parseFiles(const std::string &indexRoot, const std::vector<std::string> &files);
+	void replaceFile(const std::string &relative, ParsedFile parsed);
+	void dropFile(const std::string &relative);
+	bool isCurrent(const std::string &relative, uint64_t size, int64_t mtime) const;
+	void publish(const std::string &indexRoot);
+	// Lays the overlay out in `snap`'s overlay segment
+	void flatten(SymbolSnapshot &snap) const;
+	bool needsRewrite() const;
+	// Moves everything into the overlay and writes it out as the new file
+	bool rewrite(const std::string &indexRoot);
+	bool write(const std::filesystem::path &target);
+
+	static bool parseFile(const std::filesystem::path &path,
+						  const Language &language,
+						  TSParser *parser,
+						  TSQueryCursor *cursor,
+						  std::string &buffer,
+						  ParsedFile &out);
+	static void extractSymbols(const Language &language,
+							   TSParser *parser,
+							   TSQueryCursor *cursor,
+							   const std::string &content,
+							   std::vector<ParsedSymbol> &out);
+};
+
+extern SymbolIndex gSymbolIndex;
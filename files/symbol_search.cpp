@@ -0,0 +1,443 @@
+/*
+	files/symbol_search.cpp
+	Go-to-symbol window on top of the workspace symbol index.
+*/
+#include "symbol_search.h"
+#include "../editor/editor.h"
+#include "../util/close_popper.h"
+#include "../util/settings.h"
+#include "files.h"
+#include <algorithm>
+#include <functional>
+#include <thread>
+
+SymbolSearch gSymbolSearch;
+
+void SymbolSearch::toggleWindow()
+{
+	showWindow = !showWindow;
+	ClosePopper::closeAllExcept(ClosePopper::Type::SymbolSearch);
+
+	if (showWindow)
+	{
+		// Indexing starts with the first use when the setting was turned on
+		// after the folder was opened
+		if (gSettings.getSnapshot()->symbolIndex)
+		{
+			gSymbolIndex.open(gFileExplorer.selectedFolder);
+		} else
+		{
+			gSymbolIndex.close();
+		}
+		memset(searchBuffer, 0, sizeof(searchBuffer));
+		wasKeyboardFocusSet = false;
+		filteredSnapshot.reset();
+		filteredList.clear();
+		matchedIds.clear();
+		filteredQuery.clear();
+		selectedIndex = 0;
+		updateFilteredList();
+	}
+}
+
+void SymbolSearch::updateFilteredList()
+{
+	std::string searchTerm(searchBuffer);
+	std::transform(searchTerm.begin(), searchTerm.end(), searchTerm.begin(), ::tolower);
+
+	filteredVersion = gSymbolIndex.version();
+	std::shared_ptr<const SymbolSnapshot> snapshot = gSymbolIndex.snapshot();
+	bool narrow = snapshot && snapshot == filteredSnapshot && !filteredQuery.empty() &&
+				  searchTerm.compare(0, filteredQuery.size(), filteredQuery) == 0;
+	if (searchTerm != filteredQuery)
+	{
+		selectedIndex = 0;
+	}
+	filteredSnapshot = snapshot;
+	filteredQuery = searchTerm;
+	filteredList.clear();
+
+	// Listing every symbol of the workspace helps nobody
+	if (!snapshot || searchTerm.empty())
+	{
+		matchedIds.clear();
+		return;
+	}
+
+	FuzzyQuery query(searchTerm);
+	std::vector<Scored> scored =
+		scoreCandidates(*snapshot, query, narrow ? &matchedIds : nullptr);
+	matchedIds.resize(scored.size());
+	for (size_t i = 0; i < scored.size(); i++)
+	{
+		matchedIds[i] = scored[i].id;
+	}
+
+	// Only the rows that can be shown get sorted
+	size_t keep = std::min(scored.size(), MAX_RESULTS);
+	const SymbolSnapshot &symbols = *snapshot;
+	std::partial_sort(scored.begin(),
+					  scored.begin() + keep,
+					  scored.end(),
+					  [&symbols](const Scored &a, const Scored &b) {
+						  if (a.score != b.score)
+						  {
+							  return a.score > b.score;
+						  }
+						  size_t lengthA = symbols.qualifiedName(a.id).size();
+						  size_t lengthB = symbols.qualifiedName(b.id).size();
+						  if (lengthA != lengthB)
+						  {
+							  return lengthA < lengthB;
+						  }
+						  return a.id < b.id;
+					  });
+	filteredList.reserve(keep);
+	for (size_t i = 0; i < keep; i++)
+	{
+		filteredList.push_back(scored[i].id);
+	}
+	selectedIndex = std::min(selectedIndex, std::max(0, static_cast<int>(keep) - 1));
+}
+
+std::vector<SymbolSearch::Scored>
+SymbolSearch::scoreCandidates(const SymbolSnapshot &snapshot,
+							  const FuzzyQuery &query,
+							  const std::vector<uint32_t> *candidates) const
+{
+	size_t count = candidates ? candidates->size() : snapshot.size();
+	auto scoreRange = [&](size_t begin, size_t end, std::vector<Scored> &out) {
+		for (size_t i = begin; i < end; i++)
+		{
+			uint32_t id = candidates ? (*candidates)[i] : static_cast<uint32_t>(i);
+			if (!snapshot.live(id))
+			{
+				continue;
+			}
+			int score = snapshot.score(query, id);
+			if (score != FuzzyQuery::NO_MATCH)
+			{
+				out.push_back({id, score});
+			}
+		}
+	};
+
+	std::vector<Scored> scored;
+	size_t threads = std::min<size_t>(std::thread::hardware_concurrency(), MAX_THREADS);
+	if (count < PARALLEL_THRESHOLD || threads < 2)
+	{
+		scoreRange(0, count, scored);
+		return scored;
+	}
+
+	// Each thread takes a contiguous slice, so the joined result stays in id
+	// order
+	std::vector<std::vector<Scored>> parts(threads);
+	std::vector<std::thread> workers;
+	size_t slice = (count + threads - 1) / threads;
+	for (size_t t = 1; t < threads; t++)
+	{
+		size_t begin = std::min(count, t * slice);
+		size_t end = std::min(count, begin + slice);
+		workers.emplace_back(scoreRange, begin, end, std::ref(parts[t]));
+	}
+	scoreRange(0, std::min(count, slice), parts[0]);
+	for (std::thread &worker : workers)
+	{
+		worker.join();
+	}
+
+	size_t total = 0;
+	for (const auto &part : parts)
+	{
+		total += part.size();
+	}
+	scored.reserve(total);
+	for (const auto &part : parts)
+	{
+		scored.insert(scored.end(), part.begin(), part.end());
+	}
+	return scored;
+}
+
+void SymbolSearch::openSelected(int index)
+{
+	if (!filteredSnapshot || index < 0 || index >= static_cast<int>(filteredList.size()))
+	{
+		return;
+	}
+	uint32_t id = filteredList[index];
+	std::string path = filteredSnapshot->fullPath(id);
+	int line = static_cast<int>(filteredSnapshot->line(id));
+	int column = static_cast<int>(filteredSnapshot->column(id));
+	toggleWindow();
+
+	if (path != gFileExplorer.currentFile)
+	{
+		gFileExplorer.loadFileContent(path, [line, column]() {
+			gEditorScroll.pending_cursor_centering = true;
+			gEditorScroll.pending_cursor_line = line;
+			gEditorScroll.pending_cursor_char = column;
+		});
+		return;
+	}
+
+	// The file may have changed since it was indexed
+	const std::vector<int> &lines = editor_state.editor_content_lines;
+	int start = line < static_cast<int>(lines.size()) ? lines[line] : 0;
+	int size = static_cast<int>(editor_state.fileContent.size());
+	editor_state.cursor_index = std::min(start + column, size);
+	editor_state.selection_active = false;
+	editor_state.center_cursor_vertical = true;
+	gEditorScroll.centerCursorVertically();
+}
+
+// Helper: Render window header (setup and title)
+void SymbolSearch::renderHeader()
+{
+	ImVec2 windowSize(600, 350);
+	if (isEmbedded)
+	{
+		// In embedded mode, center the window within the editor pane
+		ImVec2 windowPos =
+			ImVec2(editorPanePos.x + editorPaneSize.x * 0.5f - windowSize.x * 0.5f,
+				   editorPanePos.y + editorPaneSize.y * 0.5f - windowSize.y * 0.5f);
+		ImGui::SetNextWindowSize(windowSize, ImGuiCond_Always);
+		ImGui::SetNextWindowPos(windowPos, ImGuiCond_Always);
+	} else
+	{
+		ImVec2 windowPos = ImVec2(ImGui::GetIO().DisplaySize.x * 0.5f,
+								  ImGui::GetIO().DisplaySize.y * 0.35f);
+		ImGui::SetNextWindowSize(windowSize, ImGuiCond_Always);
+		ImGui::SetNextWindowPos(windowPos, ImGuiCond_Always, ImVec2(0.5f, 0.5f));
+	}
+	ImGuiWindowFlags windowFlags = ImGuiWindowFlags_NoTitleBar |
+								   ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove |
+								   ImGuiWindowFlags_NoScrollbar |
+								   ImGuiWindowFlags_NoScrollWithMouse;
+	// Push window style (3 style vars, 3 style colors)
+	ImGui::PushStyleVar(ImGuiStyleVar_WindowRounding, 10.0f);
+	ImGui::PushStyleVar(ImGuiStyleVar_WindowBorderSize, 1.0f);
+	ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(16.0f, 16.0f));
+	ImGui::PushStyleColor(
+		ImGuiCol_WindowBg,
+		ImVec4(gSettings.getSettings()["backgroundColor"][0].get<float>() * .8,
+			   gSettings.getSettings()["backgroundColor"][1].get<float>() * .8,
+			   gSettings.getSettings()["backgroundColor"][2].get<float>() * .8,
+			   1.0f));
+	ImGui::PushStyleColor(ImGuiCol_Border, ImVec4(0.3f, 0.3f, 0.3f, 1.0f));
+	ImGui::PushStyleColor(
+		ImGuiCol_FrameBg,
+		ImVec4(gSettings.getSettings()["backgroundColor"][0].get<float>() * .8,
+			   gSettings.getSettings()["backgroundColor"][1].get<float>() * .8,
+			   gSettings.getSettings()["backgroundColor"][2].get<float>() * .8,
+			   1.0f));
+
+	ImGui::Begin("SymbolSearch", nullptr, windowFlags);
+
+	ImGui::TextUnformatted("Go to Symbol");
+	ImGui::Spacing();
+	ImGui::Spacing();
+
+	if (!wasKeyboardFocusSet)
+	{
+		ImGui::SetKeyboardFocusHere();
+		wasKeyboardFocusSet = true;
+	}
+}
+
+void SymbolSearch::renderSearchInput()
+{
+	ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x);
+	ImGui::PushStyleVar(ImGuiStyleVar_FrameRounding, 4.0f);
+	ImGui::PushStyleVar(ImGuiStyleVar_FrameBorderSize, 1.0f);
+	ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(8, 8));
+	ImGui::PushStyleColor(ImGuiCol_Border, ImVec4(0.3f, 0.3f, 0.3f, 1.0f));
+
+	// Keep the query focused so typing always goes to it
+	ImGui::SetKeyboardFocusHere();
+	ImGui::InputText("##SymbolSearchInput", searchBuffer, sizeof(searchBuffer));
+
+	ImGui::PopStyleColor();
+	ImGui::PopStyleVar(3);
+	ImGui::PopItemWidth();
+}
+
+void SymbolSearch::renderStatus()
+{
+	if (!gSettings.getSnapshot()->symbolIndex)
+	{
+		ImGui::TextDisabled("Turn on Symbol Index in the settings to index symbols");
+		return;
+	}
+	if (gSymbolIndex.isIndexing())
+	{
+		ImGui::TextDisabled("Indexing %zu/%zu files",
+							gSymbolIndex.filesParsed(),
+							gSymbolIndex.filesToParse());
+		return;
+	}
+	if (filteredQuery.empty())
+	{
+		ImGui::TextDisabled("Type a symbol name");
+	} else if (filteredList.empty())
+	{
+		ImGui::TextDisabled("No matching symbols");
+	} else
+	{
+		ImGui::TextDisabled("%zu symbols", matchedIds.size());
+	}
+}
+
+void SymbolSearch::renderResults()
+{
+	ImGui::PushStyleColor(ImGuiCol_ChildBg, ImVec4(0, 0, 0, 0));
+	ImGui::PushStyleColor(ImGuiCol_Border, ImVec4(0, 0, 0, 0));
+	ImGui::BeginChild("SymbolSearchResults",
+					  ImVec2(0, -ImGui::GetFrameHeightWithSpacing()),
+					  false);
+
+	ImGui::PushStyleVar(ImGuiStyleVar_SelectableTextAlign, ImVec2(0.0f, 0.5f));
+	ImGui::PushStyleColor(ImGuiCol_Header,
+						  ImVec4(1.0f, 0.1f, 0.7f, 0.4f)); // Selection color
+	ImGui::PushStyleColor(ImGuiCol_HeaderHovered, ImVec4(1.0f, 0.1f, 0.7f, 0.2f));
+
+	const ImVec4 dimColor(0.6f, 0.6f, 0.6f, 1.0f);
+	int clickedRow = -1;
+
+	ImGuiListClipper clipper;
+	clipper.Begin(static_cast<int>(filteredList.size()));
+	if (scrollToSelection && selectedIndex < static_cast<int>(filteredList.size()))
+	{
+		clipper.IncludeItemByIndex(selectedIndex);
+	}
+	while (clipper.Step())
+	{
+		for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i)
+		{
+			uint32_t id = filteredList[i];
+			bool isSelected = i == selectedIndex;
+			ImGui::PushID(i);
+			if (ImGui::Selectable(
+					"##symbol", isSelected, ImGuiSelectableFlags_SpanAllColumns))
+			{
+				clickedRow = i;
+			}
+			if (isSelected && scrollToSelection)
+			{
+				ImGui::SetScrollHereY(0.5f);
+				scrollToSelection = false;
+			}
+
+			std::string_view path = filteredSnapshot->path(id);
+			size_t slash = path.find_last_of("/\\");
+			std::string filename(path.substr(slash + 1)); // npos + 1 is 0
+			IconRef icon = gFileExplorer.getIconForFile(filename);
+			float iconSize = ImGui::GetTextLineHeight();
+			ImGui::SameLine();
+			ImGui::Image(icon.texture, ImVec2(iconSize, iconSize), icon.uv0, icon.uv1);
+			ImGui::SameLine();
+			std::string_view name = filteredSnapshot->name(id);
+			ImGui::TextUnformatted(name.data(), name.data() + name.size());
+
+			std::string_view container = filteredSnapshot->container(id);
+			ImGui::SameLine();
+			ImGui::TextColored(dimColor,
+							   "%.*s%s%s  %.*s:%u",
+							   static_cast<int>(container.size()),
+							   container.data(),
+							   container.empty() ? "" : " ",
+							   symbolKindName(filteredSnapshot->kind(id)),
+							   static_cast<int>(path.size()),
+							   path.data(),
+							   filteredSnapshot->line(id) + 1);
+			ImGui::PopID();
+		}
+	}
+
+	ImGui::PopStyleColor(2);
+	ImGui::PopStyleVar();
+	ImGui::EndChild();
+	ImGui::PopStyleColor(2);
+
+	if (clickedRow >= 0)
+	{
+		openSelected(clickedRow);
+	}
+}
+
+void SymbolSearch::renderWindow()
+{
+	// Toggle with Ctrl+Shift+J
+	ImGuiIO &io = ImGui::GetIO();
+	if ((io.KeyCtrl || io.KeySuper) && io.KeyShift &&
+		ImGui::IsKeyPressed(ImGuiKey_J, false))
+	{
+		toggleWindow();
+		return;
+	}
+	if (!showWindow)
+		return;
+
+	if (ImGui::IsKeyPressed(ImGuiKey_Escape))
+	{
+		toggleWindow();
+		return;
+	}
+
+	renderHeader();
+
+	if (ImGui::IsMouseClicked(ImGuiMouseButton_Left) &&
+		!ImGui::IsWindowHovered(ImGuiHoveredFlags_ChildWindows))
+	{
+		toggleWindow();
+		ImGui::End();
+		ImGui::PopStyleColor(3);
+		ImGui::PopStyleVar(3);
+		return;
+	}
+
+	if (ImGui::IsKeyPressed(ImGuiKey_UpArrow) && selectedIndex > 0)
+	{
+		selectedIndex--;
+		scrollToSelection = true;
+	}
+	if (ImGui::IsKeyPressed(ImGuiKey_DownArrow) &&
+		selectedIndex < static_cast<int>(filteredList.size()) - 1)
+	{
+		selectedIndex++;
+		scrollToSelection = true;
+	}
+
+	renderSearchInput();
+	std::string searchTerm(searchBuffer);
+	std::transform(searchTerm.begin(), searchTerm.end(), searchTerm.begin(), ::tolower);
+	// Also while indexing, as partial results get published
+	if (searchTerm != filteredQuery || filteredVersion != gSymbolIndex.version())
+	{
+		updateFilteredList();
+	}
+
+	if (ImGui::IsKeyPressed(ImGuiKey_Enter, false) ||
+		ImGui::IsKeyPressed(ImGuiKey_KeypadEnter, false))
+	{
+		ImGui::End();
+		ImGui::PopStyleColor(3);
+		ImGui::PopStyleVar(3);
+		openSelected(selectedIndex);
+		return;
+	}
+
+	ImGui::Spacing();
+	renderStatus();
+	ImGui::Spacing();
+
+	renderResults();
+
+	ImGui::Separator();
+	ImGui::Text("Enter to open, Ctrl+Shift+J or ESC to close");
+	ImGui::End();
+	// Pop the window style colors and vars pushed in renderHeader()
+	ImGui::PopStyleColor(3);
+	ImGui::PopStyleVar(3);
+}
@@ -0,0 +1,71 @@
+// symbol_search.h
+
+#pragma once
+#include "imgui.h"
+#include "symbol_index.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Go-to-symbol popup over the workspace symbol index. Queries narrow the
+// previous matches when they extend them, like the file finder.
+class SymbolSearch
+{
+  private:
+	char searchBuffer[256] = "";
+	bool wasKeyboardFocusSet = false;
+
+	// Best matches first, as ids into `filteredSnapshot`
+	std::shared_ptr<const SymbolSnapshot> filteredSnapshot;
+	std::vector<uint32_t> filteredList;
+	std::string filteredQuery;
+	uint64_t filteredVersion = 0; // gSymbolIndex version behind the list
+
+	// Everything the last query matched, in id order
+	std::vector<uint32_t> matchedIds;
+
+	struct Scored
+	{
+		uint32_t id;
+		int score;
+	};
+
+	static constexpr size_t MAX_RESULTS = 1000;
+	// Below this many candidates spawning threads costs more than it saves
+	static constexpr size_t PARALLEL_THRESHOLD = 16384;
+	static constexpr size_t MAX_THREADS = 8;
+
+	int selectedIndex = 0;
+	bool scrollToSelection = false;
+
+	// Embedded mode support
+	bool isEmbedded = false;
+	ImVec2 editorPanePos;
+	ImVec2 editorPaneSize;
+
+	void updateFilteredList();
+	std::vector<Scored> scoreCandidates(const SymbolSnapshot &snapshot,
+										const FuzzyQuery &query,
+										const std::vector<uint32_t> *candidates) const;
+	void openSelected(int index);
+
+	void renderHeader();
+	void renderSearchInput();
+	void renderStatus();
+	void renderResults();
+
+  public:
+	bool showWindow = false;
+	void toggleWindow();
+	bool isWindowOpen() const { return showWindow; }
+	void renderWindow();
+
+	void setEmbedded(bool embedded) { isEmbedded = embedded; }
+	void setEditorPaneBounds(const ImVec2 &pos, const ImVec2 &size)
+	{
+		editorPanePos = pos;
+		editorPaneSize = size;
+	}
+};
+
+extern SymbolSearch gSymbolSearch;
@@ -0,0 +1,965 @@
+/*
+	File: trigram_index.cpp
+	Description: Building, mapping and querying the workspace trigram index.
+*/
+
+#include "trigram_index.h"
+#include "workspace_grep.h"
+#include "workspace_index.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+TrigramIndex gTrigramIndex;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char MAGIC[8] = {'N', 'E', 'D', 'T', 'R', 'I', 'G', '\0'};
+
+inline unsigned char foldAscii(unsigned char c)
+{
+	return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c + ('a' - 'A')) : c;
+}
+
+inline uint32_t trigramAt(const unsigned char *p)
+{
+	return (uint32_t(foldAscii(p[0])) << 16) | (uint32_t(foldAscii(p[1])) << 8) |
+		   foldAscii(p[2]);
+}
+
+inline bool spansNewline(const unsigned char *p)
+{
+	return p[0] == '\n' || p[1] == '\n' || p[2] == '\n';
+}
+
+std::string genericUtf8(const fs::path &path)
+{
+#ifdef PLATFORM_WINDOWS
+	auto u8 = path.generic_u8string();
+	return std::string(u8.begin(), u8.end());
+#else
+	return path.generic_string();
+#endif
+}
+
+fs::path pathFromUtf8(const std::string &path)
+{
+#ifdef PLATFORM_WINDOWS
+	return fs::u8path(path);
+#else
+	return fs::path(path);
+#endif
+}
+
+// A workspace listing path with '/' separators, as the index stores them
+std::string genericRelative(std::string_view relative)
+{
+	std::string out(relative);
+#ifdef PLATFORM_WINDOWS
+	std::replace(out.begin(), out.end(), '\\', '/');
+#endif
+	return out;
+}
+
+// The workspace index's listing of `indexRoot`, or null until it has one
+std::shared_ptr<const WorkspaceSnapshot> workspaceOf(const std::string &indexRoot)
+{
+	std::shared_ptr<const WorkspaceSnapshot> workspace = gWorkspaceIndex.snapshot();
+	if (!workspace || workspace->root != indexRoot)
+	{
+		return nullptr;
+	}
+	return workspace;
+}
+
+void writeVarint(std::string &out, uint32_t value)
+{
+	while (value >= 0x80)
+	{
+		out.push_back(static_cast<char>(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<char>(value));
+}
+
+// Literal runs every match of `pattern` must contain. Conservative: anything
+// optional, repeated, grouped or classed ends the run, and alternation gives up.
+std::vector<std::string> requiredLiterals(const std::string &pattern)
+{
+	std::vector<std::string> runs;
+	std::string run;
+	auto endRun = [&]() {
+		if (run.size() >= 3)
+		{
+			runs.push_back(run);
+		}
+		run.clear();
+	};
+
+	int depth = 0;
+	for (size_t i = 0; i < pattern.size(); ++i)
+	{
+		char c = pattern[i];
+		if (c == '\\' && i + 1 < pattern.size())
+		{
+			char escaped = pattern[++i];
+			if (std::isalnum(static_cast<unsigned char>(escaped)))
+			{
+				endRun(); // A class like \d or a control escape like \n
+				continue;
+			}
+			c = escaped;
+		} else if (c == '|')
+		{
+			return {};
+		} else if (c == '(' || c == ')')
+		{
+			endRun();
+			depth += c == '(' ? 1 : -1;
+			continue;
+		} else if (c == '[')
+		{
+			endRun();
+			size_t j = i + 1;
+			if (j < pattern.size() && pattern[j] == '^')
+				++j;
+			if (j < pattern.size() && pattern[j] == ']')
+				++j;
+			while (j < pattern.size() && pattern[j] != ']')
+			{
+				j += pattern[j] == '\\' ? 2 : 1;
+			}
+			i = j;
+			continue;
+		} else if (c == '.' || c == '^' || c == '$')
+		{
+			endRun();
+			continue;
+		} else if (c == '*' || c == '?' || c == '{')
+		{
+			// The previous character may be absent
+			if (!run.empty())
+			{
+				run.pop_back();
+			}
+			endRun();
+			if (c == '{')
+			{
+				size_t close = pattern.find('}', i);
+				i = close == std::string::npos ? i : close;
+			}
+			continue;
+		} else if (c == '+')
+		{
+			// Required once, but what follows is not adjacent to the first copy
+			char last = run.empty() ? 0 : run.back();
+			endRun();
+			if (last)
+			{
+				run.push_back(last);
+			}
+			continue;
+		}
+		if (depth == 0)
+		{
+			run.push_back(c);
+		}
+	}
+	endRun();
+	return runs;
+}
+
+void appendTrigrams(const std::string &text, std::vector<uint32_t> &out)
+{
+	const unsigned char *p = reinterpret_cast<const unsigned char *>(text.data());
+	for (size_t i = 0; i + 3 <= text.size(); ++i)
+	{
+		if (!spansNewline(p + i))
+		{
+			out.push_back(trigramAt(p + i));
+		}
+	}
+}
+
+// Unique trigrams of one file, or none for binary and oversized files, which
+// the search skips anyway. `seen` is a 2^24-bit scratch set left cleared.
+void extractFile(const fs::path &path,
+				 size_t maxBytes,
+				 size_t binaryCheckBytes,
+				 std::string &buffer,
+				 std::vector<uint64_t> &seen,
+				 std::vector<uint32_t> &out)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		return;
+	}
+	size_t size = 0;
+	while (file)
+	{
+		if (buffer.size() < size + 64 * 1024)
+		{
+			buffer.resize(std::max(buffer.size() * 2, size + 64 * 1024));
+		}
+		file.read(buffer.data() + size,
+				  static_cast<std::streamsize>(buffer.size() - size));
+		size += static_cast<size_t>(file.gcount());
+		if (size > maxBytes)
+		{
+			return;
+		}
+	}
+	if (std::memchr(buffer.data(), 0, std::min(size, binaryCheckBytes)))
+	{
+		return;
+	}
+
+	const unsigned char *p = reinterpret_cast<const unsigned char *>(buffer.data());
+	for (size_t i = 0; i + 3 <= size; ++i)
+	{
+		if (spansNewline(p + i))
+		{
+			continue;
+		}
+		uint32_t trigram = trigramAt(p + i);
+		uint64_t bit = uint64_t(1) << (trigram & 63);
+		if (!(seen[trigram >> 6] & bit))
+		{
+			seen[trigram >> 6] |= bit;
+			out.push_back(trigram);
+		}
+	}
+	for (uint32_t trigram : out)
+	{
+		seen[trigram >> 6] = 0;
+	}
+}
+
+// A sorted run of postings written while building
+struct RunReader
+{
+	std::ifstream in;
+	uint32_t trigram = 0;
+	uint32_t count = 0;
+	bool valid = false;
+
+	bool next()
+	{
+		valid = static_cast<bool>(in.read(reinterpret_cast<char *>(&trigram), 4) &&
+								  in.read(reinterpret_cast<char *>(&count), 4));
+		return valid;
+	}
+	void readIds(std::vector<uint32_t> &ids)
+	{
+		size_t old = ids.size();
+		ids.resize(old + count);
+		in.read(reinterpret_cast<char *>(ids.data() + old), count * sizeof(uint32_t));
+	}
+};
+
+} // namespace
+
+const TrigramIndex::TrigramRecord *TrigramIndex::Snapshot::find(uint32_t trigram) const
+{
+	const TrigramRecord *end = trigrams + header->trigramCount;
+	const TrigramRecord *it =
+		std::lower_bound(trigrams, end, trigram, [](const TrigramRecord &r, uint32_t t) {
+			return r.trigram < t;
+		});
+	return it != end && it->trigram == trigram ? it : nullptr;
+}
+
+void TrigramIndex::Snapshot::decode(const TrigramRecord &record,
+									std::vector<uint32_t> &out) const
+{
+	const unsigned char *p = postings + record.offset;
+	const unsigned char *end =
+		postings + (header->trigramsOffset - header->postingsOffset);
+	uint32_t id = 0;
+	for (uint32_t i = 0; i < record.count && p < end; ++i)
+	{
+		uint32_t delta = 0;
+		int shift = 0;
+		while (p < end && (*p & 0x80))
+		{
+			delta |= uint32_t(*p++ & 0x7F) << shift;
+			shift += 7;
+		}
+		if (p < end)
+		{
+			delta |= uint32_t(*p++) << shift;
+		}
+		id += delta;
+		if (id < header->fileCount)
+		{
+			out.push_back(id);
+		}
+	}
+}
+
+TrigramIndex::~TrigramIndex() { close(); }
+
+void TrigramIndex::open(const std::string &indexRoot)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (indexRoot == root && worker.joinable())
+		{
+			return;
+		}
+	}
+	close();
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		root = indexRoot;
+		stopping = false;
+		worker = std::thread(&TrigramIndex::run, this, indexRoot);
+	}
+	// Files written outside the editor, where inotify reports them
+	listenerId = gWorkspaceIndex.addChangeListener(
+		[this](const std::string &relative) { noteRelative(relative); });
+}
+
+void TrigramIndex::close()
+{
+	// First, so no listener call is left waiting on the lock below
+	if (listenerId >= 0)
+	{
+		gWorkspaceIndex.removeChangeListener(listenerId);
+		listenerId = -1;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wakeup.notify_all();
+	if (worker.joinable())
+	{
+		worker.join();
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	root.clear();
+	snapshot.reset();
+	dirty.clear();
+	noted.clear();
+}
+
+bool TrigramIndex::shouldStop()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stopping;
+}
+
+fs::path TrigramIndex::indexPath(const std::string &indexRoot) const
+{
+	return pathFromUtf8(indexRoot) / FILE_NAME;
+}
+
+void TrigramIndex::noteFileChanged(const std::string &path)
+{
+	std::string relative;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (root.empty())
+		{
+			return;
+		}
+		relative =
+			genericUtf8(pathFromUtf8(path).lexically_relative(pathFromUtf8(root)));
+	}
+	if (relative.empty() || relative.rfind("..", 0) == 0)
+	{
+		return;
+	}
+	noteRelative(std::move(relative));
+}
+
+void TrigramIndex::noteRelative(std::string relative)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (root.empty() || stopping)
+	{
+		return;
+	}
+	dirty.insert(relative);
+	noted.push_back(std::move(relative));
+}
+
+bool TrigramIndex::candidates(const GrepQuery &query, std::vector<std::string> &out)
+{
+	std::vector<uint32_t> required = queryTrigrams(query);
+	if (required.empty())
+	{
+		return false;
+	}
+
+	std::shared_ptr<const Snapshot> snap;
+	std::unordered_set<std::string> extra;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!snapshot || root != query.root)
+		{
+			return false;
+		}
+		snap = snapshot;
+		extra = dirty;
+	}
+
+	// Intersect from the rarest trigram up, so the working set only shrinks
+	std::vector<const TrigramRecord *> records;
+	bool missing = false;
+	for (uint32_t trigram : required)
+	{
+		const TrigramRecord *record = snap->find(trigram);
+		if (!record)
+		{
+			missing = true;
+			break;
+		}
+		records.push_back(record);
+	}
+
+	std::vector<uint32_t> ids;
+	if (!missing)
+	{
+		std::sort(records.begin(),
+				  records.end(),
+				  [](const TrigramRecord *a, const TrigramRecord *b) {
+					  return a->count < b->count;
+				  });
+		snap->decode(*records[0], ids);
+		std::vector<uint32_t> next;
+		std::vector<uint32_t> merged;
+		for (size_t i = 1; i < records.size() && !ids.empty(); ++i)
+		{
+			next.clear();
+			merged.clear();
+			snap->decode(*records[i], next);
+			std::set_intersection(ids.begin(),
+								  ids.end(),
+								  next.begin(),
+								  next.end(),
+								  std::back_inserter(merged));
+			ids.swap(merged);
+		}
+	}
+
+	out.reserve(out.size() + ids.size() + extra.size());
+	for (uint32_t id : ids)
+	{
+		std::string path(snap->path(id));
+		if (!extra.count(path))
+		{
+			out.push_back(std::move(path));
+		}
+	}
+	out.insert(out.end(), extra.begin(), extra.end());
+	return true;
+}
+
+std::vector<uint32_t> TrigramIndex::queryTrigrams(const GrepQuery &query)
+{
+	std::vector<uint32_t> trigrams;
+	if (query.regex)
+	{
+		for (const std::string &literal : requiredLiterals(query.pattern))
+		{
+			appendTrigrams(literal, trigrams);
+		}
+	} else
+	{
+		appendTrigrams(query.pattern, trigrams);
+	}
+	std::sort(trigrams.begin(), trigrams.end());
+	trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+	return trigrams;
+}
+
+void TrigramIndex::run(std::string indexRoot)
+{
+	using namespace std::chrono;
+
+	// The files to index are the workspace index's, so wait for its first walk
+	std::shared_ptr<const WorkspaceSnapshot> workspace;
+	while (!(workspace = workspaceOf(indexRoot)))
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if (wakeup.wait_for(lock, seconds(1), [this] { return stopping; }))
+		{
+			return;
+		}
+	}
+	uint64_t seenWorkspace = workspace->version;
+	steady_clock::time_point lastStat = steady_clock::now();
+
+	std::shared_ptr<const Snapshot> snap = load(indexPath(indexRoot));
+	bool needsBuild = !snap || tooDrifted(*snap, refresh(indexRoot, *workspace, snap));
+
+	while (!shouldStop())
+	{
+		if (needsBuild)
+		{
+			auto start = steady_clock::now();
+			if (build(indexRoot, *workspace))
+			{
+				auto elapsed = duration_cast<milliseconds>(steady_clock::now() - start);
+				std::cout << "[TrigramIndex] Indexed " << indexRoot << " in "
+						  << elapsed.count() << " ms" << std::endl;
+			} else if (!shouldStop())
+			{
+				std::cerr << "[TrigramIndex] Failed to build the index of " << indexRoot
+						  << std::endl;
+			}
+			lastStat = steady_clock::now();
+			needsBuild = false;
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wakeup.wait_for(lock, seconds(1), [this] { return stopping; });
+			if (stopping)
+			{
+				return;
+			}
+			snap = snapshot;
+		}
+
+		// Files that appeared whenever the workspace changes, and a stat of
+		// every file now and then for edits nobody reported
+		auto now = steady_clock::now();
+		bool statFiles = now - lastStat >= seconds(REFRESH_SECONDS);
+		if (!statFiles && gWorkspaceIndex.version() == seenWorkspace)
+		{
+			continue;
+		}
+		std::shared_ptr<const WorkspaceSnapshot> latest = workspaceOf(indexRoot);
+		if (!latest)
+		{
+			continue;
+		}
+		workspace = std::move(latest);
+		seenWorkspace = workspace->version;
+		if (statFiles)
+		{
+			lastStat = now;
+			needsBuild = !snap || tooDrifted(*snap, refresh(indexRoot, *workspace, snap));
+		} else if (snap)
+		{
+			addAppeared(*workspace, *snap);
+		}
+	}
+}
+
+bool TrigramIndex::tooDrifted(const Snapshot &snap, size_t drift)
+{
+	return drift > std::max<size_t>(1000, snap.header->fileCount / 20);
+}
+
+bool TrigramIndex::listFiles(const std::string &indexRoot,
+							 const WorkspaceSnapshot &workspace,
+							 std::vector<FileStat> &out)
+{
+	const fs::path rootPath = pathFromUtf8(indexRoot);
+	out.reserve(workspace.files.size());
+	for (uint32_t id = 0; id < workspace.files.size(); ++id)
+	{
+		if (id % 1024 == 0 && shouldStop())
+		{
+			return false;
+		}
+		std::string relative = genericRelative(workspace.files.path(id));
+		const fs::path path = rootPath / pathFromUtf8(relative);
+
+		// Symlinks are left out, as whatever they point to is indexed on its own
+		std::error_code status_ec;
+		fs::file_status status = fs::symlink_status(path, status_ec);
+		if (status_ec || !fs::is_regular_file(status))
+		{
+			continue;
+		}
+		std::error_code size_ec;
+		std::error_code time_ec;
+		uint64_t size = fs::file_size(path, size_ec);
+		auto mtime = fs::last_write_time(path, time_ec);
+		if (size_ec || time_ec)
+		{
+			continue;
+		}
+		out.push_back(
+			{std::move(relative), size, int64_t(mtime.time_since_epoch().count())});
+	}
+	std::sort(out.begin(), out.end(), [](const FileStat &a, const FileStat &b) {
+		return a.relative < b.relative;
+	});
+	return true;
+}
+
+void TrigramIndex::addAppeared(const WorkspaceSnapshot &workspace, const Snapshot &snap)
+{
+	std::vector<std::string> appeared;
+	for (uint32_t id = 0; id < workspace.files.size(); ++id)
+	{
+		std::string relative = genericRelative(workspace.files.path(id));
+		if (!snap.ids.count(relative))
+		{
+			appeared.push_back(std::move(relative));
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	dirty.insert(std::make_move_iterator(appeared.begin()),
+				 std::make_move_iterator(appeared.end()));
+}
+
+std::shared_ptr<TrigramIndex::Snapshot> TrigramIndex::load(const fs::path &path)
+{
+	auto snap = std::make_shared<Snapshot>();
+	if (!snap->file.open(path) || snap->file.size() < sizeof(Header))
+	{
+		return nullptr;
+	}
+	const char *data = snap->file.data();
+	const size_t size = snap->file.size();
+	const Header *header = reinterpret_cast<const Header *>(data);
+
+	// Reject anything truncated or from another version rather than trusting it
+	bool valid =
+		std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0 &&
+		header->version == VERSION && header->totalSize == size &&
+		header->filesOffset % alignof(FileRecord) == 0 &&
+		header->trigramsOffset % alignof(TrigramRecord) == 0 &&
+		header->filesOffset + uint64_t(header->fileCount) * sizeof(FileRecord) <=
+			header->pathsOffset &&
+		header->pathsOffset <= header->postingsOffset &&
+		header->postingsOffset <= header->trigramsOffset &&
+		header->trigramsOffset + header->trigramCount * sizeof(TrigramRecord) <= size;
+	if (!valid)
+	{
+		std::cerr << "[TrigramIndex] Ignoring invalid index " << path << std::endl;
+		return nullptr;
+	}
+
+	snap->header = header;
+	snap->files = reinterpret_cast<const FileRecord *>(data + header->filesOffset);
+	snap->paths = data + header->pathsOffset;
+	snap->postings =
+		reinterpret_cast<const unsigned char *>(data + header->postingsOffset);
+	snap->trigrams =
+		reinterpret_cast<const TrigramRecord *>(data + header->trigramsOffset);
+
+	const uint64_t pathsSize = header->postingsOffset - header->pathsOffset;
+	snap->ids.reserve(header->fileCount);
+	for (uint32_t id = 0; id < header->fileCount; ++id)
+	{
+		const FileRecord &record = snap->files[id];
+		if (record.pathOffset + record.pathLength > pathsSize)
+		{
+			return nullptr;
+		}
+		snap->ids.emplace(snap->path(id), id);
+	}
+	const uint64_t postingsSize = header->trigramsOffset - header->postingsOffset;
+	for (uint64_t i = 0; i < header->trigramCount; ++i)
+	{
+		if (snap->trigrams[i].offset > postingsSize)
+		{
+			return nullptr;
+		}
+	}
+	return snap;
+}
+
+size_t TrigramIndex::refresh(const std::string &indexRoot,
+							 const WorkspaceSnapshot &workspace,
+							 std::shared_ptr<const Snapshot> snap)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		noted.clear();
+	}
+	std::vector<FileStat> files;
+	if (!listFiles(indexRoot, workspace, files))
+	{
+		return 0;
+	}
+
+	std::unordered_set<std::string> drifted;
+	size_t indexed = 0;
+	for (FileStat &file : files)
+	{
+		auto it = snap->ids.find(file.relative);
+		if (it == snap->ids.end())
+		{
+			drifted.insert(std::move(file.relative));
+			continue;
+		}
+		indexed++;
+		const FileRecord &record = snap->files[it->second];
+		if (record.size != file.size || record.mtime != file.mtime)
+		{
+			drifted.insert(std::move(file.relative));
+		}
+	}
+	const size_t deleted = snap->header->fileCount - indexed;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	// Saves noted during the walk may predate the stat it took
+	drifted.insert(noted.begin(), noted.end());
+	noted.clear();
+	dirty = std::move(drifted);
+	snapshot = std::move(snap);
+	return dirty.size() + deleted;
+}
+
+bool TrigramIndex::build(const std::string &indexRoot, const WorkspaceSnapshot &workspace)
+{
+	std::vector<FileStat> files;
+	if (!listFiles(indexRoot, workspace, files))
+	{
+		return false;
+	}
+	const fs::path target = indexPath(indexRoot);
+	std::vector<fs::path> runs;
+	auto removeRuns = [&]() {
+		std::error_code ec;
+		for (const fs::path &run : runs)
+		{
+			fs::remove(run, ec);
+		}
+	};
+
+	// Posting lists are built in memory a slice of files at a time and spilled as
+	// sorted runs, so memory stays bounded however large the workspace is
+	std::unordered_map<uint32_t, std::vector<uint32_t>> postings;
+	size_t entries = 0;
+	auto flushRun = [&]() -> bool {
+		if (postings.empty())
+		{
+			return true;
+		}
+		std::vector<uint32_t> keys;
+		keys.reserve(postings.size());
+		for (const auto &[trigram, ids] : postings)
+		{
+			keys.push_back(trigram);
+		}
+		std::sort(keys.begin(), keys.end());
+
+		fs::path runPath = target;
+		runPath += ".run" + std::to_string(runs.size()) + ".tmp";
+		runs.push_back(runPath);
+		std::ofstream out(runPath, std::ios::binary | std::ios::trunc);
+		for (uint32_t trigram : keys)
+		{
+			const std::vector<uint32_t> &ids = postings[trigram];
+			uint32_t count = static_cast<uint32_t>(ids.size());
+			out.write(reinterpret_cast<const char *>(&trigram), sizeof(trigram));
+			out.write(reinterpret_cast<const char *>(&count), sizeof(count));
+			out.write(reinterpret_cast<const char *>(ids.data()),
+					  count * sizeof(uint32_t));
+		}
+		postings.clear();
+		entries = 0;
+		return static_cast<bool>(out);
+	};
+
+	// Trigrams are extracted in parallel a wave of files at a time, then appended
+	// in file order so every posting list comes out sorted
+	const fs::path rootPath = pathFromUtf8(indexRoot);
+	const size_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+	const size_t waveSize = threadCount * 256;
+	std::vector<std::vector<uint64_t>> seen(threadCount,
+											std::vector<uint64_t>((1u << 24) / 64));
+	std::vector<std::string> buffers(threadCount);
+	std::vector<std::vector<uint32_t>> perFile;
+
+	for (size_t waveStart = 0; waveStart < files.size(); waveStart += waveSize)
+	{
+		if (shouldStop())
+		{
+			removeRuns();
+			return false;
+		}
+		const size_t waveEnd = std::min(files.size(), waveStart + waveSize);
+		perFile.assign(waveEnd - waveStart, {});
+		std::atomic<size_t> next{waveStart};
+		auto extract = [&](size_t thread) {
+			for (size_t i; (i = next++) < waveEnd;)
+			{
+				extractFile(rootPath / pathFromUtf8(files[i].relative),
+							MAX_FILE_BYTES,
+							BINARY_CHECK_BYTES,
+							buffers[thread],
+							seen[thread],
+							perFile[i - waveStart]);
+			}
+		};
+		std::vector<std::thread> pool;
+		for (size_t t = 1; t < threadCount; ++t)
+		{
+			pool.emplace_back(extract, t);
+		}
+		extract(0);
+		for (std::thread &thread : pool)
+		{
+			thread.join();
+		}
+
+		for (size_t i = waveStart; i < waveEnd; ++i)
+		{
+			for (uint32_t trigram : perFile[i - waveStart])
+			{
+				postings[trigram].push_back(static_cast<uint32_t>(i));
+			}
+			entries += perFile[i - waveStart].size();
+		}
+		if (entries >= RUN_ENTRIES && !flushRun())
+		{
+			removeRuns();
+			return false;
+		}
+	}
+	if (!flushRun())
+	{
+		removeRuns();
+		return false;
+	}
+
+	fs::path temp = target;
+	temp += ".tmp";
+	std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+	if (!out)
+	{
+		removeRuns();
+		return false;
+	}
+
+	Header header{};
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.fileCount = static_cast<uint32_t>(files.size());
+	header.filesOffset = sizeof(Header);
+	out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+	uint64_t pathOffset = 0;
+	for (const FileStat &file : files)
+	{
+		FileRecord record{};
+		record.size = file.size;
+		record.mtime = file.mtime;
+		record.pathOffset = pathOffset;
+		record.pathLength = static_cast<uint32_t>(file.relative.size());
+		out.write(reinterpret_cast<const char *>(&record), sizeof(record));
+		pathOffset += file.relative.size();
+	}
+	header.pathsOffset = header.filesOffset + files.size() * sizeof(FileRecord);
+	for (const FileStat &file : files)
+	{
+		out.write(file.relative.data(),
+				  static_cast<std::streamsize>(file.relative.size()));
+	}
+	header.postingsOffset = header.pathsOffset + pathOffset;
+
+	// Merge the runs; they cover increasing file ranges, so reading them in
+	// order keeps each list sorted
+	std::vector<std::unique_ptr<RunReader>> readers;
+	for (const fs::path &run : runs)
+	{
+		auto reader = std::make_unique<RunReader>();
+		reader->in.open(run, std::ios::binary);
+		reader->next();
+		readers.push_back(std::move(reader));
+	}
+	std::vector<TrigramRecord> table;
+	std::vector<uint32_t> ids;
+	std::string encoded;
+	uint64_t postingsSize = 0;
+	while (true)
+	{
+		bool any = false;
+		uint32_t smallest = 0;
+		for (const auto &reader : readers)
+		{
+			if (reader->valid && (!any || reader->trigram < smallest))
+			{
+				smallest = reader->trigram;
+				any = true;
+			}
+		}
+		if (!any)
+		{
+			break;
+		}
+		ids.clear();
+		for (const auto &reader : readers)
+		{
+			if (reader->valid && reader->trigram == smallest)
+			{
+				reader->readIds(ids);
+				reader->next();
+			}
+		}
+		encoded.clear();
+		uint32_t previous = 0;
+		for (uint32_t id : ids)
+		{
+			writeVarint(encoded, id - previous);
+			previous = id;
+		}
+		table.push_back({smallest, static_cast<uint32_t>(ids.size()), postingsSize});
+		out.write(encoded.data(), static_cast<std::streamsize>(encoded.size()));
+		postingsSize += encoded.size();
+	}
+	readers.clear();
+	removeRuns();
+
+	uint64_t end = header.postingsOffset + postingsSize;
+	uint64_t padding = (alignof(TrigramRecord) - end % alignof(TrigramRecord)) %
+					   alignof(TrigramRecord);
+	static const char zeros[alignof(TrigramRecord)] = {};
+	out.write(zeros, static_cast<std::streamsize>(padding));
+	header.trigramsOffset = end + padding;
+	header.trigramCount = table.size();
+	out.write(reinterpret_cast<const char *>(table.data()),
+			  static_cast<std::streamsize>(table.size() * sizeof(TrigramRecord)));
+	header.totalSize = header.trigramsOffset + table.size() * sizeof(TrigramRecord);
+	out.seekp(0);
+	out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	out.close();
+	if (!out)
+	{
+		std::error_code ec;
+		fs::remove(temp, ec);
+		return false;
+	}
+
+	// Windows cannot replace a file that is still mapped
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		snapshot.reset();
+	}
+	std::error_code ec;
+	fs::rename(temp, target, ec);
+	if (ec)
+	{
+		fs::remove(temp, ec);
+		return false;
+	}
+	std::shared_ptr<const Snapshot> snap = load(target);
+	if (!snap)
+	{
+		return false;
+	}
+	refresh(indexRoot, workspace, snap);
+	return true;
+}
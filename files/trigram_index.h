@@ -0,0 +1,150 @@
+/*
+	File: trigram_index.h
+	Description: On-disk trigram index of the workspace, used by the search window
+   to narrow a query down to the files that can match before grepping them.
+
+   The index is built in the background into .ned-search-index next to the undo
+   history and memory-mapped when opened, so a cold start costs one mmap. Every
+   trigram (ASCII case-folded, never spanning a newline) maps to a delta-encoded
+   list of file ids. The files are the workspace index's listing. The file is
+   never patched in place: files that changed since the build, found through
+   saves, the workspace index's change events and a periodic stat of its
+   listing, are searched directly, and the index is rebuilt once too many have
+   drifted.
+*/
+
+#pragma once
+
+#include "mapped_file.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+struct GrepQuery;
+struct WorkspaceSnapshot;
+
+class TrigramIndex
+{
+  public:
+	~TrigramIndex();
+
+	// Opens the index of `root`, building it in the background when missing.
+	// Cheap when `root` is already open.
+	void open(const std::string &root);
+	void close();
+
+	// Files that may contain a match of `query`, relative to the root. Returns
+	// false when the index cannot narrow this query (still building, or the
+	// pattern has no three-character literal); the caller then walks the tree.
+	bool candidates(const GrepQuery &query, std::vector<std::string> &out);
+
+	// A file changed on disk; it is searched directly until the next rebuild
+	void noteFileChanged(const std::string &path);
+
+	static constexpr const char *FILE_NAME = ".ned-search-index";
+
+  private:
+	static constexpr uint32_t VERSION = 1;
+	static constexpr int REFRESH_SECONDS = 60;
+	// Posting entries buffered in memory before a sorted run goes to disk
+	static constexpr size_t RUN_ENTRIES = 32 * 1024 * 1024;
+	static constexpr size_t MAX_FILE_BYTES = 32 * 1024 * 1024;
+	static constexpr size_t BINARY_CHECK_BYTES = 8000;
+
+	struct Header
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t fileCount;
+		uint64_t trigramCount;
+		uint64_t filesOffset;
+		uint64_t pathsOffset;
+		uint64_t postingsOffset;
+		uint64_t trigramsOffset;
+		uint64_t totalSize;
+	};
+
+	struct FileRecord
+	{
+		uint64_t size;
+		int64_t mtime;
+		uint64_t pathOffset;
+		uint32_t pathLength;
+		uint32_t reserved;
+	};
+
+	struct TrigramRecord
+	{
+		uint32_t trigram;
+		uint32_t count;
+		uint64_t offset; // Into the postings, varint deltas of file ids
+	};
+
+	// One opened index file. Immutable once loaded.
+	struct Snapshot
+	{
+		MappedFile file;
+		const Header *header = nullptr;
+		const FileRecord *files = nullptr;
+		const TrigramRecord *trigrams = nullptr;
+		const char *paths = nullptr;
+		const unsigned char *postings = nullptr;
+		std::unordered_map<std::string_view, uint32_t> ids;
+
+		std::string_view path(uint32_t id) const
+		{
+			return {paths + files[id].pathOffset, files[id].pathLength};
+		}
+		const TrigramRecord *find(uint32_t trigram) const;
+		void decode(const TrigramRecord &record, std::vector<uint32_t> &out) const;
+	};
+
+	struct FileStat
+	{
+		std::string relative;
+		uint64_t size;
+		int64_t mtime;
+	};
+
+	std::mutex mutex; // Guards everything below
+	std::condition_variable wakeup;
+	std::string root;
+	std::shared_ptr<const Snapshot> snapshot;
+	std::unordered_set<std::string> dirty; // Relative paths searched directly
+	std::vector<std::string> noted;		   // Noted while a refresh walk runs
+	bool stopping = false;
+	std::thread worker;
+	int listenerId = -1; // gWorkspaceIndex change listener
+
+	void run(std::string indexRoot);
+	bool shouldStop();
+	void noteRelative(std::string relative);
+	std::filesystem::path indexPath(const std::string &indexRoot) const;
+
+	std::shared_ptr<Snapshot> load(const std::filesystem::path &path);
+	bool build(const std::string &indexRoot, const WorkspaceSnapshot &workspace);
+	// Compares the workspace with `snap` and installs it with the resulting dirty
+	// set. Returns how many files drifted, counting deleted ones.
+	size_t refresh(const std::string &indexRoot,
+				   const WorkspaceSnapshot &workspace,
+				   std::shared_ptr<const Snapshot> snap);
+	static bool tooDrifted(const Snapshot &snap, size_t drift);
+	// Stats the workspace's files, sorted by relative path
+	bool listFiles(const std::string &indexRoot,
+				   const WorkspaceSnapshot &workspace,
+				   std::vector<FileStat> &out);
+	// Marks files the workspace gained since `snap` was built as dirty
+	void addAppeared(const WorkspaceSnapshot &workspace, const Snapshot &snap);
+
+	static std::vector<uint32_t> queryTrigrams(const GrepQuery &query);
+};
+
+extern TrigramIndex gTrigramIndex;
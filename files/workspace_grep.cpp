@@ -0,0 +1,458 @@
+/*
+	File: workspace_grep.cpp
+	Description: Worker pool, ignore-aware walk and per-file matching for the
+   workspace search.
+*/
+
+#include "workspace_grep.h"
+#include "../util/redraw.h"
+#include "trigram_index.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string pathToUtf8(const fs::path &path)
+{
+#ifdef PLATFORM_WINDOWS
+	auto u8 = path.u8string();
+	return std::string(u8.begin(), u8.end());
+#else
+	return path.string();
+#endif
+}
+
+fs::path pathFromUtf8(const std::string &path)
+{
+#ifdef PLATFORM_WINDOWS
+	return fs::u8path(path);
+#else
+	return fs::path(path);
+#endif
+}
+
+constexpr size_t READ_CHUNK = 64 * 1024;
+
+} // namespace
+
+WorkspaceGrep::~WorkspaceGrep()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+		generation++;
+	}
+	wakeup.notify_all();
+	for (std::thread &worker : workers)
+	{
+		if (worker.joinable())
+		{
+			worker.join();
+		}
+	}
+}
+
+void WorkspaceGrep::ensureWorkers()
+{
+	if (!workers.empty())
+	{
+		return;
+	}
+	unsigned count = std::max(2u, std::thread::hardware_concurrency());
+	for (unsigned i = 0; i < count; ++i)
+	{
+		workers.emplace_back(&WorkspaceGrep::workerLoop, this);
+	}
+}
+
+bool WorkspaceGrep::start(const GrepQuery &query, std::string &error)
+{
+	if (query.pattern.empty() || query.root.empty())
+	{
+		cancel();
+		return true;
+	}
+
+	auto search = std::make_shared<Search>();
+	search->query = query;
+	if (query.regex)
+	{
+		if (!search->regex.compile(query.pattern, query.ignoreCase, error))
+		{
+			cancel();
+			return false;
+		}
+	} else
+	{
+		search->literal = LiteralSearch(query.pattern, query.ignoreCase);
+	}
+
+	// The index answers in milliseconds but only for patterns it can narrow
+	std::vector<std::string> candidates;
+	bool indexed = false;
+	if (query.useIndex)
+	{
+		gTrigramIndex.open(query.root);
+		indexed = gTrigramIndex.candidates(query, candidates);
+	} else
+	{
+		gTrigramIndex.close();
+	}
+
+	ensureWorkers();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		generation++;
+		queue.clear();
+		busy = 0;
+		current = search;
+		truncated = false;
+		file_capped = false;
+		files_searched = 0;
+		{
+			std::lock_guard<std::mutex> results_lock(resultsMutex);
+			pending.clear();
+			match_count = 0;
+		}
+		if (!indexed)
+		{
+			queue.push_back({pathFromUtf8(query.root), "", nullptr, {}});
+		}
+		for (size_t i = 0; i < candidates.size(); i += INDEX_BATCH)
+		{
+			Task batch;
+			batch.dir = pathFromUtf8(query.root);
+			auto first = candidates.begin() + i;
+			auto last = candidates.begin() + std::min(candidates.size(), i + INDEX_BATCH);
+			batch.files.assign(std::make_move_iterator(first),
+							   std::make_move_iterator(last));
+			queue.push_back(std::move(batch));
+		}
+		running = !queue.empty();
+	}
+	wakeup.notify_all();
+	gRedraw.request();
+	return true;
+}
+
+void WorkspaceGrep::cancel()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	generation++;
+	queue.clear();
+	busy = 0;
+	current.reset();
+	running = false;
+	std::lock_guard<std::mutex> results_lock(resultsMutex);
+	pending.clear();
+	match_count = 0;
+}
+
+void WorkspaceGrep::takeResults(std::vector<GrepFileResult> &out)
+{
+	std::lock_guard<std::mutex> lock(resultsMutex);
+	for (GrepFileResult &result : pending)
+	{
+		out.push_back(std::move(result));
+	}
+	pending.clear();
+}
+
+void WorkspaceGrep::workerLoop()
+{
+	Scratch scratch;
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true)
+	{
+		wakeup.wait(lock, [this] { return stopping || !queue.empty(); });
+		if (stopping)
+		{
+			return;
+		}
+
+		Task task = std::move(queue.front());
+		queue.pop_front();
+		const uint64_t gen = generation;
+		std::shared_ptr<const Search> search = current;
+		busy++;
+		lock.unlock();
+
+		if (search->query.regex && scratch.regexGeneration != gen)
+		{
+			scratch.regex = search->regex;
+			scratch.regexGeneration = gen;
+		}
+		if (task.files.empty())
+		{
+			searchDirectory(task, *search, gen, scratch);
+		} else
+		{
+			searchBatch(task, *search, gen, scratch);
+		}
+
+		lock.lock();
+		// A newer search resets `busy`; stale workers must not touch it
+		if (gen == generation && --busy == 0 && queue.empty())
+		{
+			running = false;
+			gRedraw.request();
+		}
+	}
+}
+
+void WorkspaceGrep::searchBatch(const Task &task,
+								const Search &search,
+								uint64_t gen,
+								Scratch &scratch)
+{
+	for (const std::string &relative : task.files)
+	{
+		if (cancelled(gen))
+		{
+			return;
+		}
+		searchFile(task.dir / pathFromUtf8(relative), relative, search, gen, scratch);
+	}
+}
+
+void WorkspaceGrep::searchDirectory(const Task &task,
+									const Search &search,
+									uint64_t gen,
+									Scratch &scratch)
+{
+	std::shared_ptr<const IgnoreRules> rules =
+		IgnoreRules::forDirectory(task.dir, task.relative, task.rules);
+
+	std::vector<Task> subdirs;
+	std::vector<std::pair<fs::path, std::string>> files;
+	std::error_code ec;
+	fs::directory_iterator it(
+		task.dir, fs::directory_options::skip_permission_denied, ec);
+	for (; !ec && it != fs::directory_iterator(); it.increment(ec))
+	{
+		if (cancelled(gen))
+		{
+			return;
+		}
+		const fs::directory_entry &entry = *it;
+		std::string name = pathToUtf8(entry.path().filename());
+		if (IgnoreRules::isAlwaysSkipped(name))
+		{
+			continue;
+		}
+
+		// Symlinks are not followed, which also rules out cycles
+		std::error_code status_ec;
+		fs::file_status status = entry.symlink_status(status_ec);
+		if (status_ec || fs::is_symlink(status))
+		{
+			continue;
+		}
+		bool is_dir = fs::is_directory(status);
+		if (!is_dir && !fs::is_regular_file(status))
+		{
+			continue;
+		}
+
+		std::string relative = task.relative.empty() ? name : task.relative + "/" + name;
+		if (IgnoreRules::isIgnored(rules.get(), relative, is_dir))
+		{
+			continue;
+		}
+		if (is_dir)
+		{
+			subdirs.push_back({entry.path(), std::move(relative), rules, {}});
+		} else
+		{
+			files.emplace_back(entry.path(), std::move(relative));
+		}
+	}
+
+	// Hand subdirectories to idle workers before searching the files here
+	if (!subdirs.empty())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (gen != generation)
+			{
+				return;
+			}
+			for (Task &subdir : subdirs)
+			{
+				queue.push_back(std::move(subdir));
+			}
+		}
+		wakeup.notify_all();
+	}
+
+	for (auto &[path, relative] : files)
+	{
+		if (cancelled(gen))
+		{
+			return;
+		}
+		searchFile(path, std::move(relative), search, gen, scratch);
+	}
+}
+
+void WorkspaceGrep::searchFile(const fs::path &path,
+							   std::string relative,
+							   const Search &search,
+							   uint64_t gen,
+							   Scratch &scratch)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		return;
+	}
+
+	// The buffer keeps its size between files so it is only zero-filled when it
+	// grows; `size` tracks the bytes of this file
+	std::string &buffer = scratch.buffer;
+	size_t size = 0;
+	while (true)
+	{
+		if (buffer.size() < size + READ_CHUNK)
+		{
+			buffer.resize(std::max(buffer.size() * 2, size + READ_CHUNK));
+		}
+		std::streamsize room = static_cast<std::streamsize>(buffer.size() - size);
+		file.read(buffer.data() + size, room);
+		size_t read = static_cast<size_t>(file.gcount());
+		if (size < BINARY_CHECK_BYTES &&
+			std::memchr(
+				buffer.data() + size, 0, std::min(read, BINARY_CHECK_BYTES - size)))
+		{
+			return;
+		}
+		size += read;
+		if (size > MAX_FILE_BYTES)
+		{
+			return;
+		}
+		if (!file)
+		{
+			break;
+		}
+	}
+	files_searched++;
+
+	const char *data = buffer.data();
+	std::vector<std::pair<size_t, size_t>> &ranges = scratch.ranges;
+	ranges.clear();
+	if (search.query.regex)
+	{
+		scratch.regex.findAll(data, 0, size, ranges);
+	} else
+	{
+		scratch.starts.clear();
+		search.literal.findAll(data, 0, size, scratch.starts);
+		size_t covered = 0;
+		for (size_t start : scratch.starts)
+		{
+			// Literal matches may overlap; report them like the editor replaces
+			if (start < covered)
+			{
+				continue;
+			}
+			covered = start + search.literal.length();
+			ranges.emplace_back(start, covered);
+		}
+	}
+	if (ranges.empty())
+	{
+		return;
+	}
+
+	GrepFileResult result;
+	result.path = pathToUtf8(path);
+	result.relativePath = std::move(relative);
+	result.matches.reserve(std::min(ranges.size(), MAX_MATCHES_PER_FILE));
+
+	int line = 0;
+	size_t line_start = 0;
+	size_t scanned = 0;
+	bool capped = false;
+	for (const auto &[start, end] : ranges)
+	{
+		if (result.matches.size() == MAX_MATCHES_PER_FILE)
+		{
+			capped = true;
+			break;
+		}
+		for (const char *p = data + scanned;
+			 (p = static_cast<const char *>(std::memchr(p, '\n', data + start - p)));
+			 ++p)
+		{
+			line++;
+			line_start = p - data + 1;
+		}
+		scanned = start;
+
+		const char *newline =
+			static_cast<const char *>(std::memchr(data + start, '\n', size - start));
+		size_t line_end = newline ? newline - data : size;
+		if (line_end > line_start && data[line_end - 1] == '\r')
+		{
+			line_end--;
+		}
+
+		// Drop indentation, then cut long lines to a window around the match
+		size_t preview_begin = line_start;
+		while (preview_begin < start &&
+			   (data[preview_begin] == ' ' || data[preview_begin] == '\t'))
+		{
+			preview_begin++;
+		}
+		if (line_end - preview_begin > PREVIEW_BYTES && start - preview_begin > 40)
+		{
+			preview_begin = start - 40;
+		}
+		size_t preview_end = std::min(line_end, preview_begin + PREVIEW_BYTES);
+
+		GrepMatch match;
+		match.offset = start;
+		match.length = end - start;
+		match.line = line;
+		match.column = static_cast<int>(start - line_start);
+		match.preview.assign(data + preview_begin, preview_end - preview_begin);
+		match.previewStart = static_cast<int>(start - preview_begin);
+		match.previewLength =
+			static_cast<int>(std::min(end, preview_end) - std::min(start, preview_end));
+		result.matches.push_back(std::move(match));
+	}
+	publish(gen, std::move(result), capped);
+}
+
+void WorkspaceGrep::publish(uint64_t gen, GrepFileResult result, bool capped)
+{
+	{
+		std::lock_guard<std::mutex> lock(resultsMutex);
+		if (gen != generation)
+		{
+			return;
+		}
+		if (capped)
+		{
+			file_capped = true; // The search goes on with the other files
+		}
+		size_t room = MAX_MATCHES - match_count;
+		if (result.matches.size() > room)
+		{
+			result.matches.resize(room);
+			truncated = true;
+		}
+		match_count += result.matches.size();
+		if (!result.matches.empty())
+		{
+			pending.push_back(std::move(result));
+		}
+	}
+	gRedraw.request();
+}
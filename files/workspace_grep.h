@@ -0,0 +1,146 @@
+/*
+	File: workspace_grep.h
+	Description: Parallel content search over the workspace. A pool of workers
+   walks the tree (skipping .gitignore'd paths and binary files), searches each
+   file with LiteralSearch or RegexSearch, and hands results to the UI as they
+   are found. Starting a new search cancels the running one: workers notice the
+   generation change between files and drop what they were doing.
+
+   With the search index enabled, the walk is replaced by the index's list of
+   candidate files whenever the pattern contains a three-character literal.
+*/
+
+#pragma once
+
+#include "ignore_rules.h"
+#include "literal_search.h"
+#include "regex_search.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct GrepQuery
+{
+	std::string root;
+	std::string pattern;
+	bool ignoreCase = true;
+	bool regex = false;
+	bool useIndex = false; // Narrow the files through gTrigramIndex
+};
+
+struct GrepMatch
+{
+	size_t offset = 0; // Byte offset of the match in the file
+	size_t length = 0;
+	int line = 0; // 0-based
+	int column = 0;
+	std::string preview; // The matching line, trimmed
+	int previewStart = 0; // Match position inside the preview
+	int previewLength = 0;
+};
+
+struct GrepFileResult
+{
+	std::string path;
+	std::string relativePath;
+	std::vector<GrepMatch> matches;
+};
+
+class WorkspaceGrep
+{
+  public:
+	~WorkspaceGrep();
+
+	// Cancels the running search and starts `query`. An empty pattern only
+	// cancels. Returns false and fills `error` when the regex does not compile.
+	bool start(const GrepQuery &query, std::string &error);
+	void cancel();
+
+	// Appends results found since the last call. Only results of the current
+	// search are ever returned.
+	void takeResults(std::vector<GrepFileResult> &out);
+
+	bool isRunning() const { return running; }
+	// Whether matches were dropped, over all files or within one
+	bool isTruncated() const { return truncated || file_capped; }
+	size_t filesSearched() const { return files_searched; }
+
+	static constexpr size_t MAX_MATCHES = 20000;
+	static constexpr size_t MAX_MATCHES_PER_FILE = 1000;
+	static constexpr size_t MAX_FILE_BYTES = 32 * 1024 * 1024;
+	// Files with a NUL byte this early are treated as binary, like git does
+	static constexpr size_t BINARY_CHECK_BYTES = 8000;
+	static constexpr size_t PREVIEW_BYTES = 200;
+
+  private:
+	struct Search
+	{
+		GrepQuery query;
+		LiteralSearch literal;
+		RegexSearch regex; // Copied by each worker, since matching mutates it
+	};
+
+	// Either a directory to walk or, from the index, a batch of files
+	struct Task
+	{
+		std::filesystem::path dir;
+		std::string relative;
+		std::shared_ptr<const IgnoreRules> rules;
+		std::vector<std::string> files; // Relative to the root
+	};
+	static constexpr size_t INDEX_BATCH = 32;
+
+	// Per-worker state, reused across files
+	struct Scratch
+	{
+		RegexSearch regex;
+		uint64_t regexGeneration = 0;
+		std::string buffer;
+		std::vector<size_t> starts;
+		std::vector<std::pair<size_t, size_t>> ranges;
+	};
+
+	std::vector<std::thread> workers;
+	std::mutex mutex; // Guards the queue, `busy`, `current` and `stopping`
+	std::condition_variable wakeup;
+	std::deque<Task> queue;
+	int busy = 0; // Workers on a task of the current generation
+	bool stopping = false;
+	std::shared_ptr<const Search> current;
+	std::atomic<uint64_t> generation{0};
+
+	std::mutex resultsMutex;
+	std::vector<GrepFileResult> pending;
+	size_t match_count = 0;
+
+	std::atomic<bool> running{false};
+	std::atomic<bool> truncated{false}; // MAX_MATCHES reached; stops the search
+	std::atomic<bool> file_capped{false}; // A file had over MAX_MATCHES_PER_FILE
+	std::atomic<size_t> files_searched{0};
+
+	void ensureWorkers();
+	void workerLoop();
+	bool cancelled(uint64_t gen) const { return generation != gen || truncated; }
+	void searchDirectory(const Task &task,
+						 const Search &search,
+						 uint64_t gen,
+						 Scratch &scratch);
+	void searchBatch(const Task &task,
+					 const Search &search,
+					 uint64_t gen,
+					 Scratch &scratch);
+	void searchFile(const std::filesystem::path &path,
+					std::string relative,
+					const Search &search,
+					uint64_t gen,
+					Scratch &scratch);
+	void publish(uint64_t gen, GrepFileResult result, bool capped);
+};
@@ -0,0 +1,734 @@
+/*
+	File: workspace_index.cpp
+	Description: Walking and watching the open folder. See workspace_index.h.
+*/
+
+#include "workspace_index.h"
+#include "../util/redraw.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#ifdef PLATFORM_LINUX
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+WorkspaceIndex gWorkspaceIndex;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string genericUtf8(const fs::path &path)
+{
+#ifdef PLATFORM_WINDOWS
+	auto u8 = path.generic_u8string();
+	return std::string(u8.begin(), u8.end());
+#else
+	return path.generic_string();
+#endif
+}
+
+fs::path pathFromUtf8(const std::string &path)
+{
+#ifdef PLATFORM_WINDOWS
+	return fs::u8path(path);
+#else
+	return fs::path(path);
+#endif
+}
+
+std::string joinRelative(const std::string &dir, const std::string &name)
+{
+	return dir.empty() ? name : dir + "/" + name;
+}
+
+std::string parentOf(const std::string &relative)
+{
+	size_t slash = relative.rfind('/');
+	return slash == std::string::npos ? "" : relative.substr(0, slash);
+}
+
+bool isWithin(const std::string &relative, const std::string &dir)
+{
+	return dir.empty() || relative == dir ||
+		   (relative.size() > dir.size() && relative[dir.size()] == '/' &&
+			relative.compare(0, dir.size(), dir) == 0);
+}
+
+// Subdirectories a walk descends into
+bool isWalked(const WorkspaceSnapshot::Entry &entry)
+{
+	return entry.isDirectory && !entry.isSymlink && !entry.ignored;
+}
+
+} // namespace
+
+const WorkspaceSnapshot::Listing *
+WorkspaceSnapshot::find(const std::string &relative) const
+{
+	auto it = directories.find(relative);
+	return it == directories.end() ? nullptr : it->second.get();
+}
+
+WorkspaceIndex::~WorkspaceIndex() { close(); }
+
+void WorkspaceIndex::open(const std::string &indexRoot)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (indexRoot == root && worker.joinable())
+		{
+			return;
+		}
+	}
+	close();
+	if (indexRoot.empty())
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	root = indexRoot;
+	stopping = false;
+#ifdef PLATFORM_LINUX
+	if (pipe2(wakeFds, O_CLOEXEC) != 0)
+	{
+		wakeFds[0] = wakeFds[1] = -1;
+	}
+#endif
+	worker = std::thread(&WorkspaceIndex::run, this, indexRoot);
+}
+
+void WorkspaceIndex::close()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wakeup.notify_all();
+#ifdef PLATFORM_LINUX
+	if (wakeFds[1] >= 0)
+	{
+		char byte = 0;
+		(void)!write(wakeFds[1], &byte, 1);
+	}
+#endif
+	if (worker.joinable())
+	{
+		worker.join();
+	}
+#ifdef PLATFORM_LINUX
+	for (int &fd : wakeFds)
+	{
+		if (fd >= 0)
+		{
+			::close(fd);
+			fd = -1;
+		}
+	}
+#endif
+
+	std::lock_guard<std::mutex> lock(mutex);
+	bool hadSnapshot = current != nullptr;
+	root.clear();
+	current.reset();
+	if (hadSnapshot)
+	{
+		published_version++;
+	}
+}
+
+std::shared_ptr<const WorkspaceSnapshot> WorkspaceIndex::snapshot() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return current;
+}
+
+int WorkspaceIndex::addChangeListener(
+	std::function<void(const std::string &relative)> listener)
+{
+	std::lock_guard<std::mutex> lock(listenersMutex);
+	int id = nextListenerId++;
+	listeners.emplace_back(id, std::move(listener));
+	return id;
+}
+
+void WorkspaceIndex::removeChangeListener(int id)
+{
+	std::lock_guard<std::mutex> lock(listenersMutex);
+	listeners.erase(std::remove_if(listeners.begin(),
+								   listeners.end(),
+								   [id](const auto &entry) { return entry.first == id; }),
+					listeners.end());
+}
+
+void WorkspaceIndex::notifyChanged(const std::string &relative)
+{
+	std::lock_guard<std::mutex> lock(listenersMutex);
+	for (const auto &entry : listeners)
+	{
+		entry.second(relative);
+	}
+}
+
+bool WorkspaceIndex::shouldStop()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stopping;
+}
+
+void WorkspaceIndex::run(std::string indexRoot)
+{
+	using namespace std::chrono;
+
+	auto start = steady_clock::now();
+	DirectoryMap dirs;
+	if (!walk(indexRoot, {{"", nullptr}}, dirs))
+	{
+		return;
+	}
+	publish(indexRoot, dirs);
+	auto elapsed = duration_cast<milliseconds>(steady_clock::now() - start);
+	std::cout << "[WorkspaceIndex] Indexed " << dirs.size() << " directories of "
+			  << indexRoot << " in " << elapsed.count() << " ms" << std::endl;
+
+#ifdef PLATFORM_LINUX
+	int inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (inotifyFd >= 0)
+	{
+		bool fallback = watchLoop(indexRoot, dirs, inotifyFd);
+		::close(inotifyFd);
+		if (!fallback)
+		{
+			return;
+		}
+		std::cout << "[WorkspaceIndex] Out of inotify watches, polling " << indexRoot
+				  << " instead" << std::endl;
+	}
+#endif
+	pollLoop(indexRoot, dirs);
+}
+
+bool WorkspaceIndex::listDirectory(const std::string &indexRoot,
+								   const std::string &relative,
+								   const std::shared_ptr<const IgnoreRules> &parentRules,
+								   DirectoryState &state)
+{
+	fs::path dir = pathFromUtf8(indexRoot);
+	if (!relative.empty())
+	{
+		dir /= pathFromUtf8(relative);
+	}
+
+	std::error_code ec;
+	fs::directory_iterator it(dir, fs::directory_options::skip_permission_denied, ec);
+	if (ec)
+	{
+		return false;
+	}
+	state.rules = IgnoreRules::forDirectory(dir, relative, parentRules);
+
+	auto listing = std::make_shared<WorkspaceSnapshot::Listing>();
+	for (; !ec && it != fs::directory_iterator(); it.increment(ec))
+	{
+		// The type checks answer from the directory read itself; only symlinks
+		// cost a stat
+		const fs::directory_entry &entry = *it;
+		std::error_code type_ec;
+		WorkspaceSnapshot::Entry child;
+		child.name = genericUtf8(entry.path().filename());
+		child.isSymlink = entry.is_symlink(type_ec);
+		child.isDirectory = entry.is_directory(type_ec);
+		// Sockets, fifos and devices would hang or fail when opened
+		if (!child.isDirectory && !child.isSymlink && !entry.is_regular_file(type_ec))
+		{
+			continue;
+		}
+		child.ignored = IgnoreRules::isAlwaysSkipped(child.name) ||
+						IgnoreRules::isIgnored(state.rules.get(),
+											   joinRelative(relative, child.name),
+											   child.isDirectory);
+		listing->push_back(std::move(child));
+	}
+
+	std::sort(listing->begin(),
+			  listing->end(),
+			  [](const WorkspaceSnapshot::Entry &a, const WorkspaceSnapshot::Entry &b) {
+				  if (a.isDirectory != b.isDirectory)
+				  {
+					  return a.isDirectory;
+				  }
+				  return a.name < b.name;
+			  });
+	state.listing = std::move(listing);
+	return true;
+}
+
+bool WorkspaceIndex::walk(const std::string &indexRoot,
+						  std::vector<WalkStart> starts,
+						  DirectoryMap &out)
+{
+	std::mutex walkMutex; // Guards everything below and `out`
+	std::condition_variable walkWakeup;
+	auto tasks = std::move(starts);
+	size_t active = 0;
+	bool stopped = false;
+
+	auto work = [&]() {
+		std::unique_lock<std::mutex> lock(walkMutex);
+		while (true)
+		{
+			walkWakeup.wait(
+				lock, [&]() { return !tasks.empty() || active == 0 || stopped; });
+			if (stopped || tasks.empty())
+			{
+				return;
+			}
+			auto task = std::move(tasks.back());
+			tasks.pop_back();
+			active++;
+			lock.unlock();
+
+			DirectoryState state;
+			bool listed = listDirectory(indexRoot, task.first, task.second, state);
+			bool stop = shouldStop();
+
+			lock.lock();
+			active--;
+			if (listed)
+			{
+				for (const WorkspaceSnapshot::Entry &entry : *state.listing)
+				{
+					if (isWalked(entry))
+					{
+						tasks.push_back(
+							{joinRelative(task.first, entry.name), state.rules});
+					}
+				}
+				out[task.first] = std::move(state);
+			}
+			stopped = stopped || stop;
+			walkWakeup.notify_all();
+		}
+	};
+
+	size_t threads = std::clamp<size_t>(std::thread::hardware_concurrency(), 2, 8);
+	std::vector<std::thread> workers;
+	for (size_t i = 1; i < threads; i++)
+	{
+		workers.emplace_back(work);
+	}
+	work();
+	for (std::thread &thread : workers)
+	{
+		thread.join();
+	}
+	return !stopped;
+}
+
+void WorkspaceIndex::publish(const std::string &indexRoot, const DirectoryMap &dirs)
+{
+	auto snap = std::make_shared<WorkspaceSnapshot>();
+	snap->root = indexRoot;
+	snap->files.root = indexRoot;
+	snap->directories.reserve(dirs.size());
+	for (const auto &[relative, state] : dirs)
+	{
+		snap->directories.emplace(relative, state.listing);
+	}
+
+	// Depth first, so the files of a directory stay together
+	std::vector<std::string> stack{""};
+	while (!stack.empty())
+	{
+		std::string dir = std::move(stack.back());
+		stack.pop_back();
+		const WorkspaceSnapshot::Listing *listing = snap->find(dir);
+		if (!listing)
+		{
+			continue;
+		}
+		for (auto entry = listing->rbegin(); entry != listing->rend(); ++entry)
+		{
+			if (isWalked(*entry))
+			{
+				stack.push_back(joinRelative(dir, entry->name));
+			}
+		}
+		for (const WorkspaceSnapshot::Entry &entry : *listing)
+		{
+			if (entry.isDirectory || entry.ignored)
+			{
+				continue;
+			}
+			std::string relative = joinRelative(dir, entry.name);
+#ifdef PLATFORM_WINDOWS
+			std::replace(relative.begin(), relative.end(), '/', '\\');
+#endif
+			snap->files.add(relative);
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		snap->version = published_version + 1;
+		current = std::move(snap);
+		published_version++;
+	}
+	gRedraw.request();
+}
+
+bool WorkspaceIndex::update(const std::string &indexRoot,
+							DirectoryMap &dirs,
+							const std::unordered_map<std::string, bool> &changed,
+							std::vector<std::string> &added,
+							std::vector<std::string> &removed)
+{
+	auto removeTree = [&](const std::string &top) {
+		for (auto it = dirs.begin(); it != dirs.end();)
+		{
+			if (isWithin(it->first, top))
+			{
+				removed.push_back(it->first);
+				it = dirs.erase(it);
+			} else
+			{
+				++it;
+			}
+		}
+	};
+	auto walkTree = [&](const std::string &top,
+						const std::shared_ptr<const IgnoreRules> &parentRules) {
+		DirectoryMap fresh;
+		if (!walk(indexRoot, {{top, parentRules}}, fresh))
+		{
+			return;
+		}
+		for (auto &[relative, state] : fresh)
+		{
+			added.push_back(relative);
+			dirs[relative] = std::move(state);
+		}
+	};
+
+	// Parents first, so a removed parent drops its children before they are read
+	std::vector<std::pair<std::string, bool>> order(changed.begin(), changed.end());
+	std::sort(order.begin(), order.end());
+
+	bool visible = false;
+	for (const auto &[dir, rulesChanged] : order)
+	{
+		auto existing = dirs.find(dir);
+		if (existing == dirs.end())
+		{
+			continue;
+		}
+		std::shared_ptr<const IgnoreRules> parentRules;
+		if (!dir.empty())
+		{
+			auto parent = dirs.find(parentOf(dir));
+			if (parent == dirs.end())
+			{
+				continue;
+			}
+			parentRules = parent->second.rules;
+		}
+
+		DirectoryState fresh;
+		if (!listDirectory(indexRoot, dir, parentRules, fresh))
+		{
+			// Gone; its parent's events take care of the listing
+			if (!dir.empty())
+			{
+				removeTree(dir);
+				visible = true;
+			}
+			continue;
+		}
+
+		if (rulesChanged)
+		{
+			// Everything below may be ignored differently now
+			removeTree(dir);
+			walkTree(dir, parentRules);
+			visible = true;
+			continue;
+		}
+
+		DirectoryState &state = existing->second;
+		if (*fresh.listing == *state.listing)
+		{
+			continue;
+		}
+		visible = true;
+
+		std::unordered_map<std::string, bool> before;
+		for (const WorkspaceSnapshot::Entry &entry : *state.listing)
+		{
+			if (isWalked(entry))
+			{
+				before[entry.name] = true;
+			}
+		}
+		std::vector<std::string> appeared;
+		for (const WorkspaceSnapshot::Entry &entry : *fresh.listing)
+		{
+			if (isWalked(entry) && !before.erase(entry.name))
+			{
+				appeared.push_back(entry.name);
+			}
+		}
+
+		// The rules did not change, so the children keep theirs
+		state.listing = std::move(fresh.listing);
+		std::shared_ptr<const IgnoreRules> rules = state.rules;
+		for (const auto &gone : before)
+		{
+			removeTree(joinRelative(dir, gone.first));
+		}
+		for (const std::string &name : appeared)
+		{
+			walkTree(joinRelative(dir, name), rules);
+		}
+	}
+	return visible;
+}
+
+bool WorkspaceIndex::rewalk(const std::string &indexRoot, DirectoryMap &dirs)
+{
+	DirectoryMap fresh;
+	if (!walk(indexRoot, {{"", nullptr}}, fresh))
+	{
+		return false;
+	}
+
+	bool visible = fresh.size() != dirs.size();
+	for (auto &[relative, state] : fresh)
+	{
+		auto old = dirs.find(relative);
+		if (old != dirs.end() && *old->second.listing == *state.listing)
+		{
+			// Unchanged listings stay shared with the published snapshot
+			state.listing = old->second.listing;
+		} else
+		{
+			visible = true;
+		}
+	}
+	dirs = std::move(fresh);
+	return visible;
+}
+
+void WorkspaceIndex::pollLoop(const std::string &indexRoot, DirectoryMap &dirs)
+{
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wakeup.wait_for(lock, std::chrono::seconds(POLL_SECONDS), [this]() {
+				return stopping;
+			});
+			if (stopping)
+			{
+				return;
+			}
+		}
+		if (rewalk(indexRoot, dirs))
+		{
+			publish(indexRoot, dirs);
+		}
+	}
+}
+
+#ifdef PLATFORM_LINUX
+bool WorkspaceIndex::watchLoop(const std::string &indexRoot,
+							   DirectoryMap &dirs,
+							   int inotifyFd)
+{
+	// Content changes only matter for .gitignore files and change listeners
+	constexpr uint32_t MASK = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+							  IN_CLOSE_WRITE | IN_DELETE_SELF | IN_MOVE_SELF |
+							  IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK;
+
+	std::unordered_map<int, std::string> watches;
+	std::unordered_map<std::string, int> descriptors;
+	std::unordered_map<std::string, bool> changed;
+	auto changedSince = std::chrono::steady_clock::now(); // Oldest entry in `changed`
+
+	// False only when the kernel is out of watches
+	auto watch = [&](const std::string &relative) {
+		fs::path dir = pathFromUtf8(indexRoot);
+		if (!relative.empty())
+		{
+			dir /= relative;
+		}
+		int wd = inotify_add_watch(inotifyFd, dir.c_str(), MASK);
+		if (wd < 0)
+		{
+			return errno != ENOSPC && errno != ENOMEM;
+		}
+		watches[wd] = relative;
+		descriptors[relative] = wd;
+		return true;
+	};
+	auto unwatch = [&](const std::string &relative) {
+		auto it = descriptors.find(relative);
+		if (it != descriptors.end())
+		{
+			inotify_rm_watch(inotifyFd, it->second);
+			watches.erase(it->second);
+			descriptors.erase(it);
+		}
+	};
+
+	for (const auto &entry : dirs)
+	{
+		if (!watch(entry.first))
+		{
+			return true;
+		}
+	}
+
+	alignas(inotify_event) char buffer[64 * 1024];
+	while (!shouldStop())
+	{
+		pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {wakeFds[0], POLLIN, 0}};
+		int timeout = wakeFds[0] >= 0 ? -1 : 250;
+		if (!changed.empty())
+		{
+			// Wait for a quiet moment, but no longer than MAX_DELAY_MS in all
+			auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(
+				std::chrono::steady_clock::now() - changedSince);
+			timeout = std::clamp(MAX_DELAY_MS - static_cast<int>(waited.count()),
+								 0,
+								 DEBOUNCE_MS);
+		}
+		int ready = timeout == 0 ? 0 : poll(fds, 2, timeout);
+		if (ready < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			return true;
+		}
+		if (fds[1].revents)
+		{
+			return false;
+		}
+
+		if (ready == 0)
+		{
+			// Quiet for a while, or waited long enough: apply what accumulated
+			if (changed.empty())
+			{
+				continue;
+			}
+			std::vector<std::string> added;
+			std::vector<std::string> removed;
+			bool visible = update(indexRoot, dirs, changed, added, removed);
+			changed.clear();
+			for (const std::string &relative : removed)
+			{
+				unwatch(relative);
+			}
+			for (const std::string &relative : added)
+			{
+				if (!watch(relative))
+				{
+					return true;
+				}
+				// Files created before the watch existed would be missed
+				changed.emplace(relative, false);
+			}
+			changedSince = std::chrono::steady_clock::now();
+			if (visible)
+			{
+				publish(indexRoot, dirs);
+			}
+			continue;
+		}
+
+		if (changed.empty())
+		{
+			changedSince = std::chrono::steady_clock::now();
+		}
+		ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+		bool overflow = false;
+		for (ssize_t offset = 0; offset < length;)
+		{
+			const auto *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+			offset += sizeof(inotify_event) + event->len;
+
+			if (event->mask & IN_Q_OVERFLOW)
+			{
+				overflow = true;
+				continue;
+			}
+			auto it = watches.find(event->wd);
+			if (it == watches.end())
+			{
+				continue;
+			}
+			if (event->mask & IN_IGNORED)
+			{
+				descriptors.erase(it->second);
+				watches.erase(it);
+				continue;
+			}
+			const std::string &dir = it->second;
+			bool gitignore =
+				event->len > 0 && std::strcmp(event->name, ".gitignore") == 0;
+			if ((event->mask & IN_CLOSE_WRITE) && !gitignore)
+			{
+				if (event->len > 0)
+				{
+					notifyChanged(joinRelative(dir, event->name));
+				}
+				continue;
+			}
+			if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF))
+			{
+				if (!dir.empty())
+				{
+					changed.emplace(parentOf(dir), false);
+				}
+				continue;
+			}
+			changed[dir] = changed[dir] || gitignore;
+		}
+
+		if (overflow)
+		{
+			// Events were lost: start over from a full walk
+			changed.clear();
+			for (auto &entry : descriptors)
+			{
+				inotify_rm_watch(inotifyFd, entry.second);
+			}
+			watches.clear();
+			descriptors.clear();
+			if (rewalk(indexRoot, dirs))
+			{
+				publish(indexRoot, dirs);
+			}
+			for (const auto &entry : dirs)
+			{
+				if (!watch(entry.first))
+				{
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+#endif
@@ -0,0 +1,144 @@
+/*
+	File: workspace_index.h
+	Description: One shared listing of the open folder, for the file finder, the
+   file tree and the file monitor. The folder is walked once by a pool of
+   threads, skipping what .gitignore excludes, and then kept current from
+   inotify events on Linux; elsewhere, or when the watch limit runs out, it is
+   walked again every few seconds.
+
+   Consumers get immutable snapshots. A change produces a new snapshot that
+   shares every directory listing the change did not touch.
+*/
+
+#pragma once
+
+#include "fuzzy_match.h"
+#include "ignore_rules.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct WorkspaceSnapshot
+{
+	struct Entry
+	{
+		std::string name;
+		bool isDirectory = false;
+		bool isSymlink = false;
+		bool ignored = false; // By .gitignore, or .git itself
+
+		bool operator==(const Entry &other) const = default;
+	};
+
+	// Directories first, then by name
+	using Listing = std::vector<Entry>;
+
+	std::string root;
+	uint64_t version = 0;
+	// Every walked directory by its path relative to the root, with '/' as the
+	// separator and "" for the root. Ignored directories and symlinks to
+	// directories are listed by their parent but never walked.
+	std::unordered_map<std::string, std::shared_ptr<const Listing>> directories;
+	// Every file that is not ignored, relative to the root
+	PathTable files;
+
+	// Null when the directory was not walked
+	const Listing *find(const std::string &relative) const;
+};
+
+class WorkspaceIndex
+{
+  public:
+	~WorkspaceIndex();
+
+	// Starts indexing `root` in the background. Cheap when already open.
+	void open(const std::string &root);
+	void close();
+
+	// The latest snapshot, or null until the first walk finishes
+	std::shared_ptr<const WorkspaceSnapshot> snapshot() const;
+
+	// Snapshot version, to notice changes without taking the snapshot
+	uint64_t version() const { return published_version; }
+
+	// Calls `listener` on the watcher thread with the relative path, '/'
+	// separated, of every file whose contents were rewritten. Only inotify
+	// reports those; the polling fallback notices files coming and going only.
+	// Returns an id for removeChangeListener, which waits out a running call.
+	int addChangeListener(std::function<void(const std::string &relative)> listener);
+	void removeChangeListener(int id);
+
+	static constexpr int POLL_SECONDS = 3;
+	// Events are gathered this long before a listing is read again, so a
+	// checkout or build touching many files costs one update
+	static constexpr int DEBOUNCE_MS = 100;
+	// Longest a change waits while events keep arriving
+	static constexpr int MAX_DELAY_MS = 500;
+
+  private:
+	struct DirectoryState
+	{
+		std::shared_ptr<const WorkspaceSnapshot::Listing> listing;
+		std::shared_ptr<const IgnoreRules> rules; // In effect inside it
+	};
+	using DirectoryMap = std::unordered_map<std::string, DirectoryState>;
+	// A directory to walk: its relative path and the rules of its parent
+	using WalkStart = std::pair<std::string, std::shared_ptr<const IgnoreRules>>;
+
+	mutable std::mutex mutex; // Guards `current`, `root` and `stopping`
+	std::condition_variable wakeup;
+	std::shared_ptr<const WorkspaceSnapshot> current;
+	std::atomic<uint64_t> published_version{0};
+	std::string root;
+	bool stopping = false;
+	std::thread worker;
+#ifdef PLATFORM_LINUX
+	int wakeFds[2] = {-1, -1}; // Pipe that interrupts the inotify wait
+#endif
+
+	std::mutex listenersMutex;
+	std::vector<std::pair<int, std::function<void(const std::string &)>>> listeners;
+	int nextListenerId = 0;
+	void notifyChanged(const std::string &relative);
+
+	void run(std::string indexRoot);
+	bool shouldStop();
+
+	// Walks `starts` and everything below them in parallel into `out`
+	bool walk(const std::string &indexRoot,
+			  std::vector<WalkStart> starts,
+			  DirectoryMap &out);
+	static bool listDirectory(const std::string &indexRoot,
+							  const std::string &relative,
+							  const std::shared_ptr<const IgnoreRules> &parentRules,
+							  DirectoryState &state);
+
+	void publish(const std::string &indexRoot, const DirectoryMap &dirs);
+
+	// Re-reads directories after change events; `changed` maps each to whether
+	// its .gitignore changed. Reports the directories that appeared and went
+	// away. Returns false when nothing visible changed.
+	bool update(const std::string &indexRoot,
+				DirectoryMap &dirs,
+				const std::unordered_map<std::string, bool> &changed,
+				std::vector<std::string> &added,
+				std::vector<std::string> &removed);
+	// Polling fallback: walks everything again and keeps unchanged listings
+	bool rewalk(const std::string &indexRoot, DirectoryMap &dirs);
+
+#ifdef PLATFORM_LINUX
+	// Returns true when watching failed and polling should take over
+	bool watchLoop(const std::string &indexRoot, DirectoryMap &dirs, int inotifyFd);
+#endif
+	void pollLoop(const std::string &indexRoot, DirectoryMap &dirs);
+};
+
+extern WorkspaceIndex gWorkspaceIndex;
@@ -0,0 +1,376 @@
+/*
+	files/workspace_search.cpp
+	Search-in-files window on top of WorkspaceGrep.
+*/
+#include "workspace_search.h"
+#include "../editor/editor.h"
+#include "../util/close_popper.h"
+#include "../util/settings.h"
+#include "files.h"
+#include <algorithm>
+
+WorkspaceSearch gWorkspaceSearch;
+
+void WorkspaceSearch::toggleWindow()
+{
+	showWindow = !showWindow;
+	ClosePopper::closeAllExcept(ClosePopper::Type::WorkspaceSearch);
+
+	if (!showWindow && grep.isRunning())
+	{
+		// Partial results would look complete on reopening; search again then
+		grep.cancel();
+		searchedPattern.clear();
+	}
+}
+
+void WorkspaceSearch::restartSearchIfChanged()
+{
+	const std::string &root = gFileExplorer.selectedFolder;
+	bool useIndex = gSettings.getSnapshot()->searchIndex;
+	if (root == searchedRoot && searchedPattern == searchBuffer &&
+		searchedIgnoreCase == ignoreCase && searchedRegex == useRegex &&
+		searchedIndex == useIndex)
+	{
+		return;
+	}
+	searchedRoot = root;
+	searchedPattern = searchBuffer;
+	searchedIgnoreCase = ignoreCase;
+	searchedRegex = useRegex;
+	searchedIndex = useIndex;
+
+	results.clear();
+	rows.clear();
+	totalMatches = 0;
+	selectedRow = -1;
+	error.clear();
+	grep.start({root, searchedPattern, ignoreCase, useRegex, useIndex}, error);
+}
+
+void WorkspaceSearch::collectResults()
+{
+	size_t first = results.size();
+	grep.takeResults(results);
+	for (size_t i = first; i < results.size(); ++i)
+	{
+		rows.push_back({static_cast<int>(i), -1});
+		for (size_t m = 0; m < results[i].matches.size(); ++m)
+		{
+			rows.push_back({static_cast<int>(i), static_cast<int>(m)});
+		}
+		totalMatches += results[i].matches.size();
+	}
+	if (selectedRow < 0 && rows.size() > 1)
+	{
+		selectedRow = 1; // First match of the first file
+	}
+}
+
+void WorkspaceSearch::moveSelection(int direction)
+{
+	int row = selectedRow + direction;
+	// Headers are not selectable
+	while (row >= 0 && row < static_cast<int>(rows.size()) && rows[row].match < 0)
+	{
+		row += direction;
+	}
+	if (row >= 0 && row < static_cast<int>(rows.size()))
+	{
+		selectedRow = row;
+		scrollToSelection = true;
+	}
+}
+
+void WorkspaceSearch::openRow(int row)
+{
+	if (row < 0 || row >= static_cast<int>(rows.size()))
+	{
+		return;
+	}
+	const GrepFileResult &file = results[rows[row].file];
+	const GrepMatch &match = file.matches[std::max(rows[row].match, 0)];
+
+	if (file.path != gFileExplorer.currentFile)
+	{
+		gFileExplorer.loadFileContent(file.path);
+	}
+
+	// The file may have changed since it was searched
+	size_t size = editor_state.fileContent.size();
+	int start = static_cast<int>(std::min(match.offset, size));
+	int end = static_cast<int>(std::min(match.offset + match.length, size));
+	editor_state.cursor_index = start;
+	editor_state.selection_start = start;
+	editor_state.selection_end = end;
+	editor_state.center_cursor_vertical = true;
+	editor_state.ensure_cursor_visible.horizontal = true;
+	editor_state.ensure_cursor_visible.vertical = true;
+
+	toggleWindow();
+}
+
+// Helper: Render window header (setup and title)
+void WorkspaceSearch::renderHeader()
+{
+	ImVec2 windowSize(700, 450);
+	if (isEmbedded)
+	{
+		// In embedded mode, center the window within the editor pane
+		ImVec2 windowPos =
+			ImVec2(editorPanePos.x + editorPaneSize.x * 0.5f - windowSize.x * 0.5f,
+				   editorPanePos.y + editorPaneSize.y * 0.5f - windowSize.y * 0.5f);
+		ImGui::SetNextWindowSize(windowSize, ImGuiCond_Always);
+		ImGui::SetNextWindowPos(windowPos, ImGuiCond_Always);
+	} else
+	{
+		ImVec2 windowPos = ImVec2(ImGui::GetIO().DisplaySize.x * 0.5f,
+								  ImGui::GetIO().DisplaySize.y * 0.4f);
+		ImGui::SetNextWindowSize(windowSize, ImGuiCond_Always);
+		ImGui::SetNextWindowPos(windowPos, ImGuiCond_Always, ImVec2(0.5f, 0.5f));
+	}
+	ImGuiWindowFlags windowFlags = ImGuiWindowFlags_NoTitleBar |
+								   ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove |
+								   ImGuiWindowFlags_NoScrollbar |
+								   ImGuiWindowFlags_NoScrollWithMouse;
+	// Push window style (3 style vars, 3 style colors)
+	ImGui::PushStyleVar(ImGuiStyleVar_WindowRounding, 10.0f);
+	ImGui::PushStyleVar(ImGuiStyleVar_WindowBorderSize, 1.0f);
+	ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(16.0f, 16.0f));
+	ImGui::PushStyleColor(
+		ImGuiCol_WindowBg,
+		ImVec4(gSettings.getSettings()["backgroundColor"][0].get<float>() * .8,
+			   gSettings.getSettings()["backgroundColor"][1].get<float>() * .8,
+			   gSettings.getSettings()["backgroundColor"][2].get<float>() * .8,
+			   1.0f));
+	ImGui::PushStyleColor(ImGuiCol_Border, ImVec4(0.3f, 0.3f, 0.3f, 1.0f));
+	ImGui::PushStyleColor(
+		ImGuiCol_FrameBg,
+		ImVec4(gSettings.getSettings()["backgroundColor"][0].get<float>() * .8,
+			   gSettings.getSettings()["backgroundColor"][1].get<float>() * .8,
+			   gSettings.getSettings()["backgroundColor"][2].get<float>() * .8,
+			   1.0f));
+
+	ImGui::Begin("WorkspaceSearch", nullptr, windowFlags);
+
+	ImGui::TextUnformatted("Search in Files");
+	ImGui::Spacing();
+	ImGui::Spacing();
+}
+
+void WorkspaceSearch::renderSearchInput()
+{
+	ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x);
+	ImGui::PushStyleVar(ImGuiStyleVar_FrameRounding, 4.0f);
+	ImGui::PushStyleVar(ImGuiStyleVar_FrameBorderSize, 1.0f);
+	ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(8, 8));
+	ImGui::PushStyleColor(ImGuiCol_Border, ImVec4(0.3f, 0.3f, 0.3f, 1.0f));
+
+	// Keep the query focused so typing always goes to it
+	ImGui::SetKeyboardFocusHere();
+	ImGui::InputText("##WorkspaceSearchInput", searchBuffer, sizeof(searchBuffer));
+
+	ImGui::PopStyleColor();
+	ImGui::PopStyleVar(3);
+	ImGui::PopItemWidth();
+
+	ImGui::Spacing();
+	ImGui::Checkbox("Case Insensitive (Alt+C)", &ignoreCase);
+	ImGui::SameLine();
+	ImGui::Checkbox("Regex (Alt+R)", &useRegex);
+}
+
+void WorkspaceSearch::renderStatus()
+{
+	if (!error.empty())
+	{
+		ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", error.c_str());
+		return;
+	}
+	if (searchedPattern.empty())
+	{
+		ImGui::TextDisabled("Type to search %s", gFileExplorer.selectedFolder.c_str());
+		return;
+	}
+
+	const char *state = grep.isRunning() ? "Searching... " : "";
+	if (grep.isTruncated())
+	{
+		ImGui::TextDisabled("%sShowing the first %zu matches (limit reached)",
+							state,
+							totalMatches);
+	} else if (totalMatches == 0 && !grep.isRunning())
+	{
+		ImGui::TextDisabled("No matches in %zu files", grep.filesSearched());
+	} else
+	{
+		ImGui::TextDisabled("%s%zu matches in %zu files (%zu searched)",
+							state,
+							totalMatches,
+							results.size(),
+							grep.filesSearched());
+	}
+}
+
+void WorkspaceSearch::renderResults()
+{
+	ImGui::PushStyleColor(ImGuiCol_ChildBg, ImVec4(0, 0, 0, 0));
+	ImGui::PushStyleColor(ImGuiCol_Border, ImVec4(0, 0, 0, 0));
+	ImGui::BeginChild("WorkspaceSearchResults",
+					  ImVec2(0, -ImGui::GetFrameHeightWithSpacing()),
+					  false);
+
+	ImGui::PushStyleVar(ImGuiStyleVar_SelectableTextAlign, ImVec2(0.0f, 0.5f));
+	ImGui::PushStyleColor(ImGuiCol_Header,
+						  ImVec4(1.0f, 0.1f, 0.7f, 0.4f)); // Selection color
+	ImGui::PushStyleColor(ImGuiCol_HeaderHovered, ImVec4(1.0f, 0.1f, 0.7f, 0.2f));
+
+	const ImVec4 dimColor(0.6f, 0.6f, 0.6f, 1.0f);
+	const ImVec4 matchColor(1.0f, 0.3f, 0.8f, 1.0f);
+	int clickedRow = -1;
+
+	// Rows are only built for what is on screen, however many matches stream in
+	ImGuiListClipper clipper;
+	clipper.Begin(static_cast<int>(rows.size()));
+	if (scrollToSelection && selectedRow >= 0)
+	{
+		clipper.IncludeItemByIndex(selectedRow);
+	}
+	while (clipper.Step())
+	{
+		for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i)
+		{
+			const Row &row = rows[i];
+			const GrepFileResult &file = results[row.file];
+			ImGui::PushID(i);
+			if (row.match < 0)
+			{
+				float iconSize = ImGui::GetTextLineHeight();
+				size_t slash = file.relativePath.rfind('/');
+				std::string filename = file.relativePath.substr(slash + 1);
+				IconRef icon = gFileExplorer.getIconForFile(filename);
+				ImGui::Image(
+					icon.texture, ImVec2(iconSize, iconSize), icon.uv0, icon.uv1);
+				ImGui::SameLine();
+				ImGui::TextUnformatted(file.relativePath.c_str());
+				ImGui::SameLine();
+				ImGui::TextColored(dimColor, "(%zu)", file.matches.size());
+			} else
+			{
+				const GrepMatch &match = file.matches[row.match];
+				bool isSelected = i == selectedRow;
+				if (ImGui::Selectable(
+						"##match", isSelected, ImGuiSelectableFlags_SpanAllColumns))
+				{
+					clickedRow = i;
+				}
+				if (isSelected && scrollToSelection)
+				{
+					ImGui::SetScrollHereY(0.5f);
+					scrollToSelection = false;
+				}
+
+				const char *text = match.preview.c_str();
+				const char *matchBegin = text + match.previewStart;
+				const char *matchEnd = matchBegin + match.previewLength;
+				ImGui::SameLine(ImGui::GetStyle().IndentSpacing);
+				ImGui::TextColored(dimColor, "%d:", match.line + 1);
+				ImGui::SameLine();
+				ImGui::TextUnformatted(text, matchBegin);
+				ImGui::SameLine(0, 0);
+				ImGui::PushStyleColor(ImGuiCol_Text, matchColor);
+				ImGui::TextUnformatted(matchBegin, matchEnd);
+				ImGui::PopStyleColor();
+				ImGui::SameLine(0, 0);
+				ImGui::TextUnformatted(matchEnd, text + match.preview.size());
+			}
+			ImGui::PopID();
+		}
+	}
+
+	ImGui::PopStyleColor(2);
+	ImGui::PopStyleVar();
+	ImGui::EndChild();
+	ImGui::PopStyleColor(2);
+
+	if (clickedRow >= 0)
+	{
+		openRow(clickedRow);
+	}
+}
+
+void WorkspaceSearch::renderWindow()
+{
+	// Toggle with Ctrl+Shift+F
+	ImGuiIO &io = ImGui::GetIO();
+	if ((io.KeyCtrl || io.KeySuper) && io.KeyShift &&
+		ImGui::IsKeyPressed(ImGuiKey_F, false))
+	{
+		toggleWindow();
+		return;
+	}
+	if (!showWindow)
+		return;
+
+	if (ImGui::IsKeyPressed(ImGuiKey_Escape))
+	{
+		toggleWindow();
+		return;
+	}
+
+	renderHeader();
+
+	if (ImGui::IsMouseClicked(ImGuiMouseButton_Left) &&
+		!ImGui::IsWindowHovered(ImGuiHoveredFlags_ChildWindows))
+	{
+		toggleWindow();
+		ImGui::End();
+		ImGui::PopStyleColor(3);
+		ImGui::PopStyleVar(3);
+		return;
+	}
+
+	if (io.KeyAlt && ImGui::IsKeyPressed(ImGuiKey_C, false))
+	{
+		ignoreCase = !ignoreCase;
+	}
+	if (io.KeyAlt && ImGui::IsKeyPressed(ImGuiKey_R, false))
+	{
+		useRegex = !useRegex;
+	}
+	if (ImGui::IsKeyPressed(ImGuiKey_UpArrow))
+	{
+		moveSelection(-1);
+	}
+	if (ImGui::IsKeyPressed(ImGuiKey_DownArrow))
+	{
+		moveSelection(1);
+	}
+
+	renderSearchInput();
+	restartSearchIfChanged();
+	collectResults();
+
+	if (ImGui::IsKeyPressed(ImGuiKey_Enter, false) ||
+		ImGui::IsKeyPressed(ImGuiKey_KeypadEnter, false))
+	{
+		ImGui::End();
+		ImGui::PopStyleColor(3);
+		ImGui::PopStyleVar(3);
+		openRow(selectedRow);
+		return;
+	}
+
+	ImGui::Spacing();
+	renderStatus();
+	ImGui::Spacing();
+
+	renderResults();
+
+	ImGui::Separator();
+	ImGui::Text("Enter to open, Ctrl+Shift+F or ESC to close");
+	ImGui::End();
+	// Pop the window style colors and vars pushed in renderHeader()
+	ImGui::PopStyleColor(3);
+	ImGui::PopStyleVar(3);
+}
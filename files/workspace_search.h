@@ -0,0 +1,68 @@
+// workspace_search.h
+
+#pragma once
+#include "imgui.h"
+#include "workspace_grep.h"
+#include <string>
+#include <vector>
+
+// Search-in-files popup. Every edit of the query restarts the grep; results
+// are pulled from the workers each frame and rendered through a list clipper.
+class WorkspaceSearch
+{
+  private:
+	char searchBuffer[256] = "";
+	bool ignoreCase = true;
+	bool useRegex = false;
+
+	std::string searchedRoot;
+	std::string searchedPattern;
+	bool searchedIgnoreCase = true;
+	bool searchedRegex = false;
+	bool searchedIndex = false;
+	std::string error;
+
+	WorkspaceGrep grep;
+	std::vector<GrepFileResult> results;
+	size_t totalMatches = 0;
+
+	// Flattened list: a file header (match == -1) followed by its matches
+	struct Row
+	{
+		int file;
+		int match;
+	};
+	std::vector<Row> rows;
+	int selectedRow = -1;
+	bool scrollToSelection = false;
+
+	// Embedded mode support
+	bool isEmbedded = false;
+	ImVec2 editorPanePos;
+	ImVec2 editorPaneSize;
+
+	void restartSearchIfChanged();
+	void collectResults();
+	void moveSelection(int direction);
+	void openRow(int row);
+
+	void renderHeader();
+	void renderSearchInput();
+	void renderStatus();
+	void renderResults();
+
+  public:
+	bool showWindow = false;
+	void toggleWindow();
+	bool isWindowOpen() const { return showWindow; }
+	void renderWindow();
+
+	void setEmbedded(bool embedded) { isEmbedded = embedded; }
+	void setEditorPaneBounds(const ImVec2 &pos, const ImVec2 &size)
+	{
+		editorPanePos = pos;
+		editorPaneSize = size;
+	}
+};
+
+extern WorkspaceSearch gWorkspaceSearch;
@@ -1,5 +1,8 @@
 #include "lsp_client.h"
+#include "../ai/ai_tab.h"
 #include "../util/keybinds.h"
+#include "../util/redraw.h"
+#include "../util/settings.h"
 #include "lsp_includes.h"
 
 #include "lsp_goto_def.h"
@@ -13,6 +16,9 @@
 #include <filesystem>
 #include <fstream>
 #include <future>
+#include <iterator>
+#include <optional>
+#include <variant>
 
 // Global instance
 LSPClient gLSPClient;
@@ -246,6 +252,8 @@ void LSPClient::shutdown()
 	{
 		std::cout << "LSP: Beginning shutdown sequence..." << std::endl;
 
+		didClose(documentPath);
+
 		// First send proper LSP shutdown to server
 		stopServer();
 
@@ -336,6 +344,30 @@ void LSPClient::stopServer()
 	currentLanguage.clear();
 }
 
+// The sync kind a server asks for, bare or inside its sync options. Either
+// one left out means it wants no changes.
+static LSPClient::SyncMode syncModeOf(const lsp::ServerCapabilities &capabilities)
+{
+	if (!capabilities.textDocumentSync)
+		return LSPClient::SyncMode::None;
+
+	const auto &sync = *capabilities.textDocumentSync;
+	std::optional<lsp::TextDocumentSyncKind> kind;
+	if (const auto *options = std::get_if<lsp::TextDocumentSyncOptions>(&sync))
+	{
+		kind = options->change;
+	} else
+	{
+		kind = std::get<lsp::TextDocumentSyncKind>(sync);
+	}
+
+	if (kind == lsp::TextDocumentSyncKind::Incremental)
+		return LSPClient::SyncMode::Incremental;
+	if (kind == lsp::TextDocumentSyncKind::Full)
+		return LSPClient::SyncMode::Full;
+	return LSPClient::SyncMode::None;
+}
+
 bool LSPClient::sendLSPInitialize()
 {
 	if (!messageHandler)
@@ -353,6 +385,10 @@ bool LSPClient::sendLSPInitialize()
 		params.capabilities.textDocument = lsp::TextDocumentClientCapabilities{};
 		params.capabilities.textDocument->hover = lsp::HoverClientCapabilities{};
 		params.capabilities.textDocument->hover->dynamicRegistration = false;
+		params.capabilities.textDocument->synchronization =
+			lsp::TextDocumentSyncClientCapabilities{};
+		params.capabilities.textDocument->synchronization->dynamicRegistration = false;
+		syncMode = SyncMode::Full;
 
 		// Send initialize request
 		auto response =
@@ -365,6 +401,7 @@ bool LSPClient::sendLSPInitialize()
 				auto result = future.get();
 				std::cout << "LSP: Initialize request completed successfully"
 						  << std::endl;
+				syncMode = syncModeOf(result.capabilities);
 
 				// Send initialized notification
 				lsp::InitializedParams initParams;
@@ -387,25 +424,61 @@ bool LSPClient::sendLSPInitialize()
 	}
 }
 
+// LSP language identifier of a file. The lsp.json language names are
+// identifiers already, except where one server covers several languages.
+static std::string languageIdOf(const std::string &filePath, const std::string &language)
+{
+	static const std::map<std::string, std::string> byExtension = {
+		{".c", "c"},
+		{".cjs", "javascript"},
+		{".js", "javascript"},
+		{".jsx", "javascriptreact"},
+		{".mjs", "javascript"},
+		{".mod", "go.mod"},
+		{".tsx", "typescriptreact"},
+	};
+
+	std::string extension = std::filesystem::path(filePath).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+	auto it = byExtension.find(extension);
+	return it != byExtension.end() ? it->second : language;
+}
+
 void LSPClient::didOpen(const std::string &filePath, const std::string &content)
 {
 	if (!initialized || !messageHandler)
 		return;
 
+	if (!documentPath.empty())
+	{
+		didClose(documentPath);
+	}
+
+	// Other languages are not this server's business
+	std::string language = detectLanguageFromFile(filePath);
+	if (language != currentLanguage)
+		return;
+
 	try
 	{
 		// Create didOpen notification
 		lsp::DidOpenTextDocumentParams params;
 		params.textDocument.uri = lsp::FileUri::fromPath(filePath);
-		params.textDocument.languageId = "cpp"; // Simplified for now
-		params.textDocument.version = 1;
+		params.textDocument.languageId = languageIdOf(filePath, language);
+		params.textDocument.version = ++documentVersion;
 		params.textDocument.text = content;
 
 		// Send the notification
 		messageHandler->sendNotification<lsp::notifications::TextDocument_DidOpen>(
 			std::move(params));
 
-		std::cout << "LSP: Sending didOpen for file: " << filePath << std::endl;
+		documentPath = filePath;
+		pendingChanges.clear();
+		pendingBytes = 0;
+		pendingWhole = false;
+		anchorOffset = 0;
+		anchorLine = 0;
+
 		std::cout << "LSP: Document opened: " << filePath
 				  << " (content length: " << content.length() << ")" << std::endl;
 	} catch (const std::exception &e)
@@ -414,34 +487,244 @@ void LSPClient::didOpen(const std::string &filePath, const std::string &content)
 	}
 }
 
-void LSPClient::didEdit(const std::string &filePath, const std::string &content)
+void LSPClient::didChange(const std::string &filePath,
+						  std::string_view content,
+						  int position,
+						  std::string_view removed,
+						  std::string_view inserted)
 {
+	SyncMode mode = syncMode;
+	if (documentPath.empty() || filePath != documentPath || mode == SyncMode::None)
+		return;
+
+	auto now = std::chrono::steady_clock::now();
+	if (pendingChanges.empty() && !pendingWhole)
+	{
+		firstPendingTime = now;
+	}
+	lastPendingTime = now;
+	gRedraw.requestIn(std::chrono::duration<double>(DEBOUNCE).count());
+
+	// Once the queue outgrows the text, sending the text is cheaper
+	pendingBytes += inserted.size();
+	if (mode == SyncMode::Full || pendingBytes > content.size())
+	{
+		pendingWhole = true;
+		pendingChanges.clear();
+	}
+	if (pendingWhole)
+	{
+		anchorOffset = 0; // The text before it may change unseen now
+		anchorLine = 0;
+		return;
+	}
+
+	auto [line, character] = locate(content, position);
+	PendingChange change{line, character, line, character, std::string(inserted)};
+	size_t lastBreak = removed.rfind('\n');
+	if (lastBreak == std::string_view::npos)
+	{
+		change.endCharacter += utf16Length(removed);
+	} else
+	{
+		change.endLine += static_cast<uint32_t>(
+			std::count(removed.begin(), removed.end(), '\n'));
+		change.endCharacter = utf16Length(removed.substr(lastBreak + 1));
+	}
+	pendingChanges.push_back(std::move(change));
+}
+
+void LSPClient::didReload(const std::string &filePath)
+{
+	if (documentPath.empty() || filePath != documentPath)
+		return;
+
+	pendingWhole = true;
+	pendingChanges.clear();
+	anchorOffset = 0;
+	anchorLine = 0;
+	flushChanges();
+}
+
+void LSPClient::didClose(const std::string &filePath)
+{
+	if (filePath.empty() || filePath != documentPath)
+		return;
+
+	flushChanges();
+	// `filePath` may be documentPath itself, which is cleared here
+	std::string closedPath = std::move(documentPath);
+	documentPath.clear();
 	if (!initialized || !messageHandler)
 		return;
 
 	try
 	{
-		// Create didChange notification
+		lsp::DidCloseTextDocumentParams params;
+		params.textDocument.uri = lsp::FileUri::fromPath(closedPath);
+		messageHandler->sendNotification<lsp::notifications::TextDocument_DidClose>(
+			std::move(params));
+	} catch (const std::exception &e)
+	{
+		std::cerr << "LSP: Failed to send didClose: " << e.what() << std::endl;
+	}
+}
+
+void LSPClient::update()
+{
+	if (pendingChanges.empty() && !pendingWhole)
+		return;
+
+	auto now = std::chrono::steady_clock::now();
+	if (now - lastPendingTime >= DEBOUNCE || now - firstPendingTime >= MAX_DELAY)
+	{
+		flushChanges();
+	} else
+	{
+		gRedraw.requestIn(std::chrono::duration<double>(DEBOUNCE).count());
+	}
+}
+
+void LSPClient::flushChanges()
+{
+	if (pendingChanges.empty() && !pendingWhole)
+		return;
+	if (pendingWhole && gAITab.has_ghost_text)
+	{
+		// The buffer holds ghost text the server must not see; accepting or
+		// dismissing it redraws, and the text goes then
+		return;
+	}
+
+	std::vector<PendingChange> changes = std::move(pendingChanges);
+	bool whole = pendingWhole;
+	pendingChanges.clear();
+	pendingBytes = 0;
+	pendingWhole = false;
+	if (!initialized || !messageHandler || documentPath.empty())
+		return;
+
+	try
+	{
 		lsp::DidChangeTextDocumentParams params;
-		params.textDocument.uri = lsp::FileUri::fromPath(filePath);
-		params.textDocument.version = 2; // Increment version for changes
+		params.textDocument.uri = lsp::FileUri::fromPath(documentPath);
+		params.textDocument.version = ++documentVersion;
 
-		// Create a content change that replaces the entire document
-		lsp::TextDocumentContentChangeEvent_Text change;
-		change.text = content;
-		params.contentChanges.push_back(change);
+		// Changes apply in order, each to the text the one before left
+		if (whole)
+		{
+			lsp::TextDocumentContentChangeEvent_Text change;
+			change.text = editor_state.fileContent;
+			params.contentChanges.push_back(std::move(change));
+		}
+		for (PendingChange &pending : changes)
+		{
+			lsp::TextDocumentContentChangeEvent_Range change;
+			change.range.start.line = pending.startLine;
+			change.range.start.character = pending.startCharacter;
+			change.range.end.line = pending.endLine;
+			change.range.end.character = pending.endCharacter;
+			change.text = std::move(pending.text);
+			params.contentChanges.push_back(std::move(change));
+		}
 
-		// Send the notification
 		messageHandler->sendNotification<lsp::notifications::TextDocument_DidChange>(
 			std::move(params));
-
-		// std::cout << "LSP: Sending didChange for file: " << filePath << std::endl;
 	} catch (const std::exception &e)
 	{
 		std::cerr << "LSP: Failed to send didChange: " << e.what() << std::endl;
 	}
 }
 
+void LSPClient::dropAnchor()
+{
+	anchorOffset = 0;
+	anchorLine = 0;
+}
+
+uint32_t LSPClient::utf16Length(std::string_view text)
+{
+	uint32_t units = 0;
+	for (unsigned char c : text)
+	{
+		if ((c & 0xC0) != 0x80)
+			units++; // Every character starts with a lead byte
+		if (c >= 0xF0)
+			units++; // Four byte sequences are surrogate pairs
+	}
+	return units;
+}
+
+size_t LSPClient::utf16ToBytes(std::string_view text, uint32_t units)
+{
+	size_t bytes = 0;
+	while (bytes < text.size() && units > 0)
+	{
+		unsigned char c = static_cast<unsigned char>(text[bytes]);
+		size_t length = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1;
+		uint32_t width = c >= 0xF0 ? 2 : 1;
+		if (width > units)
+			break; // The offset splits a surrogate pair
+		units -= width;
+		bytes = std::min(bytes + length, text.size());
+	}
+	return bytes;
+}
+
+int LSPClient::byteColumn(const std::string &path,
+						  uint32_t line,
+						  uint32_t character,
+						  std::map<std::string, std::string> &files)
+{
+	auto it = files.find(path);
+	if (it == files.end())
+	{
+		std::ifstream in(path, std::ios::binary);
+		std::string text((std::istreambuf_iterator<char>(in)),
+						 std::istreambuf_iterator<char>());
+		it = files.emplace(path, std::move(text)).first;
+	}
+	std::string_view text(it->second);
+
+	size_t lineStart = 0;
+	for (uint32_t i = 0; i < line; i++)
+	{
+		size_t next = text.find('\n', lineStart);
+		if (next == std::string_view::npos)
+			return static_cast<int>(character) + 1; // Not the text the server saw
+		lineStart = next + 1;
+	}
+	size_t lineEnd = std::min(text.find('\n', lineStart), text.size());
+	std::string_view lineText = text.substr(lineStart, lineEnd - lineStart);
+	return static_cast<int>(utf16ToBytes(lineText, character)) + 1;
+}
+
+std::pair<uint32_t, uint32_t> LSPClient::locate(std::string_view content, size_t offset)
+{
+	offset = std::min(offset, content.size());
+	if (anchorOffset > content.size())
+	{
+		anchorOffset = 0;
+		anchorLine = 0;
+	}
+
+	// The text before an edit stays as it was, so its position is the anchor
+	// for the next one
+	size_t from = std::min(offset, anchorOffset);
+	size_t to = std::max(offset, anchorOffset);
+	auto lines = static_cast<uint32_t>(
+		std::count(content.begin() + from, content.begin() + to, '\n'));
+	anchorLine = offset >= anchorOffset ? anchorLine + lines : anchorLine - lines;
+	anchorOffset = offset;
+
+	size_t lineStart = offset;
+	while (lineStart > 0 && content[lineStart - 1] != '\n')
+	{
+		lineStart--;
+	}
+	return {anchorLine, utf16Length(content.substr(lineStart, offset - lineStart))};
+}
+
 void LSPClient::startMessageProcessingLoop()
 {
 	if (!messageHandler || running)
@@ -461,6 +744,9 @@ void LSPClient::messageProcessingThread()
 		while (running && messageHandler)
 		{
 			messageHandler->processIncomingMessages();
+
+			// Responses and notifications were just dispatched to their handlers
+			gRedraw.request();
 		}
 	} catch (const std::exception &e)
 	{
@@ -472,28 +758,30 @@ void LSPClient::messageProcessingThread()
 
 bool LSPClient::keybinds()
 {
-	if (!initialized)
-		return false;
-
 	bool modPressed = ImGui::GetIO().KeyCtrl;
 	if (!modPressed)
 		return false;
 
 	bool shortcutPressed = false;
 
-	// LSP Symbol Info keybind
-	ImGuiKey symbolInfoKey = gKeybinds.getActionKey("lsp_symbol_info");
-	if (symbolInfoKey != ImGuiKey_None && ImGui::IsKeyPressed(symbolInfoKey, false))
+	// LSP Goto Definition keybind, which falls back to the symbol index
+	// without a server
+	ImGuiKey gotoDefKey = gKeybinds.getActionKey("lsp_find_def");
+	if ((initialized || gSettings.getSnapshot()->symbolIndex) &&
+		gotoDefKey != ImGuiKey_None && ImGui::IsKeyPressed(gotoDefKey, false))
 	{
-		gLSPSymbolInfo.get();
+		gLSPGotoDef.get();
 		shortcutPressed = true;
 	}
 
-	// LSP Goto Definition keybind
-	ImGuiKey gotoDefKey = gKeybinds.getActionKey("lsp_find_def");
-	if (gotoDefKey != ImGuiKey_None && ImGui::IsKeyPressed(gotoDefKey, false))
+	if (!initialized)
+		return shortcutPressed;
+
+	// LSP Symbol Info keybind
+	ImGuiKey symbolInfoKey = gKeybinds.getActionKey("lsp_symbol_info");
+	if (symbolInfoKey != ImGuiKey_None && ImGui::IsKeyPressed(symbolInfoKey, false))
 	{
-		gLSPGotoDef.get();
+		gLSPSymbolInfo.get();
 		shortcutPressed = true;
 	}
 
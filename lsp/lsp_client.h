@@ -1,10 +1,14 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <future>
 #include <map>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <vector>
 
@@ -34,6 +38,9 @@ struct LanguageServerInfo
 class LSPClient
 {
   public:
+	// How the server wants document changes, from its initialize result
+	enum class SyncMode { None, Full, Incremental };
+
 	LSPClient();
 	~LSPClient();
 
@@ -51,9 +58,36 @@ class LSPClient
 	}
 	std::vector<std::string> getSupportedLanguages() const;
 
-	// Document management
+	// Document management. The server follows the one open buffer: edits are
+	// queued as they are made and sent together once typing pauses.
 	void didOpen(const std::string &filePath, const std::string &content);
-	void didEdit(const std::string &filePath, const std::string &content);
+	// An edit about to be made to `content`, the open buffer as it is before it
+	void didChange(const std::string &filePath,
+				   std::string_view content,
+				   int position,
+				   std::string_view removed,
+				   std::string_view inserted);
+	// The buffer was replaced as a whole, e.g. reloaded from disk
+	void didReload(const std::string &filePath);
+	void didClose(const std::string &filePath);
+	// Sends the queued edits once they are DEBOUNCE old; called every frame
+	void update();
+	// Sends the queued edits now, so a request sees the text it refers to
+	void flushChanges();
+	// Text went in or out of the buffer without an edit, i.e. AI ghost text
+	void dropAnchor();
+
+	// Length of UTF-8 text in UTF-16 code units, the unit of LSP columns
+	static uint32_t utf16Length(std::string_view text);
+	// Bytes the first `units` UTF-16 code units of `text` take; the inverse
+	// of utf16Length()
+	static size_t utf16ToBytes(std::string_view text, uint32_t units);
+	// 1-based byte column of an LSP position in the file at `path`, read from
+	// disk into `files` the first time it is needed
+	static int byteColumn(const std::string &path,
+						  uint32_t line,
+						  uint32_t character,
+						  std::map<std::string, std::string> &files);
 
 	// Direct access to message handler
 	lsp::MessageHandler *getMessageHandler() { return messageHandler.get(); }
@@ -75,12 +109,29 @@ class LSPClient
 	std::string expandEnvironmentVariables(const std::string &path) const;
 
   private:
+	// An edit waiting to be sent, in LSP coordinates
+	struct PendingChange
+	{
+		uint32_t startLine;
+		uint32_t startCharacter;
+		uint32_t endLine;
+		uint32_t endCharacter;
+		std::string text;
+	};
+
+	// Quiet time after an edit before the queue is sent, and the longest an
+	// edit waits while typing goes on
+	static constexpr std::chrono::milliseconds DEBOUNCE{100};
+	static constexpr std::chrono::milliseconds MAX_DELAY{1000};
+
 	// Helper functions
 	std::string findServerPath(const std::string &language) const;
 	std::string detectLanguageFromFile(const std::string &filePath) const;
 	bool sendLSPInitialize();
 	void startMessageProcessingLoop();
 	void messageProcessingThread();
+	// Line and UTF-16 column of a byte offset into `content`
+	std::pair<uint32_t, uint32_t> locate(std::string_view content, size_t offset);
 
 	// State
 	bool initialized;
@@ -100,6 +151,22 @@ class LSPClient
 
 	// Message processing thread
 	std::thread processingThread;
+
+	// Written by the initialize response; Full until it arrives
+	std::atomic<SyncMode> syncMode{SyncMode::Full};
+
+	// The open document; used on the UI thread only
+	std::string documentPath;
+	int documentVersion = 0; // Of all documents, so it never goes back
+	std::vector<PendingChange> pendingChanges;
+	size_t pendingBytes = 0;
+	bool pendingWhole = false; // Send the whole text instead of pendingChanges
+	std::chrono::steady_clock::time_point firstPendingTime;
+	std::chrono::steady_clock::time_point lastPendingTime;
+	// An offset whose line is known, so locating an edit only counts the
+	// lines between it and the last one
+	size_t anchorOffset = 0;
+	uint32_t anchorLine = 0;
 };
 
 // Global instance
@@ -1,6 +1,11 @@
 #include "lsp_goto_def.h"
 #include "lsp_includes.h"
 #include "lsp_uri_options.h"
+#include "../files/symbol_index.h"
+#include "../util/redraw.h"
+#include "../util/settings.h"
+#include <algorithm>
+#include <cctype>
 
 // Global instance
 LSPGotoDef gLSPGotoDef;
@@ -12,12 +17,17 @@ LSPGotoDef::~LSPGotoDef() = default;
 void LSPGotoDef::get()
 {
 	if (!gLSPClient.isInitialized())
+	{
+		getFromSymbolIndex();
 		return;
+	}
 
 	// Get current cursor position
 	int row = gEditor.getLineFromPos(editor_state.cursor_index);
 	int line_start = editor_state.editor_content_lines[row];
-	int column = editor_state.cursor_index - line_start;
+	std::string_view content(editor_state.fileContent);
+	int column = LSPClient::utf16Length(
+		content.substr(line_start, editor_state.cursor_index - line_start));
 
 	// Set pending state
 	pending = true;
@@ -40,6 +50,45 @@ void LSPGotoDef::get()
 			});
 }
 
+void LSPGotoDef::getFromSymbolIndex()
+{
+	if (!gSettings.getSnapshot()->symbolIndex)
+		return;
+
+	// The identifier around the cursor
+	const std::string &content = editor_state.fileContent;
+	auto isWordChar = [](char c) {
+		return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+	};
+	int start = std::min(editor_state.cursor_index, static_cast<int>(content.size()));
+	int end = start;
+	while (start > 0 && isWordChar(content[start - 1]))
+		start--;
+	while (end < static_cast<int>(content.size()) && isWordChar(content[end]))
+		end++;
+	if (start == end)
+		return;
+
+	gSymbolIndex.open(gFileExplorer.selectedFolder);
+	std::shared_ptr<const SymbolSnapshot> snapshot = gSymbolIndex.snapshot();
+	if (!snapshot)
+		return;
+
+	definitions.clear();
+	std::string_view word = std::string_view(content).substr(start, end - start);
+	for (uint32_t id : snapshot->find(word))
+	{
+		std::map<std::string, std::string> entry;
+		entry["file"] = snapshot->fullPath(id);
+		entry["row"] = std::to_string(snapshot->line(id) + 1);	 // Convert to 1-based
+		entry["col"] = std::to_string(snapshot->column(id) + 1); // Convert to 1-based
+		definitions.push_back(entry);
+	}
+	pending = false;
+	show = true;
+	printResponse(definitions);
+}
+
 void LSPGotoDef::request(
 	int line,
 	int character,
@@ -47,6 +96,9 @@ void LSPGotoDef::request(
 {
 	try
 	{
+		// The position refers to the text as it is now
+		gLSPClient.flushChanges();
+
 		// Create request parameters
 		lsp::ReferenceParams params;
 		params.textDocument.uri = lsp::FileUri::fromPath(gFileExplorer.currentFile);
@@ -67,11 +119,13 @@ void LSPGotoDef::request(
 							   auto result = response.result.get();
 							   auto locations = processResponse(result);
 							   callback(locations);
+							   gRedraw.request();
 						   } catch (const std::exception &e)
 						   {
 							   // Pass empty vector on error
 							   std::vector<std::map<std::string, std::string>> empty;
 							   callback(empty);
+							   gRedraw.request();
 						   }
 					   }));
 
@@ -99,13 +153,15 @@ LSPGotoDef::processResponse(const lsp::TextDocument_ReferencesResult &result)
 	if (locations.empty())
 		return results; // Return empty vector
 
+	// Columns come in UTF-16 code units; the editor counts bytes
+	std::map<std::string, std::string> files;
 	for (const auto &loc : locations)
 	{
 		std::map<std::string, std::string> entry;
 		entry["file"] = std::string(loc.uri.path());
 		entry["row"] = std::to_string(loc.range.start.line + 1); // Convert to 1-based
-		entry["col"] =
-			std::to_string(loc.range.start.character + 1); // Convert to 1-based
+		entry["col"] = std::to_string(LSPClient::byteColumn(
+			entry["file"], loc.range.start.line, loc.range.start.character, files));
 		results.push_back(entry);
 	}
 
@@ -38,6 +38,10 @@ class LSPGotoDef
 				callback);
 
   private:
+	// Looks the identifier under the cursor up in the workspace symbol index,
+	// for when no language server is running
+	void getFromSymbolIndex();
+
 	// Helper function to process the LSP response
 	std::vector<std::map<std::string, std::string>>
 	processResponse(const lsp::TextDocument_ReferencesResult &result);
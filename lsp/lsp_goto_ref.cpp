@@ -1,6 +1,7 @@
 #include "lsp_goto_ref.h"
 #include "lsp_includes.h"
 #include "lsp_uri_options.h"
+#include "../util/redraw.h"
 
 // Global instance
 LSPGotoRef gLSPGotoRef;
@@ -17,7 +18,9 @@ void LSPGotoRef::get()
 	// Get current cursor position
 	int row = gEditor.getLineFromPos(editor_state.cursor_index);
 	int line_start = editor_state.editor_content_lines[row];
-	int column = editor_state.cursor_index - line_start;
+	std::string_view content(editor_state.fileContent);
+	int column = LSPClient::utf16Length(
+		content.substr(line_start, editor_state.cursor_index - line_start));
 
 	// Set pending state
 	pending = true;
@@ -47,6 +50,9 @@ void LSPGotoRef::request(
 {
 	try
 	{
+		// The position refers to the text as it is now
+		gLSPClient.flushChanges();
+
 		// Create request parameters
 		lsp::ReferenceParams params;
 		params.textDocument.uri = lsp::FileUri::fromPath(gFileExplorer.currentFile);
@@ -68,11 +74,13 @@ void LSPGotoRef::request(
 							   auto result = response.result.get();
 							   auto locations = processResponse(result);
 							   callback(locations);
+							   gRedraw.request();
 						   } catch (const std::exception &e)
 						   {
 							   // Pass empty vector on error
 							   std::vector<std::map<std::string, std::string>> empty;
 							   callback(empty);
+							   gRedraw.request();
 						   }
 					   }));
 
@@ -100,13 +108,15 @@ LSPGotoRef::processResponse(const lsp::TextDocument_ReferencesResult &result)
 	if (locations.empty())
 		return results; // Return empty vector
 
+	// Columns come in UTF-16 code units; the editor counts bytes
+	std::map<std::string, std::string> files;
 	for (const auto &loc : locations)
 	{
 		std::map<std::string, std::string> entry;
 		entry["file"] = std::string(loc.uri.path());
 		entry["row"] = std::to_string(loc.range.start.line + 1); // Convert to 1-based
-		entry["col"] =
-			std::to_string(loc.range.start.character + 1); // Convert to 1-based
+		entry["col"] = std::to_string(LSPClient::byteColumn(
+			entry["file"], loc.range.start.line, loc.range.start.character, files));
 		results.push_back(entry);
 	}
 
@@ -16,7 +16,9 @@ void LSPSymbolInfo::get()
 	// Get current cursor position
 	int row = gEditor.getLineFromPos(editor_state.cursor_index);
 	int line_start = editor_state.editor_content_lines[row];
-	int column = editor_state.cursor_index - line_start;
+	std::string_view content(editor_state.fileContent);
+	int column = LSPClient::utf16Length(
+		content.substr(line_start, editor_state.cursor_index - line_start));
 
 	// Set pending state
 	pending = true;
@@ -38,6 +40,9 @@ void LSPSymbolInfo::request(int line,
 {
 	try
 	{
+		// The position refers to the text as it is now
+		gLSPClient.flushChanges();
+
 		// Create the hover request parameters
 		lsp::HoverParams params;
 		params.textDocument.uri = lsp::FileUri::fromPath(gFileExplorer.currentFile);
@@ -75,16 +80,9 @@ void LSPSymbolInfo::render()
 	if (!show)
 		return;
 
-	// Calculate cursor position in screen space
-	int cursor_line = gEditor.getLineFromPos(editor_state.cursor_index);
-	float cursor_x = gEditorCursor.getCursorXPosition(editor_state.text_pos,
-													  editor_state.fileContent,
-													  editor_state.cursor_index);
-
 	// Get the actual screen position of the text cursor
-	ImVec2 cursor_screen_pos = editor_state.text_pos;
-	cursor_screen_pos.x = cursor_x;
-	cursor_screen_pos.y += cursor_line * editor_state.line_height;
+	ImVec2 cursor_screen_pos =
+		gEditorCursor.cursorScreenPosition(editor_state.cursor_index);
 
 	// Set initial display position relative to cursor
 	ImVec2 displayPosition = cursor_screen_pos;
@@ -21,6 +21,8 @@ Description: Main application class implementation for NED text editor.
 #include "editor/editor_highlight.h"
 #include "editor/editor_scroll.h"
 #include "files/files.h"
+#include "files/recovery_journal.h"
+#include "files/symbol_index.h"
 #include "lsp/lsp_client.h"
 #include "util/debug_console.h"
 #include "util/init.h"
@@ -29,6 +31,7 @@ Description: Main application class implementation for NED text editor.
 #include "util/scroll.h"
 #include "util/settings.h"
 #include "util/splitter.h"
+#include "util/startup_trace.h"
 #include "util/terminal.h"
 #include "util/welcome.h"
 
@@ -64,10 +67,19 @@ bool Ned::initialize()
 	}
 
 	// Initialize application manager
-	if (!app.initializeApp(
-			shaderManager, render, gSettings, splitter, windowResize, quad, fb, accum))
 	{
-		return false;
+		StartupTrace::Phase phase("app setup");
+		if (!app.initializeApp(shaderManager,
+							   render,
+							   gSettings,
+							   splitter,
+							   windowResize,
+							   quad,
+							   fb,
+							   accum))
+		{
+			return false;
+		}
 	}
 
 	// Set up window user pointer
@@ -120,6 +132,19 @@ void Ned::cleanup()
 	std::cout << "App: Shutting down LSP client..." << std::endl;
 	gLSPClient.shutdown();
 
+	// Keep the icons rasterized this session for the next start
+	gFileExplorer.saveIconCache();
+	gFileExplorer.forceSaveUndoState();
+
+	// Tree-sitter queries may still be compiling if we quit right away
+	Init::finishBackgroundTasks();
+
+	// A clean exit leaves nothing to recover
+	gRecoveryJournal.close();
+
+	// Stops the symbol parser, which listens to the workspace index
+	gSymbolIndex.close();
+
 	// Then cleanup other components
 	app.cleanupAll(quad, shaderManager, fb, accum);
 }
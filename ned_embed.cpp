@@ -15,6 +15,8 @@ Description: Implementation of the embeddable NED editor wrapper.
 #include "files/file_finder.h"
 #include "files/file_tree.h"
 #include "files/files.h"
+#include "files/symbol_search.h"
+#include "files/workspace_search.h"
 
 #include "shaders/shader_manager.h"
 #include "shaders/shader_types.h"
@@ -237,6 +239,8 @@ void NedEmbed::render()
 
 	// Set embedded flag for FileFinder to constrain it to editor pane
 	gFileFinder.setEmbedded(true);
+	gWorkspaceSearch.setEmbedded(true);
+	gSymbolSearch.setEmbedded(true);
 
 	gSettings.renderNotification("");
 	gKeybinds.checkKeybindsFile();
@@ -328,6 +332,9 @@ void NedEmbed::cleanup() { cleanupComponents(); }
 
 void NedEmbed::cleanupComponents()
 {
+	gFileExplorer.saveIconCache();
+	gFileExplorer.forceSaveUndoState();
+
 	if (splitter)
 	{
 		delete splitter;
@@ -159,18 +159,27 @@ bool Shader::loadShader(const std::string &vertexShaderRelativePath,
 	glDeleteShader(vertexShader);
 	glDeleteShader(fragmentShader);
 
+	// Locations and uploaded values belong to the previous program
+	uniformLocations.clear();
+	floatValues.clear();
+	intValues.clear();
+	vec2Values.clear();
+
 	return true;
 }
 
 void Shader::useShader() { glUseProgram(shaderProgram); }
 
-void Shader::setFloat(const std::string &name, float value)
+int Shader::getUniformLocation(const std::string &name)
 {
-	GLint location = glGetUniformLocation(shaderProgram, name.c_str());
-	if (location != -1)
+	auto it = uniformLocations.find(name);
+	if (it != uniformLocations.end())
 	{
-		glUniform1f(location, value);
-	} else
+		return it->second;
+	}
+
+	GLint location = glGetUniformLocation(shaderProgram, name.c_str());
+	if (location == -1)
 	{
 		// Only warn once per uniform name per session
 		if (warnedUniforms.find(name) == warnedUniforms.end())
@@ -180,40 +189,70 @@ void Shader::setFloat(const std::string &name, float value)
 			warnedUniforms.insert(name);
 		}
 	}
+	uniformLocations.emplace(name, location);
+	return location;
+}
+
+void Shader::setFloat(const std::string &name, float value)
+{
+	setFloat(getUniformLocation(name), value);
 }
 
 void Shader::setInt(const std::string &name, int value)
 {
-	GLint location = glGetUniformLocation(shaderProgram, name.c_str());
+	setInt(getUniformLocation(name), value);
+}
+
+void Shader::setMatrix4fv(const std::string &name, const float *matrix)
+{
+	GLint location = getUniformLocation(name);
 	if (location != -1)
 	{
-		glUniform1i(location, value);
-	} else
+		glUniformMatrix4fv(location, 1, GL_FALSE, matrix);
+	}
+}
+
+void Shader::setFloat(int location, float value)
+{
+	if (location == -1)
 	{
-		// Only warn once per uniform name per session
-		if (warnedUniforms.find(name) == warnedUniforms.end())
-		{
-			std::cerr << "⚠️  Warning: Uniform '" << name
-					  << "' not found in shader program" << std::endl;
-			warnedUniforms.insert(name);
-		}
+		return;
 	}
+	auto it = floatValues.find(location);
+	if (it != floatValues.end() && it->second == value)
+	{
+		return;
+	}
+	glUniform1f(location, value);
+	floatValues[location] = value;
 }
 
-void Shader::setMatrix4fv(const std::string &name, const float *matrix)
+void Shader::setInt(int location, int value)
 {
-	GLint location = glGetUniformLocation(shaderProgram, name.c_str());
-	if (location != -1)
+	if (location == -1)
 	{
-		glUniformMatrix4fv(location, 1, GL_FALSE, matrix);
-	} else
+		return;
+	}
+	auto it = intValues.find(location);
+	if (it != intValues.end() && it->second == value)
 	{
-		// Only warn once per uniform name per session
-		if (warnedUniforms.find(name) == warnedUniforms.end())
-		{
-			std::cerr << "⚠️  Warning: Uniform '" << name
-					  << "' not found in shader program" << std::endl;
-			warnedUniforms.insert(name);
-		}
+		return;
+	}
+	glUniform1i(location, value);
+	intValues[location] = value;
+}
+
+void Shader::setVec2(int location, float x, float y)
+{
+	if (location == -1)
+	{
+		return;
+	}
+	auto it = vec2Values.find(location);
+	if (it != vec2Values.end() && it->second.first == x && it->second.second == y)
+	{
+		return;
 	}
+	glUniform2f(location, x, y);
+	vec2Values[location] = {x, y};
 }
@@ -6,6 +6,7 @@
 #ifndef SHADER_H
 #define SHADER_H
 #include <string>
+#include <unordered_map>
 
 class Shader
 {
@@ -24,10 +25,23 @@ class Shader
 	void setInt(const std::string &name, int value);
 	void setMatrix4fv(const std::string &name, const float *matrix);
 
+	// Location-based setters for per-frame use. Locations come from
+	// getUniformLocation once after loading; values that did not change since the
+	// last call are not re-sent (uniform state lives in the program object).
+	int getUniformLocation(const std::string &name);
+	void setFloat(int location, float value);
+	void setInt(int location, int value);
+	void setVec2(int location, float x, float y);
+
 	// Access to shader program (for ShaderManager)
 	unsigned int getShaderProgram() const { return shaderProgram; }
 
   private:
 	unsigned int shaderProgram;
+
+	std::unordered_map<std::string, int> uniformLocations;
+	std::unordered_map<int, float> floatValues;
+	std::unordered_map<int, int> intValues;
+	std::unordered_map<int, std::pair<float, float>> vec2Values;
 };
 #endif
\ No newline at end of file
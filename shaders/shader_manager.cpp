@@ -4,8 +4,11 @@
 */
 
 #include "shaders/shader_manager.h"
+#include "util/redraw.h"
 #include "util/settings.h"
 #include <GL/glew.h>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 ShaderManager::ShaderManager() {}
@@ -28,9 +31,53 @@ bool ShaderManager::initializeShaders()
 		return false;
 	}
 
+	resolveUniformLocations();
 	return true;
 }
 
+void ShaderManager::resolveUniformLocations()
+{
+	crtUniforms.screenTexture = crtShader.getUniformLocation("screenTexture");
+	crtUniforms.effectsEnabled = crtShader.getUniformLocation("u_effects_enabled");
+	crtUniforms.scanlineIntensity = crtShader.getUniformLocation("u_scanline_intensity");
+	crtUniforms.vignetIntensity = crtShader.getUniformLocation("u_vignet_intensity");
+	crtUniforms.bloomIntensity = crtShader.getUniformLocation("u_bloom_intensity");
+	crtUniforms.staticIntensity = crtShader.getUniformLocation("u_static_intensity");
+	crtUniforms.colorshiftIntensity =
+		crtShader.getUniformLocation("u_colorshift_intensity");
+	crtUniforms.jitterIntensity = crtShader.getUniformLocation("u_jitter_intensity");
+	crtUniforms.curvatureIntensity =
+		crtShader.getUniformLocation("u_curvature_intensity");
+	crtUniforms.pixelationIntensity =
+		crtShader.getUniformLocation("u_pixelation_intensity");
+	crtUniforms.pixelWidth = crtShader.getUniformLocation("u_pixel_width");
+	crtUniforms.time = crtShader.getUniformLocation("time");
+	crtUniforms.resolution = crtShader.getUniformLocation("resolution");
+
+	burnInUniforms.currentFrame = burnInShader.getUniformLocation("currentFrame");
+	burnInUniforms.previousFrame = burnInShader.getUniformLocation("previousFrame");
+	burnInUniforms.decay = burnInShader.getUniformLocation("decay");
+}
+
+int ShaderManager::burnInConvergenceFrames(float decay)
+{
+	// burn_in.frag keeps max(current, previous * decay^4). A full-intensity trail
+	// is gone once it falls under one 8-bit step; one extra frame per
+	// accumulation buffer so both end up holding the settled image.
+	const int maxFrames = 2000;
+	double perFrame = std::pow(static_cast<double>(decay), 4.0);
+	if (perFrame <= 0.0)
+	{
+		return 2;
+	}
+	if (perFrame >= 1.0)
+	{
+		return maxFrames;
+	}
+	double frames = std::log(1.0 / 255.0) / std::log(perFrame);
+	return std::min(static_cast<int>(std::ceil(frames)) + 2, maxFrames);
+}
+
 void ShaderManager::initializeFramebuffers(int width,
 										   int height,
 										   FramebufferState &fb,
@@ -135,7 +182,19 @@ void ShaderManager::renderWithEffects(int display_w,
 {
 	if (shaderEnabled)
 	{
-		renderBurnInPass(fb, accum, quad, gSettings);
+		if (gRedraw.isFrameDamaged())
+		{
+			staticFrames = 0;
+		}
+		float decay = gSettings.getSnapshot()->burninIntensity;
+		if (staticFrames < burnInConvergenceFrames(decay))
+		{
+			renderBurnInPass(fb, accum, quad, gSettings);
+			staticFrames++;
+		}
+	} else
+	{
+		staticFrames = 0;
 	}
 	renderCRTEffects(display_w, display_h, currentTime, fb, accum, quad, gSettings);
 }
@@ -150,9 +209,9 @@ void ShaderManager::renderBurnInPass(const FramebufferState &fb,
 
 	glBindFramebuffer(GL_FRAMEBUFFER, accum.accum[curr].framebuffer);
 	burnInShader.useShader();
-	burnInShader.setInt("currentFrame", 0);
-	burnInShader.setInt("previousFrame", 1);
-	burnInShader.setFloat("decay", gSettings.getSettings()["burnin_intensity"]);
+	burnInShader.setInt(burnInUniforms.currentFrame, 0);
+	burnInShader.setInt(burnInUniforms.previousFrame, 1);
+	burnInShader.setFloat(burnInUniforms.decay, gSettings.getSnapshot()->burninIntensity);
 
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, fb.renderTexture);
@@ -178,37 +237,24 @@ void ShaderManager::renderCRTEffects(int display_w,
 	glClear(GL_COLOR_BUFFER_BIT);
 	crtShader.useShader();
 
-	crtShader.setInt("screenTexture", 0);
-	if (shaderEnabled)
-	{
-		crtShader.setFloat("u_effects_enabled", 1.0f);
-	} else
-	{
-		crtShader.setFloat("u_effects_enabled", 0.0f);
-	}
-	crtShader.setFloat("u_scanline_intensity",
-					   gSettings.getSettings()["scanline_intensity"]);
-	crtShader.setFloat("u_vignet_intensity", gSettings.getSettings()["vignet_intensity"]);
-	crtShader.setFloat("u_bloom_intensity", gSettings.getSettings()["bloom_intensity"]);
-	crtShader.setFloat("u_static_intensity", gSettings.getSettings()["static_intensity"]);
-	crtShader.setFloat("u_colorshift_intensity",
-					   gSettings.getSettings()["colorshift_intensity"]);
-	crtShader.setFloat("u_jitter_intensity",
-					   gSettings.getSettings()["jitter_intensity"].get<float>());
-	crtShader.setFloat("u_curvature_intensity",
-					   gSettings.getSettings()["curvature_intensity"].get<float>());
-	crtShader.setFloat("u_pixelation_intensity",
-					   gSettings.getSettings()["pixelation_intensity"].get<float>());
-	crtShader.setFloat("u_pixel_width",
-					   gSettings.getSettings()["pixel_width"].get<float>());
-
-	GLint timeLocation = glGetUniformLocation(crtShader.getShaderProgram(), "time");
-	GLint resolutionLocation =
-		glGetUniformLocation(crtShader.getShaderProgram(), "resolution");
-	if (timeLocation != -1)
-		glUniform1f(timeLocation, currentTime);
-	if (resolutionLocation != -1)
-		glUniform2f(resolutionLocation, display_w, display_h);
+	crtShader.setInt(crtUniforms.screenTexture, 0);
+	crtShader.setFloat(crtUniforms.effectsEnabled, shaderEnabled ? 1.0f : 0.0f);
+
+	auto snapshot = gSettings.getSnapshot();
+	crtShader.setFloat(crtUniforms.scanlineIntensity, snapshot->scanlineIntensity);
+	crtShader.setFloat(crtUniforms.vignetIntensity, snapshot->vignetIntensity);
+	crtShader.setFloat(crtUniforms.bloomIntensity, snapshot->bloomIntensity);
+	crtShader.setFloat(crtUniforms.staticIntensity, snapshot->staticIntensity);
+	crtShader.setFloat(crtUniforms.colorshiftIntensity, snapshot->colorshiftIntensity);
+	crtShader.setFloat(crtUniforms.jitterIntensity, snapshot->jitterIntensity);
+	crtShader.setFloat(crtUniforms.curvatureIntensity, snapshot->curvatureIntensity);
+	crtShader.setFloat(crtUniforms.pixelationIntensity, snapshot->pixelationIntensity);
+	crtShader.setFloat(crtUniforms.pixelWidth, snapshot->pixelWidth);
+
+	crtShader.setFloat(crtUniforms.time, static_cast<float>(currentTime));
+	crtShader.setVec2(crtUniforms.resolution,
+					  static_cast<float>(display_w),
+					  static_cast<float>(display_h));
 
 	glActiveTexture(GL_TEXTURE0);
 	if (shaderEnabled)
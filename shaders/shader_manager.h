@@ -43,6 +43,39 @@ class ShaderManager
 	Shader burnInShader;
 	bool shaderEnabled = false;
 
+	// Uniform locations, resolved once after the programs are linked
+	struct CRTUniforms
+	{
+		int screenTexture = -1;
+		int effectsEnabled = -1;
+		int scanlineIntensity = -1;
+		int vignetIntensity = -1;
+		int bloomIntensity = -1;
+		int staticIntensity = -1;
+		int colorshiftIntensity = -1;
+		int jitterIntensity = -1;
+		int curvatureIntensity = -1;
+		int pixelationIntensity = -1;
+		int pixelWidth = -1;
+		int time = -1;
+		int resolution = -1;
+	} crtUniforms;
+
+	struct BurnInUniforms
+	{
+		int currentFrame = -1;
+		int previousFrame = -1;
+		int decay = -1;
+	} burnInUniforms;
+
+	// Burn-in converges once old trails have decayed below the 8-bit
+	// accumulation buffers' precision; after that, with an unchanged scene,
+	// the accumulation pass would only rewrite the same image.
+	int staticFrames = 0;
+	static int burnInConvergenceFrames(float decay);
+
+	void resolveUniformLocations();
+
 	// Internal rendering methods
 	void renderBurnInPass(const FramebufferState &fb,
 						  AccumulationBuffers &accum,
@@ -14,9 +14,11 @@ editor. This class combines the functionality of ApplicationManager and Graphics
 #include "settings.h"
 #include "shaders/shader_manager.h"
 #include "util/font.h"
+#include "util/redraw.h"
 #include "util/render.h"
 #include "util/scroll.h"
 #include "util/settings.h"
+#include "util/startup_trace.h"
 #include <chrono>
 #include <iostream>
 
@@ -39,21 +41,26 @@ App::~App() { cleanup(); }
 
 bool App::initialize(ShaderManager &shaderManager)
 {
-	if (!initializeGLFW())
 	{
-		return false;
-	}
-	if (!createWindow())
-	{
-		return false;
+		StartupTrace::Phase phase("GLFW + window");
+		if (!initializeGLFW())
+		{
+			return false;
+		}
+		if (!createWindow())
+		{
+			return false;
+		}
 	}
-	if (!initializeGLEW())
 	{
-		return false;
+		StartupTrace::Phase phase("GLEW + GL state");
+		if (!initializeGLEW())
+		{
+			return false;
+		}
+		initializeOpenGLState();
 	}
 
-	initializeOpenGLState();
-
 	// CRITICAL FIX: Configure macOS window immediately after window creation (like old
 	// version)
 #ifdef __APPLE__
@@ -62,6 +69,7 @@ bool App::initialize(ShaderManager &shaderManager)
 	configureMacOSWindow(window, opacity, blurEnabled);
 #endif
 
+	StartupTrace::Phase phase("shaders");
 	if (!shaderManager.initializeShaders())
 	{
 		std::cerr << "🔴 Shader initialization failed" << std::endl;
@@ -125,17 +133,19 @@ void App::runMainLoop(ShaderManager &shaderManager,
 					  bool &lastBlurEnabled)
 {
 	GLFWwindow *window = getWindow();
+	gRedraw.setWakeEnabled(true);
+	bool firstFrameDrawn = false;
 
 	while (!shouldWindowClose())
 	{
-		// Check for external file changes
-		gFileExplorer.checkForExternalFileChanges();
+		// Block until input, a posted redraw request or the next scheduled wake-up
+		handleEventPolling(shaderManager, glfwGetTime());
 
 		// Get current time for activity tracking
 		double currentTime = glfwGetTime();
 
-		// Handle event polling
-		handleEventPolling(shaderManager, currentTime);
+		// Check for external file changes
+		gFileExplorer.checkForExternalFileChanges();
 
 		// Handle window management
 		handleWindowManagement(window);
@@ -143,12 +153,28 @@ void App::runMainLoop(ShaderManager &shaderManager,
 		// Handle scroll accumulators
 		handleScrollAccumulators(this->scrollXAccumulator, this->scrollYAccumulator);
 
-		// Check for activity and decide if we should keep rendering
+		// Input queued by the event wait counts as damage
 		render.checkForActivity();
-		bool shouldKeepRendering = (currentTime - render.lastActivityTime()) < 0.5 ||
-								   gEditorScroll.isScrollAnimationActive();
 
-		// Always render a frame after polling events
+		// Settings/file tree checks run on their own intervals whether or not
+		// anything gets drawn this iteration
+		render.handleBackgroundUpdates(currentTime);
+
+		// Woke up only for a periodic check and nothing changed on screen
+		if (!gRedraw.hasPendingFrame(currentTime))
+		{
+			continue;
+		}
+		gRedraw.beginFrame(currentTime);
+
+		// Only the CRT noise is due: skip ImGui and re-run the effect passes
+		if (!gRedraw.isFrameDamaged() && shaderManager.isShaderEnabled() &&
+			fb.initialized)
+		{
+			render.renderEffectsOnly(window, shaderManager, fb, accum, quad, settings);
+			continue;
+		}
+
 		auto frame_start = std::chrono::high_resolution_clock::now();
 
 		// Handle frame setup using Render class
@@ -178,20 +204,31 @@ void App::runMainLoop(ShaderManager &shaderManager,
 							 windowResize,
 							 currentTime);
 
+		// Time to first frame; NED_STARTUP_TRACE=exit quits right after it
+		if (!firstFrameDrawn)
+		{
+			firstFrameDrawn = true;
+			if (gStartupTrace.markFirstFrame())
+			{
+				glfwSetWindowShouldClose(window, GLFW_TRUE);
+			}
+		}
+
 		// Handle font reloading using Font class
 		handleFontReload(needFontReload);
 
 		// Handle frame updates for font reloading
 		if (needFontReload)
 		{
-			render.setNeedsRedraw(true);
-			render.setFramesToRender(std::max(render.framesToRender(), 3));
+			gRedraw.request(3);
 		}
 
 		// Handle frame timing using Render class
 		render.handleFrameTiming(
 			frame_start, shaderManager.isShaderEnabled(), this->windowFocused, settings);
 	}
+
+	gRedraw.setWakeEnabled(false);
 }
 
 // Graphics manager methods
@@ -267,67 +304,25 @@ bool App::isWindowFocused() const
 	return window ? glfwGetWindowAttrib(window, GLFW_FOCUSED) != 0 : false;
 }
 
-void App::pollEvents(double currentTime, bool shaderEnabled, double lastActivityTime)
-{
-#ifdef PLATFORM_WINDOWS
-	// On Windows, always use non-blocking polling for consistent frame timing
-	glfwPollEvents();
-#else
-	// On macOS/Linux, use timeout-based polling for power efficiency
-	double timeout = calculateEventTimeout(currentTime, shaderEnabled, lastActivityTime);
-	glfwWaitEventsTimeout(timeout);
-#endif
-}
-
-double App::calculateEventTimeout(double currentTime,
-								  bool shaderEnabled,
-								  double lastActivityTime)
+void App::pollEvents(double currentTime)
 {
-#ifdef PLATFORM_WINDOWS
-	// On Windows, always use consistent FPS-based timeout
-	float fpsTarget = 60.0f;
-	extern Settings gSettings;
-	if (gSettings.getSettings().contains("fps_target") &&
-		gSettings.getSettings()["fps_target"].is_number())
+	// Pending damage: just drain the queue and go draw the next frame
+	if (gRedraw.hasPendingFrame(currentTime))
 	{
-		fpsTarget = gSettings.getSettings()["fps_target"].get<float>();
+		glfwPollEvents();
+		return;
 	}
-	return 1.0 / fpsTarget; // Convert FPS to timeout
-#else
-	// On macOS/Linux, keep the variable timeout logic for smooth user interaction
-	// Check if scroll animation is active - if so, use shorter timeout for responsiveness
-	extern EditorScroll gEditorScroll;
-	bool scrollAnimationActive = gEditorScroll.isScrollAnimationActive();
-
-	// When shaders are enabled, use settings FPS target for timeout
-	// When shaders are disabled, use normal timeout logic
-	if (shaderEnabled)
+
+	// Nothing to draw: sleep in the OS until input, a posted redraw request from a
+	// background thread, or the next scheduled animation/background check.
+	double timeout = gRedraw.waitTimeout(currentTime, Redraw::IDLE_WAKE_INTERVAL);
+	if (timeout > 0.0)
 	{
-		// Use settings FPS target when shaders are enabled
-		float fpsTarget = 60.0f;
-		extern Settings gSettings;
-		if (gSettings.getSettings().contains("fps_target") &&
-			gSettings.getSettings()["fps_target"].is_number())
-		{
-			fpsTarget = gSettings.getSettings()["fps_target"].get<float>();
-		}
-		return 1.0 / fpsTarget; // Convert FPS to timeout
+		glfwWaitEventsTimeout(timeout);
 	} else
 	{
-		// Use shorter timeout if we recently had activity (for smoother
-		// interaction) Also respect minimum FPS: 25 FPS normally
-		double minFPS = 25.0;
-		double maxTimeout = 1.0 / minFPS; // Convert FPS to timeout
-
-		// When scroll animation is active, use much shorter timeout for responsiveness
-		if (scrollAnimationActive)
-		{
-			return 0.001; // 1ms timeout for very responsive scrolling
-		}
-
-		return (currentTime - lastActivityTime) < 0.5 ? 0.016 : maxTimeout;
+		glfwPollEvents();
 	}
-#endif
 }
 
 // Window management methods
@@ -529,7 +524,9 @@ bool App::initializeGLEW()
 #else
 	glfwSwapInterval(0);
 #endif
-	glfwSetWindowRefreshCallback(window, [](GLFWwindow *window) { glfwPostEmptyEvent(); });
+	glfwSetWindowRefreshCallback(window, [](GLFWwindow *window) { gRedraw.request(); });
+	glfwSetFramebufferSizeCallback(
+		window, [](GLFWwindow *window, int width, int height) { gRedraw.request(); });
 
 	// Enable raw mouse motion for more accurate tracking
 	glfwSetInputMode(window, GLFW_RAW_MOUSE_MOTION, GLFW_TRUE);
@@ -557,9 +554,7 @@ void App::initializeOpenGLState()
 void App::handleEventPolling(ShaderManager &shaderManager, double currentTime)
 {
 	// Handle event polling using this class
-	pollEvents(currentTime,
-			   shaderManager.isShaderEnabled(),
-			   0.0); // We'll get activity time from render object
+	pollEvents(currentTime);
 }
 
 void App::handleWindowManagement(GLFWwindow *window)
@@ -65,10 +65,7 @@ class App
 	bool shouldWindowClose() const;
 	void getFramebufferSize(int *width, int *height);
 	bool isWindowFocused() const;
-	void pollEvents(double currentTime, bool shaderEnabled, double lastActivityTime);
-	double calculateEventTimeout(double currentTime,
-								 bool shaderEnabled,
-								 double lastActivityTime);
+	void pollEvents(double currentTime);
 
 	// Window management methods
 	void initializeWindowManagement(GLFWwindow *window);
@@ -8,6 +8,8 @@
 #include "../editor/editor_bookmarks.h"
 #include "../editor/editor_line_jump.h"
 #include "../files/file_finder.h"
+#include "../files/symbol_search.h"
+#include "../files/workspace_search.h"
 #include "settings.h"
 
 void ClosePopper::closeAllExcept(Type keepOpen)
@@ -21,6 +23,8 @@ void ClosePopper::closeAllExcept(Type keepOpen)
 		gBookmarks.showBookmarksWindow = false;
 		gLineJump.showLineJumpWindow = false;
 		gFileFinder.showFFWindow = false;
+		gWorkspaceSearch.showWindow = false;
+		gSymbolSearch.showWindow = false;
 		break;
 
 	case Type::Bookmarks:
@@ -31,6 +35,8 @@ void ClosePopper::closeAllExcept(Type keepOpen)
 		}
 		gLineJump.showLineJumpWindow = false;
 		gFileFinder.showFFWindow = false;
+		gWorkspaceSearch.showWindow = false;
+		gSymbolSearch.showWindow = false;
 		break;
 
 	case Type::LineJump:
@@ -41,6 +47,8 @@ void ClosePopper::closeAllExcept(Type keepOpen)
 		}
 		gBookmarks.showBookmarksWindow = false;
 		gFileFinder.showFFWindow = false;
+		gWorkspaceSearch.showWindow = false;
+		gSymbolSearch.showWindow = false;
 		break;
 
 	case Type::FileFinder:
@@ -51,6 +59,32 @@ void ClosePopper::closeAllExcept(Type keepOpen)
 		}
 		gBookmarks.showBookmarksWindow = false;
 		gLineJump.showLineJumpWindow = false;
+		gWorkspaceSearch.showWindow = false;
+		gSymbolSearch.showWindow = false;
+		break;
+
+	case Type::WorkspaceSearch:
+		// Only close settings window if not in embedded mode
+		if (!isEmbedded)
+		{
+			gSettings.showSettingsWindow = false;
+		}
+		gBookmarks.showBookmarksWindow = false;
+		gLineJump.showLineJumpWindow = false;
+		gFileFinder.showFFWindow = false;
+		gSymbolSearch.showWindow = false;
+		break;
+
+	case Type::SymbolSearch:
+		// Only close settings window if not in embedded mode
+		if (!isEmbedded)
+		{
+			gSettings.showSettingsWindow = false;
+		}
+		gBookmarks.showBookmarksWindow = false;
+		gLineJump.showLineJumpWindow = false;
+		gFileFinder.showFFWindow = false;
+		gWorkspaceSearch.showWindow = false;
 		break;
 	}
 }
@@ -68,4 +102,6 @@ void ClosePopper::closeAll()
 	gBookmarks.showBookmarksWindow = false;
 	gLineJump.showLineJumpWindow = false;
 	gFileFinder.showFFWindow = false;
+	gWorkspaceSearch.showWindow = false;
+	gSymbolSearch.showWindow = false;
 }
@@ -3,7 +3,14 @@
 #pragma once
 
 namespace ClosePopper {
-enum class Type { Settings, Bookmarks, LineJump, FileFinder };
+enum class Type {
+	Settings,
+	Bookmarks,
+	LineJump,
+	FileFinder,
+	WorkspaceSearch,
+	SymbolSearch
+};
 
 void closeAllExcept(Type keepOpen);
 void closeAll();
@@ -6,7 +6,9 @@ Consolidated from ned.cpp and initialization_manager.cpp
 
 #include "init.h"
 #include "editor/editor_highlight.h"
+#include "editor/editor_tree_sitter.h"
 #include "files/files.h"
+#include "files/recovery_journal.h"
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
 #include "shaders/shader_types.h"
@@ -16,6 +18,7 @@ Consolidated from ned.cpp and initialization_manager.cpp
 #include "util/keybinds.h"
 #include "util/settings.h"
 #include "util/splitter.h"
+#include "util/startup_trace.h"
 // Window manager functionality merged into GraphicsManager
 #include <imgui.h>
 
@@ -30,6 +33,31 @@ extern Font gFont;
 extern EditorHighlight gEditorHighlight;
 extern FileExplorer gFileExplorer;
 
+std::future<void> Init::settingsTask;
+std::future<void> Init::iconsTask;
+std::future<void> Init::queriesTask;
+std::future<void> Init::recoveryTask;
+
+std::future<void> Init::runInBackground(const char *phase, std::function<void()> task)
+{
+	return std::async(std::launch::async, [phase, task = std::move(task)]() {
+		StartupTrace::Phase trace(phase);
+		task();
+	});
+}
+
+void Init::finishBackgroundTasks()
+{
+	for (std::future<void> *task :
+		 {&settingsTask, &iconsTask, &queriesTask, &recoveryTask})
+	{
+		if (task->valid())
+		{
+			task->get();
+		}
+	}
+}
+
 void Init::setupSignalHandlers()
 {
 	// Set up signal handlers to catch crashes and prevent crash reports
@@ -66,6 +94,7 @@ void Init::initializeSettings()
 
 void Init::initializeUISettings()
 {
+	StartupTrace::Phase phase("UI settings");
 	// Load UI settings
 	Splitter::loadSidebarSettings();
 	Splitter::loadAgentPaneSettings();
@@ -99,21 +128,33 @@ bool Init::initializeGraphics(GLFWwindow *window)
 
 void Init::initializeResources()
 {
-	gDebugConsole.toggleVisibility();
-	gEditorHighlight.setTheme(gSettings.getCurrentTheme());
+	{
+		StartupTrace::Phase phase("theme + style");
+		gDebugConsole.toggleVisibility();
+		gEditorHighlight.setTheme(gSettings.getCurrentTheme());
 
-	// Apply settings with the actual loaded font size
-	gSettings.ApplySettings(ImGui::GetStyle());
+		// Apply settings with the actual loaded font size
+		gSettings.ApplySettings(ImGui::GetStyle());
+	}
 
-	// Initialize fonts using the Font class
-	gFont.initialize();
+	{
+		// Initialize fonts using the Font class
+		StartupTrace::Phase phase("fonts");
+		gFont.initialize();
+	}
 
-	// Continue with remaining initialization
+	// Continue with remaining initialization; the icon cache may still be loading
+	StartupTrace::Phase phase("icons");
+	if (iconsTask.valid())
+	{
+		iconsTask.get();
+	}
 	gFileExplorer.loadIcons();
 }
 
 void Init::initializeImGui(GLFWwindow *window)
 {
+	StartupTrace::Phase phase("ImGui");
 	IMGUI_CHECKVERSION();
 	ImGui::CreateContext();
 	ImGuiIO &io = ImGui::GetIO();
@@ -189,8 +230,15 @@ void Init::initializeAll(GLFWwindow *window)
 	// Set up signal handlers for crash detection
 	setupSignalHandlers();
 
-	// Initialize settings and configuration
-	initializeSettings();
+	// Initialize settings and configuration, unless already loading in the background
+	if (settingsTask.valid())
+	{
+		StartupTrace::Phase phase("settings wait");
+		settingsTask.get();
+	} else
+	{
+		initializeSettings();
+	}
 
 	// Load UI settings
 	initializeUISettings();
@@ -212,12 +260,30 @@ bool Init::initializeAllComponents(App &app,
 								   FramebufferState &fb,
 								   AccumulationBuffers &accum)
 {
+	// JSON parsing and query compilation overlap the window, GL and shader setup.
+	// Queries are only needed once a file is open, so nothing waits for them.
+	settingsTask = runInBackground("settings + keybinds", initializeSettings);
+	queriesTask = runInBackground("tree-sitter queries", TreeSitter::precompileQueries);
+
 	// Initialize graphics system
 	if (!initializeGraphicsSystem(app, shaderManager))
 	{
+		finishBackgroundTasks();
 		return false;
 	}
 
+	// The icon cache is read while ImGui and the fonts are set up
+	float scale = 1.0f;
+	float yScale = 1.0f;
+	glfwGetWindowContentScale(app.getWindow(), &scale, &yScale);
+	iconsTask = runInBackground("icon cache",
+								[scale]() { gFileExplorer.prepareIcons(scale); });
+
+	// Journals of sessions that crashed are replayed off the main thread too
+	gRecoveryJournal.open();
+	recoveryTask = runInBackground("crash recovery",
+								   []() { gRecoveryJournal.findAbandoned(); });
+
 	// Initialize window management in app
 	app.initializeWindowManagement(app.getWindow());
 
@@ -262,6 +328,7 @@ bool Init::initializeComponents(App &app)
 bool Init::initializeQuad(ShaderQuad &quad)
 {
 	// Initialize quad
+	StartupTrace::Phase phase("quad");
 	quad.initialize();
 	return true;
 }
\ No newline at end of file
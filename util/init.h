@@ -9,6 +9,8 @@ Consolidated from ned.cpp and initialization_manager.cpp
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <csignal>
+#include <functional>
+#include <future>
 #include <iostream>
 
 // Forward declarations
@@ -60,7 +62,19 @@ class Init
 										FramebufferState &fb,
 										AccumulationBuffers &accum);
 
+	// Waits for startup work still running in the background. Call before exit.
+	static void finishBackgroundTasks();
+
   private:
+	// Startup work that needs no GL context runs on worker threads while the
+	// main thread creates the window, compiles shaders and builds the fonts
+	static std::future<void> runInBackground(const char *phase,
+											 std::function<void()> task);
+	static std::future<void> settingsTask;
+	static std::future<void> iconsTask;
+	static std::future<void> queriesTask;
+	static std::future<void> recoveryTask;
+
 	// Helper initialization methods
 	static bool initializeGraphicsSystem(App &app, ShaderManager &shaderManager);
 	// Window manager functionality is now part of App
@@ -0,0 +1,133 @@
+/*
+File: redraw.cpp
+Description: Damage tracking for the main loop.
+*/
+
+#include "redraw.h"
+
+#include <GLFW/glfw3.h>
+#include <algorithm>
+
+Redraw gRedraw;
+
+double Redraw::now() { return glfwGetTime(); }
+
+void Redraw::wake()
+{
+	if (wakeEnabled.load(std::memory_order_relaxed))
+	{
+		glfwPostEmptyEvent();
+	}
+}
+
+void Redraw::request(int frames)
+{
+	int current = pendingFrames.load(std::memory_order_relaxed);
+	while (current < frames && !pendingFrames.compare_exchange_weak(
+								   current, frames, std::memory_order_relaxed))
+	{
+	}
+
+	// A loop with frames already pending never blocks, so only the transition
+	// from idle needs to wake it.
+	if (current == 0)
+	{
+		wake();
+	}
+}
+
+void Redraw::requestAt(double time)
+{
+	double current = nextWakeTime.load(std::memory_order_relaxed);
+	while ((current < 0.0 || time < current) &&
+		   !nextWakeTime.compare_exchange_weak(current, time, std::memory_order_relaxed))
+	{
+	}
+
+	// An earlier deadline shortens the timeout the loop is currently blocked on
+	if (current < 0.0 || time < current)
+	{
+		wake();
+	}
+}
+
+void Redraw::requestEffectsAt(double time)
+{
+	double current = effectsWakeTime.load(std::memory_order_relaxed);
+	while ((current < 0.0 || time < current) &&
+		   !effectsWakeTime.compare_exchange_weak(
+			   current, time, std::memory_order_relaxed))
+	{
+	}
+}
+
+void Redraw::noteInput(double now)
+{
+	lastInputTime.store(now, std::memory_order_relaxed);
+	request();
+}
+
+double Redraw::secondsSinceInput(double now) const
+{
+	return now - lastInputTime.load(std::memory_order_relaxed);
+}
+
+bool Redraw::hasPendingFrame(double now) const
+{
+	if (pendingFrames.load(std::memory_order_relaxed) > 0)
+	{
+		return true;
+	}
+	double wakeTime = nextWakeTime.load(std::memory_order_relaxed);
+	if (wakeTime >= 0.0 && wakeTime <= now)
+	{
+		return true;
+	}
+	double effectsTime = effectsWakeTime.load(std::memory_order_relaxed);
+	if (effectsTime >= 0.0 && effectsTime <= now)
+	{
+		return true;
+	}
+	return secondsSinceInput(now) < INPUT_SETTLE_SECONDS;
+}
+
+void Redraw::beginFrame(double now)
+{
+	int current = pendingFrames.load(std::memory_order_relaxed);
+	while (current > 0 && !pendingFrames.compare_exchange_weak(
+							  current, current - 1, std::memory_order_relaxed))
+	{
+	}
+	frameDamaged = current > 0 || secondsSinceInput(now) < INPUT_SETTLE_SECONDS;
+
+	double wakeTime = nextWakeTime.load(std::memory_order_relaxed);
+	if (wakeTime >= 0.0 && wakeTime <= now)
+	{
+		// Animations re-arm their deadline while rendering this frame
+		nextWakeTime.compare_exchange_strong(wakeTime, -1.0, std::memory_order_relaxed);
+		frameDamaged = true;
+	}
+
+	double effectsTime = effectsWakeTime.load(std::memory_order_relaxed);
+	if (effectsTime >= 0.0 && effectsTime <= now)
+	{
+		effectsWakeTime.compare_exchange_strong(
+			effectsTime, -1.0, std::memory_order_relaxed);
+	}
+}
+
+double Redraw::waitTimeout(double now, double maxTimeout) const
+{
+	double timeout = maxTimeout;
+	double wakeTime = nextWakeTime.load(std::memory_order_relaxed);
+	if (wakeTime >= 0.0)
+	{
+		timeout = std::min(timeout, wakeTime - now);
+	}
+	double effectsTime = effectsWakeTime.load(std::memory_order_relaxed);
+	if (effectsTime >= 0.0)
+	{
+		timeout = std::min(timeout, effectsTime - now);
+	}
+	return std::max(timeout, 0.0);
+}
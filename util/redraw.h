@@ -0,0 +1,68 @@
+/*
+File: redraw.h
+Description: Damage tracking for the main loop. Anything that changes what is on
+screen (input, terminal output, finished highlights, LSP responses, git updates,
+animations) posts a redraw request. When nothing is pending the loop blocks in
+glfwWaitEvents instead of rendering frames nobody will look at.
+*/
+
+#pragma once
+
+#include <atomic>
+
+class Redraw
+{
+  public:
+	// Request at least `frames` more frames. Safe to call from any thread; wakes
+	// the main loop if it is blocked waiting for events.
+	void request(int frames = 2);
+
+	// Schedule a frame no later than `time` (glfwGetTime() clock). Used by timed
+	// animations that only need a handful of updates per second.
+	void requestAt(double time);
+	void requestIn(double seconds) { requestAt(now() + seconds); }
+
+	// Schedule a frame for the shader effects alone (noise, pulse, burn-in decay).
+	// Such a frame changes nothing in the UI, so the loop can skip the UI pass.
+	void requestEffectsAt(double time);
+
+	// Record user input. Frames keep flowing for a short settle period so ImGui
+	// hover/active state and key repeat behave exactly as with continuous rendering.
+	void noteInput(double now);
+	double secondsSinceInput(double now) const;
+	double secondsSinceInput() const { return secondsSinceInput(now()); }
+
+	// Main loop side
+	bool hasPendingFrame(double now) const;
+	void beginFrame(double now);
+	double waitTimeout(double now, double maxTimeout) const;
+	// False when the frame begun last was only due for the shader effects
+	bool isFrameDamaged() const { return frameDamaged; }
+
+	// Only the standalone app owns the event loop; the embedded build leaves
+	// waking the host's loop disabled.
+	void setWakeEnabled(bool enabled) { wakeEnabled = enabled; }
+
+	// How long after input we keep rendering every frame
+	static constexpr double INPUT_SETTLE_SECONDS = 0.5;
+	// Upper bound on a blocking wait so periodic background checks still run
+	static constexpr double IDLE_WAKE_INTERVAL = 0.5;
+	// Animations pace themselves at this rate instead of the fps target
+	static constexpr double ANIMATION_INTERVAL = 1.0 / 30.0;
+	// Cursor blink and similar idle animations stop after this much inactivity
+	static constexpr double IDLE_ANIMATION_SECONDS = 10.0;
+
+	static double now();
+
+  private:
+	void wake();
+
+	std::atomic<int> pendingFrames{3}; // First frames are always drawn
+	std::atomic<double> nextWakeTime{-1.0};
+	std::atomic<double> effectsWakeTime{-1.0};
+	bool frameDamaged = true; // Main thread only
+	std::atomic<double> lastInputTime{0.0};
+	std::atomic<bool> wakeEnabled{false};
+};
+
+extern Redraw gRedraw;
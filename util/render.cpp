@@ -15,14 +15,18 @@ Description: Render and frame management class implementation for NED text edito
 #include "editor/editor_scroll.h"
 #include "files/file_tree.h"
 #include "files/files.h"
+#include "files/recovery_journal.h"
+#include "files/symbol_index.h"
 #include "lsp/lsp_dashboard.h"
 #include "util/app.h"
 #include "util/keybinds.h"
+#include "util/redraw.h"
 #include "util/settings.h"
 #include "util/splitter.h"
 #include "util/terminal.h"
 #include "util/welcome.h"
 #include <GLFW/glfw3.h>
+#include <algorithm>
 #include <iostream>
 #include <thread>
 
@@ -36,8 +40,7 @@ extern Settings gSettings;
 constexpr float kAgentSplitterWidth = 6.0f;
 
 Render::Render()
-	: lastTime(0.0), frames(0), currentFPS(0.0), m_needsRedraw(true), m_framesToRender(0),
-	  m_lastActivityTime(0.0)
+	: lastTime(0.0), frames(0), currentFPS(0.0), m_needsRedraw(false), m_framesToRender(0)
 {
 }
 
@@ -74,88 +77,63 @@ void Render::handleFrameTiming(std::chrono::high_resolution_clock::time_point fr
 							   bool windowFocused,
 							   Settings &settings)
 {
-	auto frame_end = std::chrono::high_resolution_clock::now();
-	auto frame_duration = frame_end - frame_start;
+	// With nothing pending the loop is about to block in glfwWaitEvents, so there
+	// is no frame to pace. Timed animations pace themselves via gRedraw.requestAt.
+	double now = glfwGetTime();
+	if (!gRedraw.hasPendingFrame(now))
+	{
+		return;
+	}
 
-	float fpsTarget = DEFAULT_FPS_TARGET;
+	float fpsTarget = windowFocused ? getFpsTarget(settings) : UNFOCUSED_FPS_TARGET;
 
-#ifdef PLATFORM_WINDOWS
-	// On Windows, use simple fixed frame timing - just sleep for the target frame time
-	if (settings.getSettings().contains("fps_target") &&
-		settings.getSettings()["fps_target"].is_number())
+	// Scroll animation and continuous shader effects run at the configured target
+	// even when unfocused
+	extern EditorScroll gEditorScroll;
+	if (shaderEnabled || gEditorScroll.isScrollAnimationActive())
 	{
-		fpsTarget = settings.getSettings()["fps_target"].get<float>();
+		fpsTarget = getFpsTarget(settings);
 	}
 
-	// Simple busy waiting - the only thing that works reliably on Windows
-	if (fpsTarget > MIN_FPS_TARGET && fpsTarget < MAX_FPS_TARGET)
+	// Only apply frame timing if FPS target is reasonable (not unlimited)
+	if (fpsTarget <= MIN_FPS_TARGET || fpsTarget >= MAX_FPS_TARGET)
 	{
-		auto targetFrameTime = std::chrono::duration<double>(1.0 / fpsTarget);
-		auto frame_duration_seconds = std::chrono::duration<double>(frame_duration);
-
-		if (frame_duration_seconds < targetFrameTime)
-		{
-			auto endTime =
-				frame_start +
-				std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(
-					targetFrameTime);
-			while (std::chrono::high_resolution_clock::now() < endTime)
-			{
-				// Busy wait for precise timing
-			}
-		}
+		return;
 	}
-#else
-	// On macOS/Linux, keep the variable FPS logic for smooth user interaction
-	// Check if scroll animation is active - if so, bypass FPS restrictions like mouse wheel
-	extern EditorScroll gEditorScroll;
-	bool scrollAnimationActive = gEditorScroll.isScrollAnimationActive();
 
-	if (shaderEnabled)
+	auto targetFrameTime = std::chrono::duration<double>(1.0 / fpsTarget);
+	auto frame_end = std::chrono::high_resolution_clock::now();
+	auto frame_duration = frame_end - frame_start;
+	if (frame_duration >= targetFrameTime)
 	{
-		// When shaders are enabled, use settings FPS target but don't sleep
-		if (settings.getSettings().contains("fps_target") &&
-			settings.getSettings()["fps_target"].is_number())
-		{
-			fpsTarget = settings.getSettings()["fps_target"].get<float>();
-		}
-		// Don't apply sleep delays when shaders are enabled - let GPU run naturally
 		return;
-	} else
-	{
-		// Only apply frame timing when shaders are disabled
-		if (!windowFocused)
-		{
-			fpsTarget = UNFOCUSED_FPS_TARGET;
-		} else if (settings.getSettings().contains("fps_target") &&
-				   settings.getSettings()["fps_target"].is_number())
-		{
-			fpsTarget = settings.getSettings()["fps_target"].get<float>();
-		}
-
-		// When scroll animation is active, set FPS target to settings value
-		if (scrollAnimationActive)
-		{
-			if (settings.getSettings().contains("fps_target") &&
-				settings.getSettings()["fps_target"].is_number())
-			{
-				fpsTarget = settings.getSettings()["fps_target"].get<float>();
-			}
-		}
 	}
 
-	// Only apply frame timing if FPS target is reasonable (not unlimited)
-	if (fpsTarget > MIN_FPS_TARGET && fpsTarget < MAX_FPS_TARGET)
+	auto endTime = frame_start +
+				   std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(
+					   targetFrameTime);
+#ifdef PLATFORM_WINDOWS
+	// Windows sleeps have coarse granularity; sleep most of the way and yield
+	// through the remainder instead of spinning for the whole frame.
+	auto sleepUntil = endTime - std::chrono::milliseconds(2);
+	if (std::chrono::high_resolution_clock::now() < sleepUntil)
 	{
-		auto targetFrameTime = std::chrono::duration<double>(1.0 / fpsTarget);
-		if (frame_duration < targetFrameTime)
-		{
-			std::this_thread::sleep_for(targetFrameTime - frame_duration);
-		}
+		std::this_thread::sleep_until(sleepUntil);
+	}
+	while (std::chrono::high_resolution_clock::now() < endTime)
+	{
+		std::this_thread::yield();
 	}
+#else
+	std::this_thread::sleep_until(endTime);
 #endif
 }
 
+float Render::getFpsTarget(Settings &settings) const
+{
+	return settings.getSnapshot()->fpsTarget;
+}
+
 void Render::checkForActivity()
 {
 	// This function will be called every loop to check for immediate input.
@@ -193,6 +171,13 @@ void Render::checkForActivity()
 		hasInput = true;
 	}
 
+	// Events delivered by the last glfwWaitEvents/glfwPollEvents that ImGui has
+	// queued but not yet processed
+	if (ImGui::GetCurrentContext()->InputEventsQueue.Size > 0)
+	{
+		hasInput = true;
+	}
+
 	// Check for active scroll animation (treat as input activity for smooth rendering)
 	extern EditorScroll gEditorScroll;
 	if (gEditorScroll.isScrollAnimationActive())
@@ -200,10 +185,10 @@ void Render::checkForActivity()
 		hasInput = true;
 	}
 
-	// If we have any input, update activity time
+	// If we have any input, keep frames flowing for the settle period
 	if (hasInput)
 	{
-		setLastActivityTime(glfwGetTime());
+		gRedraw.noteInput(glfwGetTime());
 	}
 }
 
@@ -226,22 +211,10 @@ void Render::handleBackgroundUpdates(double currentTime)
 			gSettings.hasFontSizeChanged() != hadFontSizeChanged ||
 			gSettings.hasThemeChanged() != hadThemeChanged)
 		{
-			setNeedsRedraw(true);
-			setFramesToRender(std::max(framesToRender(), 2)); // Reduced frame count
+			gRedraw.request(2);
 		}
 		timing.lastSettingsCheck = currentTime;
 	}
-
-	if (currentTime - timing.lastFileTreeRefresh >= FILE_TREE_REFRESH_INTERVAL)
-	{
-		// File tree refresh doesn't return a value, but we can trigger redraw
-		// when it's called since it updates the UI
-		extern FileTree gFileTree;
-		gFileTree.refreshFileTree();
-		setNeedsRedraw(true); // Always redraw after file tree refresh
-		setFramesToRender(std::max(framesToRender(), 2)); // Reduced frame count
-		timing.lastFileTreeRefresh = currentTime;
-	}
 }
 
 void Render::handleFrameSetup(double currentTime,
@@ -254,9 +227,6 @@ void Render::handleFrameSetup(double currentTime,
 							  bool &windowFocused,
 							  App &app)
 {
-	// Handle background updates
-	handleBackgroundUpdates(currentTime);
-
 	// Handle settings changes
 	extern Settings gSettings;
 	gSettings.handleSettingsChanges(needFontReload,
@@ -265,6 +235,13 @@ void Render::handleFrameSetup(double currentTime,
 									setShaderEnabled,
 									lastOpacity,
 									lastBlurEnabled);
+	if (m_needsRedraw)
+	{
+		gRedraw.request(m_framesToRender);
+		m_needsRedraw = false;
+		m_framesToRender = 0;
+	}
+	gSymbolIndex.followSetting(gFileExplorer.selectedFolder);
 
 	// Setup ImGui frame
 	setupImGuiFrame();
@@ -275,15 +252,14 @@ void Render::handleFrameSetup(double currentTime,
 	// Handle file dialog
 	if (gFileExplorer.handleFileDialog())
 	{
-		setNeedsRedraw(true);
-		setFramesToRender(std::max(framesToRender(), 3));
+		gRedraw.request(3);
 	}
 }
 
 void Render::renderFPSCounter(Settings &settings)
 {
 	// Check if FPS counter is enabled in settings
-	if (!settings.getSettings()["fps_toggle"].get<bool>())
+	if (!settings.getSnapshot()->fpsToggle)
 	{
 		return;
 	}
@@ -331,11 +307,11 @@ void Render::setupFrame(Settings &settings,
 	glViewport(0, 0, display_w, display_h);
 
 	// Get background color from settings
-	auto &bg = settings.getSettings()["backgroundColor"];
+	const ImVec4 bg = settings.getSnapshot()->backgroundColor;
 
 	// Use different alpha based on shader state
-	float alpha = shaderEnabled ? bg[3].get<float>() : 1.0f;
-	glClearColor(bg[0], bg[1], bg[2], alpha);
+	float alpha = shaderEnabled ? bg.w : 1.0f;
+	glClearColor(bg.x, bg.y, bg.z, alpha);
 	glClear(GL_COLOR_BUFFER_BIT);
 
 	// Render FPS counter overlay
@@ -381,6 +357,7 @@ void Render::renderFrame(GLFWwindow *window,
 	gBookmarks.renderBookmarksWindow();
 	gSettings.renderSettingsWindow();
 	gLSPDashboard.render();
+	gRecoveryJournal.renderPrompt();
 	gSettings.renderNotification("");
 	gKeybinds.checkKeybindsFile();
 	windowResize.renderResizeOverlay(gFont.largeFont);
@@ -391,6 +368,44 @@ void Render::renderFrame(GLFWwindow *window,
 	shaderManager.renderWithEffects(
 		display_w, display_h, glfwGetTime(), fb, accum, quad, gSettings);
 	glfwSwapBuffers(window);
+
+	scheduleEffectsFrame(shaderManager, gSettings);
+}
+
+void Render::renderEffectsOnly(GLFWwindow *window,
+							   ShaderManager &shaderManager,
+							   FramebufferState &fb,
+							   AccumulationBuffers &accum,
+							   ShaderQuad &quad,
+							   Settings &gSettings)
+{
+	// The UI from the last full frame is still in fb; only the effect passes
+	// need to run again
+	int display_w, display_h;
+	glfwGetFramebufferSize(window, &display_w, &display_h);
+	glViewport(0, 0, display_w, display_h);
+
+	shaderManager.renderWithEffects(
+		display_w, display_h, glfwGetTime(), fb, accum, quad, gSettings);
+	glfwSwapBuffers(window);
+
+	scheduleEffectsFrame(shaderManager, gSettings);
+}
+
+void Render::scheduleEffectsFrame(ShaderManager &shaderManager, Settings &gSettings)
+{
+	// CRT effects animate on their own (static, jitter, pulse, burn-in decay).
+	// They refresh at their own, lower rate; these frames skip the UI pass.
+	if (!shaderManager.isShaderEnabled())
+	{
+		return;
+	}
+	float effectsFps =
+		std::min(gSettings.getSnapshot()->shaderEffectsFps, getFpsTarget(gSettings));
+	if (effectsFps > MIN_FPS_TARGET)
+	{
+		gRedraw.requestEffectsAt(glfwGetTime() + 1.0 / effectsFps);
+	}
 }
 
 void Render::renderMainWindow(GLFWwindow *window,
@@ -403,8 +418,7 @@ void Render::renderMainWindow(GLFWwindow *window,
 
 	if (gKeybinds.handleKeyboardShortcuts())
 	{
-		setNeedsRedraw(true);
-		setFramesToRender(std::max(framesToRender(), 12));
+		gRedraw.request(12);
 	}
 
 	if (gTerminal.isTerminalVisible())
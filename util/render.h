@@ -32,7 +32,6 @@ struct TimingState
 	int frameCount = 0;
 	double lastFPSTime = 0.0;
 	double lastSettingsCheck = 0.0;
-	double lastFileTreeRefresh = 0.0;
 };
 
 // Render class for handling UI rendering logic and frame management
@@ -59,6 +58,14 @@ class Render
 					 WindowResize &windowResize,
 					 double currentTime);
 
+	// Re-run only the shader passes over the last UI frame
+	void renderEffectsOnly(GLFWwindow *window,
+						   ShaderManager &shaderManager,
+						   FramebufferState &fb,
+						   AccumulationBuffers &accum,
+						   ShaderQuad &quad,
+						   Settings &gSettings);
+
 	void
 	renderMainWindow(GLFWwindow *window, Splitter &splitter, WindowResize &windowResize);
 
@@ -68,6 +75,7 @@ class Render
 						   bool shaderEnabled,
 						   bool windowFocused,
 						   Settings &settings);
+	float getFpsTarget(Settings &settings) const;
 	void setupImGuiFrame();
 	void setupFrame(Settings &settings,
 					bool shaderEnabled,
@@ -92,14 +100,8 @@ class Render
 	// Frame state accessors
 	double getCurrentFPS() const { return currentFPS; }
 	int getFrameCount() const { return frames; }
-	bool needsRedraw() const { return m_needsRedraw; }
-	int framesToRender() const { return m_framesToRender; }
-	double lastActivityTime() const { return m_lastActivityTime; }
 	bool &needsRedrawRef() { return m_needsRedraw; }
 	int &framesToRenderRef() { return m_framesToRender; }
-	void setNeedsRedraw(bool needs) { m_needsRedraw = needs; }
-	void setFramesToRender(int frames) { m_framesToRender = frames; }
-	void setLastActivityTime(double time) { m_lastActivityTime = time; }
 	TimingState &getTiming() { return timing; }
 
 	// Constants
@@ -109,9 +111,10 @@ class Render
 	static constexpr float MIN_FPS_TARGET = 0.0f;
 	static constexpr float MAX_FPS_TARGET = 10000.0f;
 	static constexpr double SETTINGS_CHECK_INTERVAL = 2.0;
-	static constexpr double FILE_TREE_REFRESH_INTERVAL = 2.0;
 
   private:
+	void scheduleEffectsFrame(ShaderManager &shaderManager, Settings &gSettings);
+
 	// Helper functions for render logic
 	void setupFrameRendering(Settings &gSettings,
 							 bool shaderEnabled,
@@ -127,10 +130,9 @@ class Render
 	int frames;
 	double currentFPS;
 
-	// Redraw management variables (merged from Frame)
-	bool m_needsRedraw = true;		 // Start true to draw the first frame
-	int m_framesToRender = 0;		 // Number of frames to render for smooth interactions
-	double m_lastActivityTime = 0.0; // Track when we last had activity
+	// Redraw flags filled in by Settings::handleSettingsChanges, forwarded to gRedraw
+	bool m_needsRedraw = false;
+	int m_framesToRender = 0;
 
 	// Timing state (merged from Frame)
 	TimingState timing;
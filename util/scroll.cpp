@@ -4,6 +4,7 @@ Description: Scroll accumulator handling functions implementation
 */
 
 #include "scroll.h"
+#include "redraw.h"
 #include <imgui.h>
 
 void Scroll::handleScrollAccumulators(double &scrollXAccumulator,
@@ -16,6 +17,8 @@ void Scroll::handleScrollAccumulators(double &scrollXAccumulator,
 		ImGui::GetIO().MouseWheelH += scrollXAccumulator; // Horizontal
 		scrollXAccumulator = 0.0;
 		scrollYAccumulator = 0.0;
+		// The wheel bypasses ImGui's input queue, so report it here
+		gRedraw.noteInput(Redraw::now());
 	}
 }
 
@@ -6,7 +6,9 @@
 #include "../lsp/lsp_dashboard.h"
 #include "../util/font.h"
 #include "../util/keybinds.h"
+#include "../util/redraw.h"
 #include "../util/splitter.h"
+#include "../util/startup_trace.h"
 #include "../util/terminal.h"
 #include "config.h"
 #include "imgui.h"
@@ -48,6 +50,7 @@ Settings::Settings() : splitPos(0.3f)
 {
 	// Initialize with default values that will be overwritten by loadSettings
 	currentFontSize = 0.0f;
+	StartupTrace::Phase phase("settings (static init)");
 	loadSettings(); // Load settings immediately to set proper values
 }
 
@@ -95,12 +98,14 @@ void Settings::loadSettings()
 	themeChanged = false;
 	fontChanged = false;
 	fontSizeChanged = false;
+	rebuildSnapshot();
 	gTerminal.UpdateTerminalColors();
 }
 
 void Settings::saveSettings()
 {
 	settingsFileManager.saveSettings(settings, settingsPath);
+	rebuildSnapshot();
 	gTerminal.UpdateTerminalColors();
 }
 
@@ -115,9 +120,58 @@ void Settings::checkSettingsFile()
 	if (settingsChanged || fontChanged || fontSizeChanged || themeChanged)
 	{
 		profileJustSwitched = true;
+		rebuildSnapshot();
 	}
 }
 
+void Settings::rebuildSnapshot()
+{
+	auto next = std::make_shared<SettingsSnapshot>();
+
+	auto readFloat = [this](const char *key, float &out) {
+		auto it = settings.find(key);
+		if (it != settings.end() && it->is_number())
+		{
+			out = it->get<float>();
+		}
+	};
+	auto readBool = [this](const char *key, bool &out) {
+		auto it = settings.find(key);
+		if (it != settings.end() && it->is_boolean())
+		{
+			out = it->get<bool>();
+		}
+	};
+
+	next->backgroundColor = getCurrentBackgroundColor();
+	next->textColor = getCurrentTextColor();
+
+	readBool("shader_toggle", next->shaderEnabled);
+	readFloat("scanline_intensity", next->scanlineIntensity);
+	readFloat("vignet_intensity", next->vignetIntensity);
+	readFloat("bloom_intensity", next->bloomIntensity);
+	readFloat("static_intensity", next->staticIntensity);
+	readFloat("colorshift_intensity", next->colorshiftIntensity);
+	readFloat("jitter_intensity", next->jitterIntensity);
+	readFloat("curvature_intensity", next->curvatureIntensity);
+	readFloat("pixelation_intensity", next->pixelationIntensity);
+	readFloat("pixel_width", next->pixelWidth);
+	readFloat("burnin_intensity", next->burninIntensity);
+	readFloat("shader_effects_fps", next->shaderEffectsFps);
+
+	readFloat("fps_target", next->fpsTarget);
+	readBool("fps_toggle", next->fpsToggle);
+	readBool("rainbow", next->rainbow);
+	readBool("soft_wrap", next->softWrap);
+	readBool("minimap", next->minimap);
+	readBool("search_index", next->searchIndex);
+	readBool("symbol_index", next->symbolIndex);
+	readFloat("undo_history_mb", next->undoHistoryMb);
+
+	std::lock_guard<std::mutex> lock(snapshotMutex);
+	snapshot = std::move(next);
+}
+
 void Settings::renderSettingsWindow()
 {
 	if (!showSettingsWindow)
@@ -373,11 +427,11 @@ void Settings::renderWindowHeader()
 	}
 	bool isHovered = ImGui::IsItemHovered();
 	ImGui::SetCursorPos(cursor_pos);
-	ImTextureID closeIcon = gFileExplorer.getIcon("close");
-	ImGui::Image(ImTextureRef(closeIcon),
+	IconRef closeIcon = gFileExplorer.getIcon("close");
+	ImGui::Image(ImTextureRef(closeIcon.texture),
 				 ImVec2(closeIconSize, closeIconSize),
-				 ImVec2(0, 0),
-				 ImVec2(1, 1),
+				 closeIcon.uv0,
+				 closeIcon.uv1,
 				 isHovered ? ImVec4(1, 1, 1, 0.6f) : ImVec4(1, 1, 1, 1),
 				 ImVec4(0, 0, 0, 0));
 	ImGui::EndGroup();
@@ -844,6 +898,59 @@ void Settings::renderToggleSettings()
 	ImGui::SameLine();
 	ImGui::TextDisabled("(Highlight changed lines in git)");
 
+	bool softWrap = settings.value("soft_wrap", false);
+	if (ImGui::Checkbox("Soft Wrap", &softWrap))
+	{
+		settings["soft_wrap"] = softWrap;
+		settingsChanged = true;
+		saveSettings();
+	}
+	ImGui::SameLine();
+	ImGui::TextDisabled("(Wrap long lines to the editor width)");
+
+	bool minimap = settings.value("minimap", true);
+	if (ImGui::Checkbox("Minimap", &minimap))
+	{
+		settings["minimap"] = minimap;
+		settingsChanged = true;
+		saveSettings();
+	}
+	ImGui::SameLine();
+	ImGui::TextDisabled("(Code overview next to the editor)");
+
+	bool searchIndex = settings.value("search_index", false);
+	if (ImGui::Checkbox("Search Index", &searchIndex))
+	{
+		settings["search_index"] = searchIndex;
+		settingsChanged = true;
+		saveSettings();
+	}
+	ImGui::SameLine();
+	ImGui::TextDisabled("(Trigram index for search in files)");
+
+	bool symbolIndex = settings.value("symbol_index", false);
+	if (ImGui::Checkbox("Symbol Index", &symbolIndex))
+	{
+		settings["symbol_index"] = symbolIndex;
+		settingsChanged = true;
+		saveSettings();
+	}
+	ImGui::SameLine();
+	ImGui::TextDisabled("(Tree-sitter index for go to symbol)");
+
+	float undoHistoryMb = settings.value("undo_history_mb", 8.0f);
+	if (ImGui::SliderFloat("Undo History", &undoHistoryMb, 1.0f, 64.0f, "%.0f MB"))
+	{
+		settings["undo_history_mb"] = undoHistoryMb;
+		settingsChanged = true;
+	}
+	if (ImGui::IsItemDeactivatedAfterEdit())
+	{
+		saveSettings();
+	}
+	ImGui::SameLine();
+	ImGui::TextDisabled("(Per file, older steps compressed)");
+
 	bool aiAutocomplete = settings.value("ai_autocomplete", true);
 
 	if (ImGui::Checkbox("AI Completion", &aiAutocomplete))
@@ -899,6 +1006,7 @@ void Settings::renderShaderSettings()
 		"Pixel lines", "pixelation_intensity", -1.00f, 1.00f, "%.03f", -0.11f);
 
 	renderShaderSlider("FPS Target", "fps_target", 20.0f, 1000.0f, "%.0f", 120.0f);
+	renderShaderSlider("Effects FPS", "shader_effects_fps", 5.0f, 120.0f, "%.0f", 30.0f);
 	ImGui::SameLine();
 }
 
@@ -1141,6 +1249,10 @@ void Settings::renderNotification(const std::string &message, float duration)
 		if (notificationTimer <= 0.0f)
 		{
 			showNotification = false;
+			gRedraw.request(1); // Clear it off the screen
+		} else
+		{
+			gRedraw.requestIn(notificationTimer);
 		}
 	}
 }
@@ -1287,6 +1399,9 @@ void Settings::handleSettingsChanges(bool &needFontReload,
 			m_framesToRender = std::max(m_framesToRender, 3); // Reduced frame count
 		}
 
+		// Pick up in-memory edits (color pickers, sliders) that were not saved yet
+		rebuildSnapshot();
+
 		ImGuiStyle &style = ImGui::GetStyle();
 
 		ApplySettings(style);
@@ -1358,6 +1473,7 @@ void Settings::switchToProfile(const std::string &profileName)
 	profileJustSwitched = true;
 	settingsChanged = true;
 	fontChanged = true;
+	rebuildSnapshot();
 
 	// Force syntax color update for editor
 	extern class EditorHighlight gEditorHighlight;
@@ -5,6 +5,8 @@
 #include "settings_file_manager.h"
 #include <filesystem>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -14,6 +16,37 @@ class ShaderManager;
 namespace fs = std::filesystem;
 using json = nlohmann::json;
 
+// Typed copy of the settings the render path reads every frame. Rebuilt only when
+// the settings change and swapped in whole, so per-frame code reads plain fields
+// instead of doing json lookups.
+struct SettingsSnapshot
+{
+	ImVec4 backgroundColor{0.058f, 0.194f, 0.158f, 1.0f};
+	ImVec4 textColor{1.0f, 1.0f, 1.0f, 1.0f}; // Current theme's text color
+
+	bool shaderEnabled = true;
+	float scanlineIntensity = 0.20f;
+	float vignetIntensity = 0.25f;
+	float bloomIntensity = 0.75f;
+	float staticIntensity = 0.208f;
+	float colorshiftIntensity = 0.90f;
+	float jitterIntensity = 2.81f;
+	float curvatureIntensity = 0.0f;
+	float pixelationIntensity = -0.11f;
+	float pixelWidth = 5000.0f;
+	float burninIntensity = 0.9525f;
+	float shaderEffectsFps = 30.0f; // Refresh rate of the animated noise/pulse
+
+	float fpsTarget = 120.0f;
+	bool fpsToggle = false;
+	bool rainbow = true;
+	bool softWrap = false;
+	bool minimap = true;
+	bool searchIndex = false;
+	bool symbolIndex = false;
+	float undoHistoryMb = 8.0f; // Memory budget of each file's undo history
+};
+
 class Settings
 {
   public:
@@ -35,6 +68,14 @@ class Settings
 
 	json &getSettings() { return settings; }
 
+	// Current typed snapshot. Holding the returned pointer keeps that version alive
+	// even if the settings are reloaded meanwhile.
+	std::shared_ptr<const SettingsSnapshot> getSnapshot() const
+	{
+		std::lock_guard<std::mutex> lock(snapshotMutex);
+		return snapshot;
+	}
+
 	float getSplitPos() const { return splitPos; }
 	void setSplitPos(float pos)
 	{
@@ -121,14 +162,7 @@ class Settings
 	// Get current background color
 	ImVec4 getCurrentBackgroundColor() const;
 
-	bool getRainbowMode() const
-	{
-		if (settings.contains("rainbow") && settings["rainbow"].is_boolean())
-		{
-			return settings["rainbow"].get<bool>();
-		}
-		return true; // Fallback
-	}
+	bool getRainbowMode() const { return getSnapshot()->rainbow; }
 	bool getTreesitterMode() const
 	{
 		if (settings.contains("treesitter") && settings["treesitter"].is_boolean())
@@ -213,6 +247,11 @@ class Settings
 
 	SettingsFileManager settingsFileManager; // Handles all file operations
 
+	std::shared_ptr<const SettingsSnapshot> snapshot =
+		std::make_shared<SettingsSnapshot>();
+	mutable std::mutex snapshotMutex;
+	void rebuildSnapshot();
+
 	// Helper functions for rendering different sections of the settings window
 	void renderWindowHeader();
 	void renderProfileSelector();
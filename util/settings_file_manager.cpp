@@ -374,16 +374,22 @@ void SettingsFileManager::loadSettings(json &settings, std::string &settingsPath
 		{"fontSize", 20.0f},
 		{"git_changed_lines", true},
 		{"jitter_intensity", 2.809999942779541},
+		{"minimap", true},
 
 		{"pixel_width", 5000.0},
 		{"pixelation_intensity", -0.10999999940395355},
 		{"rainbow", true},
 		{"scanline_intensity", 0.20000000298023224},
+		{"search_index", false},
 		{"shader_toggle", true},
+		{"shader_effects_fps", 30.0},
+		{"soft_wrap", false},
 		{"splitPos", 0.2142857164144516},
 		{"static_intensity", 0.20800000429153442},
+		{"symbol_index", false},
 		{"theme", "default"},
 		{"treesitter", true},
+		{"undo_history_mb", 8.0},
 		{"vignet_intensity", 0.25},
 		{"mac_background_opacity", 0.5},
 		{"mac_blur_enabled", true},
@@ -623,6 +629,12 @@ void SettingsFileManager::checkSettingsFile(const std::string &settingsPath,
 													"rainbow",
 													"treesitter",
 													"shader_toggle",
+													"shader_effects_fps",
+													"soft_wrap",
+													"minimap",
+													"search_index",
+													"symbol_index",
+													"undo_history_mb",
 													"scanline_intensity",
 													"burnin_intensity",
 													"curvature_intensity",
@@ -737,16 +749,22 @@ void SettingsFileManager::applyDefaultSettings(json &settings)
 		{"fontSize", 20.0f},
 		{"git_changed_lines", true},
 		{"jitter_intensity", 2.809999942779541},
+		{"minimap", true},
 
 		{"pixel_width", 5000.0},
 		{"pixelation_intensity", -0.10999999940395355},
 		{"rainbow", true},
 		{"scanline_intensity", 0.20000000298023224},
+		{"search_index", false},
 		{"shader_toggle", true},
+		{"shader_effects_fps", 30.0},
+		{"soft_wrap", false},
 		{"splitPos", 0.2142857164144516},
 		{"static_intensity", 0.20800000429153442},
+		{"symbol_index", false},
 		{"theme", "default"},
 		{"treesitter", true},
+		{"undo_history_mb", 8.0},
 		{"vignet_intensity", 0.25},
 		{"mac_background_opacity", 0.5},
 		{"mac_blur_enabled", true},
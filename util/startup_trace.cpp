@@ -0,0 +1,146 @@
+/*
+File: startup_trace.cpp
+Description: Startup timing. See startup_trace.h.
+*/
+
+#include "startup_trace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+StartupTrace gStartupTrace;
+
+namespace {
+
+constexpr const char *FIRST_FRAME = "first frame";
+
+} // namespace
+
+StartupTrace::Phase::Phase(const char *name) : name(name), start(gStartupTrace.now())
+{
+}
+
+StartupTrace::Phase::~Phase() { gStartupTrace.record(name, start, Clock::now()); }
+
+StartupTrace::Clock::time_point StartupTrace::now()
+{
+	Clock::time_point time = Clock::now();
+	std::lock_guard<std::mutex> lock(mutex);
+	if (origin == Clock::time_point{})
+	{
+		origin = time;
+	}
+	return time;
+}
+
+double StartupTrace::millisSinceOrigin(Clock::time_point time) const
+{
+	return std::chrono::duration<double, std::milli>(time - origin).count();
+}
+
+void StartupTrace::record(const char *name,
+						  Clock::time_point start,
+						  Clock::time_point end)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (origin == Clock::time_point{})
+	{
+		origin = start;
+	}
+	entries.push_back({name,
+					   std::this_thread::get_id(),
+					   millisSinceOrigin(start),
+					   std::chrono::duration<double, std::milli>(end - start).count()});
+}
+
+bool StartupTrace::markFirstFrame()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (firstFrame >= 0.0)
+		{
+			return false;
+		}
+		firstFrame = millisSinceOrigin(Clock::now());
+		entries.push_back({FIRST_FRAME, std::this_thread::get_id(), firstFrame, 0.0});
+	}
+
+	std::cout << "[Startup] First frame after " << static_cast<int>(firstFrame + 0.5)
+			  << " ms" << std::endl;
+	const char *mode = std::getenv("NED_STARTUP_TRACE");
+	if (!mode || !*mode || std::strcmp(mode, "0") == 0)
+	{
+		return false;
+	}
+	dump();
+	return std::strcmp(mode, "exit") == 0;
+}
+
+double StartupTrace::firstFrameMs() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return firstFrame;
+}
+
+std::string StartupTrace::report() const
+{
+	std::vector<Entry> sorted;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		sorted = entries;
+	}
+	std::stable_sort(sorted.begin(), sorted.end(), [](const Entry &a, const Entry &b) {
+		return a.startMs < b.startMs;
+	});
+
+	// The thread that drew the first frame is the main thread, any other one a
+	// worker numbered in order of appearance
+	std::thread::id mainThread;
+	for (const Entry &entry : sorted)
+	{
+		if (entry.name == FIRST_FRAME)
+		{
+			mainThread = entry.thread;
+		}
+	}
+	std::vector<std::thread::id> workers;
+	auto threadName = [&](std::thread::id thread) {
+		if (thread == mainThread)
+		{
+			return std::string("main");
+		}
+		auto it = std::find(workers.begin(), workers.end(), thread);
+		if (it == workers.end())
+		{
+			it = workers.insert(workers.end(), thread);
+		}
+		return "worker " + std::to_string(it - workers.begin() + 1);
+	};
+
+	char line[160];
+	std::snprintf(line,
+				  sizeof(line),
+				  "[Startup] %-28s %10s %10s  %s\n",
+				  "Phase",
+				  "Start (ms)",
+				  "Time (ms)",
+				  "Thread");
+	std::string out = line;
+	for (const Entry &entry : sorted)
+	{
+		std::snprintf(line,
+					  sizeof(line),
+					  "[Startup] %-28s %10.1f %10.1f  %s\n",
+					  entry.name.c_str(),
+					  entry.startMs,
+					  entry.durationMs,
+					  threadName(entry.thread).c_str());
+		out += line;
+	}
+	return out;
+}
+
+void StartupTrace::dump() const { std::cout << report() << std::flush; }
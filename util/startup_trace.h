@@ -0,0 +1,69 @@
+/*
+File: startup_trace.h
+Description: Startup timing. Each init phase records when it started, how long it
+took and on which thread, and the main loop records the time to the first frame.
+
+Set NED_STARTUP_TRACE=1 to print the phases once the first frame is on screen, or
+NED_STARTUP_TRACE=exit to also quit right after it, for benchmarking startup.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class StartupTrace
+{
+  public:
+	using Clock = std::chrono::steady_clock;
+
+	// Times the enclosing scope as one phase
+	class Phase
+	{
+	  public:
+		explicit Phase(const char *name);
+		~Phase();
+		Phase(const Phase &) = delete;
+		Phase &operator=(const Phase &) = delete;
+
+	  private:
+		const char *name;
+		Clock::time_point start;
+	};
+
+	// Current time. The first call is the origin all times are measured from.
+	Clock::time_point now();
+	void record(const char *name, Clock::time_point start, Clock::time_point end);
+
+	// Called once the first frame is on screen. Returns true when
+	// NED_STARTUP_TRACE asked to quit right after it.
+	bool markFirstFrame();
+	// Milliseconds from the origin to the first frame, or -1 before it
+	double firstFrameMs() const;
+
+	// Phases in start order, as a table
+	std::string report() const;
+	void dump() const;
+
+  private:
+	struct Entry
+	{
+		std::string name;
+		std::thread::id thread;
+		double startMs;
+		double durationMs;
+	};
+
+	mutable std::mutex mutex;
+	Clock::time_point origin{};
+	std::vector<Entry> entries;
+	double firstFrame = -1.0;
+
+	double millisSinceOrigin(Clock::time_point time) const;
+};
+
+// Constant-initialized, so static constructors can already record phases
+extern StartupTrace gStartupTrace;
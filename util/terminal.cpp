@@ -8,6 +8,7 @@
 #include "files.h"
 #include "font.h"
 #include "imgui.h"
+#include "util/redraw.h"
 #include "util/settings.h"
 #include <iostream>
 
@@ -30,6 +31,18 @@
 #define PATH_MAX 1024
 #endif
 
+// Pulsing cursor alpha. The pulse only runs for a while after input so an idle
+// terminal stops requesting frames.
+static float cursorPulseAlpha()
+{
+	if (gRedraw.secondsSinceInput() >= Redraw::IDLE_ANIMATION_SECONDS)
+	{
+		return 0.8f;
+	}
+	gRedraw.requestIn(Redraw::ANIMATION_INTERVAL);
+	return (sin(ImGui::GetTime() * 3.14159f) * 0.3f) + 0.5f;
+}
+
 ImVec4 Terminal::defaultColorMap[16] = {
 	// Standard colors
 	ImVec4(0.0f, 0.0f, 0.0f, 1.0f), // Black
@@ -881,7 +894,7 @@ void Terminal::renderAltScreen(ImDrawList *drawList,
 	if (ImGui::IsWindowFocused())
 	{
 		ImVec2 cursorPos(pos.x + state.c.x * charWidth, pos.y + state.c.y * lineHeight);
-		float alpha = (sin(ImGui::GetTime() * 3.14159f) * 0.3f) + 0.5f;
+		float alpha = cursorPulseAlpha();
 		renderCursor(drawList,
 					 cursorPos,
 					 state.lines[state.c.y][state.c.x],
@@ -959,7 +972,7 @@ void Terminal::renderMainScreen(ImDrawList *drawList,
 						 pos.y + (visibleRows - (totalLines - scrollbackBuffer.size()) +
 								  state.c.y) *
 									 lineHeight);
-		float alpha = (sin(ImGui::GetTime() * 3.14159f) * 0.3f) + 0.5f;
+		float alpha = cursorPulseAlpha();
 		renderCursor(drawList,
 					 cursorPos,
 					 state.lines[state.c.y][state.c.x],
@@ -2834,8 +2847,11 @@ void Terminal::readOutput()
 		ssize_t bytesRead = read(ptyFd, buffer, sizeof(buffer) - 1);
 		if (bytesRead > 0)
 		{
-			std::lock_guard<std::mutex> lock(bufferMutex);
-			writeToBuffer(buffer, bytesRead);
+			{
+				std::lock_guard<std::mutex> lock(bufferMutex);
+				writeToBuffer(buffer, bytesRead);
+			}
+			gRedraw.request();
 		} else if (bytesRead < 0 && errno != EINTR)
 		{
 			break;
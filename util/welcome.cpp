@@ -1,5 +1,6 @@
 #include "welcome.h"
 #include "../files/files.h"
+#include "redraw.h"
 #include "settings.h"
 #include "util/debug_console.h"
 #include <iostream>
@@ -196,11 +197,13 @@ void Welcome::renderWelcomeImageGrid(float windowWidth, float windowHeight, floa
 						2.0f - (animationProgress * 2.0f); // Fade out (1 to 0)
 				}
 				showClickAnimation = true;
+				gRedraw.requestIn(Redraw::ANIMATION_INTERVAL);
 			} else
 			{
 				// Animation finished
 				isPlayingClickAnimation = false;
 				clickedThemeIndex = -1;
+				gRedraw.request(1);
 			}
 		}
 
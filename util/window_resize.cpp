@@ -4,6 +4,7 @@ Description: Window resize handling class implementation for NED text editor.
 */
 
 #include "window_resize.h"
+#include "redraw.h"
 #include <iostream>
 
 WindowResize::WindowResize() : window(nullptr) {}
@@ -185,6 +186,9 @@ void WindowResize::renderResizeOverlay(ImFont *font)
 
 	if (startTime > 0.0 && elapsedTime < displayDuration)
 	{
+		// Wake up again to take the overlay down
+		gRedraw.requestIn(displayDuration - elapsedTime);
+
 		ImDrawList *drawList = ImGui::GetForegroundDrawList();
 		ImGuiViewport *viewport = ImGui::GetMainViewport();
 		ImVec2 viewportPos = viewport->Pos;